@@ -95,6 +95,53 @@ RETURNS void
 LANGUAGE c
 AS 'MODULE_PATHNAME';
 
+CREATE FUNCTION create_property_index(graph_name name, label_name name,
+                                      property_name text,
+                                      access_method name = 'btree')
+RETURNS void
+LANGUAGE c
+AS 'MODULE_PATHNAME';
+
+-- edges can refer to the vertices loaded in the same transaction only
+CREATE FUNCTION load_labels_from_file(graph_name name, label_name name,
+                                      file_path text)
+RETURNS bigint
+LANGUAGE c
+AS 'MODULE_PATHNAME';
+
+CREATE FUNCTION load_edges_from_file(graph_name name, label_name name,
+                                     file_path text)
+RETURNS bigint
+LANGUAGE c
+AS 'MODULE_PATHNAME';
+
+--
+-- statistics of cypher() queries
+--
+
+-- label is set for the rows_created counters only. The counters are shared
+-- by all backends if the library is in shared_preload_libraries. Shared
+-- rows_created counters are kept for up to 1024 labels across all databases;
+-- rows created in other labels are only added to rows_created_overflow until
+-- a label is dropped or ag_stat_cypher_reset() is called. The counter of a
+-- label is removed when the transaction dropping the label commits.
+CREATE FUNCTION ag_stat_cypher(OUT name text, OUT label regclass,
+                               OUT value bigint)
+RETURNS SETOF record
+LANGUAGE c
+VOLATILE
+PARALLEL RESTRICTED
+AS 'MODULE_PATHNAME';
+
+CREATE VIEW ag_stat_cypher AS SELECT * FROM ag_stat_cypher();
+
+CREATE FUNCTION ag_stat_cypher_reset()
+RETURNS void
+LANGUAGE c
+AS 'MODULE_PATHNAME';
+
+REVOKE ALL ON FUNCTION ag_stat_cypher_reset() FROM PUBLIC;
+
 --
 -- graphid type
 --
@@ -118,9 +165,27 @@ RETURNS NULL ON NULL INPUT
 PARALLEL SAFE
 AS 'MODULE_PATHNAME';
 
+CREATE FUNCTION graphid_recv(internal)
+RETURNS graphid
+LANGUAGE c
+STABLE
+RETURNS NULL ON NULL INPUT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE FUNCTION graphid_send(graphid)
+RETURNS bytea
+LANGUAGE c
+STABLE
+RETURNS NULL ON NULL INPUT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
 CREATE TYPE graphid (
   INPUT = graphid_in,
   OUTPUT = graphid_out,
+  RECEIVE = graphid_recv,
+  SEND = graphid_send,
   INTERNALLENGTH = 8,
   PASSEDBYVALUE,
   ALIGNMENT = float8,
@@ -288,6 +353,32 @@ CREATE OPERATOR CLASS graphid_ops DEFAULT FOR TYPE graphid USING btree AS
   FUNCTION 1 graphid_btree_cmp (graphid, graphid),
   FUNCTION 2 graphid_btree_sort (internal);
 
+--
+-- statistics of edge labels
+--
+
+-- ANALYZE of an edge label derives the degrees of the vertices at both ends
+-- from the statistics of start_id and end_id and stores them here. Heavy
+-- hitters are the vertices with the most edges.
+CREATE TABLE ag_label_stats (
+  relation regclass NOT NULL,
+  edges float8 NOT NULL,
+  start_vertices float8 NOT NULL,
+  avg_out_degree float8 NOT NULL,
+  max_out_degree float8 NOT NULL,
+  heavy_start_ids graphid[] NOT NULL,
+  heavy_start_degrees float8[] NOT NULL,
+  end_vertices float8 NOT NULL,
+  avg_in_degree float8 NOT NULL,
+  max_in_degree float8 NOT NULL,
+  heavy_end_ids graphid[] NOT NULL,
+  heavy_end_degrees float8[] NOT NULL
+);
+
+CREATE UNIQUE INDEX ag_label_stats_relation_index
+ON ag_label_stats
+USING btree (relation);
+
 --
 -- graphid functions
 --
@@ -299,6 +390,14 @@ IMMUTABLE
 PARALLEL SAFE
 AS 'MODULE_PATHNAME';
 
+-- reserves entry IDs from the sequence of a label in blocks per session,
+-- parallel unsafe like nextval()
+CREATE FUNCTION _next_entry_id(seq regclass)
+RETURNS bigint
+LANGUAGE c
+RETURNS NULL ON NULL INPUT
+AS 'MODULE_PATHNAME';
+
 CREATE FUNCTION _label_name(graph_oid oid, graphid)
 RETURNS cstring
 LANGUAGE c
@@ -329,9 +428,27 @@ RETURNS NULL ON NULL INPUT
 PARALLEL SAFE
 AS 'MODULE_PATHNAME';
 
+CREATE FUNCTION agtype_recv(internal)
+RETURNS agtype
+LANGUAGE c
+STABLE
+RETURNS NULL ON NULL INPUT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE FUNCTION agtype_send(agtype)
+RETURNS bytea
+LANGUAGE c
+STABLE
+RETURNS NULL ON NULL INPUT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
 CREATE TYPE agtype (
   INPUT = agtype_in,
   OUTPUT = agtype_out,
+  RECEIVE = agtype_recv,
+  SEND = agtype_send,
   LIKE = jsonb
 );
 
@@ -457,7 +574,9 @@ CREATE OPERATOR = (
   COMMUTATOR = =,
   NEGATOR = <>,
   RESTRICT = eqsel,
-  JOIN = eqjoinsel
+  JOIN = eqjoinsel,
+  HASHES,
+  MERGES
 );
 
 CREATE FUNCTION agtype_ne(agtype, agtype)
@@ -550,6 +669,268 @@ CREATE OPERATOR >= (
   JOIN = scalargejoinsel
 );
 
+--
+-- agtype - B-tree and hash support functions
+--
+
+-- comparison support
+CREATE FUNCTION agtype_btree_cmp(agtype, agtype)
+RETURNS int
+LANGUAGE c
+IMMUTABLE
+RETURNS NULL ON NULL INPUT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+-- sort support
+CREATE FUNCTION agtype_btree_sort(internal)
+RETURNS void
+LANGUAGE c
+IMMUTABLE
+RETURNS NULL ON NULL INPUT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+-- hash support
+CREATE FUNCTION agtype_hash(agtype)
+RETURNS int
+LANGUAGE c
+IMMUTABLE
+RETURNS NULL ON NULL INPUT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE FUNCTION agtype_hash_extended(agtype, int8)
+RETURNS int8
+LANGUAGE c
+IMMUTABLE
+RETURNS NULL ON NULL INPUT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+--
+-- define operator classes for agtype
+--
+
+-- B-tree strategies and support functions are the same as graphid_ops.
+CREATE OPERATOR CLASS agtype_btree_ops DEFAULT FOR TYPE agtype USING btree AS
+  OPERATOR 1 <,
+  OPERATOR 2 <=,
+  OPERATOR 3 =,
+  OPERATOR 4 >=,
+  OPERATOR 5 >,
+  FUNCTION 1 agtype_btree_cmp (agtype, agtype),
+  FUNCTION 2 agtype_btree_sort (internal);
+
+-- Hash strategies
+--   1: equal
+--
+-- Hash support functions
+--   1: compute the 32-bit hash value for a key
+--   2: compute the 64-bit hash value for a key given a 64-bit salt (optional)
+CREATE OPERATOR CLASS agtype_hash_ops DEFAULT FOR TYPE agtype USING hash AS
+  OPERATOR 1 =,
+  FUNCTION 1 agtype_hash (agtype),
+  FUNCTION 2 agtype_hash_extended (agtype, int8);
+
+--
+-- agtype - containment and existence operators (@>, <@, ?, ?|, ?&)
+--
+
+CREATE FUNCTION agtype_contains(agtype, agtype)
+RETURNS boolean
+LANGUAGE c
+IMMUTABLE
+RETURNS NULL ON NULL INPUT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE OPERATOR @> (
+  FUNCTION = agtype_contains,
+  LEFTARG = agtype,
+  RIGHTARG = agtype,
+  COMMUTATOR = <@,
+  RESTRICT = contsel,
+  JOIN = contjoinsel
+);
+
+CREATE FUNCTION agtype_contained_by(agtype, agtype)
+RETURNS boolean
+LANGUAGE c
+IMMUTABLE
+RETURNS NULL ON NULL INPUT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE OPERATOR <@ (
+  FUNCTION = agtype_contained_by,
+  LEFTARG = agtype,
+  RIGHTARG = agtype,
+  COMMUTATOR = @>,
+  RESTRICT = contsel,
+  JOIN = contjoinsel
+);
+
+CREATE FUNCTION agtype_exists(agtype, agtype)
+RETURNS boolean
+LANGUAGE c
+IMMUTABLE
+RETURNS NULL ON NULL INPUT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE OPERATOR ? (
+  FUNCTION = agtype_exists,
+  LEFTARG = agtype,
+  RIGHTARG = agtype,
+  RESTRICT = contsel,
+  JOIN = contjoinsel
+);
+
+CREATE FUNCTION agtype_exists_any(agtype, agtype)
+RETURNS boolean
+LANGUAGE c
+IMMUTABLE
+RETURNS NULL ON NULL INPUT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE OPERATOR ?| (
+  FUNCTION = agtype_exists_any,
+  LEFTARG = agtype,
+  RIGHTARG = agtype,
+  RESTRICT = contsel,
+  JOIN = contjoinsel
+);
+
+CREATE FUNCTION agtype_exists_all(agtype, agtype)
+RETURNS boolean
+LANGUAGE c
+IMMUTABLE
+RETURNS NULL ON NULL INPUT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE OPERATOR ?& (
+  FUNCTION = agtype_exists_all,
+  LEFTARG = agtype,
+  RIGHTARG = agtype,
+  RESTRICT = contsel,
+  JOIN = contjoinsel
+);
+
+--
+-- agtype - GIN operator classes
+--
+
+CREATE FUNCTION gin_compare_agtype(text, text)
+RETURNS int4
+LANGUAGE c
+IMMUTABLE
+RETURNS NULL ON NULL INPUT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE FUNCTION gin_extract_agtype(agtype, internal)
+RETURNS internal
+LANGUAGE c
+IMMUTABLE
+RETURNS NULL ON NULL INPUT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE FUNCTION gin_extract_agtype_query(agtype, internal, int2, internal,
+                                         internal, internal, internal)
+RETURNS internal
+LANGUAGE c
+IMMUTABLE
+RETURNS NULL ON NULL INPUT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE FUNCTION gin_consistent_agtype(internal, int2, agtype, int4, internal,
+                                      internal, internal, internal)
+RETURNS boolean
+LANGUAGE c
+IMMUTABLE
+RETURNS NULL ON NULL INPUT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE FUNCTION gin_triconsistent_agtype(internal, int2, agtype, int4,
+                                         internal, internal, internal)
+RETURNS "char"
+LANGUAGE c
+IMMUTABLE
+RETURNS NULL ON NULL INPUT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE OPERATOR CLASS agtype_ops DEFAULT FOR TYPE agtype USING gin AS
+  OPERATOR 7 @>,
+  OPERATOR 9 ?(agtype, agtype),
+  OPERATOR 10 ?|(agtype, agtype),
+  OPERATOR 11 ?&(agtype, agtype),
+  FUNCTION 1 gin_compare_agtype(text, text),
+  FUNCTION 2 gin_extract_agtype(agtype, internal),
+  FUNCTION 3 gin_extract_agtype_query(agtype, internal, int2, internal,
+                                      internal, internal, internal),
+  FUNCTION 4 gin_consistent_agtype(internal, int2, agtype, int4, internal,
+                                   internal, internal, internal),
+  FUNCTION 6 gin_triconsistent_agtype(internal, int2, agtype, int4, internal,
+                                      internal, internal),
+  STORAGE text;
+
+CREATE FUNCTION gin_extract_agtype_path(agtype, internal)
+RETURNS internal
+LANGUAGE c
+IMMUTABLE
+RETURNS NULL ON NULL INPUT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE FUNCTION gin_extract_agtype_query_path(agtype, internal, int2,
+                                              internal, internal, internal,
+                                              internal)
+RETURNS internal
+LANGUAGE c
+IMMUTABLE
+RETURNS NULL ON NULL INPUT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE FUNCTION gin_consistent_agtype_path(internal, int2, agtype, int4,
+                                           internal, internal, internal,
+                                           internal)
+RETURNS boolean
+LANGUAGE c
+IMMUTABLE
+RETURNS NULL ON NULL INPUT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE FUNCTION gin_triconsistent_agtype_path(internal, int2, agtype, int4,
+                                              internal, internal, internal)
+RETURNS "char"
+LANGUAGE c
+IMMUTABLE
+RETURNS NULL ON NULL INPUT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE OPERATOR CLASS agtype_path_ops FOR TYPE agtype USING gin AS
+  OPERATOR 7 @>,
+  FUNCTION 1 btint4cmp(int4, int4),
+  FUNCTION 2 gin_extract_agtype_path(agtype, internal),
+  FUNCTION 3 gin_extract_agtype_query_path(agtype, internal, int2, internal,
+                                           internal, internal, internal),
+  FUNCTION 4 gin_consistent_agtype_path(internal, int2, agtype, int4,
+                                        internal, internal, internal,
+                                        internal),
+  FUNCTION 6 gin_triconsistent_agtype_path(internal, int2, agtype, int4,
+                                           internal, internal, internal),
+  STORAGE int4;
+
 --
 -- agtype - vertex
 --
@@ -561,6 +942,15 @@ CALLED ON NULL INPUT
 PARALLEL SAFE
 AS 'MODULE_PATHNAME';
 
+-- takes the label name of the graphid from the labels of the graph
+CREATE FUNCTION _agtype_build_vertex(graph_oid oid, graphid, agtype)
+RETURNS agtype
+LANGUAGE c
+STABLE
+CALLED ON NULL INPUT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME', '_agtype_build_graph_vertex';
+
 --
 -- agtype - edge
 --
@@ -572,6 +962,16 @@ CALLED ON NULL INPUT
 PARALLEL SAFE
 AS 'MODULE_PATHNAME';
 
+-- takes the label name of the graphid from the labels of the graph
+CREATE FUNCTION _agtype_build_edge(graph_oid oid, graphid, graphid, graphid,
+                                   agtype)
+RETURNS agtype
+LANGUAGE c
+STABLE
+CALLED ON NULL INPUT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME', '_agtype_build_graph_edge';
+
 
 --
 -- agtype - map literal (`{key: expr, ...}`)
@@ -631,6 +1031,20 @@ CREATE CAST (agtype AS boolean)
 WITH FUNCTION agtype_to_bool(agtype)
 AS IMPLICIT;
 
+-- agtype -> int8 (assignment)
+
+CREATE FUNCTION agtype_to_int8(agtype)
+RETURNS bigint
+LANGUAGE c
+IMMUTABLE
+RETURNS NULL ON NULL INPUT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE CAST (agtype AS bigint)
+WITH FUNCTION agtype_to_int8(agtype)
+AS ASSIGNMENT;
+
 -- boolean -> agtype (explicit)
 
 CREATE FUNCTION bool_to_agtype(boolean)
@@ -652,7 +1066,7 @@ WITH FUNCTION bool_to_agtype(boolean);
 CREATE FUNCTION agtype_access_operator(VARIADIC agtype[])
 RETURNS agtype
 LANGUAGE c
-STABLE
+IMMUTABLE
 RETURNS NULL ON NULL INPUT
 PARALLEL SAFE
 AS 'MODULE_PATHNAME';
@@ -699,6 +1113,288 @@ RETURNS NULL ON NULL INPUT
 PARALLEL SAFE
 AS 'MODULE_PATHNAME';
 
+--
+-- agtype - aggregates
+--
+
+-- count()
+CREATE FUNCTION agtype_count_transfn(int8, agtype)
+RETURNS int8
+LANGUAGE c
+IMMUTABLE
+RETURNS NULL ON NULL INPUT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE FUNCTION agtype_count_final(int8)
+RETURNS agtype
+LANGUAGE c
+IMMUTABLE
+RETURNS NULL ON NULL INPUT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE AGGREGATE agtype_count(*) (
+  STYPE = int8,
+  SFUNC = int8inc,
+  COMBINEFUNC = int8pl,
+  FINALFUNC = agtype_count_final,
+  INITCOND = '0',
+  PARALLEL = SAFE
+);
+
+CREATE AGGREGATE agtype_count(agtype) (
+  STYPE = int8,
+  SFUNC = agtype_count_transfn,
+  COMBINEFUNC = int8pl,
+  FINALFUNC = agtype_count_final,
+  INITCOND = '0',
+  PARALLEL = SAFE
+);
+
+-- sum() and avg()
+CREATE FUNCTION agtype_sum_transfn(internal, agtype)
+RETURNS internal
+LANGUAGE c
+IMMUTABLE
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE FUNCTION agtype_sum_combinefn(internal, internal)
+RETURNS internal
+LANGUAGE c
+IMMUTABLE
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE FUNCTION agtype_sum_serialize(internal)
+RETURNS bytea
+LANGUAGE c
+IMMUTABLE
+RETURNS NULL ON NULL INPUT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE FUNCTION agtype_sum_deserialize(bytea, internal)
+RETURNS internal
+LANGUAGE c
+IMMUTABLE
+RETURNS NULL ON NULL INPUT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE FUNCTION agtype_sum_final(internal)
+RETURNS agtype
+LANGUAGE c
+IMMUTABLE
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE FUNCTION agtype_avg_final(internal)
+RETURNS agtype
+LANGUAGE c
+IMMUTABLE
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE AGGREGATE agtype_sum(agtype) (
+  STYPE = internal,
+  SFUNC = agtype_sum_transfn,
+  COMBINEFUNC = agtype_sum_combinefn,
+  SERIALFUNC = agtype_sum_serialize,
+  DESERIALFUNC = agtype_sum_deserialize,
+  FINALFUNC = agtype_sum_final,
+  PARALLEL = SAFE
+);
+
+CREATE AGGREGATE agtype_avg(agtype) (
+  STYPE = internal,
+  SFUNC = agtype_sum_transfn,
+  COMBINEFUNC = agtype_sum_combinefn,
+  SERIALFUNC = agtype_sum_serialize,
+  DESERIALFUNC = agtype_sum_deserialize,
+  FINALFUNC = agtype_avg_final,
+  PARALLEL = SAFE
+);
+
+-- min() and max()
+CREATE FUNCTION agtype_smaller(agtype, agtype)
+RETURNS agtype
+LANGUAGE c
+IMMUTABLE
+RETURNS NULL ON NULL INPUT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE FUNCTION agtype_larger(agtype, agtype)
+RETURNS agtype
+LANGUAGE c
+IMMUTABLE
+RETURNS NULL ON NULL INPUT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE AGGREGATE agtype_min(agtype) (
+  STYPE = agtype,
+  SFUNC = agtype_smaller,
+  COMBINEFUNC = agtype_smaller,
+  PARALLEL = SAFE
+);
+
+CREATE AGGREGATE agtype_max(agtype) (
+  STYPE = agtype,
+  SFUNC = agtype_larger,
+  COMBINEFUNC = agtype_larger,
+  PARALLEL = SAFE
+);
+
+-- collect()
+CREATE FUNCTION agtype_collect_transfn(internal, agtype)
+RETURNS internal
+LANGUAGE c
+IMMUTABLE
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE FUNCTION agtype_collect_combinefn(internal, internal)
+RETURNS internal
+LANGUAGE c
+IMMUTABLE
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE FUNCTION agtype_collect_serialize(internal)
+RETURNS bytea
+LANGUAGE c
+IMMUTABLE
+RETURNS NULL ON NULL INPUT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE FUNCTION agtype_collect_deserialize(bytea, internal)
+RETURNS internal
+LANGUAGE c
+IMMUTABLE
+RETURNS NULL ON NULL INPUT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE FUNCTION agtype_collect_final(internal)
+RETURNS agtype
+LANGUAGE c
+IMMUTABLE
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE AGGREGATE agtype_collect(agtype) (
+  STYPE = internal,
+  SFUNC = agtype_collect_transfn,
+  COMBINEFUNC = agtype_collect_combinefn,
+  SERIALFUNC = agtype_collect_serialize,
+  DESERIALFUNC = agtype_collect_deserialize,
+  FINALFUNC = agtype_collect_final,
+  PARALLEL = SAFE
+);
+
+-- percentileCont() and percentileDisc()
+CREATE FUNCTION agtype_percentile_transfn(internal, agtype, agtype)
+RETURNS internal
+LANGUAGE c
+IMMUTABLE
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE FUNCTION agtype_percentile_combinefn(internal, internal)
+RETURNS internal
+LANGUAGE c
+IMMUTABLE
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE FUNCTION agtype_percentile_serialize(internal)
+RETURNS bytea
+LANGUAGE c
+IMMUTABLE
+RETURNS NULL ON NULL INPUT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE FUNCTION agtype_percentile_deserialize(bytea, internal)
+RETURNS internal
+LANGUAGE c
+IMMUTABLE
+RETURNS NULL ON NULL INPUT
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE FUNCTION agtype_percentile_cont_final(internal)
+RETURNS agtype
+LANGUAGE c
+IMMUTABLE
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE FUNCTION agtype_percentile_disc_final(internal)
+RETURNS agtype
+LANGUAGE c
+IMMUTABLE
+PARALLEL SAFE
+AS 'MODULE_PATHNAME';
+
+CREATE AGGREGATE agtype_percentile_cont(agtype, agtype) (
+  STYPE = internal,
+  SFUNC = agtype_percentile_transfn,
+  COMBINEFUNC = agtype_percentile_combinefn,
+  SERIALFUNC = agtype_percentile_serialize,
+  DESERIALFUNC = agtype_percentile_deserialize,
+  FINALFUNC = agtype_percentile_cont_final,
+  PARALLEL = SAFE
+);
+
+CREATE AGGREGATE agtype_percentile_disc(agtype, agtype) (
+  STYPE = internal,
+  SFUNC = agtype_percentile_transfn,
+  COMBINEFUNC = agtype_percentile_combinefn,
+  SERIALFUNC = agtype_percentile_serialize,
+  DESERIALFUNC = agtype_percentile_deserialize,
+  FINALFUNC = agtype_percentile_disc_final,
+  PARALLEL = SAFE
+);
+
+--
+-- functions for reading clauses
+--
+
+-- Placeholder for a hop of a MATCH pattern. It is always replaced by the
+-- "Cypher Expand" custom scan which returns, for the given vertex, the
+-- adjacent edges and vertices as (edge_id, start_id, end_id,
+-- edge_properties, id, properties). The scan only reads, so parallel workers
+-- can expand the vertices they scan.
+CREATE FUNCTION _cypher_expand_clause(graph_oid oid, vertex_id graphid,
+                                      edge_relation oid, direction int4,
+                                      vertex_label_id int4)
+RETURNS SETOF record
+LANGUAGE c
+PARALLEL SAFE
+ROWS 10
+AS 'MODULE_PATHNAME';
+
+-- Placeholder for a variable-length hop of a MATCH pattern, like
+-- _cypher_expand_clause(). It is always replaced by the "Cypher VLE" custom
+-- scan which returns the (id, properties, edge_ids) of the vertices at the
+-- end of the paths from the given vertex and the edges of the paths. max_hops
+-- is -1 if the length has no upper bound. If shortest is true, only the
+-- shortest path to each vertex counts and edge_ids is NULL.
+CREATE FUNCTION _cypher_vle_clause(graph_oid oid, vertex_id graphid,
+                                   edge_relation oid, direction int4,
+                                   vertex_label_id int4, min_hops int4,
+                                   max_hops int4, shortest bool)
+RETURNS SETOF record
+LANGUAGE c
+PARALLEL SAFE
+ROWS 100
+AS 'MODULE_PATHNAME';
+
 --
 -- functions for updating clauses
 --
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2020 Bitnine Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+LOAD 'agensgraph';
+SET search_path TO ag_catalog;
+
+SELECT create_graph('ag_stat');
+
+SELECT ag_stat_cypher_reset();
+
+SELECT * FROM cypher('ag_stat', $$CREATE (:v {i: 0})$$) AS (a agtype);
+SELECT * FROM cypher('ag_stat', $$
+CREATE (:v {i: 1})-[:e]->(:v {i: 2})
+$$) AS (a agtype);
+
+-- the second query is found in the query cache
+SELECT * FROM cypher('ag_stat', $$MATCH (n:v) RETURN n.i$$) AS (i agtype);
+SELECT * FROM cypher('ag_stat', $$MATCH (n:v) RETURN n.i$$) AS (i agtype);
+
+SELECT name, value FROM ag_stat_cypher
+WHERE name IN ('parse_calls', 'analyze_calls',
+               'cypher_query_cache_hits', 'cypher_query_cache_misses')
+ORDER BY name;
+
+SELECT name, value > 0 AS counted FROM ag_stat_cypher
+WHERE name IN ('parse_time', 'label_name_graph_cache_misses',
+               'agtype_build_bytes', 'agtype_serialize_bytes',
+               'access_operator_calls')
+ORDER BY name;
+
+-- rows created per label
+SELECT label, value FROM ag_stat_cypher
+WHERE name = 'rows_created'
+ORDER BY label::text;
+
+-- the counters of a label are removed only if dropping the label commits
+BEGIN;
+SELECT drop_label('ag_stat', 'e');
+ROLLBACK;
+SELECT label, value FROM ag_stat_cypher
+WHERE name = 'rows_created'
+ORDER BY label::text;
+
+-- nothing is counted while tracking is off
+SET agensgraph.track_cypher_stats = off;
+SELECT * FROM cypher('ag_stat', $$MATCH (n:v) RETURN n.i$$) AS (i agtype);
+RESET agensgraph.track_cypher_stats;
+
+SELECT value FROM ag_stat_cypher WHERE name = 'cypher_query_cache_hits';
+
+-- the queries against the view look up the caches as well
+SELECT ag_stat_cypher_reset();
+SELECT count(*) FROM ag_stat_cypher
+WHERE value <> 0 AND name NOT LIKE '%\_cache\_%';
+
+SELECT drop_graph('ag_stat', true);
@@ -85,6 +85,11 @@ INSERT INTO agtype_table VALUES ('bad float', '-NaN');
 INSERT INTO agtype_table VALUES ('bad float', 'Infi');
 INSERT INTO agtype_table VALUES ('bad float', '-Infi');
 
+--
+-- Strings with characters to escape
+--
+SELECT '"tab\tnewline\nquote\"backslash\\ bell\u0007 end"'::agtype;
+
 --
 -- Test agtype mathematical operator functions
 -- +, -, unary -, *, /, %, and ^
@@ -184,6 +189,18 @@ SELECT '3'::agtype + '3.14'::agtype;
 SELECT '3'::agtype + '3.14::numeric'::agtype;
 SELECT '3.14'::agtype + '3.14::numeric'::agtype;
 SELECT '3.14::numeric'::agtype + '3.14::numeric'::agtype;
+-- Integers and floats stored in a table take the fixed-layout path; the
+-- results and their binary form match the general path
+CREATE TEMPORARY TABLE agtype_numbers AS
+SELECT '7'::agtype AS i, '2.5'::agtype AS f, '"s"'::agtype AS s;
+SELECT i + i, i - f, -f, i * f, i / '2', i % '4', f ^ i, i + s
+FROM agtype_numbers;
+SELECT substring(agtype_send(i + i) FROM 6) =
+       substring(agtype_send('[14]') FROM 6) AS integer_layout,
+       substring(agtype_send(f * f) FROM 6) =
+       substring(agtype_send('[6.25]') FROM 6) AS float_layout
+FROM agtype_numbers;
+DROP TABLE agtype_numbers;
 
 --
 -- Test orderability of comparison operators =, <>, <, >, <=, >=
@@ -348,7 +365,15 @@ SELECT _agtype_build_vertex('1'::graphid, $$label_name$$, NULL);
 --Test access operator
 SELECT agtype_access_operator(_agtype_build_vertex('1'::graphid, $$label$$,
                               agtype_build_map('id', 2)), '"id"');
+SELECT agtype_access_operator(_agtype_build_vertex('1'::graphid, $$label$$,
+                              agtype_build_map('id', 2)), '"none"');
+SELECT agtype_access_operator(_agtype_build_vertex('1'::graphid, $$label$$,
+                              agtype_build_map('list', agtype_build_list(1,
+                                  agtype_build_map('key', 'value')))),
+                              '"list"', '-1', '"key"');
 SELECT _agtype_build_vertex('1'::graphid, $$label$$, agtype_build_list());
+SELECT _agtype_build_edge('1'::graphid, '2'::graphid, '3'::graphid, $$label$$,
+                          agtype_build_list());
 
 --Vertex in a map
 SELECT agtype_build_map(
@@ -424,6 +449,13 @@ SELECT agtype_access_operator(
 		_agtype_build_edge('2'::graphid, '2'::graphid, '3'::graphid, $$label_name$$,
                                      agtype_build_map('id', 4))), '0');
 
+--Entities with nested properties in a list
+SELECT agtype_build_list(
+	_agtype_build_edge('1'::graphid, '2'::graphid, '3'::graphid, $$e$$,
+			   agtype_build_map('a', agtype_build_list(1, 'b'))),
+	_agtype_build_vertex('4'::graphid, $$vertex$$,
+			     agtype_build_map('c', agtype_build_map('d', 2))));
+
 --
 -- Test STARTS WITH, ENDS WITH, and CONTAINS
 --
@@ -437,6 +469,261 @@ SELECT agtype_string_match_starts_with('"abcdefghijklmnopqrstuvwxyz"', '"bcde"')
 SELECT agtype_string_match_ends_with('"abcdefghijklmnopqrstuvwxyz"', '"vwxy"');
 SELECT agtype_string_match_contains('"abcdefghijklmnopqrstuvwxyz"', '"hijl"');
 
+--
+-- Test containment and existence operators
+--
+SELECT '{"a": 1, "b": [1, 2, {"c": "d"}]}'::agtype @> '{"b": [{"c": "d"}]}';
+SELECT '{"a": 1}'::agtype @> '{"a": 2}';
+SELECT '{"a": 1}'::agtype <@ '{"a": 1, "b": 2.5}';
+SELECT '{"a": 1, "b": 2}'::agtype ? '"b"';
+SELECT '["a", "b"]'::agtype ? '"c"';
+SELECT '{"a": 1}'::agtype ? '1';
+SELECT '{"a": 1, "b": 2}'::agtype ?| '["c", "b"]';
+SELECT '{"a": 1, "b": 2}'::agtype ?& '["a", "c"]';
+
+--
+-- Test GIN indexes
+--
+CREATE TABLE agtype_gin_table (id int, props agtype);
+INSERT INTO agtype_gin_table
+SELECT i, ('{"id": ' || i || ', "odd": ' || (i % 2 = 1) || '}')::agtype
+FROM generate_series(1, 100) AS i;
+INSERT INTO agtype_gin_table VALUES (0, '{"id": 0, "float": 1.5}');
+SET enable_seqscan = off;
+
+CREATE INDEX agtype_gin_table_ops_idx ON agtype_gin_table USING gin (props);
+EXPLAIN (COSTS OFF)
+SELECT id FROM agtype_gin_table WHERE props @> '{"id": 7}';
+SELECT id FROM agtype_gin_table WHERE props @> '{"id": 7}';
+SELECT id FROM agtype_gin_table WHERE props @> '{"float": 1.5}';
+SELECT count(*) FROM agtype_gin_table WHERE props @> '{"odd": true}';
+SELECT id FROM agtype_gin_table WHERE props ? '"float"';
+SELECT count(*) FROM agtype_gin_table WHERE props ?| '["float", "odd"]';
+SELECT count(*) FROM agtype_gin_table WHERE props ?& '["id", "odd"]';
+DROP INDEX agtype_gin_table_ops_idx;
+
+CREATE INDEX agtype_gin_table_path_ops_idx ON agtype_gin_table
+USING gin (props agtype_path_ops);
+EXPLAIN (COSTS OFF)
+SELECT id FROM agtype_gin_table WHERE props @> '{"id": 7}';
+SELECT id FROM agtype_gin_table WHERE props @> '{"id": 7}';
+SELECT count(*) FROM agtype_gin_table WHERE props @> '{"odd": false}';
+
+RESET enable_seqscan;
+DROP TABLE agtype_gin_table;
+
+--
+-- B-tree and hash operator classes
+--
+SELECT agtype_btree_cmp('1', '1.0') = 0 AS eq,
+       agtype_btree_cmp('"a"', '"b"') < 0 AS lt,
+       agtype_btree_cmp('{"k": 1}', 'null') < 0 AS object_first;
+SELECT agtype_hash('1') = agtype_hash('1.0') AS int_float,
+       agtype_hash('1') = agtype_hash('1::numeric') AS int_numeric,
+       agtype_hash_extended('1', 42) = agtype_hash_extended('1.0', 42) AS extended;
+-- with seed 0, the low 32 bits of the extended hash are the hash
+SELECT (agtype_hash_extended(a, 0) & 4294967295) =
+       (agtype_hash(a)::bigint & 4294967295) AS low_bits
+FROM (VALUES ('1'::agtype), ('"s"'),
+             (_agtype_build_vertex('1'::graphid, $$v$$, NULL)),
+             (_agtype_build_edge('2'::graphid, '1'::graphid, '1'::graphid,
+                                 $$e$$, NULL))) AS t(a);
+
+CREATE TABLE agtype_sort_table (a agtype);
+INSERT INTO agtype_sort_table VALUES
+('2'), ('"b"'), ('1.5'), ('null'), ('true'), ('"a"'), ('1'), ('[1, 2]'),
+('{"k": 1}'), ('2.5::numeric');
+SELECT a FROM agtype_sort_table ORDER BY a;
+SELECT a FROM agtype_sort_table ORDER BY a DESC LIMIT 3;
+
+INSERT INTO agtype_sort_table VALUES ('1.0'), ('1::numeric'), ('2.0');
+SET enable_sort = off;
+EXPLAIN (COSTS OFF)
+SELECT DISTINCT a FROM agtype_sort_table;
+SELECT count(*) FROM (SELECT DISTINCT a FROM agtype_sort_table) AS s;
+RESET enable_sort;
+
+SET enable_seqscan = off;
+CREATE INDEX agtype_sort_table_btree_idx ON agtype_sort_table (a);
+SELECT a FROM agtype_sort_table WHERE a >= '"a"' AND a <= 'true' ORDER BY a;
+DROP INDEX agtype_sort_table_btree_idx;
+
+CREATE INDEX agtype_sort_table_hash_idx ON agtype_sort_table USING hash (a);
+SELECT count(*) FROM agtype_sort_table WHERE a = '1';
+SELECT count(*) FROM agtype_sort_table WHERE a = '"b"';
+DROP INDEX agtype_sort_table_hash_idx;
+RESET enable_seqscan;
+
+DROP TABLE agtype_sort_table;
+
+--
+-- The lexer must accept and reject the same strings as the jsonb lexer, and
+-- de-escape them the same way. The strings are made of random pieces.
+--
+CREATE FUNCTION lexer_fuzz_parse(str text, typ regtype)
+RETURNS text
+LANGUAGE plpgsql
+AS $$
+DECLARE
+    result text;
+BEGIN
+    EXECUTE format('SELECT %L::%s::text', str, typ) INTO result;
+    RETURN result;
+EXCEPTION
+    WHEN invalid_text_representation OR untranslatable_character THEN
+        RETURN NULL;
+END;
+$$;
+
+SELECT setseed(0.5);
+CREATE TEMPORARY TABLE lexer_fuzz AS
+SELECT i, '"' || (SELECT string_agg(p[1 + floor(random() * array_length(p, 1))::int], '')
+                  FROM generate_series(0, i % 40)) || '"' AS s
+FROM generate_series(1, 2000) AS i,
+     (SELECT ARRAY['a', 'abcdefgh', 'xyz 0123456789', '/', chr(233),
+                   '\"', '\\', '\/', '\b', '\f', '\n', '\r', '\t',
+                   '\u0041', '\u00e9', '\ud83d\ude00', '\u0000', '\ud83d',
+                   '"', '\', '\x', '\u12', chr(1), chr(9), chr(10),
+                   repeat('plain text ', 4)] AS p) AS pieces;
+
+CREATE TEMPORARY TABLE lexer_fuzz_result AS
+SELECT s, lexer_fuzz_parse(s, 'agtype') AS a, lexer_fuzz_parse(s, 'jsonb') AS j
+FROM (SELECT s FROM lexer_fuzz
+      UNION ALL
+      SELECT '[' || s || ', {' || s || ': ' || s || '}]' FROM lexer_fuzz) AS t;
+
+SELECT count(*) AS cases,
+       count(*) FILTER (WHERE a IS DISTINCT FROM j) AS mismatches,
+       bool_or(a IS NULL) AND bool_or(a IS NOT NULL) AS both_kinds
+FROM lexer_fuzz_result;
+
+DROP TABLE lexer_fuzz, lexer_fuzz_result;
+DROP FUNCTION lexer_fuzz_parse(text, regtype);
+
+--
+-- The same goes for whitespace and numbers. Numbers become floats and
+-- integers in agtype, so only the number of elements is compared. Numbers
+-- that are out of the range of agtype (-1) match any number of elements.
+--
+CREATE FUNCTION lexer_fuzz_count(str text, typ regtype)
+RETURNS int
+LANGUAGE plpgsql
+AS $$
+DECLARE
+    result int;
+BEGIN
+    EXECUTE format('SELECT jsonb_array_length(%L::%s::text::jsonb)', str, typ)
+    INTO result;
+    RETURN result;
+EXCEPTION
+    WHEN invalid_text_representation THEN
+        RETURN NULL;
+    WHEN numeric_value_out_of_range THEN
+        RETURN -1;
+END;
+$$;
+
+CREATE TEMPORARY TABLE lexer_fuzz_numbers AS
+SELECT i, '[' || (SELECT string_agg(w[1 + floor(random() * array_length(w, 1))::int] ||
+                                    n[1 + floor(random() * array_length(n, 1))::int] ||
+                                    f[1 + floor(random() * array_length(f, 1))::int] ||
+                                    e[1 + floor(random() * array_length(e, 1))::int] ||
+                                    w[1 + floor(random() * array_length(w, 1))::int], ',')
+                  FROM generate_series(0, i % 10)) || ']' AS s
+FROM generate_series(1, 1000) AS i,
+     (SELECT ARRAY['', ' ', E'\n', E'\t\r', repeat(' ', 20),
+                   repeat(E' \n', 12), repeat(' ', 40), E'\f'] AS w,
+             ARRAY['0', '-0', '7', '-12', repeat('1', 17), repeat('5', 40),
+                   '"' || repeat('x', 20) || '"', '"a b"', '01', '-'] AS n,
+             ARRAY['', '', '', '.5', '.' || repeat('3', 33), '.'] AS f,
+             ARRAY['', '', 'e5', 'E-12', 'e+' || repeat('0', 30) || '7',
+                   'e999', 'e'] AS e) AS pieces;
+
+SELECT count(*) AS cases,
+       count(*) FILTER (WHERE (a IS NULL) <> (j IS NULL) OR a <> -1 AND a <> j)
+           AS mismatches,
+       bool_or(a IS NULL) AND bool_or(a > 0) AS both_kinds
+FROM (SELECT lexer_fuzz_count(s, 'agtype') AS a,
+             lexer_fuzz_count(s, 'jsonb') AS j
+      FROM lexer_fuzz_numbers) AS t;
+
+DROP TABLE lexer_fuzz_numbers;
+DROP FUNCTION lexer_fuzz_count(text, regtype);
+
+--
+-- Binary input and output
+--
+CREATE TABLE agtype_binary (a agtype, g graphid);
+INSERT INTO agtype_binary VALUES
+    ('null', '0'),
+    ('true', '1'),
+    ('-1', '844424930131969'),
+    ('2.5', '-1'),
+    ('3.14::numeric', '9223372036854775807'),
+    ('"string é"', '1125899906842625'),
+    ('[1, "a", {"k": [true, false, null]}, 0.0::numeric]', '2'),
+    (_agtype_build_vertex('1'::graphid, $$v$$, agtype_build_map('k', 'v')),
+     '3'),
+    (agtype_build_list(_agtype_build_edge('1'::graphid, '2'::graphid,
+                                          '3'::graphid, $$e$$,
+                                          agtype_build_map())),
+     '4');
+
+DO $$
+DECLARE
+    file text := current_setting('data_directory') || '/agtype_binary.bin';
+BEGIN
+    EXECUTE format('COPY agtype_binary TO %L WITH (FORMAT binary)', file);
+    EXECUTE format('COPY agtype_binary FROM %L WITH (FORMAT binary)', file);
+END
+$$;
+
+-- every value is read back as it was written
+SELECT a::text, g, count(*) FROM agtype_binary GROUP BY a::text, g ORDER BY g;
+
+DROP TABLE agtype_binary;
+
+-- malformed binary input is rejected
+CREATE TEMPORARY TABLE agtype_recv_result (a agtype);
+CREATE FUNCTION agtype_recv_bytes(data bytea)
+RETURNS text
+LANGUAGE plpgsql
+AS $$
+DECLARE
+    file text := current_setting('data_directory') || '/agtype_recv.bin';
+    detail text;
+    result text;
+BEGIN
+    EXECUTE format('COPY (SELECT %L::bytea) TO %L WITH (FORMAT binary)',
+                   data, file);
+    TRUNCATE agtype_recv_result;
+    EXECUTE format('COPY agtype_recv_result FROM %L WITH (FORMAT binary)',
+                   file);
+    SELECT a::text INTO result FROM agtype_recv_result;
+    RETURN result;
+EXCEPTION
+    WHEN invalid_binary_representation OR character_not_in_repertoire THEN
+        GET STACKED DIAGNOSTICS detail = PG_EXCEPTION_DETAIL;
+        RETURN concat_ws(': ', SQLERRM, nullif(detail, ''));
+END;
+$$;
+
+SELECT agtype_recv_bytes(b) FROM (VALUES
+    (1, agtype_send('{"a": [1, 2]}')),
+    (2, '\x02' || substring(agtype_send('1') FROM 2)),
+    (3, substring(agtype_send('[1, 2]') FROM 1 FOR 6)),
+    (4, substring(agtype_send('"abc"') FROM 1 FOR 11)),
+    (5, '\x010100005001000080ff'),
+    (6, '\x01010000500c0000f0000000000700000000000000'),
+    (7, '\x01010000500c0000f0050000000700000000000000'),
+    (8, '\x0102000020010000800100000000000040000000406162'),
+    (9, '\x0102000020010000800100000000000040000000406261'),
+    (10, '\x0101000050010000806162')
+) AS t(i, b) ORDER BY i;
+
+DROP FUNCTION agtype_recv_bytes(bytea);
+DROP TABLE agtype_recv_result;
+
 --
 -- Cleanup
 --
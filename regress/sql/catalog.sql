@@ -126,3 +126,101 @@ SELECT * FROM cypher('g', $$CREATE (:v2)$$) as r(a agtype);
 SELECT name, id, kind, relation FROM ag_label;
 
 SELECT drop_graph('g', true);
+
+--
+-- indexes of label tables
+--
+
+SELECT create_graph('g');
+
+SELECT * FROM cypher('g', $$CREATE (:v)-[:e]->(:v)$$) AS r(a agtype);
+
+-- every label has a primary key and edge labels have adjacency indexes
+SELECT tablename, indexname, indexdef FROM pg_indexes
+WHERE schemaname = 'g'
+ORDER BY tablename, indexname;
+
+-- edge tables are clustered on the outgoing adjacency index
+SELECT indexrelid::regclass FROM pg_index
+WHERE indisclustered AND indrelid IN (SELECT relation FROM ag_label)
+ORDER BY indexrelid::regclass::text;
+
+SELECT drop_graph('g', true);
+
+--
+-- entry id allocation
+--
+
+SET agensgraph.entry_id_block_size = 4;
+
+SELECT create_graph('g');
+
+SELECT * FROM cypher('g', $$CREATE (:v)$$) AS r(a agtype);
+INSERT INTO g.v DEFAULT VALUES;
+SELECT * FROM cypher('g', $$CREATE (:v)$$) AS r(a agtype);
+
+-- CREATE and the column default share the block of entry ids 1 .. 4
+SELECT id FROM g.v ORDER BY id;
+SELECT last_value FROM g.v_id_seq;
+
+-- the next block is reserved once the block is used up
+INSERT INTO g.v DEFAULT VALUES;
+INSERT INTO g.v DEFAULT VALUES;
+SELECT id FROM g.v ORDER BY id;
+SELECT last_value FROM g.v_id_seq;
+
+RESET agensgraph.entry_id_block_size;
+
+SELECT drop_graph('g', true);
+
+--
+-- statistics of edge labels
+--
+
+SELECT create_graph('g');
+
+SELECT * FROM cypher('g', $$CREATE (:v)-[:e]->(:v)$$) AS r(a agtype);
+
+-- vertex 1 has the most outgoing edges
+INSERT INTO g.e (start_id, end_id)
+SELECT _graphid(3, s), _graphid(3, e)
+FROM (VALUES (1, 3), (1, 4), (1, 5), (1, 6), (2, 3), (3, 4), (4, 2)) AS t(s, e);
+
+-- the label has not been analyzed yet
+SELECT count(*) FROM ag_label_stats;
+
+ANALYZE g.e;
+
+SELECT relation, edges, start_vertices, avg_out_degree, max_out_degree,
+       heavy_start_ids, heavy_start_degrees
+FROM ag_label_stats;
+SELECT end_vertices, avg_in_degree, max_in_degree, heavy_end_degrees
+FROM ag_label_stats;
+
+SELECT drop_graph('g', true);
+
+SELECT count(*) FROM ag_label_stats;
+
+--
+-- label names of vertices and edges
+--
+
+SELECT create_graph('g');
+
+SELECT * FROM cypher('g', $$CREATE (:v)-[:e]->(:v)$$) AS r(a agtype);
+
+-- the default labels have empty names
+SELECT _agtype_build_vertex(g.oid, _graphid(l, 1), NULL)
+FROM ag_graph g, (VALUES (1), (3)) AS t(l)
+WHERE g.name = 'g'
+ORDER BY l;
+SELECT _agtype_build_edge(g.oid, _graphid(4, 1), _graphid(3, 1),
+                          _graphid(3, 2), agtype_build_map('w', 1))
+FROM ag_graph g
+WHERE g.name = 'g';
+
+SELECT _agtype_build_vertex(g.oid, _graphid(9, 1), NULL)
+FROM ag_graph g
+WHERE g.name = 'g';
+
+SELECT drop_graph('g', true);
@@ -65,4 +65,42 @@ SELECT (SELECT * FROM cypher('cypher', $$RETURN 0$$) AS r(c agtype));
 SELECT * FROM cypher('cypher', $$RETURN true$$) AS (c bool);
 SELECT * FROM cypher('cypher', $$RETURN 0$$) AS (c oid);
 
+-- Analyzed queries are cached per session. The same query with a different
+-- column definition list is analyzed again, and dropping a label invalidates
+-- the cached queries that use the label.
+
+SELECT * FROM cypher('cypher', $$RETURN true$$) AS (c agtype);
+
+SELECT * FROM cypher('cypher', $$CREATE (:cached {n: 1})$$) AS (a agtype);
+SELECT * FROM cypher('cypher', $$MATCH (v:cached) RETURN v.n$$) AS (n agtype);
+SELECT drop_label('cypher', 'cached');
+SELECT * FROM cypher('cypher', $$CREATE (:cached {n: 2})$$) AS (a agtype);
+SELECT * FROM cypher('cypher', $$MATCH (v:cached) RETURN v.n$$) AS (n agtype);
+
+-- Operators are looked up through search_path. A cached query is not used
+-- under another search_path, and dropping an operator invalidates it.
+
+CREATE FUNCTION public.cached_add(ag_catalog.agtype, ag_catalog.agtype)
+RETURNS ag_catalog.agtype
+LANGUAGE sql
+AS $$SELECT '"public"'::ag_catalog.agtype$$;
+CREATE OPERATOR public.+ (LEFTARG = agtype, RIGHTARG = agtype,
+                          PROCEDURE = public.cached_add);
+SELECT * FROM cypher('cypher', $$RETURN 1 + 1$$) AS (c agtype);
+SET search_path TO public, ag_catalog;
+SELECT * FROM cypher('cypher', $$RETURN 1 + 1$$) AS (c agtype);
+DROP OPERATOR public.+ (agtype, agtype);
+SELECT * FROM cypher('cypher', $$RETURN 1 + 1$$) AS (c agtype);
+DROP FUNCTION public.cached_add(agtype, agtype);
+SET search_path TO ag_catalog;
+
+-- RETURN DISTINCT and ORDER BY use the B-tree and hash operator classes of
+-- agtype.
+
+SELECT * FROM cypher('cypher', $$CREATE (:cached {n: 1})$$) AS (a agtype);
+SELECT * FROM cypher('cypher', $$CREATE (:cached {n: 2})$$) AS (a agtype);
+SELECT * FROM cypher('cypher', $$
+MATCH (v:cached) RETURN DISTINCT v.n ORDER BY v.n DESC
+$$) AS (n agtype);
+
 SELECT drop_graph('cypher', true);
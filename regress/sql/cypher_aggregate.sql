@@ -0,0 +1,148 @@
+/*
+ * Copyright 2020 Bitnine Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+LOAD 'agensgraph';
+SET search_path TO ag_catalog;
+
+SELECT create_graph('cypher_aggregate');
+
+SELECT * FROM cypher('cypher_aggregate', $$
+CREATE (:p {name: 'a', dept: 'x', age: 20, score: 1.5})
+$$) AS (a agtype);
+SELECT * FROM cypher('cypher_aggregate', $$
+CREATE (:p {name: 'b', dept: 'x', age: 30})
+$$) AS (a agtype);
+SELECT * FROM cypher('cypher_aggregate', $$
+CREATE (:p {name: 'c', dept: 'y', age: 40, score: 2.5})
+$$) AS (a agtype);
+SELECT * FROM cypher('cypher_aggregate', $$
+CREATE (:p {name: 'd', dept: 'y', age: null})
+$$) AS (a agtype);
+
+-- null values are skipped
+SELECT * FROM cypher('cypher_aggregate', $$
+MATCH (n:p)
+RETURN count(*), count(n.age), sum(n.age), avg(n.age), min(n.age), max(n.age)
+$$) AS (c agtype, c_age agtype, s agtype, a agtype, mi agtype, ma agtype);
+
+SELECT * FROM cypher('cypher_aggregate', $$
+MATCH (n:p)
+RETURN sum(n.score), avg(n.score), min(n.name), max(n.name), collect(n.name)
+$$) AS (s agtype, a agtype, mi agtype, ma agtype, names agtype);
+
+SELECT * FROM cypher('cypher_aggregate', $$
+MATCH (n:p)
+RETURN percentileCont(n.age, 0.4), percentileDisc(n.age, 0.4),
+       percentileCont(n.age, 0.5), percentileDisc(n.age, 0.5)
+$$) AS (pc4 agtype, pd4 agtype, pc5 agtype, pd5 agtype);
+
+-- function names are case-insensitive
+SELECT * FROM cypher('cypher_aggregate', $$
+MATCH (n:p)
+RETURN COUNT(DISTINCT n.dept), Count(n)
+$$) AS (d agtype, c agtype);
+
+-- no input
+SELECT * FROM cypher('cypher_aggregate', $$
+MATCH (n:p) WHERE n.age > 100
+RETURN count(*), sum(n.age), avg(n.age), max(n.age), collect(n.name)
+$$) AS (c agtype, s agtype, a agtype, m agtype, names agtype);
+
+-- items without aggregates are the grouping keys
+SELECT * FROM cypher('cypher_aggregate', $$
+MATCH (n:p)
+RETURN n.dept, count(*), sum(n.age)
+ORDER BY n.dept
+$$) AS (dept agtype, c agtype, s agtype);
+
+SELECT * FROM cypher('cypher_aggregate', $$
+MATCH (n:p)
+RETURN n.dept, max(n.age) - min(n.age) AS age_range
+ORDER BY n.dept
+$$) AS (dept agtype, age_range agtype);
+
+SELECT * FROM cypher('cypher_aggregate', $$
+MATCH (n:p)
+WITH n.dept AS dept, sum(n.age) AS s WHERE s > 40
+RETURN dept, s
+$$) AS (dept agtype, s agtype);
+
+-- unknown function (should fail)
+SELECT * FROM cypher('cypher_aggregate', $$
+RETURN foo(1)
+$$) AS (a agtype);
+
+-- aggregates are not allowed in WHERE (should fail)
+SELECT * FROM cypher('cypher_aggregate', $$
+MATCH (n:p) WHERE count(*) > 1
+RETURN n
+$$) AS (n agtype);
+
+-- percentile must be between 0 and 1 (should fail)
+SELECT * FROM cypher('cypher_aggregate', $$
+MATCH (n:p)
+RETURN percentileCont(n.age, 1.5)
+$$) AS (p agtype);
+
+-- sum() and avg() only take numbers (should fail)
+SELECT * FROM cypher('cypher_aggregate', $$
+MATCH (n:p)
+RETURN sum(n.name)
+$$) AS (s agtype);
+
+SELECT drop_graph('cypher_aggregate', true);
+
+-- partial aggregation in parallel workers
+
+CREATE TABLE agg_data (a agtype);
+INSERT INTO agg_data SELECT i::text::agtype FROM generate_series(1, 10000) i;
+INSERT INTO agg_data VALUES ('null'), (NULL);
+ANALYZE agg_data;
+
+SET parallel_setup_cost = 0;
+SET parallel_tuple_cost = 0;
+SET min_parallel_table_scan_size = 0;
+SET max_parallel_workers_per_gather = 1;
+
+EXPLAIN (COSTS OFF)
+SELECT agtype_count(*), agtype_sum(a), agtype_collect(a)
+FROM agg_data;
+
+SELECT agtype_count(*), agtype_count(a), agtype_sum(a), agtype_avg(a),
+       agtype_min(a), agtype_max(a)
+FROM agg_data;
+
+SELECT agtype_percentile_cont(a, '0.5'), agtype_percentile_disc(a, '0.5')
+FROM agg_data;
+
+RESET max_parallel_workers_per_gather;
+RESET min_parallel_table_scan_size;
+RESET parallel_tuple_cost;
+RESET parallel_setup_cost;
+
+SELECT agtype_collect(a) FROM agg_data WHERE a < '4';
+
+-- an integer sum that overflows int64 becomes a numeric
+SELECT agtype_sum(a), agtype_avg(a)
+FROM (VALUES ('9223372036854775807'::agtype), ('9223372036854775807'),
+             ('2')) AS t(a);
+
+-- integers and floats are compared exactly, even above 2^53
+SELECT agtype_percentile_disc(a, '1')
+FROM (VALUES ('9007199254740993'::agtype), ('9007199254740992.0'),
+             ('9007199254740992')) AS t(a);
+
+DROP TABLE agg_data;
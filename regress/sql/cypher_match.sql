@@ -33,3 +33,189 @@ $$) AS (i agtype);
 
 -- need a following RETURN clause (should fail)
 SELECT * FROM cypher('cypher_match', $$MATCH (n:v)$$) AS (a agtype);
+
+-- multi-hop patterns
+SELECT * FROM cypher('cypher_match', $$
+CREATE (:v1 {id: 'initial'})-[:e1 {id: 'initial-middle'}]->(:v1 {id: 'middle'})-[:e1 {id: 'middle-end'}]->(:v1 {id: 'end'})
+$$) AS (a agtype);
+
+SELECT * FROM cypher('cypher_match', $$
+MATCH (a:v1)-[e:e1]->(b:v1)
+RETURN a.id, e.id, b.id
+$$) AS (a agtype, e agtype, b agtype);
+
+SELECT * FROM cypher('cypher_match', $$
+MATCH (a:v1)<-[e:e1]-(b)
+RETURN a.id, e.id, b.id
+$$) AS (a agtype, e agtype, b agtype);
+
+SELECT * FROM cypher('cypher_match', $$
+MATCH (a:v1)-[e]-(b)
+RETURN a.id, e.id, b.id
+$$) AS (a agtype, e agtype, b agtype);
+
+SELECT * FROM cypher('cypher_match', $$
+MATCH (a)-[e]->(b)-[]->(c)
+RETURN a, e, c
+$$) AS (a agtype, e agtype, c agtype);
+
+SELECT * FROM cypher('cypher_match', $$
+MATCH (a:v1)-[]->(b:v1) WHERE b.id = 'end'
+RETURN a.id
+$$) AS (a agtype);
+
+-- the label of the other end must match
+SELECT * FROM cypher('cypher_match', $$
+MATCH (a:v1)-[e]->(b:v)
+RETURN e.id
+$$) AS (e agtype);
+
+-- edges are ordered by their ids
+SELECT * FROM cypher('cypher_match', $$
+MATCH (a:v1)-[e]-(b)
+WITH DISTINCT e ORDER BY e
+RETURN e.id
+$$) AS (e agtype);
+SELECT * FROM cypher('cypher_match', $$
+MATCH (a:v1)-[e]-(b)
+RETURN DISTINCT e ORDER BY e DESC
+$$) AS (e agtype);
+
+-- property conditions
+
+SELECT * FROM cypher('cypher_match', $$
+MATCH (n:v {i: 1})
+RETURN n.i
+$$) AS (i agtype);
+
+SELECT * FROM cypher('cypher_match', $$
+MATCH (a:v1 {id: 'initial'})-[e:e1]->(b)
+RETURN e.id, b.id
+$$) AS (e agtype, b agtype);
+
+SELECT * FROM cypher('cypher_match', $$
+MATCH (a:v1)-[:e1 {id: 'middle-end'}]->(b:v1 {id: 'end'})
+RETURN a.id
+$$) AS (a agtype);
+
+SELECT * FROM cypher('cypher_match', $$
+MATCH (a:v1)-[:e1]->(b {id: 'initial'})
+RETURN a.id
+$$) AS (a agtype);
+
+-- null never equals to anything
+SELECT * FROM cypher('cypher_match', $$
+MATCH (n:v {i: null})
+RETURN n.i
+$$) AS (i agtype);
+
+-- property indexes
+
+SELECT create_property_index('cypher_match', '_ag_label_vertex', 'i');
+SELECT tablename, indexname FROM pg_indexes
+WHERE schemaname = 'cypher_match' AND indexname LIKE '%\_i\_idx'
+ORDER BY tablename;
+
+SELECT create_property_index('cypher_match', 'v1', 'id', 'hash');
+
+SET enable_seqscan = off;
+SET enable_bitmapscan = off;
+
+EXPLAIN (COSTS OFF)
+SELECT * FROM cypher('cypher_match', $$
+MATCH (n:v) WHERE n.i = 1
+RETURN n.i
+$$) AS (i agtype);
+SELECT * FROM cypher('cypher_match', $$
+MATCH (n:v) WHERE n.i = 1
+RETURN n.i
+$$) AS (i agtype);
+
+EXPLAIN (COSTS OFF)
+SELECT * FROM cypher('cypher_match', $$
+MATCH (a:v1) WHERE a.id = 'end'
+RETURN a
+$$) AS (a agtype);
+SELECT * FROM cypher('cypher_match', $$
+MATCH (a:v1) WHERE a.id = 'end'
+RETURN a
+$$) AS (a agtype);
+
+EXPLAIN (COSTS OFF)
+SELECT * FROM cypher('cypher_match', $$
+MATCH (n:v {i: 1})
+RETURN n.i
+$$) AS (i agtype);
+
+RESET enable_bitmapscan;
+
+-- property conditions are also containment quals that GIN indexes can serve
+DROP INDEX cypher_match.v_i_idx;
+CREATE INDEX ON cypher_match.v USING gin (properties);
+
+EXPLAIN (COSTS OFF)
+SELECT * FROM cypher('cypher_match', $$
+MATCH (n:v {i: 1})
+RETURN n.i
+$$) AS (i agtype);
+SELECT * FROM cypher('cypher_match', $$
+MATCH (n:v {i: 1})
+RETURN n.i
+$$) AS (i agtype);
+
+RESET enable_seqscan;
+
+-- only btree and hash indexes are supported (should fail)
+SELECT create_property_index('cypher_match', 'v', 'i', 'gin');
+
+-- parallel scans
+
+SET parallel_setup_cost = 0;
+SET parallel_tuple_cost = 0;
+SET min_parallel_table_scan_size = 0;
+SET max_parallel_workers_per_gather = 1;
+
+EXPLAIN (COSTS OFF)
+SELECT * FROM cypher('cypher_match', $$
+MATCH (a:v1)
+RETURN a
+$$) AS (a agtype);
+
+-- each worker expands the vertices that it scans
+EXPLAIN (COSTS OFF)
+SELECT * FROM cypher('cypher_match', $$
+MATCH (a:v1)-[e:e1]->(b:v1)
+RETURN a.id, e.id, b.id
+$$) AS (a agtype, e agtype, b agtype);
+
+-- the tables of all vertex labels are scanned by a Parallel Append
+EXPLAIN (COSTS OFF)
+SELECT * FROM cypher('cypher_match', $$
+MATCH (a)-[e]->(b)
+RETURN a.id, e.id, b.id
+$$) AS (a agtype, e agtype, b agtype);
+
+RESET max_parallel_workers_per_gather;
+RESET min_parallel_table_scan_size;
+RESET parallel_tuple_cost;
+RESET parallel_setup_cost;
+
+-- a relationship never matches an edge that another one has matched
+
+SELECT create_graph('cypher_match_unique');
+
+SELECT * FROM cypher('cypher_match_unique', $$
+CREATE (:v {id: 'a'})-[:e]->(:v {id: 'b'})
+$$) AS (a agtype);
+
+SELECT * FROM cypher('cypher_match_unique', $$
+MATCH (x)-[e1]-(y)
+RETURN x.id, y.id
+$$) AS (x agtype, y agtype);
+
+SELECT * FROM cypher('cypher_match_unique', $$
+MATCH (x)-[e1]-(y)-[e2]-(z)
+RETURN x, e1, y, e2, z
+$$) AS (x agtype, e1 agtype, y agtype, e2 agtype, z agtype);
+
+SELECT drop_graph('cypher_match_unique', true);
@@ -0,0 +1,162 @@
+/*
+ * Copyright 2020 Bitnine Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+LOAD 'agensgraph';
+SET search_path TO ag_catalog;
+
+SELECT create_graph('cypher_vle');
+
+SELECT * FROM cypher('cypher_vle', $$
+CREATE (:n {name: 'a'})-[:r]->(:n {name: 'b'})-[:r]->(:n {name: 'c'})-[:r]->(:n {name: 'd'})
+$$) AS (a agtype);
+SELECT * FROM cypher('cypher_vle', $$
+CREATE (:n {name: 'x'})-[:r]->(:n {name: 'y'})<-[:r]-(:n {name: 'z'})
+$$) AS (a agtype);
+
+-- variable-length relationships
+
+SELECT * FROM cypher('cypher_vle', $$
+MATCH (s:n)-[:r*1..2]->(t) WHERE s.name = 'a'
+RETURN t.name
+$$) AS (name agtype);
+
+SELECT * FROM cypher('cypher_vle', $$
+MATCH (s:n)-[:r*]->(t) WHERE s.name = 'a'
+RETURN t.name
+$$) AS (name agtype);
+
+SELECT * FROM cypher('cypher_vle', $$
+MATCH (s:n)-[:r*0..1]->(t) WHERE s.name = 'a'
+RETURN t.name
+$$) AS (name agtype);
+
+SELECT * FROM cypher('cypher_vle', $$
+MATCH (s:n)-[:r*2]->(t) WHERE s.name = 'a'
+RETURN t.name
+$$) AS (name agtype);
+
+SELECT * FROM cypher('cypher_vle', $$
+MATCH (s:n)<-[:r*]-(t) WHERE s.name = 'd'
+RETURN t.name
+$$) AS (name agtype);
+
+-- an edge appears at most once in a path
+SELECT * FROM cypher('cypher_vle', $$
+MATCH (s:n)-[:r*2]-(t) WHERE s.name = 'b'
+RETURN t.name
+$$) AS (name agtype);
+
+SELECT * FROM cypher('cypher_vle', $$
+MATCH (s:n)-[:r*]->(t)
+RETURN count(*)
+$$) AS (c agtype);
+
+-- nor in a pattern
+SELECT * FROM cypher('cypher_vle', $$
+MATCH (s:n)-[:r*..1]-(t)-[:r]->(u) WHERE s.name = 'y'
+RETURN t.name, u.name
+$$) AS (t agtype, u agtype);
+SELECT * FROM cypher('cypher_vle', $$
+MATCH (s:n)-[:r*..1]-(t)-[:r]->(u) WHERE s.name = 'b'
+RETURN t.name, u.name
+$$) AS (t agtype, u agtype);
+SELECT * FROM cypher('cypher_vle', $$
+MATCH (s:n)-[:r*..1]-(t)-[:r*..1]-(u) WHERE s.name = 'b'
+RETURN t.name, u.name
+$$) AS (t agtype, u agtype);
+
+EXPLAIN (COSTS OFF)
+SELECT * FROM cypher('cypher_vle', $$
+MATCH (s:n)-[:r*]->(t)
+RETURN t.name
+$$) AS (name agtype);
+
+-- shortest paths
+
+SELECT * FROM cypher('cypher_vle', $$
+MATCH shortestPath((s:n)-[:r*]-(t)) WHERE s.name = 'a'
+RETURN t.name
+$$) AS (name agtype);
+
+SELECT * FROM cypher('cypher_vle', $$
+MATCH shortestPath((s:n)-[:r*0..2]-(t)) WHERE s.name = 'y'
+RETURN t.name
+$$) AS (name agtype);
+
+SELECT * FROM cypher('cypher_vle', $$
+MATCH shortestPath((s:n)-[:r]->(t)) WHERE s.name = 'a'
+RETURN t.name
+$$) AS (name agtype);
+
+SELECT * FROM cypher('cypher_vle', $$
+MATCH shortestPath((s:n)-[:r*]-(t))
+RETURN count(*)
+$$) AS (c agtype);
+
+-- limits
+
+SET agensgraph.cypher_vle_max_hops = 2;
+SELECT * FROM cypher('cypher_vle', $$
+MATCH (s:n)-[:r*]->(t) WHERE s.name = 'a'
+RETURN t.name
+$$) AS (name agtype);
+RESET agensgraph.cypher_vle_max_hops;
+
+-- too many rows for a vertex (should fail)
+SET agensgraph.cypher_vle_max_rows = 2;
+SELECT * FROM cypher('cypher_vle', $$
+MATCH (s:n)-[:r*]->(t) WHERE s.name = 'a'
+RETURN t.name
+$$) AS (name agtype);
+RESET agensgraph.cypher_vle_max_rows;
+
+-- invalid patterns (should fail)
+
+SELECT * FROM cypher('cypher_vle', $$
+MATCH (s:n)-[e:r*]->(t)
+RETURN t
+$$) AS (t agtype);
+
+SELECT * FROM cypher('cypher_vle', $$
+MATCH (s:n)-[:r*3..1]->(t)
+RETURN t
+$$) AS (t agtype);
+
+SELECT * FROM cypher('cypher_vle', $$
+MATCH shortestPath((s:n)-[:r*2..]-(t))
+RETURN t
+$$) AS (t agtype);
+
+SELECT * FROM cypher('cypher_vle', $$
+MATCH shortestPath((s:n)-[:r*2]-(t))
+RETURN t
+$$) AS (t agtype);
+
+SELECT * FROM cypher('cypher_vle', $$
+MATCH shortestPath((s:n)-[:r]->(t)-[:r]->(u))
+RETURN u
+$$) AS (u agtype);
+
+SELECT * FROM cypher('cypher_vle', $$
+MATCH allShortestPaths((s:n)-[:r*]-(t))
+RETURN t
+$$) AS (t agtype);
+
+SELECT * FROM cypher('cypher_vle', $$
+CREATE (:n)-[:r*2]->(:n)
+$$) AS (a agtype);
+
+SELECT drop_graph('cypher_vle', true);
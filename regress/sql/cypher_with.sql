@@ -30,4 +30,85 @@ WITH 1 + 1
 RETURN i
 $$) AS (i int);
 
+-- vertices passed through WITH
+
+SELECT * FROM cypher('cypher_with', $$CREATE (:v {i: 2})$$) AS (a agtype);
+SELECT * FROM cypher('cypher_with', $$CREATE (:v {i: 1})$$) AS (a agtype);
+SELECT * FROM cypher('cypher_with', $$CREATE (:v {i: 3})$$) AS (a agtype);
+
+SELECT * FROM cypher('cypher_with', $$
+MATCH (n:v)
+WITH n WHERE n.i < 3
+RETURN n ORDER BY n.i
+$$) AS (n agtype);
+
+SELECT * FROM cypher('cypher_with', $$
+MATCH (n:v)
+WITH n AS m WHERE m.i > 1
+RETURN m.i ORDER BY m.i
+$$) AS (i agtype);
+
+SELECT * FROM cypher('cypher_with', $$
+MATCH (n:v)
+WITH n WHERE n.i < 3
+WITH n WHERE n.i > 1
+RETURN n.i, n
+$$) AS (i agtype, n agtype);
+
+SELECT * FROM cypher('cypher_with', $$
+MATCH (n:v)
+WITH n, count(*) AS c
+RETURN n.i, c ORDER BY n.i
+$$) AS (i agtype, c agtype);
+
+-- items named like the id and the properties of a vertex
+SELECT * FROM cypher('cypher_with', $$
+MATCH (n:v)
+WITH n, n.i AS `n.id`, n.i AS `n.properties`
+WITH n, `n.id` WHERE n.i < 2
+RETURN n, `n.id`
+$$) AS (n agtype, i agtype);
+
+-- SKIP and LIMIT
+
+SELECT * FROM cypher('cypher_with', $$
+MATCH (n:v)
+RETURN n.i ORDER BY n.i SKIP 1 LIMIT 1
+$$) AS (i agtype);
+
+SELECT * FROM cypher('cypher_with', $$
+MATCH (n:v)
+WITH n ORDER BY n.i LIMIT 2
+RETURN n
+$$) AS (n agtype);
+SELECT * FROM cypher('cypher_with', $$
+MATCH (n:v)
+WITH n WHERE n.i < 3
+WITH n ORDER BY n.i DESC LIMIT 1
+RETURN n.i, n
+$$) AS (i agtype, n agtype);
+-- the Limit right above the Sort bounds it
+EXPLAIN (COSTS OFF)
+SELECT * FROM cypher('cypher_with', $$
+MATCH (n:v)
+WITH n ORDER BY n.i LIMIT 2
+RETURN n
+$$) AS (n agtype);
+
+-- a constant LIMIT bounds the sort, which can be an index scan
+SELECT create_property_index('cypher_with', 'v', 'i');
+SET enable_seqscan = off;
+EXPLAIN (COSTS OFF)
+SELECT * FROM cypher('cypher_with', $$
+MATCH (n:v)
+RETURN n ORDER BY n.i DESC LIMIT 1
+$$) AS (n agtype);
+RESET enable_seqscan;
+
+-- LIMIT must be an integer (should fail)
+SELECT * FROM cypher('cypher_with', $$
+MATCH (n:v)
+RETURN n LIMIT 'a'
+$$) AS (n agtype);
+
 SELECT drop_graph('cypher_with', true);
@@ -42,3 +42,6 @@ EXPLAIN (COSTS FALSE) SELECT * FROM graphid_table WHERE gid = '1';
 EXPLAIN (COSTS FALSE) SELECT * FROM graphid_table WHERE gid > '0';
 SET enable_seqscan = ON;
 DROP TABLE graphid_table;
+
+-- binary output
+SELECT graphid_send('844424930131969'), graphid_send('-1');
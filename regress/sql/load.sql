@@ -0,0 +1,57 @@
+/*
+ * Copyright 2020 Bitnine Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+LOAD 'agensgraph';
+SET search_path TO ag_catalog;
+
+SELECT create_graph('load');
+
+-- write the files to load in the data directory
+DO $$
+DECLARE
+    dir text := current_setting('data_directory');
+BEGIN
+    EXECUTE format('COPY (SELECT * FROM (VALUES (%L, %L), (%L, %L), (%L, NULL)) AS t(id, name)) TO %L WITH (FORMAT csv, HEADER)',
+                   '1', 'Alice', '2', 'Bob', '3', dir || '/load_person.csv');
+    EXECUTE format('COPY (SELECT * FROM (VALUES (%L, %L, %L, %L, %L), (%L, %L, %L, %L, NULL)) AS t(start_id, start_vertex_type, end_id, end_vertex_type, since)) TO %L WITH (FORMAT csv, HEADER)',
+                   '1', 'person', '2', 'person', '2010',
+                   '2', 'person', '3', 'person', dir || '/load_knows.csv');
+END
+$$;
+
+-- edges refer to the vertices loaded in the same transaction
+BEGIN;
+SELECT load_labels_from_file('load', 'person', 'load_person.csv');
+SELECT load_edges_from_file('load', 'knows', 'load_knows.csv');
+COMMIT;
+
+SELECT * FROM cypher('load', $$
+MATCH (a:person)-[e:knows]->(b:person)
+RETURN a.id, a.name, e.since, b.id, b.name
+ORDER BY a.id
+$$) AS (a_id agtype, a_name agtype, since agtype, b_id agtype, b_name agtype);
+
+-- the label has rows now, so the index entries are inserted as it loads
+SELECT load_labels_from_file('load', 'person', 'load_person.csv');
+SELECT count(*) FROM load.person;
+
+-- the vertices were loaded by another transaction (should fail)
+SELECT load_edges_from_file('load', 'knows', 'load_knows.csv');
+
+-- the label must be of the right kind (should fail)
+SELECT load_labels_from_file('load', 'knows', 'load_person.csv');
+
+SELECT drop_graph('load', true);
@@ -19,9 +19,13 @@
 #include "fmgr.h"
 
 #include "catalog/ag_catalog.h"
+#include "commands/analyze_commands.h"
 #include "nodes/ag_nodes.h"
+#include "optimizer/cypher_createplan.h"
 #include "optimizer/cypher_paths.h"
 #include "parser/cypher_analyze.h"
+#include "utils/ag_guc.h"
+#include "utils/ag_stat.h"
 
 PG_MODULE_MAGIC;
 
@@ -29,16 +33,22 @@ void _PG_init(void);
 
 void _PG_init(void)
 {
+    define_config_params();
     register_ag_nodes();
+    register_cypher_scan_methods();
     set_rel_pathlist_init();
     object_access_hook_init();
     post_parse_analyze_init();
+    process_utility_hook_init();
+    ag_stat_init();
 }
 
 void _PG_fini(void);
 
 void _PG_fini(void)
 {
+    ag_stat_fini();
+    process_utility_hook_fini();
     post_parse_analyze_fini();
     object_access_hook_fini();
     set_rel_pathlist_fini();
@@ -24,8 +24,10 @@
 
 #include "catalog/ag_catalog.h"
 #include "catalog/ag_label.h"
+#include "catalog/ag_label_stats.h"
 #include "catalog/ag_namespace.h"
 #include "utils/ag_cache.h"
+#include "utils/ag_stat.h"
 
 static object_access_hook_type prev_object_access_hook;
 
@@ -111,6 +113,8 @@ static void object_access(ObjectAccessType access, Oid class_id, Oid object_id,
              * drop_graph().
              */
             delete_label(object_id);
+            delete_label_stats(object_id);
+            ag_stat_forget_label(object_id);
         }
         else
         {
@@ -29,6 +29,7 @@
 #include "utils/builtins.h"
 #include "utils/fmgroids.h"
 #include "utils/lsyscache.h"
+#include "utils/memutils.h"
 #include "utils/rel.h"
 #include "utils/relcache.h"
 
@@ -38,6 +39,9 @@
 #include "utils/ag_cache.h"
 #include "utils/graphid.h"
 
+static void set_label_name(label_name_table *table, int32 label_id,
+                           const char *name);
+
 // INSERT INTO ag_catalog.ag_label
 // VALUES (label_name, label_graph, label_id, label_kind, label_relation)
 Oid insert_label(const char *label_name, Oid label_graph, int32 label_id,
@@ -190,6 +194,116 @@ Datum _label_name(PG_FUNCTION_ARGS)
     PG_RETURN_CSTRING(label_name);
 }
 
+/*
+ * Builds the label_name_table of the given graph with all the labels that
+ * exist now. It reads ag_label once so that callers which turn many graphids
+ * into label names do not need a cache lookup per graphid.
+ */
+label_name_table *make_label_name_table(Oid graph, MemoryContext mcxt)
+{
+    ScanKeyData scan_keys[1];
+    Relation ag_label;
+    SysScanDesc scan_desc;
+    HeapTuple tuple;
+    label_name_table *table;
+
+    table = MemoryContextAllocZero(mcxt, sizeof(label_name_table));
+    table->graph = graph;
+    table->mcxt = mcxt;
+
+    ScanKeyInit(&scan_keys[0], Anum_ag_label_graph, BTEqualStrategyNumber,
+                F_OIDEQ, ObjectIdGetDatum(graph));
+
+    ag_label = heap_open(ag_label_relation_id(), AccessShareLock);
+    scan_desc = systable_beginscan(ag_label, ag_label_graph_id_index_id(),
+                                   true, NULL, 1, scan_keys);
+
+    while (HeapTupleIsValid(tuple = systable_getnext(scan_desc)))
+    {
+        Datum id;
+        Datum name;
+        bool is_null;
+
+        id = heap_getattr(tuple, Anum_ag_label_id, RelationGetDescr(ag_label),
+                          &is_null);
+        Assert(!is_null);
+        name = heap_getattr(tuple, Anum_ag_label_name,
+                            RelationGetDescr(ag_label), &is_null);
+        Assert(!is_null);
+
+        set_label_name(table, DatumGetInt32(id),
+                       NameStr(*DatumGetName(name)));
+    }
+
+    systable_endscan(scan_desc);
+    heap_close(ag_label, AccessShareLock);
+
+    return table;
+}
+
+/*
+ * Returns the name of the label and its length in len. Labels created after
+ * the table was built are looked up in the label cache and added to it.
+ */
+char *lookup_label_name(label_name_table *table, int32 label_id, int *len)
+{
+    label_cache_data *cache_data;
+
+    if (label_id < table->size && table->names[label_id])
+    {
+        *len = table->name_lens[label_id];
+        return table->names[label_id];
+    }
+
+    cache_data = search_label_graph_id_cache(table->graph, label_id);
+    if (!cache_data)
+    {
+        ereport(ERROR, (errcode(ERRCODE_UNDEFINED_OBJECT),
+                        errmsg("label with id %d does not exist", label_id)));
+    }
+
+    set_label_name(table, label_id, NameStr(cache_data->name));
+
+    *len = table->name_lens[label_id];
+    return table->names[label_id];
+}
+
+static void set_label_name(label_name_table *table, int32 label_id,
+                           const char *name)
+{
+    if (label_id >= table->size)
+    {
+        int32 new_size = Max(table->size, 16);
+
+        while (new_size <= label_id)
+            new_size *= 2;
+
+        if (table->size == 0)
+        {
+            table->names = MemoryContextAllocZero(table->mcxt,
+                                                  sizeof(char *) * new_size);
+            table->name_lens = MemoryContextAllocZero(table->mcxt,
+                                                      sizeof(int) * new_size);
+        }
+        else
+        {
+            table->names = repalloc(table->names, sizeof(char *) * new_size);
+            table->name_lens = repalloc(table->name_lens,
+                                        sizeof(int) * new_size);
+            MemSet(table->names + table->size, 0,
+                   sizeof(char *) * (new_size - table->size));
+        }
+
+        table->size = new_size;
+    }
+
+    if (IS_AG_DEFAULT_LABEL(name))
+        name = "";
+
+    table->names[label_id] = MemoryContextStrdup(table->mcxt, name);
+    table->name_lens[label_id] = strlen(name);
+}
+
 PG_FUNCTION_INFO_V1(_label_id);
 
 Datum _label_id(PG_FUNCTION_ARGS)
@@ -0,0 +1,254 @@
+/*
+ * Copyright 2020 Bitnine Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "postgres.h"
+
+#include "access/genam.h"
+#include "access/heapam.h"
+#include "access/htup.h"
+#include "access/htup_details.h"
+#include "access/skey.h"
+#include "access/stratnum.h"
+#include "catalog/indexing.h"
+#include "catalog/pg_type_d.h"
+#include "storage/lockdefs.h"
+#include "utils/array.h"
+#include "utils/fmgroids.h"
+#include "utils/inval.h"
+#include "utils/rel.h"
+#include "utils/relcache.h"
+
+#include "catalog/ag_label_stats.h"
+#include "utils/ag_cache.h"
+#include "utils/graphid.h"
+
+static void fill_degree_stats_values(label_degree_stats *stats,
+                                     Datum *values, AttrNumber vertices_attnum);
+static void get_degree_stats(HeapTuple tuple, TupleDesc tupdesc,
+                             AttrNumber vertices_attnum,
+                             label_degree_stats *stats);
+static void copy_degree_stats(label_degree_stats *dst,
+                              const label_degree_stats *src);
+
+/*
+ * INSERT INTO ag_catalog.ag_label_stats VALUES (relation, ...)
+ * or UPDATE the row of the relation if there is one
+ */
+void store_label_stats(Oid relation, label_stats_data *stats)
+{
+    Datum values[Natts_ag_label_stats];
+    bool nulls[Natts_ag_label_stats];
+    ScanKeyData scan_keys[1];
+    Relation ag_label_stats;
+    SysScanDesc scan_desc;
+    HeapTuple cur_tuple;
+    HeapTuple new_tuple;
+
+    values[Anum_ag_label_stats_relation - 1] = ObjectIdGetDatum(relation);
+    values[Anum_ag_label_stats_edges - 1] = Float8GetDatum(stats->edges);
+    fill_degree_stats_values(&stats->out, values,
+                             Anum_ag_label_stats_start_vertices);
+    fill_degree_stats_values(&stats->in, values,
+                             Anum_ag_label_stats_end_vertices);
+    MemSet(nulls, false, sizeof(nulls));
+
+    ScanKeyInit(&scan_keys[0], Anum_ag_label_stats_relation,
+                BTEqualStrategyNumber, F_OIDEQ, ObjectIdGetDatum(relation));
+
+    ag_label_stats = heap_open(ag_label_stats_relation_id(), RowExclusiveLock);
+    scan_desc = systable_beginscan(ag_label_stats,
+                                   ag_label_stats_relation_index_id(), true,
+                                   NULL, 1, scan_keys);
+
+    new_tuple = heap_form_tuple(RelationGetDescr(ag_label_stats), values,
+                                nulls);
+
+    cur_tuple = systable_getnext(scan_desc);
+    if (HeapTupleIsValid(cur_tuple))
+        CatalogTupleUpdate(ag_label_stats, &cur_tuple->t_self, new_tuple);
+    else
+        CatalogTupleInsert(ag_label_stats, new_tuple);
+
+    systable_endscan(scan_desc);
+    heap_close(ag_label_stats, RowExclusiveLock);
+
+    // the label stats cache is invalidated along with the relation
+    CacheInvalidateRelcacheByRelid(relation);
+}
+
+/*
+ * The columns of the degree statistics of an end of the edges are in the
+ * order of the fields of label_degree_stats, starting at vertices_attnum.
+ */
+static void fill_degree_stats_values(label_degree_stats *stats,
+                                     Datum *values, AttrNumber vertices_attnum)
+{
+    int i = vertices_attnum - 1;
+    Datum *heavy_degrees;
+    int j;
+
+    values[i++] = Float8GetDatum(stats->vertices);
+    values[i++] = Float8GetDatum(stats->avg_degree);
+    values[i++] = Float8GetDatum(stats->max_degree);
+
+    if (stats->num_heavy == 0)
+    {
+        values[i++] = PointerGetDatum(construct_empty_array(GRAPHIDOID));
+        values[i++] = PointerGetDatum(construct_empty_array(FLOAT8OID));
+        return;
+    }
+
+    heavy_degrees = palloc(sizeof(Datum) * stats->num_heavy);
+    for (j = 0; j < stats->num_heavy; j++)
+        heavy_degrees[j] = Float8GetDatum(stats->heavy_degrees[j]);
+
+    values[i++] = PointerGetDatum(
+        construct_array(stats->heavy_ids, stats->num_heavy, GRAPHIDOID,
+                        sizeof(graphid), FLOAT8PASSBYVAL, 'd'));
+    values[i++] = PointerGetDatum(
+        construct_array(heavy_degrees, stats->num_heavy, FLOAT8OID,
+                        sizeof(float8), FLOAT8PASSBYVAL, 'd'));
+}
+
+// DELETE FROM ag_catalog.ag_label_stats WHERE relation = relation
+void delete_label_stats(Oid relation)
+{
+    ScanKeyData scan_keys[1];
+    Relation ag_label_stats;
+    SysScanDesc scan_desc;
+    HeapTuple tuple;
+
+    ScanKeyInit(&scan_keys[0], Anum_ag_label_stats_relation,
+                BTEqualStrategyNumber, F_OIDEQ, ObjectIdGetDatum(relation));
+
+    ag_label_stats = heap_open(ag_label_stats_relation_id(), RowExclusiveLock);
+    scan_desc = systable_beginscan(ag_label_stats,
+                                   ag_label_stats_relation_index_id(), true,
+                                   NULL, 1, scan_keys);
+
+    // labels that have never been analyzed have no statistics
+    tuple = systable_getnext(scan_desc);
+    if (HeapTupleIsValid(tuple))
+        CatalogTupleDelete(ag_label_stats, &tuple->t_self);
+
+    systable_endscan(scan_desc);
+    heap_close(ag_label_stats, RowExclusiveLock);
+
+    CacheInvalidateRelcacheByRelid(relation);
+}
+
+/*
+ * Returns false if the edge label of the given relation has no statistics,
+ * that is, it has not been analyzed yet. The heavy hitters are allocated in
+ * CurrentMemoryContext.
+ */
+bool read_label_stats(Oid relation, label_stats_data *stats)
+{
+    ScanKeyData scan_keys[1];
+    Relation ag_label_stats;
+    SysScanDesc scan_desc;
+    HeapTuple tuple;
+    bool found = false;
+
+    ScanKeyInit(&scan_keys[0], Anum_ag_label_stats_relation,
+                BTEqualStrategyNumber, F_OIDEQ, ObjectIdGetDatum(relation));
+
+    ag_label_stats = heap_open(ag_label_stats_relation_id(), AccessShareLock);
+    scan_desc = systable_beginscan(ag_label_stats,
+                                   ag_label_stats_relation_index_id(), true,
+                                   NULL, 1, scan_keys);
+
+    tuple = systable_getnext(scan_desc);
+    if (HeapTupleIsValid(tuple))
+    {
+        TupleDesc tupdesc = RelationGetDescr(ag_label_stats);
+        bool is_null;
+
+        stats->edges = DatumGetFloat8(heap_getattr(
+            tuple, Anum_ag_label_stats_edges, tupdesc, &is_null));
+        get_degree_stats(tuple, tupdesc, Anum_ag_label_stats_start_vertices,
+                         &stats->out);
+        get_degree_stats(tuple, tupdesc, Anum_ag_label_stats_end_vertices,
+                         &stats->in);
+        found = true;
+    }
+
+    systable_endscan(scan_desc);
+    heap_close(ag_label_stats, AccessShareLock);
+
+    return found;
+}
+
+static void get_degree_stats(HeapTuple tuple, TupleDesc tupdesc,
+                             AttrNumber vertices_attnum,
+                             label_degree_stats *stats)
+{
+    AttrNumber attnum = vertices_attnum;
+    bool is_null;
+    Datum datum;
+    Datum *degrees;
+    int num_degrees;
+    int i;
+
+    stats->vertices = DatumGetFloat8(
+        heap_getattr(tuple, attnum++, tupdesc, &is_null));
+    stats->avg_degree = DatumGetFloat8(
+        heap_getattr(tuple, attnum++, tupdesc, &is_null));
+    stats->max_degree = DatumGetFloat8(
+        heap_getattr(tuple, attnum++, tupdesc, &is_null));
+
+    datum = heap_getattr(tuple, attnum++, tupdesc, &is_null);
+    deconstruct_array(DatumGetArrayTypeP(datum), GRAPHIDOID, sizeof(graphid),
+                      FLOAT8PASSBYVAL, 'd', &stats->heavy_ids, NULL,
+                      &stats->num_heavy);
+
+    datum = heap_getattr(tuple, attnum++, tupdesc, &is_null);
+    deconstruct_array(DatumGetArrayTypeP(datum), FLOAT8OID, sizeof(float8),
+                      FLOAT8PASSBYVAL, 'd', &degrees, NULL, &num_degrees);
+    Assert(num_degrees == stats->num_heavy);
+
+    stats->heavy_degrees = palloc(sizeof(float8) * num_degrees);
+    for (i = 0; i < num_degrees; i++)
+        stats->heavy_degrees[i] = DatumGetFloat8(degrees[i]);
+}
+
+bool get_label_stats(Oid relation, label_stats_data *stats)
+{
+    label_stats_data *cached;
+
+    cached = search_label_stats_cache(relation);
+    if (!cached)
+        return false;
+
+    stats->edges = cached->edges;
+    copy_degree_stats(&stats->out, &cached->out);
+    copy_degree_stats(&stats->in, &cached->in);
+
+    return true;
+}
+
+static void copy_degree_stats(label_degree_stats *dst,
+                              const label_degree_stats *src)
+{
+    *dst = *src;
+
+    // palloc(0) is allowed
+    dst->heavy_ids = palloc(sizeof(Datum) * src->num_heavy);
+    memcpy(dst->heavy_ids, src->heavy_ids, sizeof(Datum) * src->num_heavy);
+    dst->heavy_degrees = palloc(sizeof(float8) * src->num_heavy);
+    memcpy(dst->heavy_degrees, src->heavy_degrees,
+           sizeof(float8) * src->num_heavy);
+}
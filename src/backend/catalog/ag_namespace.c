@@ -16,11 +16,19 @@
 
 #include "postgres.h"
 
-#include "catalog/namespace.h"
-
 #include "catalog/ag_namespace.h"
+#include "utils/ag_cache.h"
 
 Oid ag_catalog_namespace_id(void)
 {
-    return get_namespace_oid("ag_catalog", false);
+    Oid namespace;
+
+    namespace = search_ag_namespace_oid_cache();
+    if (!OidIsValid(namespace))
+    {
+        ereport(ERROR, (errcode(ERRCODE_UNDEFINED_SCHEMA),
+                        errmsg("schema \"%s\" does not exist", "ag_catalog")));
+    }
+
+    return namespace;
 }
@@ -0,0 +1,284 @@
+/*
+ * Copyright 2020 Bitnine Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "postgres.h"
+
+#include "access/genam.h"
+#include "access/heapam.h"
+#include "access/htup_details.h"
+#include "catalog/namespace.h"
+#include "catalog/pg_class.h"
+#include "catalog/pg_inherits.h"
+#include "catalog/pg_statistic.h"
+#include "commands/vacuum.h"
+#include "nodes/parsenodes.h"
+#include "nodes/pg_list.h"
+#include "storage/lockdefs.h"
+#include "tcop/utility.h"
+#include "utils/lsyscache.h"
+#include "utils/rel.h"
+#include "utils/syscache.h"
+
+#include "catalog/ag_label.h"
+#include "catalog/ag_label_stats.h"
+#include "commands/analyze_commands.h"
+#include "utils/ag_cache.h"
+
+static ProcessUtility_hook_type prev_process_utility_hook;
+
+static void process_utility(PlannedStmt *pstmt, const char *queryString,
+                            ProcessUtilityContext context,
+                            ParamListInfo params, QueryEnvironment *queryEnv,
+                            DestReceiver *dest, char *completionTag);
+static void analyze_labels(VacuumStmt *stmt);
+static List *get_edge_label_relations(void);
+static void analyze_label(Oid relid);
+static bool compute_degree_stats(Oid relid, AttrNumber attnum, bool inh,
+                                 float8 edges, label_degree_stats *stats);
+static float8 get_reltuples(Oid relid);
+
+void process_utility_hook_init(void)
+{
+    prev_process_utility_hook = ProcessUtility_hook;
+    ProcessUtility_hook = process_utility;
+}
+
+void process_utility_hook_fini(void)
+{
+    ProcessUtility_hook = prev_process_utility_hook;
+}
+
+/*
+ * ANALYZE computes the statistics of the start_id and end_id columns of edge
+ * label tables. Once it is done, the degrees of the vertices are derived from
+ * them and stored in ag_label_stats for the planner.
+ */
+static void process_utility(PlannedStmt *pstmt, const char *queryString,
+                            ProcessUtilityContext context,
+                            ParamListInfo params, QueryEnvironment *queryEnv,
+                            DestReceiver *dest, char *completionTag)
+{
+    Node *parsetree = pstmt->utilityStmt;
+
+    if (prev_process_utility_hook)
+        prev_process_utility_hook(pstmt, queryString, context, params,
+                                  queryEnv, dest, completionTag);
+    else
+        standard_ProcessUtility(pstmt, queryString, context, params, queryEnv,
+                                dest, completionTag);
+
+    if (IsA(parsetree, VacuumStmt) &&
+        (((VacuumStmt *)parsetree)->options & VACOPT_ANALYZE))
+        analyze_labels((VacuumStmt *)parsetree);
+}
+
+static void analyze_labels(VacuumStmt *stmt)
+{
+    List *relids = NIL;
+    ListCell *lc;
+
+    // the extension may not be installed in this database
+    if (!OidIsValid(search_ag_namespace_oid_cache()))
+        return;
+
+    if (stmt->rels == NIL)
+    {
+        relids = get_edge_label_relations();
+    }
+    else
+    {
+        foreach (lc, stmt->rels)
+        {
+            VacuumRelation *vrel = lfirst(lc);
+            Oid relid;
+
+            relid = RangeVarGetRelid(vrel->relation, NoLock, true);
+            if (OidIsValid(relid))
+                relids = lappend_oid(relids, relid);
+        }
+    }
+
+    foreach (lc, relids)
+        analyze_label(lfirst_oid(lc));
+}
+
+// SELECT relation FROM ag_catalog.ag_label WHERE kind = 'e'
+static List *get_edge_label_relations(void)
+{
+    List *relids = NIL;
+    Relation ag_label;
+    SysScanDesc scan_desc;
+    HeapTuple tuple;
+
+    ag_label = heap_open(ag_label_relation_id(), AccessShareLock);
+    scan_desc = systable_beginscan(ag_label, InvalidOid, false, NULL, 0, NULL);
+
+    while (HeapTupleIsValid(tuple = systable_getnext(scan_desc)))
+    {
+        TupleDesc tupdesc = RelationGetDescr(ag_label);
+        bool is_null;
+        char kind;
+
+        kind = DatumGetChar(
+            heap_getattr(tuple, Anum_ag_label_kind, tupdesc, &is_null));
+        if (kind != LABEL_KIND_EDGE)
+            continue;
+
+        relids = lappend_oid(relids,
+                             DatumGetObjectId(heap_getattr(
+                                 tuple, Anum_ag_label_relation, tupdesc,
+                                 &is_null)));
+    }
+
+    systable_endscan(scan_desc);
+    heap_close(ag_label, AccessShareLock);
+
+    return relids;
+}
+
+/*
+ * If the relation is of an edge label, stores the degree statistics of the
+ * label. A label that has child labels uses the statistics that ANALYZE
+ * computes for the whole inheritance tree, the same set of tables that MATCH
+ * looks up edges in.
+ */
+static void analyze_label(Oid relid)
+{
+    label_cache_data *label_cache;
+    label_stats_data stats;
+    bool inh;
+    List *relids;
+    ListCell *lc;
+
+    label_cache = search_label_relation_cache(relid);
+    if (!label_cache || label_cache->kind != LABEL_KIND_EDGE)
+        return;
+
+    inh = has_subclass(relid);
+
+    stats.edges = 0;
+    relids = find_all_inheritors(relid, AccessShareLock, NULL);
+    foreach (lc, relids)
+        stats.edges += get_reltuples(lfirst_oid(lc));
+
+    if (stats.edges < 1 ||
+        !compute_degree_stats(relid, Anum_ag_label_edge_table_start_id, inh,
+                              stats.edges, &stats.out) ||
+        !compute_degree_stats(relid, Anum_ag_label_edge_table_end_id, inh,
+                              stats.edges, &stats.in))
+    {
+        delete_label_stats(relid);
+        return;
+    }
+
+    store_label_stats(relid, &stats);
+}
+
+/*
+ * Derives the degrees of the vertices in the given column from its
+ * statistics. The number of distinct vertices gives the average degree, and
+ * the most common values of the column are the vertices with the most edges.
+ * The vertices that are not among them are assumed to share the rest of the
+ * edges evenly.
+ */
+static bool compute_degree_stats(Oid relid, AttrNumber attnum, bool inh,
+                                 float8 edges, label_degree_stats *stats)
+{
+    HeapTuple stats_tuple;
+    float8 stadistinct;
+    float8 vertices;
+    AttStatsSlot sslot;
+    float8 heavy_edges = 0;
+    float8 rest_degree;
+    int i;
+
+    stats_tuple = SearchSysCache3(STATRELATTINH, ObjectIdGetDatum(relid),
+                                  Int16GetDatum(attnum), BoolGetDatum(inh));
+    if (!HeapTupleIsValid(stats_tuple))
+        return false;
+
+    // See get_variable_numdistinct()
+    stadistinct = ((Form_pg_statistic)GETSTRUCT(stats_tuple))->stadistinct;
+    if (stadistinct > 0.0)
+        vertices = stadistinct;
+    else if (stadistinct < 0.0)
+        vertices = -stadistinct * edges;
+    else
+    {
+        // unknown
+        ReleaseSysCache(stats_tuple);
+        return false;
+    }
+    vertices = rint(vertices);
+    if (vertices < 1)
+        vertices = 1;
+    else if (vertices > edges)
+        vertices = edges;
+
+    stats->vertices = vertices;
+    stats->avg_degree = edges / vertices;
+
+    stats->num_heavy = 0;
+    stats->heavy_ids = NULL;
+    stats->heavy_degrees = NULL;
+    if (get_attstatsslot(&sslot, stats_tuple, STATISTIC_KIND_MCV, InvalidOid,
+                         ATTSTATSSLOT_VALUES | ATTSTATSSLOT_NUMBERS))
+    {
+        // graphid is passed by value
+        stats->num_heavy = sslot.nvalues;
+        stats->heavy_ids = palloc(sizeof(Datum) * sslot.nvalues);
+        stats->heavy_degrees = palloc(sizeof(float8) * sslot.nvalues);
+        for (i = 0; i < sslot.nvalues; i++)
+        {
+            stats->heavy_ids[i] = sslot.values[i];
+            stats->heavy_degrees[i] = sslot.numbers[i] * edges;
+            heavy_edges += stats->heavy_degrees[i];
+        }
+
+        free_attstatsslot(&sslot);
+    }
+
+    ReleaseSysCache(stats_tuple);
+
+    if (vertices > stats->num_heavy)
+        rest_degree = Max(edges - heavy_edges, 0) /
+                      (vertices - stats->num_heavy);
+    else
+        rest_degree = 0;
+
+    if (stats->num_heavy > 0)
+        stats->max_degree = Max(stats->heavy_degrees[0], rest_degree);
+    else
+        stats->max_degree = rest_degree;
+
+    return true;
+}
+
+static float8 get_reltuples(Oid relid)
+{
+    HeapTuple tuple;
+    float8 reltuples;
+
+    tuple = SearchSysCache1(RELOID, ObjectIdGetDatum(relid));
+    if (!HeapTupleIsValid(tuple))
+        return 0;
+
+    reltuples = ((Form_pg_class)GETSTRUCT(tuple))->reltuples;
+
+    ReleaseSysCache(tuple);
+
+    return reltuples;
+}
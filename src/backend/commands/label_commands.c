@@ -22,6 +22,8 @@
 #include "catalog/namespace.h"
 #include "catalog/objectaddress.h"
 #include "catalog/pg_class_d.h"
+#include "catalog/pg_inherits.h"
+#include "commands/cluster.h"
 #include "commands/defrem.h"
 #include "commands/sequence.h"
 #include "commands/tablecmds.h"
@@ -46,7 +48,9 @@
 #include "catalog/ag_graph.h"
 #include "catalog/ag_label.h"
 #include "commands/label_commands.h"
+#include "parser/cypher_expr.h"
 #include "utils/ag_cache.h"
+#include "utils/ag_guc.h"
 #include "utils/agtype.h"
 #include "utils/graphid.h"
 
@@ -69,6 +73,16 @@ static List *create_vertex_table_elements(char *graph_name, char *label_name,
                                           char *schema_name, char *rel_name,
                                           char *seq_name);
 static void create_sequence_for_label(RangeVar *seq_range_var);
+static void create_pk_for_label(char *schema_name, char *rel_name);
+static void create_adjacency_indexes_for_label(char *schema_name,
+                                               char *rel_name, Oid nsp_id,
+                                               Oid relid);
+static void create_index_for_label(char *schema_name, char *rel_name,
+                                   char *idx_name, List *key_names,
+                                   List *include_names, bool primary);
+static void create_property_index_for_label(Oid relid, char *property_name,
+                                            char *access_method);
+static void define_index(IndexStmt *index_stmt);
 static Constraint *build_pk_constraint(void);
 static Constraint *build_id_default(char *graph_name, char *label_name,
                                     char *schema_name, char *seq_name);
@@ -132,10 +146,21 @@ Oid create_label(char *graph_name, char *label_name, char label_type,
     // record the new label in ag_label
     relation_id = get_relname_relid(rel_name, nsp_id);
 
-    // If a label has parents, switch the parents id default, with its own.
+    /*
+     * If a label has parents, switch the parents id default, with its own.
+     * Indexes are not inherited, so the label needs its own primary key.
+     */
     if (list_length(parents) != 0)
+    {
         change_label_id_default(graph_name, label_name, schema_name, seq_name,
                                 relation_id);
+        create_pk_for_label(schema_name, rel_name);
+    }
+
+    // edges are looked up by the vertices at their ends
+    if (label_type == LABEL_TYPE_EDGE)
+        create_adjacency_indexes_for_label(schema_name, rel_name, nsp_id,
+                                           relation_id);
 
     // associate the sequence with the "id" column
     alter_sequence_owned_by_for_label(seq_range_var, rel_name);
@@ -278,6 +303,8 @@ static void create_sequence_for_label(RangeVar *seq_range_var)
     CreateSeqStmt *seq_stmt;
     char buf[32]; // greater than MAXINT8LEN+1
     DefElem *maxvalue;
+    DefElem *increment;
+    DefElem *start;
 
     pstate = make_parsestate(NULL);
     pstate->p_sourcetext = "(generated CREATE SEQUENCE command)";
@@ -286,7 +313,14 @@ static void create_sequence_for_label(RangeVar *seq_range_var)
     seq_stmt->sequence = seq_range_var;
     pg_lltoa(ENTRY_ID_MAX, buf);
     maxvalue = makeDefElem("maxvalue", (Node *)makeFloat(pstrdup(buf)), -1);
-    seq_stmt->options = list_make1(maxvalue);
+    /*
+     * The sequence holds the last entry ID reserved by any backend, and each
+     * nextval() reserves a block of IDs. See next_entry_id().
+     */
+    increment = makeDefElem("increment",
+                            (Node *)makeInteger(entry_id_block_size), -1);
+    start = makeDefElem("start", (Node *)makeInteger(entry_id_block_size), -1);
+    seq_stmt->options = list_make3(maxvalue, increment, start);
     seq_stmt->ownerId = InvalidOid;
     seq_stmt->for_identity = false;
     seq_stmt->if_not_exists = false;
@@ -295,6 +329,184 @@ static void create_sequence_for_label(RangeVar *seq_range_var)
     CommandCounterIncrement();
 }
 
+// ALTER TABLE `schema_name`.`rel_name` ADD PRIMARY KEY ("id")
+static void create_pk_for_label(char *schema_name, char *rel_name)
+{
+    create_index_for_label(schema_name, rel_name, NULL,
+                           list_make1(makeString("id")), NIL, true);
+}
+
+/*
+ * CREATE INDEX ON `schema_name`.`rel_name` ("start_id", "end_id")
+ *   INCLUDE ("id")
+ * CREATE INDEX ON `schema_name`.`rel_name` ("end_id", "start_id")
+ *   INCLUDE ("id")
+ * ALTER TABLE `schema_name`.`rel_name` CLUSTER ON `start_id index`
+ *
+ * Each index is the sorted adjacency list of the vertices, (other end, edge
+ * id) for every vertex, in one direction. The table is marked to be clustered
+ * on the outgoing one so that CLUSTER stores the edges of a vertex together.
+ */
+static void create_adjacency_indexes_for_label(char *schema_name,
+                                               char *rel_name, Oid nsp_id,
+                                               Oid relid)
+{
+    char *start_idx_name;
+    char *end_idx_name;
+    Relation rel;
+
+    start_idx_name = ChooseRelationName(rel_name, "start_id", "idx", nsp_id,
+                                        false);
+    create_index_for_label(
+        schema_name, rel_name, start_idx_name,
+        list_make2(makeString("start_id"), makeString("end_id")),
+        list_make1(makeString("id")), false);
+
+    end_idx_name = ChooseRelationName(rel_name, "end_id", "idx", nsp_id,
+                                      false);
+    create_index_for_label(
+        schema_name, rel_name, end_idx_name,
+        list_make2(makeString("end_id"), makeString("start_id")),
+        list_make1(makeString("id")), false);
+
+    rel = heap_open(relid, AccessExclusiveLock);
+    mark_index_clustered(rel, get_relname_relid(start_idx_name, nsp_id),
+                         true);
+    heap_close(rel, NoLock);
+
+    CommandCounterIncrement();
+}
+
+static void create_index_for_label(char *schema_name, char *rel_name,
+                                   char *idx_name, List *key_names,
+                                   List *include_names, bool primary)
+{
+    IndexStmt *index_stmt;
+    ListCell *lc;
+
+    index_stmt = makeNode(IndexStmt);
+    index_stmt->idxname = idx_name;
+    index_stmt->relation = makeRangeVar(schema_name, rel_name, -1);
+    index_stmt->accessMethod = DEFAULT_INDEX_TYPE;
+    index_stmt->tableSpace = NULL;
+    index_stmt->indexParams = NIL;
+    index_stmt->indexIncludingParams = NIL;
+
+    foreach (lc, key_names)
+    {
+        IndexElem *elem = makeNode(IndexElem);
+
+        elem->name = strVal(lfirst(lc));
+        elem->ordering = SORTBY_DEFAULT;
+        elem->nulls_ordering = SORTBY_NULLS_DEFAULT;
+        index_stmt->indexParams = lappend(index_stmt->indexParams, elem);
+    }
+
+    foreach (lc, include_names)
+    {
+        IndexElem *elem = makeNode(IndexElem);
+
+        elem->name = strVal(lfirst(lc));
+        elem->ordering = SORTBY_DEFAULT;
+        elem->nulls_ordering = SORTBY_NULLS_DEFAULT;
+        index_stmt->indexIncludingParams =
+            lappend(index_stmt->indexIncludingParams, elem);
+    }
+
+    index_stmt->options = NIL;
+    index_stmt->whereClause = NULL;
+    index_stmt->excludeOpNames = NIL;
+    index_stmt->idxcomment = NULL;
+    index_stmt->indexOid = InvalidOid;
+    index_stmt->oldNode = InvalidOid;
+    index_stmt->unique = primary;
+    index_stmt->primary = primary;
+    index_stmt->isconstraint = primary;
+    index_stmt->deferrable = false;
+    index_stmt->initdeferred = false;
+    index_stmt->transformed = false;
+    index_stmt->concurrent = false;
+    index_stmt->if_not_exists = false;
+
+    define_index(index_stmt);
+}
+
+/*
+ * CREATE INDEX ON `schema_name`.`rel_name` USING `access_method`
+ *   (agtype_access_operator("properties", '"`property_name`"'))
+ *
+ * The index expression is built by the same function that transforms
+ * `v.property_name` in Cypher queries so that the planner can match it.
+ */
+static void create_property_index_for_label(Oid relid, char *property_name,
+                                            char *access_method)
+{
+    Oid nsp_id;
+    char *rel_name;
+    AttrNumber props_attnum;
+    IndexStmt *index_stmt;
+    IndexElem *elem;
+
+    nsp_id = get_rel_namespace(relid);
+    rel_name = get_rel_name(relid);
+
+    props_attnum = get_attnum(relid, "properties");
+    Assert(props_attnum != InvalidAttrNumber);
+
+    // index expressions refer to the indexed relation as varno 1
+    elem = makeNode(IndexElem);
+    elem->name = NULL;
+    elem->expr = make_property_access_expr(
+        (Node *)makeVar(1, props_attnum, AGTYPEOID, -1, InvalidOid, 0),
+        property_name);
+    elem->ordering = SORTBY_DEFAULT;
+    elem->nulls_ordering = SORTBY_NULLS_DEFAULT;
+
+    index_stmt = makeNode(IndexStmt);
+    index_stmt->idxname = ChooseRelationName(rel_name, property_name, "idx",
+                                             nsp_id, false);
+    index_stmt->relation = makeRangeVar(get_namespace_name(nsp_id), rel_name,
+                                        -1);
+    index_stmt->relation->inh = false;
+    index_stmt->accessMethod = access_method;
+    index_stmt->indexParams = list_make1(elem);
+    index_stmt->indexIncludingParams = NIL;
+    index_stmt->options = NIL;
+    index_stmt->whereClause = NULL;
+    index_stmt->excludeOpNames = NIL;
+    index_stmt->idxcomment = NULL;
+    index_stmt->indexOid = InvalidOid;
+    index_stmt->oldNode = InvalidOid;
+    index_stmt->unique = false;
+    index_stmt->primary = false;
+    index_stmt->isconstraint = false;
+    index_stmt->deferrable = false;
+    index_stmt->initdeferred = false;
+    // the expression is already transformed
+    index_stmt->transformed = true;
+    index_stmt->concurrent = false;
+    index_stmt->if_not_exists = false;
+
+    define_index(index_stmt);
+}
+
+static void define_index(IndexStmt *index_stmt)
+{
+    PlannedStmt *wrapper;
+
+    wrapper = makeNode(PlannedStmt);
+    wrapper->commandType = CMD_UTILITY;
+    wrapper->canSetTag = false;
+    wrapper->utilityStmt = (Node *)index_stmt;
+    wrapper->stmt_location = -1;
+    wrapper->stmt_len = 0;
+
+    ProcessUtility(wrapper, "(generated CREATE INDEX command)",
+                   PROCESS_UTILITY_SUBCOMMAND, NULL, NULL, None_Receiver,
+                   NULL);
+    // CommandCounterIncrement() is called in ProcessUtility()
+}
+
 /*
  * Builds the primary key constraint for when a table is created.
  */
@@ -325,12 +537,12 @@ static FuncCall *build_id_default_func_expr(char *graph_name, char *label_name,
     A_Const *label_name_const;
     List *label_id_func_args;
     FuncCall *label_id_func;
-    List *nextval_func_name;
+    List *entry_id_func_name;
     char *qualified_seq_name;
     A_Const *qualified_seq_name_const;
     TypeCast *regclass_cast;
-    List *nextval_func_args;
-    FuncCall *nextval_func;
+    List *entry_id_func_args;
+    FuncCall *entry_id_func;
     List *graphid_func_name;
     List *graphid_func_args;
     FuncCall *graphid_func;
@@ -349,8 +561,12 @@ static FuncCall *build_id_default_func_expr(char *graph_name, char *label_name,
     label_id_func_args = list_make2(graph_name_const, label_name_const);
     label_id_func = makeFuncCall(label_id_func_name, label_id_func_args, -1);
 
-    //Build a node that will get the next val from the label's sequence
-    nextval_func_name = SystemFuncName("nextval");
+    /*
+     * Build a node that will get the next entry id from the block that the
+     * backend reserved from the label's sequence
+     */
+    entry_id_func_name = list_make2(makeString("ag_catalog"),
+                                    makeString("_next_entry_id"));
     qualified_seq_name = quote_qualified_identifier(schema_name, seq_name);
     qualified_seq_name_const = makeNode(A_Const);
     qualified_seq_name_const->val.type = T_String;
@@ -360,16 +576,16 @@ static FuncCall *build_id_default_func_expr(char *graph_name, char *label_name,
     regclass_cast->typeName = SystemTypeName("regclass");
     regclass_cast->arg = (Node *)qualified_seq_name_const;
     regclass_cast->location = -1;
-    nextval_func_args = list_make1(regclass_cast);
-    nextval_func = makeFuncCall(nextval_func_name, nextval_func_args, -1);
+    entry_id_func_args = list_make1(regclass_cast);
+    entry_id_func = makeFuncCall(entry_id_func_name, entry_id_func_args, -1);
 
     /*
      * Build a node that contructs the graphid from the label id function
-     * and the next val function for the given sequence.
+     * and the next entry id function for the given sequence.
      */
     graphid_func_name = list_make2(makeString("ag_catalog"),
                                    makeString("_graphid"));
-    graphid_func_args = list_make2(label_id_func, nextval_func);
+    graphid_func_args = list_make2(label_id_func, entry_id_func);
     graphid_func = makeFuncCall(graphid_func_name, graphid_func_args, -1);
 
     return graphid_func;
@@ -598,6 +814,88 @@ Datum drop_label(PG_FUNCTION_ARGS)
     PG_RETURN_VOID();
 }
 
+PG_FUNCTION_INFO_V1(create_property_index);
+
+/*
+ * Creates an index on a property of the label and all the labels that
+ * inherit it. Labels that are created afterwards don't get the index.
+ */
+Datum create_property_index(PG_FUNCTION_ARGS)
+{
+    Name graph_name;
+    Name label_name;
+    char *property_name;
+    char *access_method;
+    char *graph_name_str;
+    graph_cache_data *cache_data;
+    char *label_name_str;
+    Oid label_relation;
+    List *relids;
+    ListCell *lc;
+
+    if (PG_ARGISNULL(0))
+    {
+        ereport(ERROR, (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                        errmsg("graph name must not be NULL")));
+    }
+    if (PG_ARGISNULL(1))
+    {
+        ereport(ERROR, (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                        errmsg("label name must not be NULL")));
+    }
+    if (PG_ARGISNULL(2))
+    {
+        ereport(ERROR, (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                        errmsg("property name must not be NULL")));
+    }
+    if (PG_ARGISNULL(3))
+    {
+        ereport(ERROR, (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                        errmsg("access method must not be NULL")));
+    }
+    graph_name = PG_GETARG_NAME(0);
+    label_name = PG_GETARG_NAME(1);
+    property_name = text_to_cstring(PG_GETARG_TEXT_PP(2));
+    access_method = NameStr(*PG_GETARG_NAME(3));
+
+    // the index expression is compared with = only
+    if (strcmp(access_method, "btree") != 0 &&
+        strcmp(access_method, "hash") != 0)
+    {
+        ereport(ERROR,
+                (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                 errmsg("access method \"%s\" is not supported for property indexes",
+                        access_method),
+                 errhint("Use btree or hash.")));
+    }
+
+    graph_name_str = NameStr(*graph_name);
+    cache_data = search_graph_name_cache(graph_name_str);
+    if (!cache_data)
+    {
+        ereport(ERROR,
+                (errcode(ERRCODE_UNDEFINED_SCHEMA),
+                 errmsg("graph \"%s\" does not exist", graph_name_str)));
+    }
+
+    label_name_str = NameStr(*label_name);
+    label_relation = get_label_relation(label_name_str, cache_data->oid);
+    if (!OidIsValid(label_relation))
+    {
+        ereport(ERROR,
+                (errcode(ERRCODE_UNDEFINED_TABLE),
+                 errmsg("label \"%s\" does not exist", label_name_str)));
+    }
+
+    // the label itself comes first
+    relids = find_all_inheritors(label_relation, ShareLock, NULL);
+    foreach (lc, relids)
+        create_property_index_for_label(lfirst_oid(lc), property_name,
+                                        access_method);
+
+    PG_RETURN_VOID();
+}
+
 // See RemoveRelations() for more details.
 static void remove_relation(List *qname)
 {
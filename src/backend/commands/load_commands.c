@@ -0,0 +1,774 @@
+/*
+ * Copyright 2020 Bitnine Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "postgres.h"
+
+#include "access/hash.h"
+#include "access/heapam.h"
+#include "access/htup_details.h"
+#include "access/xact.h"
+#include "catalog/dependency.h"
+#include "catalog/index.h"
+#include "catalog/pg_authid.h"
+#include "commands/copy.h"
+#include "executor/executor.h"
+#include "fmgr.h"
+#include "miscadmin.h"
+#include "nodes/makefuncs.h"
+#include "nodes/pg_list.h"
+#include "storage/bufmgr.h"
+#include "utils/acl.h"
+#include "utils/builtins.h"
+#include "utils/hashutils.h"
+#include "utils/hsearch.h"
+#include "utils/lsyscache.h"
+#include "utils/memutils.h"
+#include "utils/rel.h"
+
+#include "catalog/ag_label.h"
+#include "commands/label_commands.h"
+#include "utils/ag_cache.h"
+#include "utils/agtype.h"
+#include "utils/graphid.h"
+
+/*
+ * The loaded tuples are buffered and written with heap_multi_insert() once
+ * either limit is reached. These are the limits that COPY FROM uses.
+ */
+#define LOAD_BATCH_NTUPLES 1000
+#define LOAD_BATCH_SIZE 65535
+
+// the leading columns of an edge file, the rest are properties
+#define EDGE_FIELD_START_ID 0
+#define EDGE_FIELD_START_LABEL 1
+#define EDGE_FIELD_END_ID 2
+#define EDGE_FIELD_END_LABEL 3
+#define EDGE_FIELD_PROPERTIES 4
+
+/*
+ * External IDs of the vertices loaded in the current transaction. The map is
+ * allocated in a child context of TopTransactionContext so that it goes away
+ * with the transaction, which is also when the vertices it points at may go.
+ */
+typedef struct vertex_key
+{
+    Oid graph;
+    int32 label_id;
+    char *ext_id;
+} vertex_key;
+
+typedef struct vertex_key_entry
+{
+    vertex_key key; // hash key
+    graphid id;
+} vertex_key_entry;
+
+typedef struct load_state
+{
+    Oid graph_oid;
+    char *label_name;
+    int32 label_id;
+    Oid seq_relid;
+    Relation rel;
+    EState *estate;
+    ResultRelInfo *result_rel_info;
+    TupleTableSlot *slot;
+    bool defer_indexes; // rebuild the indexes at the end instead
+    CopyState cstate;
+    ErrorContextCallback errcallback;
+    char **header; // column names, property names for the property columns
+    int header_nfields;
+    MemoryContext row_context;
+    MemoryContext batch_context;
+    BulkInsertState bistate;
+    HeapTuple *batch_tuples;
+    int batch_ntuples;
+    Size batch_size;
+    int64 ntuples;
+} load_state;
+
+static HTAB *vertex_keys = NULL;
+static MemoryContext vertex_keys_context = NULL;
+static bool vertex_keys_callbacks_registered = false;
+
+static void begin_load(load_state *state, Name graph_name, Name label_name,
+                       text *file_path, char label_kind, int min_nfields);
+static void end_load(load_state *state);
+static bool read_load_fields(load_state *state, char ***fields);
+static Datum build_load_properties(load_state *state, char **fields,
+                                   int first_prop_field);
+static graphid next_load_graphid(load_state *state);
+static void insert_load_tuple(load_state *state, Datum *values);
+static void flush_load_tuples(load_state *state);
+static label_cache_data *get_load_label(Oid graph_oid, char *graph_name,
+                                        char *label_name, char label_kind);
+
+static void create_vertex_keys(void);
+static uint32 vertex_key_hash(const void *key, Size keysize);
+static int vertex_key_compare(const void *key1, const void *key2,
+                              Size keysize);
+static void *vertex_key_copy(void *dest, const void *src, Size keysize);
+static void vertex_keys_xact_callback(XactEvent event, void *arg);
+static void vertex_keys_subxact_callback(SubXactEvent event,
+                                         SubTransactionId mySubid,
+                                         SubTransactionId parentSubid,
+                                         void *arg);
+static graphid lookup_vertex_key(Oid graph_oid, char *label_name,
+                                 char *ext_id);
+
+PG_FUNCTION_INFO_V1(load_labels_from_file);
+
+/*
+ * Loads vertices of the label from a CSV file that has a header line. The
+ * first column is the external ID of the vertex that edges refer to. All the
+ * columns, including the first one, become string properties of the vertex.
+ * Empty unquoted fields are NULL and the property is left out.
+ */
+Datum load_labels_from_file(PG_FUNCTION_ARGS)
+{
+    load_state state;
+    char **fields;
+
+    if (PG_ARGISNULL(0))
+    {
+        ereport(ERROR, (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                        errmsg("graph name must not be NULL")));
+    }
+    if (PG_ARGISNULL(1))
+    {
+        ereport(ERROR, (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                        errmsg("label name must not be NULL")));
+    }
+    if (PG_ARGISNULL(2))
+    {
+        ereport(ERROR, (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                        errmsg("file path must not be NULL")));
+    }
+
+    begin_load(&state, PG_GETARG_NAME(0), PG_GETARG_NAME(1),
+               PG_GETARG_TEXT_PP(2), LABEL_KIND_VERTEX, 1);
+
+    if (!vertex_keys)
+        create_vertex_keys();
+
+    while (read_load_fields(&state, &fields))
+    {
+        Datum values[Anum_ag_label_vertex_table_properties];
+        vertex_key key;
+        vertex_key_entry *entry;
+        bool found;
+        graphid id;
+
+        if (!fields[0])
+        {
+            ereport(ERROR, (errcode(ERRCODE_NOT_NULL_VIOLATION),
+                            errmsg("vertex ID must not be NULL")));
+        }
+
+        id = next_load_graphid(&state);
+
+        key.graph = state.graph_oid;
+        key.label_id = state.label_id;
+        key.ext_id = fields[0];
+        entry = hash_search(vertex_keys, &key, HASH_ENTER, &found);
+        if (found)
+        {
+            ereport(ERROR,
+                    (errcode(ERRCODE_UNIQUE_VIOLATION),
+                     errmsg("vertex \"%s\" of label \"%s\" has already been loaded",
+                            fields[0], state.label_name)));
+        }
+        entry->id = id;
+
+        values[vertex_tuple_id] = GRAPHID_GET_DATUM(id);
+        values[vertex_tuple_properties] =
+            build_load_properties(&state, fields, 0);
+
+        insert_load_tuple(&state, values);
+    }
+
+    end_load(&state);
+
+    PG_RETURN_INT64(state.ntuples);
+}
+
+PG_FUNCTION_INFO_V1(load_edges_from_file);
+
+/*
+ * Loads edges of the label from a CSV file that has a header line. The first
+ * four columns are the external ID and the label of the start vertex and the
+ * external ID and the label of the end vertex. The rest of the columns become
+ * string properties of the edge.
+ *
+ * The vertices at the ends must have been loaded by load_labels_from_file()
+ * in the same transaction.
+ */
+Datum load_edges_from_file(PG_FUNCTION_ARGS)
+{
+    load_state state;
+    char **fields;
+
+    if (PG_ARGISNULL(0))
+    {
+        ereport(ERROR, (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                        errmsg("graph name must not be NULL")));
+    }
+    if (PG_ARGISNULL(1))
+    {
+        ereport(ERROR, (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                        errmsg("label name must not be NULL")));
+    }
+    if (PG_ARGISNULL(2))
+    {
+        ereport(ERROR, (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                        errmsg("file path must not be NULL")));
+    }
+
+    begin_load(&state, PG_GETARG_NAME(0), PG_GETARG_NAME(1),
+               PG_GETARG_TEXT_PP(2), LABEL_KIND_EDGE, EDGE_FIELD_PROPERTIES);
+
+    while (read_load_fields(&state, &fields))
+    {
+        Datum values[Anum_ag_label_edge_table_properties];
+        int i;
+
+        for (i = 0; i < EDGE_FIELD_PROPERTIES; i++)
+        {
+            if (!fields[i])
+            {
+                ereport(ERROR,
+                        (errcode(ERRCODE_NOT_NULL_VIOLATION),
+                         errmsg("column \"%s\" must not be NULL",
+                                state.header[i])));
+            }
+        }
+
+        values[edge_tuple_id] = GRAPHID_GET_DATUM(next_load_graphid(&state));
+        values[edge_tuple_start_id] = GRAPHID_GET_DATUM(lookup_vertex_key(
+            state.graph_oid, fields[EDGE_FIELD_START_LABEL],
+            fields[EDGE_FIELD_START_ID]));
+        values[edge_tuple_end_id] = GRAPHID_GET_DATUM(lookup_vertex_key(
+            state.graph_oid, fields[EDGE_FIELD_END_LABEL],
+            fields[EDGE_FIELD_END_ID]));
+        values[edge_tuple_properties] =
+            build_load_properties(&state, fields, EDGE_FIELD_PROPERTIES);
+
+        insert_load_tuple(&state, values);
+    }
+
+    end_load(&state);
+
+    PG_RETURN_INT64(state.ntuples);
+}
+
+/*
+ * Opens the label, creating it if it doesn't exist, and the file to load and
+ * reads the header line of the file. The file must have at least min_nfields
+ * columns.
+ */
+static void begin_load(load_state *state, Name graph_name, Name label_name,
+                       text *file_path, char label_kind, int min_nfields)
+{
+    char *graph_name_str;
+    graph_cache_data *graph_cache;
+    label_cache_data *label_cache;
+    char *file_path_str;
+    List *seq_relids;
+    AclResult aclresult;
+    RangeTblEntry *rte;
+    List *options;
+    char **fields;
+    int nfields;
+    int i;
+
+    // See DoCopy()
+    if (!is_member_of_role(GetUserId(), DEFAULT_ROLE_READ_SERVER_FILES))
+    {
+        ereport(ERROR,
+                (errcode(ERRCODE_INSUFFICIENT_PRIVILEGE),
+                 errmsg("must be superuser or a member of the pg_read_server_files role to load a graph from a file")));
+    }
+
+    graph_name_str = NameStr(*graph_name);
+    graph_cache = search_graph_name_cache(graph_name_str);
+    if (!graph_cache)
+    {
+        ereport(ERROR,
+                (errcode(ERRCODE_UNDEFINED_SCHEMA),
+                 errmsg("graph \"%s\" does not exist", graph_name_str)));
+    }
+    state->graph_oid = graph_cache->oid;
+
+    state->label_name = NameStr(*label_name);
+    label_cache = get_load_label(state->graph_oid, graph_name_str,
+                                 state->label_name, label_kind);
+    state->label_id = label_cache->id;
+
+    state->rel = heap_open(label_cache->relation, RowExclusiveLock);
+
+    aclresult = pg_class_aclcheck(RelationGetRelid(state->rel), GetUserId(),
+                                  ACL_INSERT);
+    if (aclresult != ACLCHECK_OK)
+        aclcheck_error(aclresult, OBJECT_TABLE,
+                       RelationGetRelationName(state->rel));
+
+    // the "id" column of both vertex and edge labels owns the label's sequence
+    seq_relids = getOwnedSequences(RelationGetRelid(state->rel),
+                                   Anum_ag_label_vertex_table_id);
+    if (list_length(seq_relids) != 1)
+    {
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("label \"%s\" has no sequence for its IDs",
+                        state->label_name)));
+    }
+    state->seq_relid = linitial_oid(seq_relids);
+
+    /*
+     * Maintaining the indexes tuple by tuple is what makes loading slow. If
+     * the label is empty, the indexes are built once after all the tuples are
+     * written instead.
+     */
+    state->defer_indexes = (state->rel->rd_rel->relhasindex &&
+                            RelationGetNumberOfBlocks(state->rel) == 0);
+
+    // ExecConstraints() and ExecInsertIndexTuples() need an executor state
+    rte = makeNode(RangeTblEntry);
+    rte->rtekind = RTE_RELATION;
+    rte->relid = RelationGetRelid(state->rel);
+    rte->relkind = state->rel->rd_rel->relkind;
+    rte->requiredPerms = ACL_INSERT;
+
+    state->estate = CreateExecutorState();
+    state->estate->es_range_table = list_make1(rte);
+
+    state->result_rel_info = makeNode(ResultRelInfo);
+    InitResultRelInfo(state->result_rel_info, state->rel, 1, NULL, 0);
+    state->estate->es_result_relations = state->result_rel_info;
+    state->estate->es_num_result_relations = 1;
+    state->estate->es_result_relation_info = state->result_rel_info;
+
+    if (!state->defer_indexes)
+        ExecOpenIndices(state->result_rel_info, false);
+
+    state->slot = ExecInitExtraTupleSlot(state->estate,
+                                         RelationGetDescr(state->rel));
+
+    // the file is read by the CSV reader of COPY FROM
+    file_path_str = text_to_cstring(file_path);
+    options = list_make1(makeDefElem("format", (Node *)makeString("csv"), -1));
+    state->cstate = BeginCopyFrom(NULL, state->rel, file_path_str, false, NULL,
+                                  NIL, options);
+
+    // report the line of the file for errors like COPY FROM does
+    state->errcallback.callback = CopyFromErrorCallback;
+    state->errcallback.arg = (void *)state->cstate;
+    state->errcallback.previous = error_context_stack;
+    error_context_stack = &state->errcallback;
+
+    if (!NextCopyFromRawFields(state->cstate, &fields, &nfields))
+    {
+        ereport(ERROR, (errcode(ERRCODE_BAD_COPY_FILE_FORMAT),
+                        errmsg("missing header line")));
+    }
+    if (nfields < min_nfields)
+    {
+        ereport(ERROR, (errcode(ERRCODE_BAD_COPY_FILE_FORMAT),
+                        errmsg("header line must have at least %d columns",
+                               min_nfields)));
+    }
+
+    // the fields are overwritten by the next line
+    state->header = palloc(sizeof(char *) * nfields);
+    for (i = 0; i < nfields; i++)
+    {
+        if (!fields[i])
+        {
+            ereport(ERROR, (errcode(ERRCODE_BAD_COPY_FILE_FORMAT),
+                            errmsg("column name must not be NULL")));
+        }
+        state->header[i] = pstrdup(fields[i]);
+    }
+    state->header_nfields = nfields;
+
+    state->row_context = AllocSetContextCreate(CurrentMemoryContext,
+                                               "Load Row",
+                                               ALLOCSET_DEFAULT_SIZES);
+    state->batch_context = AllocSetContextCreate(CurrentMemoryContext,
+                                                 "Load Batch",
+                                                 ALLOCSET_DEFAULT_SIZES);
+    state->bistate = GetBulkInsertState();
+    state->batch_tuples = palloc(sizeof(HeapTuple) * LOAD_BATCH_NTUPLES);
+    state->batch_ntuples = 0;
+    state->batch_size = 0;
+    state->ntuples = 0;
+}
+
+/*
+ * Writes out the buffered tuples, closes the file and the label and builds
+ * the indexes of the label if their maintenance was deferred.
+ */
+static void end_load(load_state *state)
+{
+    Oid relid = RelationGetRelid(state->rel);
+
+    flush_load_tuples(state);
+
+    error_context_stack = state->errcallback.previous;
+
+    EndCopyFrom(state->cstate);
+
+    FreeBulkInsertState(state->bistate);
+    MemoryContextDelete(state->batch_context);
+    MemoryContextDelete(state->row_context);
+
+    if (!state->defer_indexes)
+        ExecCloseIndices(state->result_rel_info);
+
+    ExecResetTupleTable(state->estate->es_tupleTable, false);
+    FreeExecutorState(state->estate);
+
+    // keep the lock until the end of the transaction
+    heap_close(state->rel, NoLock);
+
+    if (state->defer_indexes)
+    {
+        // make the new tuples visible to the index builds
+        CommandCounterIncrement();
+
+        reindex_relation(relid, 0, 0);
+    }
+}
+
+/*
+ * Reads the next line of the file. Returns false at the end of the file. NULL
+ * fields are NULL pointers. The fields are valid until the next call.
+ */
+static bool read_load_fields(load_state *state, char ***fields)
+{
+    int nfields;
+
+    CHECK_FOR_INTERRUPTS();
+
+    MemoryContextReset(state->row_context);
+
+    if (!NextCopyFromRawFields(state->cstate, fields, &nfields))
+        return false;
+
+    // the same errors that COPY FROM raises
+    if (nfields > state->header_nfields)
+    {
+        ereport(ERROR, (errcode(ERRCODE_BAD_COPY_FILE_FORMAT),
+                        errmsg("extra data after last expected column")));
+    }
+    if (nfields < state->header_nfields)
+    {
+        ereport(ERROR, (errcode(ERRCODE_BAD_COPY_FILE_FORMAT),
+                        errmsg("missing data for column \"%s\"",
+                               state->header[nfields])));
+    }
+
+    return true;
+}
+
+/*
+ * Builds the properties map from the fields starting at first_prop_field.
+ * The values are strings, NULL fields are left out.
+ */
+static Datum build_load_properties(load_state *state, char **fields,
+                                   int first_prop_field)
+{
+    MemoryContext old_context;
+    agtype_parse_state *parse_state = NULL;
+    agtype_value *res;
+    agtype *props;
+    int i;
+
+    old_context = MemoryContextSwitchTo(state->row_context);
+
+    push_agtype_value(&parse_state, WAGT_BEGIN_OBJECT, NULL);
+    for (i = first_prop_field; i < state->header_nfields; i++)
+    {
+        agtype_value v;
+
+        if (!fields[i])
+            continue;
+
+        v.type = AGTV_STRING;
+        v.val.string.len = check_string_length(strlen(state->header[i]));
+        v.val.string.val = state->header[i];
+        push_agtype_value(&parse_state, WAGT_KEY, &v);
+
+        v.val.string.len = check_string_length(strlen(fields[i]));
+        v.val.string.val = fields[i];
+        push_agtype_value(&parse_state, WAGT_VALUE, &v);
+    }
+    res = push_agtype_value(&parse_state, WAGT_END_OBJECT, NULL);
+
+    props = agtype_value_to_agtype(res);
+
+    MemoryContextSwitchTo(old_context);
+
+    return AGTYPE_P_GET_DATUM(props);
+}
+
+static graphid next_load_graphid(load_state *state)
+{
+    return make_graphid(state->label_id, next_entry_id(state->seq_relid));
+}
+
+/*
+ * Buffers the tuple that has the given values. The buffer is written out once
+ * it reaches LOAD_BATCH_NTUPLES tuples or LOAD_BATCH_SIZE bytes.
+ */
+static void insert_load_tuple(load_state *state, Datum *values)
+{
+    TupleTableSlot *slot = state->slot;
+    int natts = slot->tts_tupleDescriptor->natts;
+    MemoryContext old_context;
+    HeapTuple tuple;
+
+    ExecClearTuple(slot);
+    memcpy(slot->tts_values, values, sizeof(Datum) * natts);
+    memset(slot->tts_isnull, false, sizeof(bool) * natts);
+    ExecStoreVirtualTuple(slot);
+
+    if (state->rel->rd_att->constr != NULL)
+        ExecConstraints(state->result_rel_info, slot, state->estate);
+
+    old_context = MemoryContextSwitchTo(state->batch_context);
+    tuple = ExecCopySlotTuple(slot);
+    MemoryContextSwitchTo(old_context);
+
+    state->batch_tuples[state->batch_ntuples++] = tuple;
+    state->batch_size += tuple->t_len;
+    state->ntuples++;
+
+    if (state->batch_ntuples >= LOAD_BATCH_NTUPLES ||
+        state->batch_size >= LOAD_BATCH_SIZE)
+        flush_load_tuples(state);
+}
+
+/*
+ * Writes the buffered tuples with heap_multi_insert() and then inserts their
+ * index entries unless the maintenance of the indexes is deferred.
+ */
+static void flush_load_tuples(load_state *state)
+{
+    ResultRelInfo *result_rel_info = state->result_rel_info;
+    EState *estate = state->estate;
+    int i;
+
+    if (state->batch_ntuples == 0)
+        return;
+
+    heap_multi_insert(state->rel, state->batch_tuples, state->batch_ntuples,
+                      GetCurrentCommandId(true), 0, state->bistate);
+
+    if (!state->defer_indexes && result_rel_info->ri_NumIndices > 0)
+    {
+        for (i = 0; i < state->batch_ntuples; i++)
+        {
+            HeapTuple tuple = state->batch_tuples[i];
+
+            ExecStoreTuple(tuple, state->slot, InvalidBuffer, false);
+            ExecInsertIndexTuples(state->slot, &(tuple->t_self), estate,
+                                  false, NULL, NIL);
+            ResetPerTupleExprContext(estate);
+        }
+
+        ExecClearTuple(state->slot);
+    }
+
+    state->batch_ntuples = 0;
+    state->batch_size = 0;
+    MemoryContextReset(state->batch_context);
+}
+
+/*
+ * Returns the label, creating it if it doesn't exist. The returned struct
+ * must not be used after the cache can be invalidated.
+ */
+static label_cache_data *get_load_label(Oid graph_oid, char *graph_name,
+                                        char *label_name, char label_kind)
+{
+    label_cache_data *label_cache;
+
+    label_cache = search_label_name_graph_cache(label_name, graph_oid);
+    if (!label_cache)
+    {
+        char *parent_name;
+        RangeVar *rv;
+
+        if (label_kind == LABEL_KIND_VERTEX)
+            parent_name = AG_DEFAULT_LABEL_VERTEX;
+        else
+            parent_name = AG_DEFAULT_LABEL_EDGE;
+
+        rv = get_label_range_var(graph_name, graph_oid, parent_name);
+        create_label(graph_name, label_name, label_kind, list_make1(rv));
+
+        label_cache = search_label_name_graph_cache(label_name, graph_oid);
+        Assert(label_cache);
+    }
+
+    if (label_cache->kind != label_kind)
+    {
+        ereport(ERROR,
+                (errcode(ERRCODE_WRONG_OBJECT_TYPE),
+                 errmsg("label \"%s\" is not %s label", label_name,
+                        label_kind == LABEL_KIND_VERTEX ? "a vertex" :
+                                                          "an edge")));
+    }
+
+    return label_cache;
+}
+
+static void create_vertex_keys(void)
+{
+    HASHCTL hash_ctl;
+
+    if (!vertex_keys_callbacks_registered)
+    {
+        RegisterXactCallback(vertex_keys_xact_callback, NULL);
+        RegisterSubXactCallback(vertex_keys_subxact_callback, NULL);
+        vertex_keys_callbacks_registered = true;
+    }
+
+    vertex_keys_context = AllocSetContextCreate(TopTransactionContext,
+                                                "Load Vertex Keys",
+                                                ALLOCSET_DEFAULT_SIZES);
+
+    MemSet(&hash_ctl, 0, sizeof(hash_ctl));
+    hash_ctl.keysize = sizeof(vertex_key);
+    hash_ctl.entrysize = sizeof(vertex_key_entry);
+    hash_ctl.hash = vertex_key_hash;
+    hash_ctl.match = vertex_key_compare;
+    hash_ctl.keycopy = vertex_key_copy;
+    hash_ctl.hcxt = vertex_keys_context;
+
+    // Please see the comment of hash_create() for the nelem value 16 here.
+    vertex_keys = hash_create("load vertex keys", 16, &hash_ctl,
+                              HASH_ELEM | HASH_FUNCTION | HASH_COMPARE |
+                                  HASH_KEYCOPY | HASH_CONTEXT);
+}
+
+static uint32 vertex_key_hash(const void *key, Size keysize)
+{
+    const vertex_key *k = key;
+    uint32 hash;
+
+    hash = DatumGetUInt32(hash_any((const unsigned char *)k->ext_id,
+                                   strlen(k->ext_id)));
+    hash = hash_combine(hash, DatumGetUInt32(hash_uint32(k->label_id)));
+    hash = hash_combine(hash, DatumGetUInt32(hash_uint32(k->graph)));
+
+    return hash;
+}
+
+static int vertex_key_compare(const void *key1, const void *key2,
+                              Size keysize)
+{
+    const vertex_key *k1 = key1;
+    const vertex_key *k2 = key2;
+
+    if (k1->graph != k2->graph || k1->label_id != k2->label_id)
+        return 1;
+
+    return strcmp(k1->ext_id, k2->ext_id);
+}
+
+// the external ID of a new entry is copied into the context of the map
+static void *vertex_key_copy(void *dest, const void *src, Size keysize)
+{
+    vertex_key *d = dest;
+    const vertex_key *s = src;
+
+    d->graph = s->graph;
+    d->label_id = s->label_id;
+    d->ext_id = MemoryContextStrdup(vertex_keys_context, s->ext_id);
+
+    return dest;
+}
+
+static void vertex_keys_xact_callback(XactEvent event, void *arg)
+{
+    switch (event)
+    {
+    case XACT_EVENT_COMMIT:
+    case XACT_EVENT_PARALLEL_COMMIT:
+    case XACT_EVENT_ABORT:
+    case XACT_EVENT_PARALLEL_ABORT:
+    case XACT_EVENT_PREPARE:
+        // the map is freed along with TopTransactionContext
+        vertex_keys = NULL;
+        vertex_keys_context = NULL;
+        break;
+    default:
+        break;
+    }
+}
+
+/*
+ * The map doesn't know which subtransaction loaded which vertices. So, it is
+ * dropped as a whole so that edges never point at vertices that are gone.
+ */
+static void vertex_keys_subxact_callback(SubXactEvent event,
+                                         SubTransactionId mySubid,
+                                         SubTransactionId parentSubid,
+                                         void *arg)
+{
+    if (event != SUBXACT_EVENT_ABORT_SUB || !vertex_keys)
+        return;
+
+    MemoryContextDelete(vertex_keys_context);
+    vertex_keys = NULL;
+    vertex_keys_context = NULL;
+}
+
+static graphid lookup_vertex_key(Oid graph_oid, char *label_name,
+                                 char *ext_id)
+{
+    label_cache_data *label_cache;
+    vertex_key key;
+    vertex_key_entry *entry = NULL;
+
+    label_cache = search_label_name_graph_cache(label_name, graph_oid);
+    if (!label_cache || label_cache->kind != LABEL_KIND_VERTEX)
+    {
+        ereport(ERROR,
+                (errcode(ERRCODE_UNDEFINED_TABLE),
+                 errmsg("vertex label \"%s\" does not exist", label_name)));
+    }
+
+    if (vertex_keys)
+    {
+        key.graph = graph_oid;
+        key.label_id = label_cache->id;
+        key.ext_id = ext_id;
+        entry = hash_search(vertex_keys, &key, HASH_FIND, NULL);
+    }
+    if (!entry)
+    {
+        ereport(ERROR,
+                (errcode(ERRCODE_UNDEFINED_OBJECT),
+                 errmsg("vertex \"%s\" of label \"%s\" has not been loaded",
+                        ext_id, label_name),
+                 errhint("Load the vertices with load_labels_from_file() in the same transaction.")));
+    }
+
+    return entry->id;
+}
@@ -29,6 +29,7 @@
 #include "catalog/ag_label.h"
 #include "executor/cypher_executor.h"
 #include "nodes/cypher_nodes.h"
+#include "utils/ag_stat.h"
 
 typedef struct cypher_create_custom_scan_state
 {
@@ -112,6 +113,8 @@ static void begin_cypher_create(CustomScanState *node, EState *estate,
                     lappend(cypher_node->expr_states,
                             ExecInitExpr(te->expr, (PlanState *)node));
             }
+
+            cypher_node->rows_created = 0;
         }
     }
 }
@@ -165,6 +168,9 @@ static void end_cypher_create(CustomScanState *node)
             cypher_target_node *cypher_node =
                 (cypher_target_node *)lfirst(lc2);
 
+            ag_stat_count_rows_created(cypher_node->relid,
+                                       cypher_node->rows_created);
+
             // close all indices for the node
             ExecCloseIndices(cypher_node->resultRelInfo);
 
@@ -257,6 +263,7 @@ static void create_edge(cypher_create_custom_scan_state *css,
 
      // Insert the new edge
     insert_entity_tuple(resultRelInfo, elemTupleSlot, estate);
+    node->rows_created++;
 }
 
 /*
@@ -300,6 +307,7 @@ static Datum create_vertex(cypher_create_custom_scan_state *css,
 
     // Insert the new vertex
     insert_entity_tuple(resultRelInfo, elemTupleSlot, estate);
+    node->rows_created++;
 
     /*
      * Get the vertex's id so it can be passed to the next edge and the
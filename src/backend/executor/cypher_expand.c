@@ -0,0 +1,1012 @@
+/*
+ * Copyright 2020 Bitnine Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "postgres.h"
+
+#include "access/genam.h"
+#include "access/heapam.h"
+#include "access/htup_details.h"
+#include "access/skey.h"
+#include "access/stratnum.h"
+#include "catalog/pg_am_d.h"
+#include "catalog/pg_inherits.h"
+#include "catalog/pg_type_d.h"
+#include "executor/executor.h"
+#include "executor/tuptable.h"
+#include "miscadmin.h"
+#include "nodes/execnodes.h"
+#include "nodes/extensible.h"
+#include "nodes/nodes.h"
+#include "nodes/pg_list.h"
+#include "nodes/plannodes.h"
+#include "utils/array.h"
+#include "utils/datum.h"
+#include "utils/hashutils.h"
+#include "utils/memutils.h"
+#include "utils/rel.h"
+#include "utils/relcache.h"
+
+#include "catalog/ag_label.h"
+#include "executor/cypher_executor.h"
+#include "nodes/cypher_nodes.h"
+#include "utils/ag_cache.h"
+#include "utils/ag_func.h"
+#include "utils/ag_guc.h"
+#include "utils/graphid.h"
+
+/*
+ * An edge label table with the indexes that can be used to look up its
+ * edges by start_id and end_id
+ */
+typedef struct expand_edge_rel
+{
+    Relation rel;
+    Oid start_id_index;
+    Oid end_id_index;
+} expand_edge_rel;
+
+// A vertex label table with the index that can be used to look up by id
+typedef struct expand_vertex_rel
+{
+    Relation rel;
+    Oid id_index;
+} expand_vertex_rel;
+
+// Position in the adjacent edges of a vertex
+typedef struct expand_cursor
+{
+    Datum vertex_id;
+    int edge_rel_idx;
+    AttrNumber edge_attnum;
+    SysScanDesc edge_scan;
+} expand_cursor;
+
+typedef struct cypher_expand_custom_scan_state
+{
+    CustomScanState css;
+    // arguments of _cypher_expand_clause()
+    List *arg_states;
+    Oid graph_oid;
+    cypher_rel_dir dir;
+    int32 vertex_label_id;
+    // the edge label table and all its children
+    expand_edge_rel *edge_rels;
+    int num_edge_rels;
+    // vertex label tables opened so far
+    List *vertex_rels;
+    RegProcedure graphid_eq;
+    // current position
+    bool bound;
+    expand_cursor cursor;
+} cypher_expand_custom_scan_state;
+
+// set of graphids, see lib/simplehash.h
+typedef struct graphid_set_entry
+{
+    graphid id;
+    char status;
+} graphid_set_entry;
+
+#define SH_PREFIX graphid_set
+#define SH_ELEMENT_TYPE graphid_set_entry
+#define SH_KEY_TYPE graphid
+#define SH_KEY id
+#define SH_HASH_KEY(tb, key) \
+    murmurhash32((uint32)(key) ^ (uint32)((uint64)(key) >> 32))
+#define SH_EQUAL(tb, a, b) ((a) == (b))
+#define SH_SCOPE static inline
+#define SH_DECLARE
+#define SH_DEFINE
+#include "lib/simplehash.h"
+
+/*
+ * Cypher VLE extends Cypher Expand with the paths of more than one hop. The
+ * edge and vertex label tables and the cursor of Cypher Expand are shared.
+ */
+typedef struct cypher_vle_custom_scan_state
+{
+    cypher_expand_custom_scan_state expand;
+    // the other arguments of _cypher_vle_clause()
+    int min_hops;
+    int max_hops;
+    bool shortest;
+    // memory for the expansion of the current start vertex
+    MemoryContext vle_context;
+    // the edges of the current path, or the vertices visited so far
+    graphid_set_hash *visited;
+    bool start_pending; // the start vertex matches 0 hops
+    int64 nrows;
+    /*
+     * All paths: frames[i] is the cursor over the adjacent edges of the i-th
+     * vertex of the current path, and path_edges[i] the edge that reached it.
+     */
+    expand_cursor *frames;
+    graphid *path_edges;
+    int depth;
+    /*
+     * Shortest paths: expand.cursor is the cursor of frontier[frontier_idx],
+     * the vertices found at `hops` hops. next_frontier collects the vertices
+     * found at `hops` + 1 hops.
+     */
+    bool cursor_active;
+    int hops;
+    graphid *frontier;
+    int frontier_len;
+    int frontier_idx;
+    graphid *next_frontier;
+    int next_frontier_len;
+    int frontier_size; // allocated size of both frontiers
+} cypher_vle_custom_scan_state;
+
+static void begin_cypher_expand(CustomScanState *node, EState *estate,
+                                int eflags);
+static TupleTableSlot *exec_cypher_expand(CustomScanState *node);
+static void end_cypher_expand(CustomScanState *node);
+static void rescan_cypher_expand(CustomScanState *node);
+
+static void begin_cypher_vle(CustomScanState *node, EState *estate,
+                             int eflags);
+static TupleTableSlot *exec_cypher_vle(CustomScanState *node);
+static void end_cypher_vle(CustomScanState *node);
+static void rescan_cypher_vle(CustomScanState *node);
+
+static TupleTableSlot *next_cypher_expand(ScanState *node);
+static bool recheck_cypher_expand(ScanState *node, TupleTableSlot *slot);
+static bool bind_vertex(cypher_expand_custom_scan_state *css);
+static void begin_cursor(expand_cursor *cursor, Datum vertex_id);
+static void end_cursor(expand_cursor *cursor);
+static HeapTuple next_adjacent_edge(cypher_expand_custom_scan_state *css,
+                                    expand_cursor *cursor, Datum *start_id,
+                                    Datum *end_id, Datum *other_id);
+static bool next_edge_scan(cypher_expand_custom_scan_state *css,
+                           expand_cursor *cursor);
+static TupleTableSlot *next_cypher_vle(ScanState *node);
+static void start_vle(cypher_vle_custom_scan_state *vle);
+static void end_vle_cursors(cypher_vle_custom_scan_state *vle);
+static bool next_path_end(cypher_vle_custom_scan_state *vle, graphid *id);
+static Datum make_path_edges_array(cypher_vle_custom_scan_state *vle);
+static bool next_shortest_path_end(cypher_vle_custom_scan_state *vle,
+                                   graphid *id);
+static bool fetch_vertex(cypher_expand_custom_scan_state *css, graphid id,
+                         Datum *properties);
+static expand_vertex_rel *get_vertex_rel(cypher_expand_custom_scan_state *css,
+                                         int32 label_id);
+static Oid find_index_on_column(Relation rel, AttrNumber attnum);
+
+const CustomExecMethods cypher_expand_exec_methods = {"Cypher Expand",
+                                                      begin_cypher_expand,
+                                                      exec_cypher_expand,
+                                                      end_cypher_expand,
+                                                      rescan_cypher_expand,
+                                                      NULL,
+                                                      NULL,
+                                                      NULL,
+                                                      NULL,
+                                                      NULL,
+                                                      NULL,
+                                                      NULL,
+                                                      NULL};
+
+const CustomExecMethods cypher_vle_exec_methods = {"Cypher VLE",
+                                                   begin_cypher_vle,
+                                                   exec_cypher_vle,
+                                                   end_cypher_vle,
+                                                   rescan_cypher_vle,
+                                                   NULL,
+                                                   NULL,
+                                                   NULL,
+                                                   NULL,
+                                                   NULL,
+                                                   NULL,
+                                                   NULL,
+                                                   NULL};
+
+static void begin_cypher_expand(CustomScanState *node, EState *estate,
+                                int eflags)
+{
+    cypher_expand_custom_scan_state *css =
+        (cypher_expand_custom_scan_state *)node;
+    CustomScan *cscan = (CustomScan *)node->ss.ps.plan;
+    Const *c;
+    Oid edge_relid;
+    List *edge_relids;
+    ListCell *lc;
+    int i;
+
+    // _cypher_vle_clause() has the arguments of _cypher_expand_clause() first
+    Assert(list_length(cscan->custom_exprs) >= 5);
+
+    /*
+     * Only the vertex id can change between rescans, the other arguments
+     * of _cypher_expand_clause() are constants.
+     */
+    css->arg_states = ExecInitExprList(cscan->custom_exprs,
+                                       (PlanState *)node);
+
+    c = linitial(cscan->custom_exprs);
+    css->graph_oid = DatumGetObjectId(c->constvalue);
+    c = lthird(cscan->custom_exprs);
+    edge_relid = DatumGetObjectId(c->constvalue);
+    c = lfourth(cscan->custom_exprs);
+    css->dir = (cypher_rel_dir)DatumGetInt32(c->constvalue);
+    c = list_nth(cscan->custom_exprs, 4);
+    css->vertex_label_id = DatumGetInt32(c->constvalue);
+
+    // Open the edge label table and all of its children
+    edge_relids = find_all_inheritors(edge_relid, AccessShareLock, NULL);
+    css->num_edge_rels = list_length(edge_relids);
+    css->edge_rels = palloc(sizeof(expand_edge_rel) * css->num_edge_rels);
+    i = 0;
+    foreach (lc, edge_relids)
+    {
+        expand_edge_rel *edge_rel = &css->edge_rels[i++];
+
+        edge_rel->rel = heap_open(lfirst_oid(lc), NoLock);
+        edge_rel->start_id_index = find_index_on_column(
+            edge_rel->rel, Anum_ag_label_edge_table_start_id);
+        edge_rel->end_id_index = find_index_on_column(
+            edge_rel->rel, Anum_ag_label_edge_table_end_id);
+    }
+
+    css->vertex_rels = NIL;
+    css->graphid_eq = get_ag_func_oid("graphid_eq", 2, GRAPHIDOID,
+                                      GRAPHIDOID);
+
+    css->bound = false;
+    css->cursor.edge_scan = NULL;
+}
+
+static TupleTableSlot *exec_cypher_expand(CustomScanState *node)
+{
+    return ExecScan(&node->ss, next_cypher_expand, recheck_cypher_expand);
+}
+
+static void end_cypher_expand(CustomScanState *node)
+{
+    cypher_expand_custom_scan_state *css =
+        (cypher_expand_custom_scan_state *)node;
+    ListCell *lc;
+    int i;
+
+    end_cursor(&css->cursor);
+
+    for (i = 0; i < css->num_edge_rels; i++)
+        heap_close(css->edge_rels[i].rel, NoLock);
+
+    foreach (lc, css->vertex_rels)
+    {
+        expand_vertex_rel *vertex_rel = lfirst(lc);
+
+        heap_close(vertex_rel->rel, NoLock);
+    }
+}
+
+// The vertex id has changed, restart the expansion from the new vertex
+static void rescan_cypher_expand(CustomScanState *node)
+{
+    cypher_expand_custom_scan_state *css =
+        (cypher_expand_custom_scan_state *)node;
+
+    end_cursor(&css->cursor);
+
+    css->bound = false;
+
+    ExecScanReScan(&node->ss);
+}
+
+Node *create_cypher_expand_plan_state(CustomScan *cscan)
+{
+    cypher_expand_custom_scan_state *cypher_css =
+        palloc0(sizeof(cypher_expand_custom_scan_state));
+
+    cypher_css->css.ss.ps.type = T_CustomScanState;
+    cypher_css->css.methods = &cypher_expand_exec_methods;
+
+    return (Node *)cypher_css;
+}
+
+/*
+ * Return the next adjacent (edge, vertex) pair of the bound vertex in the
+ * scan tuple slot. ExecScan() applies the quals and the projection.
+ */
+static TupleTableSlot *next_cypher_expand(ScanState *node)
+{
+    cypher_expand_custom_scan_state *css =
+        (cypher_expand_custom_scan_state *)node;
+    ExprContext *econtext = node->ps.ps_ExprContext;
+    TupleTableSlot *slot = node->ss_ScanTupleSlot;
+    MemoryContext old_context;
+
+    ExecClearTuple(slot);
+
+    if (!css->bound && !bind_vertex(css))
+        return slot;
+
+    for (;;)
+    {
+        TupleDesc tupdesc;
+        HeapTuple tuple;
+        Datum start_id;
+        Datum end_id;
+        Datum other_id;
+        Datum properties;
+        bool isnull;
+
+        tuple = next_adjacent_edge(css, &css->cursor, &start_id, &end_id,
+                                   &other_id);
+        if (!HeapTupleIsValid(tuple))
+            return slot;
+
+        // The label of the other end is encoded in its graphid
+        if (css->vertex_label_id != INVALID_LABEL_ID &&
+            get_graphid_label_id(DATUM_GET_GRAPHID(other_id)) !=
+                css->vertex_label_id)
+            continue;
+
+        // Skip dangling edges
+        if (!fetch_vertex(css, DATUM_GET_GRAPHID(other_id), &properties))
+            continue;
+
+        tupdesc = RelationGetDescr(
+            css->edge_rels[css->cursor.edge_rel_idx].rel);
+        slot->tts_values[cypher_expand_edge_id] = heap_getattr(
+            tuple, Anum_ag_label_edge_table_id, tupdesc, &isnull);
+        slot->tts_values[cypher_expand_start_id] = start_id;
+        slot->tts_values[cypher_expand_end_id] = end_id;
+        // The edge tuple is only valid until the next systable_getnext()
+        old_context = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+        slot->tts_values[cypher_expand_edge_properties] = datumCopy(
+            heap_getattr(tuple, Anum_ag_label_edge_table_properties, tupdesc,
+                         &isnull),
+            false, -1);
+        MemoryContextSwitchTo(old_context);
+        slot->tts_values[cypher_expand_id] = other_id;
+        slot->tts_values[cypher_expand_properties] = properties;
+        memset(slot->tts_isnull, false, sizeof(bool) * Natts_cypher_expand);
+
+        return ExecStoreVirtualTuple(slot);
+    }
+}
+
+// Cypher Expand is never the target of EvalPlanQual
+static bool recheck_cypher_expand(ScanState *node, TupleTableSlot *slot)
+{
+    return true;
+}
+
+/*
+ * Evaluate the vertex id that the expansion starts from and rewind to the
+ * first edge label table. Returns false if there is no such vertex.
+ */
+static bool bind_vertex(cypher_expand_custom_scan_state *css)
+{
+    ExprContext *econtext = css->css.ss.ps.ps_ExprContext;
+    ExprState *es;
+    Datum vertex_id;
+    bool isnull;
+
+    es = lsecond(css->arg_states);
+    vertex_id = ExecEvalExpr(es, econtext, &isnull);
+    if (isnull)
+        return false;
+
+    css->bound = true;
+    begin_cursor(&css->cursor, vertex_id);
+
+    return true;
+}
+
+static void begin_cursor(expand_cursor *cursor, Datum vertex_id)
+{
+    cursor->vertex_id = vertex_id;
+    cursor->edge_rel_idx = -1;
+    cursor->edge_attnum = InvalidAttrNumber;
+    cursor->edge_scan = NULL;
+}
+
+static void end_cursor(expand_cursor *cursor)
+{
+    if (cursor->edge_scan)
+    {
+        systable_endscan(cursor->edge_scan);
+        cursor->edge_scan = NULL;
+    }
+}
+
+/*
+ * Return the next adjacent edge of the vertex of the cursor, or NULL if there
+ * is no more. The tuple is only valid until the next call. other_id is the
+ * vertex at the other end of the edge.
+ */
+static HeapTuple next_adjacent_edge(cypher_expand_custom_scan_state *css,
+                                    expand_cursor *cursor, Datum *start_id,
+                                    Datum *end_id, Datum *other_id)
+{
+    for (;;)
+    {
+        TupleDesc tupdesc;
+        HeapTuple tuple;
+        bool isnull;
+
+        if (!cursor->edge_scan && !next_edge_scan(css, cursor))
+            return NULL;
+
+        tuple = systable_getnext(cursor->edge_scan);
+        if (!HeapTupleIsValid(tuple))
+        {
+            end_cursor(cursor);
+            continue;
+        }
+
+        tupdesc = RelationGetDescr(css->edge_rels[cursor->edge_rel_idx].rel);
+        *start_id = heap_getattr(tuple, Anum_ag_label_edge_table_start_id,
+                                 tupdesc, &isnull);
+        *end_id = heap_getattr(tuple, Anum_ag_label_edge_table_end_id,
+                               tupdesc, &isnull);
+
+        if (cursor->edge_attnum == Anum_ag_label_edge_table_start_id)
+        {
+            *other_id = *end_id;
+        }
+        else
+        {
+            /*
+             * A self-loop has already been returned by the start_id pass if
+             * the relationship has no direction.
+             */
+            if (css->dir == CYPHER_REL_DIR_NONE &&
+                DATUM_GET_GRAPHID(*start_id) == DATUM_GET_GRAPHID(*end_id))
+                continue;
+
+            *other_id = *start_id;
+        }
+
+        return tuple;
+    }
+}
+
+/*
+ * Start the scan of the next (edge label table, column) pair. The start_id
+ * column of a table is scanned before its end_id column. Returns false if
+ * all the scans are done.
+ */
+static bool next_edge_scan(cypher_expand_custom_scan_state *css,
+                           expand_cursor *cursor)
+{
+    EState *estate = css->css.ss.ps.state;
+    expand_edge_rel *edge_rel;
+    Oid index;
+    ScanKeyData scan_keys[1];
+
+    if (cursor->edge_attnum == Anum_ag_label_edge_table_start_id &&
+        css->dir == CYPHER_REL_DIR_NONE)
+    {
+        cursor->edge_attnum = Anum_ag_label_edge_table_end_id;
+    }
+    else
+    {
+        if (cursor->edge_rel_idx + 1 >= css->num_edge_rels)
+            return false;
+
+        cursor->edge_rel_idx++;
+
+        if (css->dir == CYPHER_REL_DIR_LEFT)
+            cursor->edge_attnum = Anum_ag_label_edge_table_end_id;
+        else
+            cursor->edge_attnum = Anum_ag_label_edge_table_start_id;
+    }
+
+    edge_rel = &css->edge_rels[cursor->edge_rel_idx];
+    if (cursor->edge_attnum == Anum_ag_label_edge_table_start_id)
+        index = edge_rel->start_id_index;
+    else
+        index = edge_rel->end_id_index;
+
+    ScanKeyInit(&scan_keys[0], cursor->edge_attnum, BTEqualStrategyNumber,
+                css->graphid_eq, cursor->vertex_id);
+
+    // Without an index, this falls back to a filtered heap scan
+    cursor->edge_scan = systable_beginscan(edge_rel->rel, index,
+                                           OidIsValid(index),
+                                           estate->es_snapshot, 1, scan_keys);
+
+    return true;
+}
+
+static void begin_cypher_vle(CustomScanState *node, EState *estate,
+                             int eflags)
+{
+    cypher_vle_custom_scan_state *vle = (cypher_vle_custom_scan_state *)node;
+    CustomScan *cscan = (CustomScan *)node->ss.ps.plan;
+    Const *c;
+
+    Assert(list_length(cscan->custom_exprs) == 8);
+
+    begin_cypher_expand(node, estate, eflags);
+
+    c = list_nth(cscan->custom_exprs, 5);
+    vle->min_hops = DatumGetInt32(c->constvalue);
+    c = list_nth(cscan->custom_exprs, 6);
+    vle->max_hops = DatumGetInt32(c->constvalue);
+    c = list_nth(cscan->custom_exprs, 7);
+    vle->shortest = DatumGetBool(c->constvalue);
+
+    if (vle->max_hops < 0)
+        vle->max_hops = Max(cypher_vle_max_hops, vle->min_hops);
+
+    // see next_shortest_path_end()
+    Assert(!vle->shortest || vle->min_hops <= 1);
+
+    vle->vle_context = AllocSetContextCreate(estate->es_query_cxt,
+                                             "Cypher VLE",
+                                             ALLOCSET_DEFAULT_SIZES);
+
+    // a path has at most max_hops + 1 vertices
+    if (!vle->shortest)
+    {
+        vle->frames = palloc(sizeof(*vle->frames) * (vle->max_hops + 1));
+        vle->path_edges = palloc(sizeof(*vle->path_edges) *
+                                 (vle->max_hops + 1));
+    }
+    vle->depth = -1;
+    vle->cursor_active = false;
+}
+
+static TupleTableSlot *exec_cypher_vle(CustomScanState *node)
+{
+    return ExecScan(&node->ss, next_cypher_vle, recheck_cypher_expand);
+}
+
+static void end_cypher_vle(CustomScanState *node)
+{
+    cypher_vle_custom_scan_state *vle = (cypher_vle_custom_scan_state *)node;
+
+    end_vle_cursors(vle);
+
+    end_cypher_expand(node);
+
+    MemoryContextDelete(vle->vle_context);
+}
+
+static void rescan_cypher_vle(CustomScanState *node)
+{
+    cypher_vle_custom_scan_state *vle = (cypher_vle_custom_scan_state *)node;
+
+    end_vle_cursors(vle);
+
+    rescan_cypher_expand(node);
+}
+
+Node *create_cypher_vle_plan_state(CustomScan *cscan)
+{
+    cypher_vle_custom_scan_state *cypher_css =
+        palloc0(sizeof(cypher_vle_custom_scan_state));
+
+    cypher_css->expand.css.ss.ps.type = T_CustomScanState;
+    cypher_css->expand.css.methods = &cypher_vle_exec_methods;
+
+    return (Node *)cypher_css;
+}
+
+/*
+ * Return the next vertex at the end of the paths from the bound vertex in the
+ * scan tuple slot. The vertex label only applies to the end of the paths.
+ */
+static TupleTableSlot *next_cypher_vle(ScanState *node)
+{
+    cypher_vle_custom_scan_state *vle = (cypher_vle_custom_scan_state *)node;
+    cypher_expand_custom_scan_state *css = &vle->expand;
+    TupleTableSlot *slot = node->ss_ScanTupleSlot;
+
+    ExecClearTuple(slot);
+
+    if (!css->bound)
+    {
+        if (!bind_vertex(css))
+            return slot;
+
+        start_vle(vle);
+    }
+
+    for (;;)
+    {
+        graphid id;
+        Datum properties;
+        bool found;
+
+        CHECK_FOR_INTERRUPTS();
+
+        if (vle->shortest)
+            found = next_shortest_path_end(vle, &id);
+        else
+            found = next_path_end(vle, &id);
+        if (!found)
+            return slot;
+
+        if (css->vertex_label_id != INVALID_LABEL_ID &&
+            get_graphid_label_id(id) != css->vertex_label_id)
+            continue;
+
+        // Skip dangling edges
+        if (!fetch_vertex(css, id, &properties))
+            continue;
+
+        vle->nrows++;
+        if (cypher_vle_max_rows > 0 && vle->nrows > cypher_vle_max_rows)
+        {
+            ereport(ERROR,
+                    (errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+                     errmsg("variable-length relationship returned more than %d rows for a vertex",
+                            cypher_vle_max_rows),
+                     errhint("Raise agensgraph.cypher_vle_max_rows or give the relationship an upper bound.")));
+        }
+
+        slot->tts_values[cypher_vle_id] = GRAPHID_GET_DATUM(id);
+        slot->tts_values[cypher_vle_properties] = properties;
+        memset(slot->tts_isnull, false, sizeof(bool) * Natts_cypher_vle);
+        // shortestPath() has a single relationship, there is nothing to compare
+        if (vle->shortest)
+            slot->tts_isnull[cypher_vle_edge_ids] = true;
+        else
+            slot->tts_values[cypher_vle_edge_ids] = make_path_edges_array(vle);
+
+        return ExecStoreVirtualTuple(slot);
+    }
+}
+
+// Start the expansion from the vertex that bind_vertex() has evaluated
+static void start_vle(cypher_vle_custom_scan_state *vle)
+{
+    Datum start_id = vle->expand.cursor.vertex_id;
+    MemoryContext old_context;
+
+    MemoryContextReset(vle->vle_context);
+    old_context = MemoryContextSwitchTo(vle->vle_context);
+
+    vle->visited = graphid_set_create(vle->vle_context, 256, NULL);
+    vle->start_pending = (vle->min_hops == 0);
+    vle->nrows = 0;
+
+    if (vle->shortest)
+    {
+        bool found;
+
+        graphid_set_insert(vle->visited, DATUM_GET_GRAPHID(start_id), &found);
+
+        vle->frontier_size = 64;
+        vle->frontier = palloc(sizeof(graphid) * vle->frontier_size);
+        vle->next_frontier = palloc(sizeof(graphid) * vle->frontier_size);
+        vle->frontier[0] = DATUM_GET_GRAPHID(start_id);
+        vle->frontier_len = (vle->max_hops > 0 ? 1 : 0);
+        vle->frontier_idx = 0;
+        vle->next_frontier_len = 0;
+        vle->hops = 0;
+        vle->cursor_active = false;
+    }
+    else
+    {
+        begin_cursor(&vle->frames[0], start_id);
+        vle->depth = 0;
+    }
+
+    MemoryContextSwitchTo(old_context);
+}
+
+static void end_vle_cursors(cypher_vle_custom_scan_state *vle)
+{
+    for (; vle->depth >= 0; vle->depth--)
+        end_cursor(&vle->frames[vle->depth]);
+
+    // expand.cursor is ended by Cypher Expand
+    vle->cursor_active = false;
+}
+
+/*
+ * Depth-first search of the paths whose length is between min_hops and
+ * max_hops. An edge appears at most once in a path. Returns the end of the
+ * next path, false if there is no more.
+ */
+static bool next_path_end(cypher_vle_custom_scan_state *vle, graphid *id)
+{
+    cypher_expand_custom_scan_state *css = &vle->expand;
+
+    if (vle->start_pending)
+    {
+        vle->start_pending = false;
+        *id = DATUM_GET_GRAPHID(vle->frames[0].vertex_id);
+        return true;
+    }
+
+    while (vle->depth >= 0)
+    {
+        expand_cursor *cursor = &vle->frames[vle->depth];
+        HeapTuple tuple = NULL;
+        Datum start_id;
+        Datum end_id;
+        Datum other_id;
+        graphid edge_id;
+        bool isnull;
+        bool found;
+
+        CHECK_FOR_INTERRUPTS();
+
+        // the paths cannot be longer
+        if (vle->depth < vle->max_hops)
+            tuple = next_adjacent_edge(css, cursor, &start_id, &end_id,
+                                       &other_id);
+
+        // backtrack
+        if (!HeapTupleIsValid(tuple))
+        {
+            end_cursor(cursor);
+            if (vle->depth > 0)
+                graphid_set_delete(vle->visited,
+                                   vle->path_edges[vle->depth]);
+            vle->depth--;
+            continue;
+        }
+
+        edge_id = DATUM_GET_GRAPHID(heap_getattr(
+            tuple, Anum_ag_label_edge_table_id,
+            RelationGetDescr(css->edge_rels[cursor->edge_rel_idx].rel),
+            &isnull));
+
+        graphid_set_insert(vle->visited, edge_id, &found);
+        if (found)
+            continue;
+
+        vle->depth++;
+        vle->path_edges[vle->depth] = edge_id;
+        begin_cursor(&vle->frames[vle->depth], other_id);
+
+        if (vle->depth >= vle->min_hops)
+        {
+            *id = DATUM_GET_GRAPHID(other_id);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*
+ * Build the array of the edges of the path that next_path_end() has returned
+ * last in the per-tuple memory of the scan. The array is compared with the
+ * edges of the other relationships of the pattern.
+ */
+static Datum make_path_edges_array(cypher_vle_custom_scan_state *vle)
+{
+    ExprContext *econtext = vle->expand.css.ss.ps.ps_ExprContext;
+    MemoryContext old_context;
+    Datum *elems;
+    ArrayType *array;
+    int i;
+
+    old_context = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+
+    // path_edges[i] is the edge that reached the i-th vertex of the path
+    elems = palloc(sizeof(Datum) * (vle->depth + 1));
+    for (i = 0; i < vle->depth; i++)
+        elems[i] = GRAPHID_GET_DATUM(vle->path_edges[i + 1]);
+
+    array = construct_array(elems, vle->depth, GRAPHIDOID, sizeof(graphid),
+                            true, 'd');
+
+    MemoryContextSwitchTo(old_context);
+
+    return PointerGetDatum(array);
+}
+
+/*
+ * Breadth-first search from the bound vertex. Each vertex is visited once,
+ * at the length of the shortest paths to it, and is returned if that length
+ * is at least min_hops. Returns false if there is no more vertex.
+ *
+ * A vertex whose shortest path is shorter than min_hops may still have longer
+ * paths, but it is never visited again. So, min_hops must be 0 or 1, which
+ * transform_cypher_path() makes sure of.
+ */
+static bool next_shortest_path_end(cypher_vle_custom_scan_state *vle,
+                                   graphid *id)
+{
+    cypher_expand_custom_scan_state *css = &vle->expand;
+    graphid *frontier;
+
+    if (vle->start_pending)
+    {
+        vle->start_pending = false;
+        *id = vle->frontier[0];
+        return true;
+    }
+
+    for (;;)
+    {
+        CHECK_FOR_INTERRUPTS();
+
+        if (vle->cursor_active)
+        {
+            HeapTuple tuple;
+            Datum start_id;
+            Datum end_id;
+            Datum other_id;
+            graphid other;
+            bool found;
+
+            tuple = next_adjacent_edge(css, &css->cursor, &start_id, &end_id,
+                                       &other_id);
+            if (!HeapTupleIsValid(tuple))
+            {
+                vle->cursor_active = false;
+                vle->frontier_idx++;
+                continue;
+            }
+
+            other = DATUM_GET_GRAPHID(other_id);
+
+            graphid_set_insert(vle->visited, other, &found);
+            if (found)
+                continue;
+
+            if (vle->next_frontier_len == vle->frontier_size)
+            {
+                vle->frontier_size *= 2;
+                vle->frontier = repalloc(vle->frontier,
+                                         sizeof(graphid) * vle->frontier_size);
+                vle->next_frontier = repalloc(vle->next_frontier,
+                                              sizeof(graphid) *
+                                                  vle->frontier_size);
+            }
+            vle->next_frontier[vle->next_frontier_len++] = other;
+
+            if (vle->hops + 1 >= vle->min_hops)
+            {
+                *id = other;
+                return true;
+            }
+
+            continue;
+        }
+
+        if (vle->frontier_idx < vle->frontier_len)
+        {
+            begin_cursor(&css->cursor,
+                         GRAPHID_GET_DATUM(vle->frontier[vle->frontier_idx]));
+            vle->cursor_active = true;
+            continue;
+        }
+
+        // all the vertices at the current length have been expanded
+        vle->hops++;
+        if (vle->next_frontier_len == 0 || vle->hops >= vle->max_hops)
+            return false;
+
+        frontier = vle->frontier;
+        vle->frontier = vle->next_frontier;
+        vle->frontier_len = vle->next_frontier_len;
+        vle->frontier_idx = 0;
+        vle->next_frontier = frontier;
+        vle->next_frontier_len = 0;
+    }
+}
+
+/*
+ * Look up the vertex by its id in the table of its label. The properties are
+ * copied into the per-tuple memory of the scan.
+ */
+static bool fetch_vertex(cypher_expand_custom_scan_state *css, graphid id,
+                         Datum *properties)
+{
+    EState *estate = css->css.ss.ps.state;
+    ExprContext *econtext = css->css.ss.ps.ps_ExprContext;
+    expand_vertex_rel *vertex_rel;
+    SysScanDesc scan_desc;
+    ScanKeyData scan_keys[1];
+    HeapTuple tuple;
+    bool found = false;
+
+    vertex_rel = get_vertex_rel(css, get_graphid_label_id(id));
+    if (!vertex_rel)
+        return false;
+
+    ScanKeyInit(&scan_keys[0], Anum_ag_label_vertex_table_id,
+                BTEqualStrategyNumber, css->graphid_eq, GRAPHID_GET_DATUM(id));
+
+    scan_desc = systable_beginscan(vertex_rel->rel, vertex_rel->id_index,
+                                   OidIsValid(vertex_rel->id_index),
+                                   estate->es_snapshot, 1, scan_keys);
+
+    tuple = systable_getnext(scan_desc);
+    if (HeapTupleIsValid(tuple))
+    {
+        MemoryContext old_context;
+        bool isnull;
+
+        old_context = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+        *properties = datumCopy(
+            heap_getattr(tuple, Anum_ag_label_vertex_table_properties,
+                         RelationGetDescr(vertex_rel->rel), &isnull),
+            false, -1);
+        MemoryContextSwitchTo(old_context);
+        found = true;
+    }
+
+    systable_endscan(scan_desc);
+
+    return found;
+}
+
+static expand_vertex_rel *get_vertex_rel(cypher_expand_custom_scan_state *css,
+                                         int32 label_id)
+{
+    label_cache_data *cache_data;
+    expand_vertex_rel *vertex_rel;
+    MemoryContext old_context;
+    ListCell *lc;
+
+    cache_data = search_label_graph_id_cache(css->graph_oid, label_id);
+    if (!cache_data || cache_data->kind != LABEL_KIND_VERTEX)
+        return NULL;
+
+    foreach (lc, css->vertex_rels)
+    {
+        vertex_rel = lfirst(lc);
+
+        if (RelationGetRelid(vertex_rel->rel) == cache_data->relation)
+            return vertex_rel;
+    }
+
+    // The list must survive the per-tuple memory context
+    old_context = MemoryContextSwitchTo(css->css.ss.ps.state->es_query_cxt);
+
+    vertex_rel = palloc(sizeof(expand_vertex_rel));
+    vertex_rel->rel = heap_open(cache_data->relation, AccessShareLock);
+    vertex_rel->id_index = find_index_on_column(vertex_rel->rel,
+                                                Anum_ag_label_vertex_table_id);
+    css->vertex_rels = lappend(css->vertex_rels, vertex_rel);
+
+    MemoryContextSwitchTo(old_context);
+
+    return vertex_rel;
+}
+
+// Find a btree index of the relation whose first key is the given column
+static Oid find_index_on_column(Relation rel, AttrNumber attnum)
+{
+    List *index_oids;
+    ListCell *lc;
+    Oid result = InvalidOid;
+
+    index_oids = RelationGetIndexList(rel);
+    foreach (lc, index_oids)
+    {
+        Relation index;
+
+        index = index_open(lfirst_oid(lc), AccessShareLock);
+
+        if (index->rd_rel->relam == BTREE_AM_OID &&
+            index->rd_index->indisvalid &&
+            index->rd_index->indkey.values[0] == attnum)
+            result = RelationGetRelid(index);
+
+        index_close(index, AccessShareLock);
+
+        if (OidIsValid(result))
+            break;
+    }
+    list_free(index_oids);
+
+    return result;
+}
@@ -54,6 +54,13 @@
                          (int)_node->field_name); \
     } while (0)
 
+#define write_int_field(field_name) \
+    do \
+    { \
+        appendStringInfo(str, " :" CppAsString(field_name) " %d", \
+                         _node->field_name); \
+    } while (0)
+
 #define write_location_field(field_name) \
     do \
     { \
@@ -137,6 +144,7 @@ void out_cypher_path(StringInfo str, const ExtensibleNode *node)
     DEFINE_AG_NODE(cypher_path);
 
     write_node_field(path);
+    write_bool_field(shortest);
     write_location_field(location);
 }
 
@@ -158,6 +166,9 @@ void out_cypher_relationship(StringInfo str, const ExtensibleNode *node)
     write_string_field(label);
     write_node_field(props);
     write_enum_field(dir, cypher_rel_dir);
+    write_bool_field(varlen);
+    write_int_field(min_hops);
+    write_int_field(max_hops);
 }
 
 /*
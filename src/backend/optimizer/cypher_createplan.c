@@ -17,17 +17,124 @@
 #include "postgres.h"
 
 #include "nodes/extensible.h"
+#include "nodes/makefuncs.h"
 #include "nodes/nodes.h"
 #include "nodes/pg_list.h"
 #include "nodes/plannodes.h"
 #include "nodes/relation.h"
+#include "optimizer/restrictinfo.h"
+#include "parser/parsetree.h"
 
 #include "executor/cypher_executor.h"
 #include "optimizer/cypher_createplan.h"
 
+const CustomScanMethods cypher_expand_plan_methods = {
+    "Cypher Expand", create_cypher_expand_plan_state};
+const CustomScanMethods cypher_vle_plan_methods = {
+    "Cypher VLE", create_cypher_vle_plan_state};
 const CustomScanMethods cypher_create_plan_methods = {
     "Cypher Create", create_cypher_create_plan_state};
 
+/*
+ * Parallel workers look up the methods of the CustomScan nodes in the plan
+ * they get by name.
+ */
+void register_cypher_scan_methods(void)
+{
+    static bool initialized = false;
+
+    if (initialized)
+        return;
+
+    RegisterCustomScanMethods(&cypher_expand_plan_methods);
+    RegisterCustomScanMethods(&cypher_vle_plan_methods);
+    RegisterCustomScanMethods(&cypher_create_plan_methods);
+
+    initialized = true;
+}
+
+Plan *plan_cypher_expand_path(PlannerInfo *root, RelOptInfo *rel,
+                              CustomPath *best_path, List *tlist,
+                              List *clauses, List *custom_plans)
+{
+    CustomScan *cs;
+    RangeTblEntry *rte;
+    RangeTblFunction *rtfunc;
+    List *scan_tlist = NIL;
+    ListCell *lc_type;
+    AttrNumber attno;
+
+    cs = makeNode(CustomScan);
+
+    cs->scan.plan.startup_cost = best_path->path.startup_cost;
+    cs->scan.plan.total_cost = best_path->path.total_cost;
+
+    cs->scan.plan.plan_rows = best_path->path.rows;
+    cs->scan.plan.plan_width = 0;
+
+    cs->scan.plan.parallel_aware = best_path->path.parallel_aware;
+    cs->scan.plan.parallel_safe = best_path->path.parallel_safe;
+
+    cs->scan.plan.plan_node_id = 0; // Set later in set_plan_refs
+    cs->scan.plan.targetlist = tlist;
+    cs->scan.plan.qual = extract_actual_clauses(clauses, false);
+    cs->scan.plan.lefttree = NULL;
+    cs->scan.plan.righttree = NULL;
+    cs->scan.plan.initPlan = NIL;
+
+    cs->scan.plan.extParam = NULL;
+    cs->scan.plan.allParam = NULL;
+
+    cs->scan.scanrelid = 0;
+
+    /*
+     * The scan tuple has all the columns of the function RTE, see
+     * cypher_expand_* in executor/cypher_executor.h.
+     */
+    rte = planner_rt_fetch(rel->relid, root);
+    rtfunc = linitial(rte->functions);
+    attno = 1;
+    foreach (lc_type, rtfunc->funccoltypes)
+    {
+        Var *var;
+
+        var = makeVar(rel->relid, attno, lfirst_oid(lc_type), -1, InvalidOid,
+                      0);
+        scan_tlist = lappend(scan_tlist,
+                             makeTargetEntry((Expr *)var, attno, NULL, false));
+        attno++;
+    }
+
+    cs->flags = best_path->flags;
+
+    cs->custom_plans = custom_plans;
+    /*
+     * The arguments of _cypher_expand_clause(). Core code replaces the
+     * reference to the outer vertex id with a nestloop Param.
+     */
+    cs->custom_exprs = best_path->custom_private;
+    cs->custom_private = NIL;
+    cs->custom_scan_tlist = scan_tlist;
+    cs->custom_relids = rel->relids;
+    cs->methods = &cypher_expand_plan_methods;
+
+    return (Plan *)cs;
+}
+
+// Cypher VLE is planned like Cypher Expand, see cypher_vle_* columns.
+Plan *plan_cypher_vle_path(PlannerInfo *root, RelOptInfo *rel,
+                           CustomPath *best_path, List *tlist, List *clauses,
+                           List *custom_plans)
+{
+    CustomScan *cs;
+
+    cs = (CustomScan *)plan_cypher_expand_path(root, rel, best_path, tlist,
+                                               clauses, custom_plans);
+    cs->methods = &cypher_vle_plan_methods;
+
+    return (Plan *)cs;
+}
+
 Plan *plan_cypher_create_path(PlannerInfo *root, RelOptInfo *rel,
                               CustomPath *best_path, List *tlist,
                               List *clauses, List *custom_plans)
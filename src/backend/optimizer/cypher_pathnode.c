@@ -20,13 +20,85 @@
 #include "nodes/nodes.h"
 #include "nodes/pg_list.h"
 #include "nodes/relation.h"
+#include "optimizer/cost.h"
+#include "optimizer/pathnode.h"
 
 #include "optimizer/cypher_createplan.h"
 #include "optimizer/cypher_pathnode.h"
 
+const CustomPathMethods cypher_expand_path_methods = {
+    "Cypher Expand", plan_cypher_expand_path, NULL};
+const CustomPathMethods cypher_vle_path_methods = {
+    "Cypher VLE", plan_cypher_vle_path, NULL};
 const CustomPathMethods cypher_create_path_methods = {
     "Cypher Create", plan_cypher_create_path, NULL};
 
+CustomPath *create_cypher_expand_path(PlannerInfo *root, RelOptInfo *rel,
+                                      List *custom_private)
+{
+    CustomPath *cp;
+
+    cp = makeNode(CustomPath);
+
+    cp->path.pathtype = T_CustomScan;
+
+    cp->path.parent = rel;
+    cp->path.pathtarget = rel->reltarget;
+
+    // The vertex to expand from always comes from the outer side
+    cp->path.param_info = get_baserel_parampathinfo(root, rel,
+                                                    rel->lateral_relids);
+
+    /*
+     * The scan is not parallel aware, but it can run in parallel workers.
+     * Each worker expands the vertices of the outer rows it gets.
+     */
+    cp->path.parallel_aware = false;
+    cp->path.parallel_safe = rel->consider_parallel;
+    cp->path.parallel_workers = 0;
+
+    /*
+     * rel->rows is the ROWS estimate of _cypher_expand_clause(), the average
+     * degree of a vertex. Each adjacent edge costs an index lookup on the
+     * edge table and another one on the vertex table.
+     */
+    if (cp->path.param_info)
+        cp->path.rows = cp->path.param_info->ppi_rows;
+    else
+        cp->path.rows = rel->rows;
+    cp->path.startup_cost = random_page_cost;
+    cp->path.total_cost = cp->path.startup_cost +
+                          cp->path.rows * (random_page_cost + cpu_tuple_cost +
+                                           cpu_index_tuple_cost * 2);
+
+    // No output ordering
+    cp->path.pathkeys = NULL;
+
+    // Disable all custom flags for now
+    cp->flags = 0;
+
+    cp->custom_paths = NIL;
+    cp->custom_private = custom_private;
+    cp->methods = &cypher_expand_path_methods;
+
+    return cp;
+}
+
+/*
+ * Each vertex that Cypher VLE returns costs at least the lookups of a single
+ * hop, so the path is costed like Cypher Expand with the rows of the paths.
+ */
+CustomPath *create_cypher_vle_path(PlannerInfo *root, RelOptInfo *rel,
+                                   List *custom_private)
+{
+    CustomPath *cp;
+
+    cp = create_cypher_expand_path(root, rel, custom_private);
+    cp->methods = &cypher_vle_path_methods;
+
+    return cp;
+}
+
 CustomPath *create_cypher_create_path(PlannerInfo *root, RelOptInfo *rel,
                                       List *custom_private)
 {
@@ -16,30 +16,84 @@
 
 #include "postgres.h"
 
+#include <math.h>
+
 #include "catalog/pg_type_d.h"
 #include "nodes/parsenodes.h"
 #include "nodes/primnodes.h"
 #include "nodes/relation.h"
+#include "optimizer/cost.h"
 #include "optimizer/pathnode.h"
 #include "optimizer/paths.h"
+#include "parser/parsetree.h"
 
+#include "catalog/ag_label_stats.h"
+#include "nodes/cypher_nodes.h"
 #include "optimizer/cypher_pathnode.h"
 #include "optimizer/cypher_paths.h"
 #include "utils/ag_func.h"
+#include "utils/graphid.h"
 
 typedef enum cypher_clause_kind
 {
     CYPHER_CLAUSE_NONE,
+    CYPHER_CLAUSE_EXPAND,
+    CYPHER_CLAUSE_VLE,
     CYPHER_CLAUSE_CREATE
 } cypher_clause_kind;
 
+typedef struct vertex_degree
+{
+    graphid id;
+    float8 degree;
+} vertex_degree;
+
+/*
+ * The degrees of the vertices at one end of the edges of a label. The heavy
+ * hitters are sorted by their ids to look them up with bsearch().
+ */
+typedef struct end_degrees
+{
+    float8 edges;
+    float8 rest_degree; // the degree of the vertices that are not heavy
+    float8 max_degree;
+    int num_heavy;
+    vertex_degree *heavy;
+} end_degrees;
+
+// the ends of the edges of a hop, two of them if the hop is undirected
+typedef struct hop_ends
+{
+    int num_ends;
+    end_degrees ends[2];
+} hop_ends;
+
 static set_rel_pathlist_hook_type prev_set_rel_pathlist_hook;
 
 static void set_rel_pathlist(PlannerInfo *root, RelOptInfo *rel, Index rti,
                              RangeTblEntry *rte);
 static cypher_clause_kind get_cypher_clause_kind(RangeTblEntry *rte);
+static void handle_cypher_expand_clause(PlannerInfo *root, RelOptInfo *rel,
+                                        Index rti, RangeTblEntry *rte);
+static void handle_cypher_vle_clause(PlannerInfo *root, RelOptInfo *rel,
+                                     Index rti, RangeTblEntry *rte);
 static void handle_cypher_create_clause(PlannerInfo *root, RelOptInfo *rel,
                                         Index rti, RangeTblEntry *rte);
+static void set_cypher_expand_size_estimates(PlannerInfo *root,
+                                             RelOptInfo *rel, List *args);
+static void set_cypher_vle_size_estimates(PlannerInfo *root, RelOptInfo *rel,
+                                          List *args);
+static bool get_hop_degree(PlannerInfo *root, List *args, float8 *degree,
+                           label_stats_data *stats);
+static void get_hop_args(List *args, Oid *edge_relid, cypher_rel_dir *dir);
+static void init_hop_ends(hop_ends *hop, label_stats_data *stats,
+                          cypher_rel_dir dir, bool reached);
+static void init_end_degrees(end_degrees *end, float8 edges,
+                             label_degree_stats *stats);
+static int vertex_degree_cmp(const void *a, const void *b);
+static float8 get_reached_degree(hop_ends *reached, hop_ends *next);
+static float8 get_vertex_degree(hop_ends *hop, graphid id);
+static vertex_degree *find_heavy_vertex(end_degrees *end, graphid id);
 
 void set_rel_pathlist_init(void)
 {
@@ -60,6 +114,12 @@ static void set_rel_pathlist(PlannerInfo *root, RelOptInfo *rel, Index rti,
 
     switch (get_cypher_clause_kind(rte))
     {
+    case CYPHER_CLAUSE_EXPAND:
+        handle_cypher_expand_clause(root, rel, rti, rte);
+        break;
+    case CYPHER_CLAUSE_VLE:
+        handle_cypher_vle_clause(root, rel, rti, rte);
+        break;
     case CYPHER_CLAUSE_CREATE:
         handle_cypher_create_clause(root, rel, rti, rte);
         break;
@@ -71,15 +131,40 @@ static void set_rel_pathlist(PlannerInfo *root, RelOptInfo *rel, Index rti,
 }
 
 /*
- * Check to see if the rte is a Cypher clause. An rte is only a Cypher clause
- * if it is a subquery, with the last entry in its target list, that is a
- * FuncExpr.
+ * Check to see if the rte is a Cypher clause. An rte is a Cypher clause if it
+ * is a subquery, with the last entry in its target list, that is a FuncExpr,
+ * or if it is a function RTE of a single FuncExpr.
  */
 static cypher_clause_kind get_cypher_clause_kind(RangeTblEntry *rte)
 {
     TargetEntry *te;
     FuncExpr *fe;
 
+    /*
+     * A hop of a MATCH pattern is a function RTE of _cypher_expand_clause(),
+     * or of _cypher_vle_clause() if it has a variable length.
+     */
+    if (rte->rtekind == RTE_FUNCTION)
+    {
+        RangeTblFunction *rtfunc;
+
+        if (list_length(rte->functions) != 1)
+            return CYPHER_CLAUSE_NONE;
+
+        rtfunc = linitial(rte->functions);
+        if (!IsA(rtfunc->funcexpr, FuncExpr))
+            return CYPHER_CLAUSE_NONE;
+
+        fe = (FuncExpr *)rtfunc->funcexpr;
+
+        if (is_oid_ag_func(fe->funcid, "_cypher_expand_clause"))
+            return CYPHER_CLAUSE_EXPAND;
+        else if (is_oid_ag_func(fe->funcid, "_cypher_vle_clause"))
+            return CYPHER_CLAUSE_VLE;
+        else
+            return CYPHER_CLAUSE_NONE;
+    }
+
     // If it's not a subquery, it's not a Cypher clause.
     if (rte->rtekind != RTE_SUBQUERY)
         return CYPHER_CLAUSE_NONE;
@@ -99,6 +184,382 @@ static cypher_clause_kind get_cypher_clause_kind(RangeTblEntry *rte)
         return CYPHER_CLAUSE_NONE;
 }
 
+// replace the FunctionScan path with our CustomPath
+static void handle_cypher_expand_clause(PlannerInfo *root, RelOptInfo *rel,
+                                        Index rti, RangeTblEntry *rte)
+{
+    RangeTblFunction *rtfunc;
+    FuncExpr *fe;
+    CustomPath *cp;
+
+    // Add the arguments of _cypher_expand_clause() to the CustomPath
+    rtfunc = linitial(rte->functions);
+    fe = (FuncExpr *)rtfunc->funcexpr;
+
+    // Discard any pre-existing paths
+    rel->pathlist = NIL;
+    rel->partial_pathlist = NIL;
+
+    set_cypher_expand_size_estimates(root, rel, fe->args);
+
+    cp = create_cypher_expand_path(root, rel, fe->args);
+    add_path(rel, (Path *)cp);
+}
+
+/*
+ * The row estimate of a function RTE comes from the ROWS of the function. If
+ * the edge label has been analyzed, use the degree of the vertices in the
+ * direction of the hop instead, so that the joins above the hop are planned
+ * with the real fan-out of the label.
+ */
+static void set_cypher_expand_size_estimates(PlannerInfo *root,
+                                             RelOptInfo *rel, List *args)
+{
+    label_stats_data stats;
+    float8 degree;
+
+    if (!get_hop_degree(root, args, &degree, &stats))
+        return;
+
+    // See set_function_size_estimates()
+    rel->tuples = degree;
+    rel->rows = clamp_row_est(degree *
+                              clauselist_selectivity(root,
+                                                     rel->baserestrictinfo, 0,
+                                                     JOIN_INNER, NULL));
+}
+
+// same as handle_cypher_expand_clause()
+static void handle_cypher_vle_clause(PlannerInfo *root, RelOptInfo *rel,
+                                     Index rti, RangeTblEntry *rte)
+{
+    RangeTblFunction *rtfunc;
+    FuncExpr *fe;
+    CustomPath *cp;
+
+    rtfunc = linitial(rte->functions);
+    fe = (FuncExpr *)rtfunc->funcexpr;
+
+    rel->pathlist = NIL;
+    rel->partial_pathlist = NIL;
+
+    set_cypher_vle_size_estimates(root, rel, fe->args);
+
+    cp = create_cypher_vle_path(root, rel, fe->args);
+    add_path(rel, (Path *)cp);
+}
+
+/*
+ * A vertex has degree * reached_degree^(k - 1) paths of k hops, where
+ * reached_degree is the degree of the vertices that the edges of the label
+ * reach. Only the first few lengths are counted; the paths are bounded by the
+ * edges of the label, and the shortest paths by its vertices.
+ */
+static void set_cypher_vle_size_estimates(PlannerInfo *root, RelOptInfo *rel,
+                                          List *args)
+{
+    Const *c;
+    int min_hops;
+    int max_hops;
+    bool shortest;
+    label_stats_data stats;
+    float8 degree;
+    cypher_rel_dir dir;
+    hop_ends reached;
+    hop_ends next;
+    float8 reached_degree;
+    float8 hop_paths;
+    float8 paths;
+    float8 limit;
+    int i;
+
+    // _cypher_vle_clause(graph_oid, vertex_id, edge_relation, direction,
+    //                    vertex_label_id, min_hops, max_hops, shortest)
+    c = list_nth(args, 5);
+    min_hops = DatumGetInt32(c->constvalue);
+    c = list_nth(args, 6);
+    max_hops = DatumGetInt32(c->constvalue);
+    c = list_nth(args, 7);
+    shortest = DatumGetBool(c->constvalue);
+
+    if (!get_hop_degree(root, args, &degree, &stats))
+        return;
+
+    // every hop after the first one starts at a vertex that an edge reached
+    dir = DatumGetInt32(((Const *)lfourth(args))->constvalue);
+    init_hop_ends(&reached, &stats, dir, true);
+    init_hop_ends(&next, &stats, dir, false);
+    reached_degree = get_reached_degree(&reached, &next);
+
+    if (max_hops < 0 || max_hops > min_hops + 3)
+        max_hops = min_hops + 3;
+
+    paths = 0;
+    hop_paths = 1;
+    for (i = 0; i <= max_hops; i++)
+    {
+        if (i >= min_hops)
+            paths += hop_paths;
+
+        hop_paths *= (i == 0 ? degree : reached_degree);
+    }
+
+    if (shortest)
+        limit = stats.out.vertices + stats.in.vertices;
+    else
+        limit = stats.edges;
+    paths = Min(paths, Max(limit, 1));
+
+    rel->tuples = paths;
+    rel->rows = clamp_row_est(paths *
+                              clauselist_selectivity(root,
+                                                     rel->baserestrictinfo, 0,
+                                                     JOIN_INNER, NULL));
+}
+
+/*
+ * Get the degree of the vertices in the direction of the hop from the
+ * statistics of the edge label. Returns false if the label has not been
+ * analyzed.
+ *
+ * If the hop starts at the vertex that the previous hop reached, the vertex is
+ * more likely to be one with many edges of the previous label. The degree is
+ * then weighted by how often the previous label reaches each vertex, which
+ * matters when the same vertices are heavy hitters of both labels.
+ */
+static bool get_hop_degree(PlannerInfo *root, List *args, float8 *degree,
+                           label_stats_data *stats)
+{
+    Oid edge_relid;
+    cypher_rel_dir dir;
+    Node *vertex_id;
+    RangeTblEntry *prev_rte;
+    RangeTblFunction *rtfunc;
+    List *prev_args;
+    Oid prev_edge_relid;
+    cypher_rel_dir prev_dir;
+    label_stats_data prev_stats;
+    hop_ends reached;
+    hop_ends next;
+
+    get_hop_args(args, &edge_relid, &dir);
+
+    if (!get_label_stats(edge_relid, stats))
+        return false;
+
+    if (dir == CYPHER_REL_DIR_RIGHT)
+        *degree = stats->out.avg_degree;
+    else if (dir == CYPHER_REL_DIR_LEFT)
+        *degree = stats->in.avg_degree;
+    else
+        *degree = stats->out.avg_degree + stats->in.avg_degree;
+
+    // _cypher_expand_clause(graph_oid, vertex_id, ...)
+    vertex_id = lsecond(args);
+    if (!IsA(vertex_id, Var) || ((Var *)vertex_id)->varlevelsup != 0)
+        return true;
+
+    prev_rte = planner_rt_fetch(((Var *)vertex_id)->varno, root);
+    switch (get_cypher_clause_kind(prev_rte))
+    {
+    case CYPHER_CLAUSE_EXPAND:
+    case CYPHER_CLAUSE_VLE:
+        break;
+    default:
+        return true;
+    }
+
+    rtfunc = linitial(prev_rte->functions);
+    prev_args = ((FuncExpr *)rtfunc->funcexpr)->args;
+    get_hop_args(prev_args, &prev_edge_relid, &prev_dir);
+
+    if (!get_label_stats(prev_edge_relid, &prev_stats))
+        return true;
+
+    init_hop_ends(&reached, &prev_stats, prev_dir, true);
+    init_hop_ends(&next, stats, dir, false);
+    *degree = get_reached_degree(&reached, &next);
+
+    return true;
+}
+
+static void get_hop_args(List *args, Oid *edge_relid, cypher_rel_dir *dir)
+{
+    Const *c;
+
+    // the arguments of _cypher_expand_clause(graph_oid, vertex_id,
+    // edge_relation, direction, vertex_label_id) start _cypher_vle_clause()
+    c = lthird(args);
+    *edge_relid = DatumGetObjectId(c->constvalue);
+    c = lfourth(args);
+    *dir = DatumGetInt32(c->constvalue);
+}
+
+/*
+ * The vertices that the edges of a hop reach are the end vertices of them if
+ * the hop goes to the right. The vertices that the hop starts from are the
+ * start vertices of them instead. An undirected hop does both.
+ */
+static void init_hop_ends(hop_ends *hop, label_stats_data *stats,
+                          cypher_rel_dir dir, bool reached)
+{
+    label_degree_stats *first;
+    label_degree_stats *second;
+
+    if ((dir == CYPHER_REL_DIR_RIGHT) == reached)
+    {
+        first = &stats->in;
+        second = &stats->out;
+    }
+    else
+    {
+        first = &stats->out;
+        second = &stats->in;
+    }
+
+    init_end_degrees(&hop->ends[0], stats->edges, first);
+    if (dir == CYPHER_REL_DIR_NONE)
+    {
+        init_end_degrees(&hop->ends[1], stats->edges, second);
+        hop->num_ends = 2;
+    }
+    else
+    {
+        hop->num_ends = 1;
+    }
+}
+
+// See compute_degree_stats()
+static void init_end_degrees(end_degrees *end, float8 edges,
+                             label_degree_stats *stats)
+{
+    float8 heavy_edges = 0;
+    int i;
+
+    end->edges = edges;
+    end->max_degree = stats->max_degree;
+    end->num_heavy = stats->num_heavy;
+    end->heavy = palloc(sizeof(vertex_degree) * stats->num_heavy);
+    for (i = 0; i < stats->num_heavy; i++)
+    {
+        end->heavy[i].id = DATUM_GET_GRAPHID(stats->heavy_ids[i]);
+        end->heavy[i].degree = stats->heavy_degrees[i];
+        heavy_edges += stats->heavy_degrees[i];
+    }
+    qsort(end->heavy, end->num_heavy, sizeof(vertex_degree),
+          vertex_degree_cmp);
+
+    if (stats->vertices > stats->num_heavy)
+    {
+        end->rest_degree = Max(edges - heavy_edges, 0) /
+                           (stats->vertices - stats->num_heavy);
+    }
+    else
+    {
+        end->rest_degree = 0;
+    }
+}
+
+static int vertex_degree_cmp(const void *a, const void *b)
+{
+    graphid id_a = ((const vertex_degree *)a)->id;
+    graphid id_b = ((const vertex_degree *)b)->id;
+
+    if (id_a < id_b)
+        return -1;
+    else if (id_a > id_b)
+        return 1;
+    else
+        return 0;
+}
+
+/*
+ * The average degree of the next hop over the vertices that the edges of the
+ * reached hop reach, where each vertex counts as many times as it is reached.
+ * The vertices that are not heavy hitters of the reached hop are reached
+ * rest_degree times each.
+ */
+static float8 get_reached_degree(hop_ends *reached, hop_ends *next)
+{
+    float8 next_rest_degree = 0;
+    float8 next_max_degree = 0;
+    float8 total = 0;
+    float8 weights = 0;
+    int i;
+    int j;
+    int k;
+
+    for (i = 0; i < next->num_ends; i++)
+    {
+        next_rest_degree += next->ends[i].rest_degree;
+        next_max_degree += next->ends[i].max_degree;
+    }
+
+    for (i = 0; i < reached->num_ends; i++)
+    {
+        end_degrees *end = &reached->ends[i];
+        float8 heavy_edges = 0;
+
+        for (j = 0; j < end->num_heavy; j++)
+        {
+            total += end->heavy[j].degree *
+                     get_vertex_degree(next, end->heavy[j].id);
+            heavy_edges += end->heavy[j].degree;
+        }
+
+        total += Max(end->edges - heavy_edges, 0) * next_rest_degree;
+
+        // heavy hitters of the next hop among the rest of the vertices
+        for (j = 0; j < next->num_ends; j++)
+        {
+            end_degrees *next_end = &next->ends[j];
+
+            for (k = 0; k < next_end->num_heavy; k++)
+            {
+                vertex_degree *v = &next_end->heavy[k];
+
+                if (find_heavy_vertex(end, v->id))
+                    continue;
+
+                total += end->rest_degree *
+                         (v->degree - next_end->rest_degree);
+            }
+        }
+
+        weights += end->edges;
+    }
+
+    if (weights <= 0)
+        return next_rest_degree;
+
+    return Min(total / weights, next_max_degree);
+}
+
+static float8 get_vertex_degree(hop_ends *hop, graphid id)
+{
+    float8 degree = 0;
+    int i;
+
+    for (i = 0; i < hop->num_ends; i++)
+    {
+        vertex_degree *v = find_heavy_vertex(&hop->ends[i], id);
+
+        degree += (v ? v->degree : hop->ends[i].rest_degree);
+    }
+
+    return degree;
+}
+
+static vertex_degree *find_heavy_vertex(end_degrees *end, graphid id)
+{
+    vertex_degree key;
+
+    key.id = id;
+
+    return bsearch(&key, end->heavy, end->num_heavy, sizeof(vertex_degree),
+                   vertex_degree_cmp);
+}
+
 // replace all possible paths with our CustomPath
 static void handle_cypher_create_clause(PlannerInfo *root, RelOptInfo *rel,
                                         Index rti, RangeTblEntry *rte)
@@ -38,7 +38,9 @@
 #include "parser/cypher_clause.h"
 #include "parser/cypher_parse_node.h"
 #include "parser/cypher_parser.h"
+#include "utils/ag_cache.h"
 #include "utils/ag_func.h"
+#include "utils/ag_stat.h"
 #include "utils/agtype.h"
 
 static post_parse_analyze_hook_type prev_post_parse_analyze_hook;
@@ -153,8 +155,18 @@ static bool convert_cypher_walker(Node *node, ParseState *pstate)
 
     if (IsA(node, Query))
     {
+        Query *query = (Query *)node;
         int flags;
 
+        // EXPLAIN keeps the analyzed query in its utility statement
+        if (query->commandType == CMD_UTILITY &&
+            IsA(query->utilityStmt, ExplainStmt))
+        {
+            ExplainStmt *explain_stmt = (ExplainStmt *)query->utilityStmt;
+
+            return convert_cypher_walker(explain_stmt->query, pstate);
+        }
+
         /*
          * QTW_EXAMINE_RTES
          *     We convert RTE_FUNCTION (cypher()) to RTE_SUBQUERY (SELECT)
@@ -171,8 +183,7 @@ static bool convert_cypher_walker(Node *node, ParseState *pstate)
         flags = QTW_EXAMINE_RTES | QTW_IGNORE_RT_SUBQUERIES |
                 QTW_IGNORE_JOINALIASES;
 
-        return query_tree_walker((Query *)node, convert_cypher_walker, pstate,
-                                 flags);
+        return query_tree_walker(query, convert_cypher_walker, pstate, flags);
     }
 
     return expression_tree_walker(node, convert_cypher_walker, pstate);
@@ -225,6 +236,7 @@ static void convert_cypher_to_subquery(RangeTblEntry *rte, ParseState *pstate)
     errpos_ecb_state ecb_state;
     List *stmt;
     Query *query;
+    instr_time start;
 
     /*
      * We cannot apply this feature directly to SELECT subquery because the
@@ -307,13 +319,29 @@ static void convert_cypher_to_subquery(RangeTblEntry *rte, ParseState *pstate)
         params = NULL;
     }
 
+    /*
+     * The same query strings are usually issued over and over again. If the
+     * query has been analyzed before, skip parsing and analyzing it.
+     */
+    query = search_cypher_query_cache(graph_oid, query_str, params,
+                                      rtfunc->funccoltypes,
+                                      rtfunc->funccoltypmods);
+    if (query)
+    {
+        rte->rtekind = RTE_SUBQUERY;
+        rte->subquery = query;
+        return;
+    }
+
     /*
      * install error context callback to adjust an error position for
      * parse_cypher() since locations that parse_cypher() stores are 0 based
      */
     setup_errpos_ecb(&ecb_state, pstate, query_loc);
 
+    ag_stat_start_timer(&start);
     stmt = parse_cypher(query_str);
+    ag_stat_stop_timer(AG_STAT_PARSE_CALLS, AG_STAT_PARSE_TIME, &start);
 
     cancel_errpos_ecb(&ecb_state);
 
@@ -341,14 +369,28 @@ static void convert_cypher_to_subquery(RangeTblEntry *rte, ParseState *pstate)
                      parser_errposition(pstate, exprLocation(rtfunc->funcexpr))));
         }
 
+        ag_stat_start_timer(&start);
         query = analyze_cypher(stmt, pstate, query_str, query_loc,
                                NameStr(*graph_name), graph_oid, params);
+        ag_stat_stop_timer(AG_STAT_ANALYZE_CALLS, AG_STAT_ANALYZE_TIME,
+                           &start);
     }
     else
     {
+        ag_stat_start_timer(&start);
         query = analyze_cypher_and_coerce(stmt, rtfunc, pstate, query_str,
                                           query_loc, NameStr(*graph_name),
                                           graph_oid, params);
+        ag_stat_stop_timer(AG_STAT_ANALYZE_CALLS, AG_STAT_ANALYZE_TIME,
+                           &start);
+
+        /*
+         * Queries that end with CREATE clause are not cached because the
+         * pattern of the clause is passed to the executor by a pointer.
+         */
+        store_cypher_query_cache(graph_oid, query_str, params,
+                                 rtfunc->funccoltypes, rtfunc->funccoltypmods,
+                                 query);
     }
 
     pstate->p_lateral_active = false;
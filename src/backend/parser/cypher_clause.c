@@ -23,23 +23,28 @@
 #include "nodes/parsenodes.h"
 #include "nodes/pg_list.h"
 #include "nodes/primnodes.h"
+#include "optimizer/clauses.h"
 #include "optimizer/var.h"
+#include "parser/parse_agg.h"
 #include "parser/parse_clause.h"
 #include "parser/parse_coerce.h"
 #include "parser/parse_collate.h"
 #include "parser/parse_expr.h"
 #include "parser/parse_func.h"
 #include "parser/parse_node.h"
+#include "parser/parse_oper.h"
 #include "parser/parse_relation.h"
 #include "parser/parse_target.h"
 #include "parser/parsetree.h"
 #include "rewrite/rewriteHandler.h"
+#include "rewrite/rewriteManip.h"
 #include "utils/lsyscache.h"
 #include "utils/rel.h"
 
 #include "catalog/ag_graph.h"
 #include "catalog/ag_label.h"
 #include "commands/label_commands.h"
+#include "executor/cypher_executor.h"
 #include "nodes/ag_nodes.h"
 #include "nodes/cypher_nodes.h"
 #include "parser/cypher_clause.h"
@@ -54,9 +59,21 @@
 typedef Query *(*transform_method) (cypher_parsestate *cpstate,
                                     cypher_clause *clause);
 
+// column names of the RTE's for _cypher_expand_clause()
+static const char *cypher_expand_colnames[Natts_cypher_expand] = {
+    "edge_id", "start_id", "end_id", "edge_properties", "id", "properties"};
+
+// column names of the RTE's for _cypher_vle_clause()
+static const char *cypher_vle_colnames[Natts_cypher_vle] = {
+    "id", "properties", "edge_ids"};
+
 // projection
 static Query *transform_cypher_return(cypher_parsestate *cpstate,
                                       cypher_clause *clause);
+static Query *transform_cypher_with_return(cypher_parsestate *cpstate,
+                                           cypher_clause *clause);
+static Query *transform_cypher_projection(cypher_parsestate *cpstate,
+                                          cypher_clause *clause, bool is_with);
 static List *transform_cypher_order_by(cypher_parsestate *cpstate,
                                        List *sort_items, List **target_list,
                                        ParseExprKind expr_kind);
@@ -66,6 +83,7 @@ static TargetEntry *find_target_list_entry(cypher_parsestate *cpstate,
 static Node *transform_cypher_limit(cypher_parsestate *cpstate, Node *node,
                                     ParseExprKind expr_kind,
                                     const char *construct_name);
+static List *make_implicit_group_clause(List *target_list);
 static Query *transform_cypher_with(cypher_parsestate *cpstate,
                                     cypher_clause *clause);
 static Query *transform_cypher_clause_with_where(cypher_parsestate *cpstate,
@@ -78,11 +96,41 @@ static Query *transform_cypher_match(cypher_parsestate *cpstate,
                                      cypher_clause *clause);
 static Query *transform_cypher_match_pattern(cypher_parsestate *cpstate,
                                              cypher_clause *clause);
-static cypher_node *get_node_from_pattern(ParseState *pstate, List *pattern);
-static void transform_cypher_node(cypher_parsestate *cpstate,
-                                  cypher_node *node, List **target_list);
+static cypher_path *get_path_from_pattern(ParseState *pstate, List *pattern);
+static void transform_cypher_path(cypher_parsestate *cpstate,
+                                  cypher_path *path, List **target_list,
+                                  List **quals);
+static RangeTblEntry *transform_cypher_node(cypher_parsestate *cpstate,
+                                            cypher_node *node,
+                                            List **target_list, List **quals);
+static RangeTblEntry *transform_cypher_expand(cypher_parsestate *cpstate,
+                                              RangeTblEntry *prev_rte,
+                                              cypher_relationship *rel,
+                                              cypher_node *node, bool shortest,
+                                              List **target_list,
+                                              List **quals);
+static List *make_relationship_uniqueness_quals(cypher_parsestate *cpstate,
+                                                List *rels, List *rtes,
+                                                List *quals);
+static Node *make_edges_differ_qual(cypher_parsestate *cpstate,
+                                    cypher_relationship *rel1,
+                                    RangeTblEntry *rte1,
+                                    cypher_relationship *rel2,
+                                    RangeTblEntry *rte2);
+static List *transform_cypher_properties_quals(cypher_parsestate *cpstate,
+                                              RangeTblEntry *rte,
+                                              char *colname, Node *props,
+                                              List *quals);
+static void add_label_rte(cypher_parsestate *cpstate, Oid relid);
+static void add_vertex_columns_target_entries(cypher_parsestate *cpstate,
+                                              RangeTblEntry *rte,
+                                              List **target_list);
+static List *add_vertex_columns_of_items(cypher_parsestate *cpstate,
+                                         List *target_list);
 static Node *make_vertex_expr(cypher_parsestate *cpstate, RangeTblEntry *rte,
                               char *label);
+static Node *make_edge_expr(cypher_parsestate *cpstate, RangeTblEntry *rte);
+static Node *make_graph_oid_const(cypher_parsestate *cpstate);
 
 // updating clause
 static Query *transform_cypher_create(cypher_parsestate *cpstate,
@@ -137,6 +185,19 @@ Query *transform_cypher_clause(cypher_parsestate *cpstate,
 
 static Query *transform_cypher_return(cypher_parsestate *cpstate,
                                       cypher_clause *clause)
+{
+    return transform_cypher_projection(cpstate, clause, false);
+}
+
+// the RETURN clause that a WITH clause is transformed into
+static Query *transform_cypher_with_return(cypher_parsestate *cpstate,
+                                           cypher_clause *clause)
+{
+    return transform_cypher_projection(cpstate, clause, true);
+}
+
+static Query *transform_cypher_projection(cypher_parsestate *cpstate,
+                                          cypher_clause *clause, bool is_with)
 {
     ParseState *pstate = (ParseState *)cpstate;
     cypher_return *self = (cypher_return *)clause->self;
@@ -151,6 +212,11 @@ static Query *transform_cypher_return(cypher_parsestate *cpstate,
     query->targetList = transform_cypher_item_list(cpstate, self->items,
                                                    EXPR_KIND_SELECT_TARGET);
 
+    // the columns of RETURN clause are the result of the query
+    if (is_with)
+        query->targetList = add_vertex_columns_of_items(cpstate,
+                                                        query->targetList);
+
     markTargetListOrigins(pstate, query->targetList);
 
     // ORDER BY
@@ -158,7 +224,12 @@ static Query *transform_cypher_return(cypher_parsestate *cpstate,
                                                   &query->targetList,
                                                   EXPR_KIND_ORDER_BY);
 
-    // TODO: auto GROUP BY for aggregation
+    // items without aggregates are the grouping keys of items with them
+    if (pstate->p_hasAggs)
+    {
+        query->hasAggs = true;
+        query->groupClause = make_implicit_group_clause(query->targetList);
+    }
 
     // DISTINCT
     if (self->distinct)
@@ -186,9 +257,45 @@ static Query *transform_cypher_return(cypher_parsestate *cpstate,
 
     assign_query_collations(pstate, query);
 
+    if (query->hasAggs)
+        parseCheckAggregates(pstate, query);
+
     return query;
 }
 
+// see addTargetToGroupList()
+static List *make_implicit_group_clause(List *target_list)
+{
+    List *group_list = NIL;
+    ListCell *lt;
+
+    foreach (lt, target_list)
+    {
+        TargetEntry *te = lfirst(lt);
+        SortGroupClause *grpcl;
+        Oid sortop;
+        Oid eqop;
+        bool hashable;
+
+        if (te->resjunk || contain_aggs_of_level((Node *)te->expr, 0))
+            continue;
+
+        get_sort_group_operators(exprType((Node *)te->expr), false, true,
+                                 false, &sortop, &eqop, NULL, &hashable);
+
+        grpcl = makeNode(SortGroupClause);
+        grpcl->tleSortGroupRef = assignSortGroupRef(te, target_list);
+        grpcl->eqop = eqop;
+        grpcl->sortop = sortop;
+        grpcl->nulls_first = false;
+        grpcl->hashable = hashable;
+
+        group_list = lappend(group_list, grpcl);
+    }
+
+    return group_list;
+}
+
 // see transformSortClause()
 static List *transform_cypher_order_by(cypher_parsestate *cpstate,
                                        List *sort_items, List **target_list,
@@ -291,7 +398,8 @@ static Query *transform_cypher_with(cypher_parsestate *cpstate,
     wrapper->self = (Node *)return_clause;
     wrapper->prev = clause->prev;
 
-    return transform_cypher_clause_with_where(cpstate, transform_cypher_return,
+    return transform_cypher_clause_with_where(cpstate,
+                                              transform_cypher_with_return,
                                               wrapper, self->where);
 }
 
@@ -353,6 +461,7 @@ static Query *transform_cypher_match_pattern(cypher_parsestate *cpstate,
     ParseState *pstate = (ParseState *)cpstate;
     cypher_match *self = (cypher_match *)clause->self;
     Query *query;
+    List *quals = NIL;
 
     query = makeNode(Query);
     query->commandType = CMD_SELECT;
@@ -376,19 +485,17 @@ static Query *transform_cypher_match_pattern(cypher_parsestate *cpstate,
 
     // TODO: transform self->pattern into a connected component
 
-    /*
-     * TODO: transform the connected component into RangeTblEntry's and
-     *       TargetEntry's
-     */
-    // NOTE: for now, only patterns that have a single node are supported
-    transform_cypher_node(cpstate,
-                          get_node_from_pattern(pstate, self->pattern),
-                          &query->targetList);
+    // NOTE: for now, only patterns that have a single path are supported
+    transform_cypher_path(cpstate,
+                          get_path_from_pattern(pstate, self->pattern),
+                          &query->targetList, &quals);
 
     markTargetListOrigins(pstate, query->targetList);
 
     query->rtable = pstate->p_rtable;
-    query->jointree = makeFromExpr(pstate->p_joinlist, NULL);
+    query->jointree = makeFromExpr(pstate->p_joinlist,
+                                   quals ? (Node *)make_ands_explicit(quals)
+                                         : NULL);
 
     assign_query_collations(pstate, query);
 
@@ -396,32 +503,138 @@ static Query *transform_cypher_match_pattern(cypher_parsestate *cpstate,
 }
 
 /*
- * NOTE: a temporary logic that checks whether given pattern has only 1 node
- *       and returns the node
+ * NOTE: a temporary logic that checks whether given pattern has only 1 path
+ *       and returns the path
  */
-static cypher_node *get_node_from_pattern(ParseState *pstate, List *pattern)
+static cypher_path *get_path_from_pattern(ParseState *pstate, List *pattern)
 {
     cypher_path *path;
-    cypher_node *node;
 
     // a pattern has at least 1 path that has at least 1 node
     path = linitial(pattern);
-    node = linitial(path->path);
 
     // only 1 path
-    if (list_length(pattern) > 1 || list_length(path->path) > 1)
+    if (list_length(pattern) > 1)
     {
+        cypher_path *next_path = lsecond(pattern);
+
         ereport(ERROR,
                 (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-                 errmsg("MATCH clause can have only 1 node"),
-                 parser_errposition(pstate, path->location)));
+                 errmsg("MATCH clause can have only 1 path"),
+                 parser_errposition(pstate, next_path->location)));
+    }
+
+    return path;
+}
+
+/*
+ * The first node of the path becomes a scan of its label table. Every
+ * following (relationship, node) pair becomes a LATERAL function RTE of
+ * _cypher_expand_clause() that is bound to the id of the previous node. The
+ * planner replaces those RTE's with the Cypher Expand custom scan, which looks
+ * up the adjacent edges of the bound vertex instead of joining the edge and
+ * the vertex tables.
+ */
+static void transform_cypher_path(cypher_parsestate *cpstate,
+                                  cypher_path *path, List **target_list,
+                                  List **quals)
+{
+    ParseState *pstate = (ParseState *)cpstate;
+    List *names = NIL;
+    List *rels = NIL;
+    List *rel_rtes = NIL;
+    RangeTblEntry *rte;
+    ListCell *lc;
+
+    // NOTE: for now, a variable cannot appear twice in a path
+    foreach (lc, path->path)
+    {
+        Node *entity = lfirst(lc);
+        char *name;
+        int location;
+        ListCell *lc_name;
+
+        if (is_ag_node(entity, cypher_node))
+        {
+            name = ((cypher_node *)entity)->name;
+            location = ((cypher_node *)entity)->location;
+        }
+        else
+        {
+            name = ((cypher_relationship *)entity)->name;
+            location = ((cypher_relationship *)entity)->location;
+        }
+
+        if (!name)
+            continue;
+
+        foreach (lc_name, names)
+        {
+            if (strcmp(name, lfirst(lc_name)) == 0)
+            {
+                ereport(ERROR,
+                        (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                         errmsg("variable \"%s\" cannot appear more than once in a path",
+                                name),
+                         parser_errposition(pstate, location)));
+            }
+        }
+
+        names = lappend(names, name);
+    }
+
+    // shortestPath() has a single relationship whose length can be 0 or 1
+    if (path->shortest)
+    {
+        cypher_relationship *rel;
+
+        if (list_length(path->path) != 3)
+        {
+            ereport(ERROR,
+                    (errcode(ERRCODE_SYNTAX_ERROR),
+                     errmsg("shortestPath() requires a path with a single relationship"),
+                     parser_errposition(pstate, path->location)));
+        }
+
+        rel = lsecond(path->path);
+        if (!rel->varlen)
+        {
+            rel->varlen = true;
+            rel->min_hops = 1;
+            rel->max_hops = 1;
+        }
+        else if (rel->min_hops > 1)
+        {
+            ereport(ERROR,
+                    (errcode(ERRCODE_SYNTAX_ERROR),
+                     errmsg("the minimum length of a relationship in shortestPath() must be 0 or 1"),
+                     parser_errposition(pstate, rel->location)));
+        }
+    }
+
+    lc = list_head(path->path);
+    rte = transform_cypher_node(cpstate, lfirst(lc), target_list, quals);
+
+    // a path is [ node ( , relationship , node , ... ) ]
+    for (lc = lnext(lc); lc != NULL; lc = lnext(lnext(lc)))
+    {
+        cypher_relationship *rel = lfirst(lc);
+        cypher_node *node = lfirst(lnext(lc));
+
+        rte = transform_cypher_expand(cpstate, rte, rel, node, path->shortest,
+                                      target_list, quals);
+
+        rels = lappend(rels, rel);
+        rel_rtes = lappend(rel_rtes, rte);
     }
 
-    return node;
+    *quals = make_relationship_uniqueness_quals(cpstate, rels, rel_rtes,
+                                                *quals);
 }
 
-static void transform_cypher_node(cypher_parsestate *cpstate,
-                                  cypher_node *node, List **target_list)
+static RangeTblEntry *transform_cypher_node(cypher_parsestate *cpstate,
+                                            cypher_node *node,
+                                            List **target_list, List **quals)
 {
     ParseState *pstate = (ParseState *)cpstate;
     char *schema_name;
@@ -433,8 +646,8 @@ static void transform_cypher_node(cypher_parsestate *cpstate,
     TargetEntry *te;
 
     /*
-     * NOTE: for now, nodes without a name are not supported because
-     *       patterns can have only 1 node
+     * NOTE: for now, the first node of a path must have a name because it is
+     *       the only node that is not bound to a previous one
      */
     if (!node->name)
     {
@@ -450,15 +663,6 @@ static void transform_cypher_node(cypher_parsestate *cpstate,
         node->label = "_ag_label_vertex";
     }
 
-    // NOTE: for now, nodes with a property condition are not supported
-    if (node->props)
-    {
-        ereport(ERROR,
-                (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-                 errmsg("nodes with a property condition are not supported"),
-                 parser_errposition(pstate, node->location)));
-    }
-
     schema_name = get_graph_namespace_name(cpstate->graph_name);
     rel_name = get_label_relation_name(node->label, cpstate->graph_oid);
     label_range_var = makeRangeVar(schema_name, rel_name, -1);
@@ -476,43 +680,527 @@ static void transform_cypher_node(cypher_parsestate *cpstate,
     te = makeTargetEntry((Expr *)make_vertex_expr(cpstate, rte, node->label),
                          resno, node->name, false);
     *target_list = lappend(*target_list, te);
+
+    add_vertex_columns_target_entries(cpstate, rte, target_list);
+
+    *quals = transform_cypher_properties_quals(cpstate, rte, "properties",
+                                               node->props, *quals);
+
+    return rte;
 }
 
-static Node *make_vertex_expr(cypher_parsestate *cpstate, RangeTblEntry *rte,
-                              char *label)
+/*
+ * Transform the hop (prev)-[rel]-(node) into a LATERAL function RTE whose
+ * columns are the ones of cypher_expand_colnames. A hop of variable length is
+ * a function RTE of _cypher_vle_clause() whose columns are the ones of
+ * cypher_vle_colnames instead.
+ */
+static RangeTblEntry *transform_cypher_expand(cypher_parsestate *cpstate,
+                                              RangeTblEntry *prev_rte,
+                                              cypher_relationship *rel,
+                                              cypher_node *node, bool shortest,
+                                              List **target_list, List **quals)
+{
+    ParseState *pstate = (ParseState *)cpstate;
+    char *edge_label;
+    Oid edge_relid;
+    int32 vertex_label_id;
+    Node *prev_id;
+    List *args;
+    Oid func_oid;
+    FuncExpr *func_expr;
+    RangeTblFunction *rtfunc;
+    List *colnames = NIL;
+    RangeTblEntry *rte;
+    int ncolumns;
+    int i;
+
+    if (rel->varlen)
+    {
+        // the condition applies to every edge of the paths, not to a column
+        if (rel->props)
+        {
+            ereport(ERROR,
+                    (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                     errmsg("variable-length relationships with a property condition are not supported"),
+                     parser_errposition(pstate, rel->location)));
+        }
+
+        // NOTE: for now, there is no type for the list of edges of a path
+        if (rel->name)
+        {
+            ereport(ERROR,
+                    (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                     errmsg("variable-length relationships with a variable are not supported"),
+                     parser_errposition(pstate, rel->location)));
+        }
+
+        if (rel->max_hops >= 0 && rel->min_hops > rel->max_hops)
+        {
+            ereport(ERROR,
+                    (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                     errmsg("the minimum length of a relationship cannot be greater than its maximum length"),
+                     parser_errposition(pstate, rel->location)));
+        }
+    }
+
+    // a relationship without a label matches edges of all labels
+    edge_label = rel->label ? rel->label : AG_DEFAULT_LABEL_EDGE;
+    edge_relid = get_label_relation(edge_label, cpstate->graph_oid);
+    if (!OidIsValid(edge_relid))
+    {
+        ereport(ERROR,
+                (errcode(ERRCODE_UNDEFINED_TABLE),
+                 errmsg("label \"%s\" does not exist", edge_label),
+                 parser_errposition(pstate, rel->location)));
+    }
+    add_label_rte(cpstate, edge_relid);
+
+    // a node without a label matches vertices of all labels
+    if (!node->label)
+        node->label = AG_DEFAULT_LABEL_VERTEX;
+
+    if (strcmp(node->label, AG_DEFAULT_LABEL_VERTEX) == 0)
+    {
+        vertex_label_id = INVALID_LABEL_ID;
+    }
+    else
+    {
+        vertex_label_id = get_label_id(node->label, cpstate->graph_oid);
+        if (!label_id_is_valid(vertex_label_id))
+        {
+            ereport(ERROR,
+                    (errcode(ERRCODE_UNDEFINED_TABLE),
+                     errmsg("label \"%s\" does not exist", node->label),
+                     parser_errposition(pstate, node->location)));
+        }
+    }
+    add_label_rte(cpstate, get_label_relation(node->label, cpstate->graph_oid));
+
+    // _cypher_expand_clause(graph_oid, vertex_id, edge_relation, direction,
+    //                       vertex_label_id)
+    prev_id = scanRTEForColumn(pstate, prev_rte, "id", -1, 0, NULL);
+    args = list_make4(makeConst(OIDOID, -1, InvalidOid, sizeof(Oid),
+                                ObjectIdGetDatum(cpstate->graph_oid), false,
+                                true),
+                      prev_id,
+                      makeConst(OIDOID, -1, InvalidOid, sizeof(Oid),
+                                ObjectIdGetDatum(edge_relid), false, true),
+                      makeConst(INT4OID, -1, InvalidOid, sizeof(int32),
+                                Int32GetDatum(rel->dir), false, true));
+    args = lappend(args, makeConst(INT4OID, -1, InvalidOid, sizeof(int32),
+                                   Int32GetDatum(vertex_label_id), false,
+                                   true));
+
+    if (rel->varlen)
+    {
+        // _cypher_vle_clause(..., min_hops, max_hops, shortest)
+        args = lappend(args, makeConst(INT4OID, -1, InvalidOid, sizeof(int32),
+                                       Int32GetDatum(rel->min_hops), false,
+                                       true));
+        args = lappend(args, makeConst(INT4OID, -1, InvalidOid, sizeof(int32),
+                                       Int32GetDatum(rel->max_hops), false,
+                                       true));
+        args = lappend(args, makeBoolConst(shortest, false));
+
+        func_oid = get_ag_func_oid("_cypher_vle_clause", 8, OIDOID,
+                                   GRAPHIDOID, OIDOID, INT4OID, INT4OID,
+                                   INT4OID, INT4OID, BOOLOID);
+        ncolumns = Natts_cypher_vle;
+    }
+    else
+    {
+        func_oid = get_ag_func_oid("_cypher_expand_clause", 5, OIDOID,
+                                   GRAPHIDOID, OIDOID, INT4OID, INT4OID);
+        ncolumns = Natts_cypher_expand;
+    }
+
+    func_expr = makeFuncExpr(func_oid, RECORDOID, args, InvalidOid,
+                             InvalidOid, COERCE_EXPLICIT_CALL);
+    func_expr->funcretset = true;
+    func_expr->location = -1;
+
+    rtfunc = makeNode(RangeTblFunction);
+    rtfunc->funcexpr = (Node *)func_expr;
+    rtfunc->funccolcount = ncolumns;
+    rtfunc->funccolnames = NIL;
+    rtfunc->funccoltypes = NIL;
+    rtfunc->funccoltypmods = NIL;
+    rtfunc->funccolcollations = NIL;
+    rtfunc->funcparams = NULL;
+
+    for (i = 0; i < ncolumns; i++)
+    {
+        const char *colname;
+        Oid type;
+
+        if (rel->varlen)
+        {
+            colname = cypher_vle_colnames[i];
+            if (i == cypher_vle_properties)
+                type = AGTYPEOID;
+            else if (i == cypher_vle_edge_ids)
+                type = GRAPHIDARRAYOID;
+            else
+                type = GRAPHIDOID;
+        }
+        else
+        {
+            colname = cypher_expand_colnames[i];
+            if (i == cypher_expand_edge_properties ||
+                i == cypher_expand_properties)
+                type = AGTYPEOID;
+            else
+                type = GRAPHIDOID;
+        }
+
+        colnames = lappend(colnames, makeString(pstrdup(colname)));
+        rtfunc->funccoltypes = lappend_oid(rtfunc->funccoltypes, type);
+        rtfunc->funccoltypmods = lappend_int(rtfunc->funccoltypmods, -1);
+        rtfunc->funccolcollations = lappend_oid(rtfunc->funccolcollations,
+                                                InvalidOid);
+    }
+    rtfunc->funccolnames = colnames;
+
+    rte = makeNode(RangeTblEntry);
+    rte->rtekind = RTE_FUNCTION;
+    rte->functions = list_make1(rtfunc);
+    rte->funcordinality = false;
+    rte->alias = NULL;
+    rte->eref = makeAlias(rel->varlen ? "_vle" : "_expand", colnames);
+    // the function refers to the id of the previous node
+    rte->lateral = true;
+    rte->inh = false;
+    rte->inFromCl = true;
+    rte->requiredPerms = 0;
+    rte->checkAsUser = InvalidOid;
+
+    pstate->p_rtable = lappend(pstate->p_rtable, rte);
+    addRTEtoQuery(pstate, rte, true, false, false);
+
+    if (rel->name)
+    {
+        TargetEntry *te;
+
+        te = makeTargetEntry((Expr *)make_edge_expr(cpstate, rte),
+                             pstate->p_next_resno++, rel->name, false);
+        *target_list = lappend(*target_list, te);
+    }
+
+    if (node->name)
+    {
+        TargetEntry *te;
+
+        te = makeTargetEntry(
+            (Expr *)make_vertex_expr(cpstate, rte, node->label),
+            pstate->p_next_resno++, node->name, false);
+        *target_list = lappend(*target_list, te);
+
+        add_vertex_columns_target_entries(cpstate, rte, target_list);
+    }
+
+    if (!rel->varlen)
+        *quals = transform_cypher_properties_quals(cpstate, rte,
+                                                   "edge_properties",
+                                                   rel->props, *quals);
+    *quals = transform_cypher_properties_quals(cpstate, rte, "properties",
+                                               node->props, *quals);
+
+    return rte;
+}
+
+/*
+ * A relationship of a pattern never matches an edge that another relationship
+ * of the pattern has matched. Append a qual for every pair of the
+ * relationships rels, whose hops are the RTE's rtes, to quals.
+ */
+static List *make_relationship_uniqueness_quals(cypher_parsestate *cpstate,
+                                                List *rels, List *rtes,
+                                                List *quals)
+{
+    ListCell *lc_rel1;
+    ListCell *lc_rte1;
+
+    forboth (lc_rel1, rels, lc_rte1, rtes)
+    {
+        ListCell *lc_rel2;
+        ListCell *lc_rte2;
+
+        for (lc_rel2 = lnext(lc_rel1), lc_rte2 = lnext(lc_rte1);
+             lc_rel2 != NULL;
+             lc_rel2 = lnext(lc_rel2), lc_rte2 = lnext(lc_rte2))
+        {
+            quals = lappend(quals,
+                            make_edges_differ_qual(cpstate, lfirst(lc_rel1),
+                                                   lfirst(lc_rte1),
+                                                   lfirst(lc_rel2),
+                                                   lfirst(lc_rte2)));
+        }
+    }
+
+    return quals;
+}
+
+/*
+ * The hop of a single relationship has the edge_id column while the hop of a
+ * variable-length relationship has the edge_ids column, the array of the
+ * edges of the path.
+ *
+ *   edge_id1 <> edge_id2
+ *   edge_id1 <> ALL (edge_ids2)
+ *   NOT (edge_ids1 && edge_ids2)
+ */
+static Node *make_edges_differ_qual(cypher_parsestate *cpstate,
+                                    cypher_relationship *rel1,
+                                    RangeTblEntry *rte1,
+                                    cypher_relationship *rel2,
+                                    RangeTblEntry *rte2)
+{
+    ParseState *pstate = (ParseState *)cpstate;
+    List *ne = list_make1(makeString("<>"));
+    Node *edges1;
+    Node *edges2;
+    Node *qual;
+
+    if (rel1->varlen && !rel2->varlen)
+        return make_edges_differ_qual(cpstate, rel2, rte2, rel1, rte1);
+
+    edges1 = scanRTEForColumn(pstate, rte1,
+                              rel1->varlen ? "edge_ids" : "edge_id", -1, 0,
+                              NULL);
+    edges2 = scanRTEForColumn(pstate, rte2,
+                              rel2->varlen ? "edge_ids" : "edge_id", -1, 0,
+                              NULL);
+
+    if (!rel1->varlen && !rel2->varlen)
+        return (Node *)make_op(pstate, ne, edges1, edges2, pstate->p_last_srf,
+                               -1);
+
+    if (!rel1->varlen)
+        return (Node *)make_scalar_array_op(pstate, ne, false, edges1, edges2,
+                                            -1);
+
+    qual = (Node *)make_op(pstate, list_make1(makeString("&&")), edges1,
+                           edges2, pstate->p_last_srf, -1);
+
+    return (Node *)makeBoolExpr(NOT_EXPR, list_make1(qual), -1);
+}
+
+/*
+ * Transform the property condition {k1: v1, k2: v2, ...} of a node or a
+ * relationship into the quals `colname.k1 = v1`, `colname.k2 = v2`, ... on
+ * the properties column of rte and append them to quals. The quals refer to
+ * the column directly instead of the vertex or the edge built from it so that
+ * the planner can push them down to the scan of the label table, and match
+ * them with the property indexes of the label.
+ */
+static List *transform_cypher_properties_quals(cypher_parsestate *cpstate,
+                                              RangeTblEntry *rte,
+                                              char *colname, Node *props,
+                                              List *quals)
+{
+    ParseState *pstate = (ParseState *)cpstate;
+    cypher_map *map = (cypher_map *)props;
+    Node *props_var;
+    Node *qual;
+    ListCell *lc;
+
+    if (!map)
+        return quals;
+
+    Assert(is_ag_node(map, cypher_map));
+
+    if (!map->keyvals)
+        return quals;
+
+    props_var = scanRTEForColumn(pstate, rte, colname, -1, 0, NULL);
+
+    /*
+     * properties @> {k: v, ...} can be served by a GIN index on the
+     * properties column (agtype_ops or agtype_path_ops). It is looser than
+     * the equality quals below for lists and maps, so those are kept.
+     */
+    qual = (Node *)make_op(pstate, list_make1(makeString("@>")),
+                           copyObject(props_var),
+                           transform_cypher_expr(cpstate, props,
+                                                 EXPR_KIND_WHERE),
+                           pstate->p_last_srf, map->location);
+    qual = coerce_to_boolean(pstate, qual, "MATCH");
+    quals = lappend(quals, qual);
+
+    // keyvals is [ key , value , ... ]
+    for (lc = list_head(map->keyvals); lc != NULL; lc = lnext(lnext(lc)))
+    {
+        char *key = strVal(lfirst(lc));
+        Node *val = lfirst(lnext(lc));
+        Node *access;
+
+        access = make_property_access_expr(copyObject(props_var), key);
+        val = transform_cypher_expr(cpstate, val, EXPR_KIND_WHERE);
+
+        qual = (Node *)make_op(pstate, list_make1(makeString("=")), access,
+                               val, pstate->p_last_srf, map->location);
+        qual = coerce_to_boolean(pstate, qual, "MATCH");
+
+        quals = lappend(quals, qual);
+    }
+
+    return quals;
+}
+
+/*
+ * Add an RTE for the label table, that is read by Cypher Expand, to the
+ * range table without adding it to the join tree. The executor checks the
+ * permissions of, and the plan cache depends on, every relation in the range
+ * table.
+ */
+static void add_label_rte(cypher_parsestate *cpstate, Oid relid)
+{
+    ParseState *pstate = (ParseState *)cpstate;
+    Relation relation;
+
+    relation = heap_open(relid, AccessShareLock);
+    addRangeTableEntryForRelation(pstate, relation, NULL, true, false);
+    heap_close(relation, NoLock);
+}
+
+/*
+ * Expose the id and the properties of a vertex as columns next to it.
+ * transform_cypher_expr() builds the vertex from these columns where it is
+ * used in later clauses, and turns `name.key` into an access to the
+ * properties column instead of the vertex so that the expression matches the
+ * property indexes of the label.
+ *
+ * The columns are found by their expressions, which are the arguments of the
+ * _agtype_build_vertex() call of the vertex, and not by their names. So
+ * neither an item named like them nor the columns of other vertices can be
+ * taken for them (see make_vertex_expr_from_columns()).
+ */
+static void add_vertex_columns_target_entries(cypher_parsestate *cpstate,
+                                              RangeTblEntry *rte,
+                                              List **target_list)
+{
+    ParseState *pstate = (ParseState *)cpstate;
+    Node *id;
+    Node *props;
+    TargetEntry *te;
+
+    id = scanRTEForColumn(pstate, rte, "id", -1, 0, NULL);
+
+    te = makeTargetEntry((Expr *)id, pstate->p_next_resno++,
+                         pstrdup(VERTEX_ID_COLUMN_NAME), false);
+    *target_list = lappend(*target_list, te);
+
+    props = scanRTEForColumn(pstate, rte, "properties", -1, 0, NULL);
+
+    te = makeTargetEntry((Expr *)props, pstate->p_next_resno++,
+                         pstrdup(VERTEX_PROPERTIES_COLUMN_NAME), false);
+    *target_list = lappend(*target_list, te);
+}
+
+/*
+ * WITH clause passes the id and the properties of each vertex item on to the
+ * next clause in the same way as MATCH clause, see
+ * add_vertex_columns_target_entries().
+ */
+static List *add_vertex_columns_of_items(cypher_parsestate *cpstate,
+                                         List *target_list)
+{
+    ParseState *pstate = (ParseState *)cpstate;
+    Oid build_vertex_oid;
+    List *vertex_columns = NIL;
+    ListCell *lt;
+
+    build_vertex_oid = get_ag_func_oid("_agtype_build_vertex", 3, OIDOID,
+                                       GRAPHIDOID, AGTYPEOID);
+
+    foreach (lt, target_list)
+    {
+        TargetEntry *te = lfirst(lt);
+        FuncExpr *fexpr;
+        TargetEntry *column_te;
+
+        if (te->resjunk || !IsA(te->expr, FuncExpr))
+            continue;
+
+        fexpr = (FuncExpr *)te->expr;
+        if (fexpr->funcid != build_vertex_oid)
+            continue;
+
+        // _agtype_build_vertex(graph_oid, id, properties)
+        column_te = makeTargetEntry(copyObject(lsecond(fexpr->args)),
+                                    pstate->p_next_resno++,
+                                    pstrdup(VERTEX_ID_COLUMN_NAME), false);
+        vertex_columns = lappend(vertex_columns, column_te);
+
+        column_te = makeTargetEntry(copyObject(lthird(fexpr->args)),
+                                    pstate->p_next_resno++,
+                                    pstrdup(VERTEX_PROPERTIES_COLUMN_NAME),
+                                    false);
+        vertex_columns = lappend(vertex_columns, column_te);
+    }
+
+    return list_concat(target_list, vertex_columns);
+}
+
+/*
+ * The functions that build vertices and edges take the graph OID to look up
+ * the label names of the graphids.
+ */
+static Node *make_graph_oid_const(cypher_parsestate *cpstate)
+{
+    return (Node *)makeConst(OIDOID, -1, InvalidOid, sizeof(Oid),
+                             ObjectIdGetDatum(cpstate->graph_oid), false,
+                             true);
+}
+
+static Node *make_edge_expr(cypher_parsestate *cpstate, RangeTblEntry *rte)
 {
     ParseState *pstate = (ParseState *)cpstate;
-    Oid label_name_func_oid;
     Oid func_oid;
     Node *id;
-    Const *graph_oid_const;
+    Node *start_id;
+    Node *end_id;
     Node *props;
-    List *args, *label_name_args;
+    List *args;
     FuncExpr *func_expr;
-    FuncExpr *label_name_func_expr;
 
-    func_oid = get_ag_func_oid("_agtype_build_vertex", 3, GRAPHIDOID,
-                               CSTRINGOID, AGTYPEOID);
+    func_oid = get_ag_func_oid("_agtype_build_edge", 5, OIDOID, GRAPHIDOID,
+                               GRAPHIDOID, GRAPHIDOID, AGTYPEOID);
 
-    id = scanRTEForColumn(pstate, rte, "id", -1, 0, NULL);
+    id = scanRTEForColumn(pstate, rte, "edge_id", -1, 0, NULL);
+    start_id = scanRTEForColumn(pstate, rte, "start_id", -1, 0, NULL);
+    end_id = scanRTEForColumn(pstate, rte, "end_id", -1, 0, NULL);
+    props = scanRTEForColumn(pstate, rte, "edge_properties", -1, 0, NULL);
 
-    label_name_func_oid = get_ag_func_oid("_label_name", 2, OIDOID,
-                                          GRAPHIDOID);
+    args = list_make4(make_graph_oid_const(cpstate), id, start_id, end_id);
+    args = lappend(args, props);
 
-    graph_oid_const = makeConst(OIDOID, -1, InvalidOid, sizeof(Oid),
-                                ObjectIdGetDatum(cpstate->graph_oid), false,
-                                true);
+    func_expr = makeFuncExpr(func_oid, AGTYPEOID, args, InvalidOid, InvalidOid,
+                             COERCE_EXPLICIT_CALL);
+    func_expr->location = -1;
 
-    label_name_args = list_make2(graph_oid_const, id);
+    return (Node *)func_expr;
+}
 
-    label_name_func_expr = makeFuncExpr(label_name_func_oid, CSTRINGOID,
-                                        label_name_args, InvalidOid,
-                                        InvalidOid, COERCE_EXPLICIT_CALL);
-    label_name_func_expr->location = -1;
+static Node *make_vertex_expr(cypher_parsestate *cpstate, RangeTblEntry *rte,
+                              char *label)
+{
+    ParseState *pstate = (ParseState *)cpstate;
+    Oid func_oid;
+    Node *id;
+    Node *props;
+    List *args;
+    FuncExpr *func_expr;
+
+    func_oid = get_ag_func_oid("_agtype_build_vertex", 3, OIDOID, GRAPHIDOID,
+                               AGTYPEOID);
+
+    id = scanRTEForColumn(pstate, rte, "id", -1, 0, NULL);
 
     props = scanRTEForColumn(pstate, rte, "properties", -1, 0, NULL);
 
-    args = list_make3(id, label_name_func_expr, props);
+    args = list_make3(make_graph_oid_const(cpstate), id, props);
 
     func_expr = makeFuncExpr(func_oid, AGTYPEOID, args, InvalidOid, InvalidOid,
                              COERCE_EXPLICIT_CALL);
@@ -601,6 +1289,14 @@ static List *transform_cypher_create_path(cypher_parsestate *cpstate,
     ListCell *lc;
     List *transformed_path = NIL;
 
+    if (path->shortest)
+    {
+        ereport(ERROR,
+                (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                 errmsg("shortestPath() is not allowed in CREATE"),
+                 parser_errposition(&cpstate->pstate, path->location)));
+    }
+
     foreach (lc, path->path)
     {
         if (is_ag_node(lfirst(lc), cypher_node))
@@ -650,6 +1346,11 @@ transform_create_cypher_edge(cypher_parsestate *cpstate, cypher_relationship *ed
 
     rel->dir = edge->dir;
 
+    if (edge->varlen)
+        ereport(ERROR, (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                        errmsg("variable-length relationships are not allowed in CREATE"),
+                        parser_errposition(&cpstate->pstate, edge->location)));
+
     if (!edge->label)
             ereport(ERROR, (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
                             errmsg("relationships must be specify a label in CREATE."),
@@ -24,9 +24,11 @@
 #include "nodes/parsenodes.h"
 #include "nodes/value.h"
 #include "parser/parse_coerce.h"
+#include "parser/parse_func.h"
 #include "parser/parse_node.h"
 #include "parser/parse_oper.h"
 #include "parser/parse_relation.h"
+#include "parser/parsetree.h"
 #include "utils/builtins.h"
 #include "utils/int8.h"
 #include "utils/lsyscache.h"
@@ -37,6 +39,7 @@
 #include "parser/cypher_parse_node.h"
 #include "utils/ag_func.h"
 #include "utils/agtype.h"
+#include "utils/graphid.h"
 
 static Node *transform_cypher_expr_recurse(cypher_parsestate *cpstate,
                                            Node *expr);
@@ -44,6 +47,11 @@ static Node *transform_A_Const(cypher_parsestate *cpstate, A_Const *ac);
 static Node *transform_ColumnRef(cypher_parsestate *cpstate, ColumnRef *cref);
 static Node *transform_A_Indirection(cypher_parsestate *cpstate,
                                      A_Indirection *a_ind);
+static Node *make_vertex_expr_from_columns(cypher_parsestate *cpstate,
+                                           Var *var);
+static AttrNumber find_vertex_column_attnum(RangeTblEntry *rte,
+                                            const char *colname, Node *expr);
+static Const *make_agtype_string_const(char *s);
 static Node *transform_AEXPR_OP(cypher_parsestate *cpstate, A_Expr *a);
 static Node *transform_BoolExpr(cypher_parsestate *cpstate, BoolExpr *expr);
 static Node *transform_cypher_bool_const(cypher_parsestate *cpstate,
@@ -58,6 +66,7 @@ static Node *transform_cypher_string_match(cypher_parsestate *cpstate,
                                            cypher_string_match *csm_node);
 static Node *transform_cypher_typecast(cypher_parsestate *cpstate,
                                        cypher_typecast *ctypecast);
+static Node *transform_FuncCall(cypher_parsestate *cpstate, FuncCall *fn);
 
 Node *transform_cypher_expr(cypher_parsestate *cpstate, Node *expr,
                             ParseExprKind expr_kind)
@@ -112,6 +121,8 @@ static Node *transform_cypher_expr_recurse(cypher_parsestate *cpstate,
     }
     case T_BoolExpr:
         return transform_BoolExpr(cpstate, (BoolExpr *)expr);
+    case T_FuncCall:
+        return transform_FuncCall(cpstate, (FuncCall *)expr);
     case T_NullTest:
     {
         NullTest *n = (NullTest *)expr;
@@ -220,6 +231,14 @@ static Node *transform_ColumnRef(cypher_parsestate *cpstate, ColumnRef *cref)
                         parser_errposition(pstate, cref->location)));
     }
 
+    if (IsA(var, Var))
+    {
+        Node *vertex = make_vertex_expr_from_columns(cpstate, (Var *)var);
+
+        if (vertex)
+            return vertex;
+    }
+
     return var;
 }
 
@@ -448,6 +467,25 @@ static Node *transform_A_Indirection(cypher_parsestate *cpstate,
     ind_arg_expr = transform_cypher_expr_recurse(cpstate, a_ind->arg);
     location = exprLocation(ind_arg_expr);
 
+    /*
+     * `v.key` where v is a vertex is transformed into an access to the
+     * properties that the vertex is built from. This skips building the vertex
+     * and makes the expression the same as the one of the property indexes of
+     * the label.
+     */
+    if (IsA(ind_arg_expr, FuncExpr) &&
+        IsA(linitial(a_ind->indirection), String))
+    {
+        FuncExpr *fexpr = (FuncExpr *)ind_arg_expr;
+
+        if (fexpr->funcid == get_ag_func_oid("_agtype_build_vertex", 3,
+                                             OIDOID, GRAPHIDOID, AGTYPEOID))
+        {
+            // _agtype_build_vertex(graph_oid, id, properties)
+            ind_arg_expr = lthird(fexpr->args);
+        }
+    }
+
     args = lappend(args, ind_arg_expr);
     foreach (lc, a_ind->indirection)
     {
@@ -513,10 +551,7 @@ static Node *transform_A_Indirection(cypher_parsestate *cpstate,
             /* it must be a string */
             else
             {
-                Const *const_str = makeConst(AGTYPEOID, -1, InvalidOid, -1,
-                                             string_to_agtype(strVal(node)),
-                                             false, false);
-                args = lappend(args, const_str);
+                args = lappend(args, make_agtype_string_const(strVal(node)));
             }
         }
         /* not an indirection we understand */
@@ -537,6 +572,132 @@ static Node *transform_A_Indirection(cypher_parsestate *cpstate,
     return (Node *)func_expr;
 }
 
+/*
+ * If var refers to a vertex of a previous clause, returns the expression that
+ * builds the vertex from the id and properties columns that the clause
+ * exposes next to it. Otherwise, returns NULL.
+ *
+ * Vertices are passed between clauses as those columns and only built where
+ * they are used. The column of the vertex itself is then unused and the
+ * planner does not compute it in subqueries that it cannot pull up (e.g. WITH
+ * with ORDER BY and LIMIT), so no vertex is built for the rows that are
+ * filtered out or only passed through.
+ */
+static Node *make_vertex_expr_from_columns(cypher_parsestate *cpstate,
+                                           Var *var)
+{
+    ParseState *pstate = (ParseState *)cpstate;
+    RangeTblEntry *rte;
+    TargetEntry *te;
+    FuncExpr *vertex;
+    AttrNumber id_attnum;
+    AttrNumber props_attnum;
+    Oid func_oid;
+    Const *graph_oid;
+    List *args;
+    FuncExpr *func_expr;
+
+    if (var->varlevelsup != 0 || var->varattno <= 0 ||
+        var->vartype != AGTYPEOID)
+        return NULL;
+
+    rte = GetRTEByRangeTablePosn(pstate, var->varno, 0);
+    if (rte->rtekind != RTE_SUBQUERY)
+        return NULL;
+
+    func_oid = get_ag_func_oid("_agtype_build_vertex", 3, OIDOID, GRAPHIDOID,
+                               AGTYPEOID);
+
+    te = get_tle_by_resno(rte->subquery->targetList, var->varattno);
+    if (!te || !IsA(te->expr, FuncExpr))
+        return NULL;
+
+    vertex = (FuncExpr *)te->expr;
+    if (vertex->funcid != func_oid)
+        return NULL;
+
+    // _agtype_build_vertex(graph_oid, id, properties)
+    id_attnum = find_vertex_column_attnum(rte, VERTEX_ID_COLUMN_NAME,
+                                          lsecond(vertex->args));
+    if (id_attnum == InvalidAttrNumber)
+        return NULL;
+
+    props_attnum = find_vertex_column_attnum(rte,
+                                             VERTEX_PROPERTIES_COLUMN_NAME,
+                                             lthird(vertex->args));
+    if (props_attnum == InvalidAttrNumber)
+        return NULL;
+
+    graph_oid = makeConst(OIDOID, -1, InvalidOid, sizeof(Oid),
+                          ObjectIdGetDatum(cpstate->graph_oid), false, true);
+    args = list_make3(graph_oid,
+                      makeVar(var->varno, id_attnum, GRAPHIDOID, -1,
+                              InvalidOid, 0),
+                      makeVar(var->varno, props_attnum, AGTYPEOID, -1,
+                              InvalidOid, 0));
+
+    func_expr = makeFuncExpr(func_oid, AGTYPEOID, args, InvalidOid,
+                             InvalidOid, COERCE_EXPLICIT_CALL);
+    func_expr->location = var->location;
+
+    return (Node *)func_expr;
+}
+
+/*
+ * Returns the attribute number of the column colname of rte that is exposed
+ * next to a vertex and computes expr, or InvalidAttrNumber if there is none.
+ * The name only tells the id and the properties columns apart; expr tells
+ * which vertex they belong to.
+ */
+static AttrNumber find_vertex_column_attnum(RangeTblEntry *rte,
+                                            const char *colname, Node *expr)
+{
+    ListCell *lt;
+
+    foreach (lt, rte->subquery->targetList)
+    {
+        TargetEntry *te = lfirst(lt);
+
+        if (te->resjunk || strcmp(te->resname, colname) != 0)
+            continue;
+
+        if (equal(te->expr, expr))
+            return te->resno;
+    }
+
+    return InvalidAttrNumber;
+}
+
+static Const *make_agtype_string_const(char *s)
+{
+    // typtypmod, typcollation, typlen, and typbyval of agtype are hard-coded.
+    return makeConst(AGTYPEOID, -1, InvalidOid, -1, string_to_agtype(s), false,
+                     false);
+}
+
+/*
+ * agtype_access_operator(properties, '"key"')
+ *
+ * This is the expression of `v.key` for a vertex v of a label. Property
+ * indexes are created on it so that the planner can match them.
+ */
+Node *make_property_access_expr(Node *properties, char *key)
+{
+    Oid func_access_oid;
+    FuncExpr *func_expr;
+
+    func_access_oid = get_ag_func_oid("agtype_access_operator", 1,
+                                      AGTYPEARRAYOID);
+
+    func_expr = makeFuncExpr(func_access_oid, AGTYPEOID,
+                             list_make2(properties,
+                                        make_agtype_string_const(key)),
+                             InvalidOid, InvalidOid, COERCE_EXPLICIT_CALL);
+    func_expr->location = -1;
+
+    return (Node *)func_expr;
+}
+
 static Node *transform_cypher_string_match(cypher_parsestate *cpstate,
                                            cypher_string_match *csm_node)
 {
@@ -612,3 +773,60 @@ static Node *transform_cypher_typecast(cypher_parsestate *cpstate,
 
     return (Node *)func_expr;
 }
+
+/*
+ * Cypher functions are mapped to the functions in ag_catalog that implement
+ * them. Function names are case-insensitive in Cypher.
+ */
+static const struct
+{
+    const char *cypher_name;
+    const char *func_name;
+} cypher_funcs[] = {
+    {"count", "agtype_count"},
+    {"sum", "agtype_sum"},
+    {"avg", "agtype_avg"},
+    {"min", "agtype_min"},
+    {"max", "agtype_max"},
+    {"collect", "agtype_collect"},
+    {"percentilecont", "agtype_percentile_cont"},
+    {"percentiledisc", "agtype_percentile_disc"}
+};
+
+static Node *transform_FuncCall(cypher_parsestate *cpstate, FuncCall *fn)
+{
+    ParseState *pstate = (ParseState *)cpstate;
+    char *name = strVal(linitial(fn->funcname));
+    const char *func_name = NULL;
+    List *funcname;
+    List *targs = NIL;
+    ListCell *la;
+    int i;
+
+    for (i = 0; i < lengthof(cypher_funcs); i++)
+    {
+        if (pg_strcasecmp(name, cypher_funcs[i].cypher_name) == 0)
+        {
+            func_name = cypher_funcs[i].func_name;
+            break;
+        }
+    }
+    if (!func_name)
+    {
+        ereport(ERROR,
+                (errcode(ERRCODE_UNDEFINED_FUNCTION),
+                 errmsg("function %s does not exist", name),
+                 parser_errposition(pstate, fn->location)));
+    }
+
+    foreach (la, fn->args)
+        targs = lappend(targs, transform_cypher_expr_recurse(cpstate,
+                                                             lfirst(la)));
+
+    funcname = list_make2(makeString("ag_catalog"),
+                          makeString(pstrdup(func_name)));
+
+    // aggregates are checked and set up the same way as in SQL
+    return ParseFuncOrColumn(pstate, funcname, targs, pstate->p_last_srf, fn,
+                             false, fn->location);
+}
@@ -124,9 +124,10 @@
              path_node path_relationship path_relationship_body
              properties_opt
 %type <string> label_opt
+%type <list> varlen_opt
 
 /* expression */
-%type <node> expr expr_opt atom literal map list var
+%type <node> expr expr_opt atom literal map list var func_invocation
 %type <list> expr_list expr_list_opt map_keyval_list_opt map_keyval_list
 
 /* names */
@@ -668,6 +669,25 @@ pattern:
 /* path is a series of connected nodes and relationships */
 path:
     anonymous_path
+    | symbolic_name '(' simple_path ')' /* shortestPath() */
+        {
+            cypher_path *n;
+
+            if (pg_strcasecmp($1, "shortestpath") != 0)
+            {
+                ereport(ERROR,
+                        (errcode(ERRCODE_SYNTAX_ERROR),
+                         errmsg("unknown path function \"%s\"", $1),
+                         ag_scanner_errposition(@1, scanner)));
+            }
+
+            n = make_ag_node(cypher_path);
+            n->path = $3;
+            n->shortest = true;
+            n->location = @1;
+
+            $$ = (Node *)n;
+        }
     | var_name '=' anonymous_path /* named path */
         {
             ereport(ERROR, (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
@@ -755,19 +775,53 @@ path_relationship:
     ;
 
 path_relationship_body:
-    '[' var_name_opt label_opt properties_opt ']'
+    '[' var_name_opt label_opt varlen_opt properties_opt ']'
         {
             cypher_relationship *n;
 
             n = make_ag_node(cypher_relationship);
             n->name = $2;
             n->label = $3;
-            n->props = $4;
+            n->props = $5;
+            if ($4)
+            {
+                n->varlen = true;
+                n->min_hops = intVal(linitial($4));
+                n->max_hops = intVal(lsecond($4));
+            }
 
             $$ = (Node *)n;
         }
     ;
 
+/* [ min_hops, max_hops ], max_hops is -1 if there is no upper bound */
+varlen_opt:
+    /* empty */
+        {
+            $$ = NIL;
+        }
+    | '*'
+        {
+            $$ = list_make2(makeInteger(1), makeInteger(-1));
+        }
+    | '*' INTEGER
+        {
+            $$ = list_make2(makeInteger($2), makeInteger($2));
+        }
+    | '*' INTEGER DOT_DOT
+        {
+            $$ = list_make2(makeInteger($2), makeInteger(-1));
+        }
+    | '*' DOT_DOT INTEGER
+        {
+            $$ = list_make2(makeInteger(1), makeInteger($3));
+        }
+    | '*' INTEGER DOT_DOT INTEGER
+        {
+            $$ = list_make2(makeInteger($2), makeInteger($4));
+        }
+    ;
+
 label_opt:
     /* empty */
         {
@@ -995,6 +1049,28 @@ atom:
             $$ = $2;
         }
     | var
+    | func_invocation
+    ;
+
+func_invocation:
+    symbolic_name '(' '*' ')'
+        {
+            FuncCall *n;
+
+            n = makeFuncCall(list_make1(makeString($1)), NIL, @1);
+            n->agg_star = true;
+
+            $$ = (Node *)n;
+        }
+    | symbolic_name '(' distinct_opt expr_list_opt ')'
+        {
+            FuncCall *n;
+
+            n = makeFuncCall(list_make1(makeString($1)), $4, @1);
+            n->agg_distinct = $3;
+
+            $$ = (Node *)n;
+        }
     ;
 
 literal:
@@ -22,20 +22,32 @@
 
 #include "postgres.h"
 
+#include <float.h>
+#include <math.h>
+
 #include "access/htup_details.h"
 #include "catalog/pg_type.h"
 #include "funcapi.h"
+#include "libpq/pqformat.h"
 #include "miscadmin.h"
 #include "parser/parse_coerce.h"
 #include "utils/builtins.h"
+#include "utils/float.h"
 #include "utils/int8.h"
 #include "utils/lsyscache.h"
 #include "utils/typcache.h"
 
+#include "catalog/ag_label.h"
+#include "utils/ag_stat.h"
 #include "utils/agtype.h"
+#include "utils/agtype_ext.h"
 #include "utils/agtype_parser.h"
+#include "utils/agtype_scan.h"
 #include "utils/graphid.h"
 
+// the same as MAXDOUBLEWIDTH of float.c
+#define AGTYPE_FLOAT8_WIDTH 128
+
 typedef struct agtype_in_state
 {
     agtype_parse_state *parse_state;
@@ -71,7 +83,10 @@ static void agtype_in_array_end(void *pstate);
 static void agtype_in_object_field_start(void *pstate, char *fname,
                                          bool isnull);
 static void agtype_put_escaped_value(StringInfo out, agtype_value *scalar_val);
-static void escape_agtype(StringInfo buf, const char *str);
+static void escape_agtype(StringInfo buf, const char *str, int len);
+static void put_int8(StringInfo out, int64 num);
+static void put_float8(StringInfo out, float8 num);
+static void put_entity(StringInfo out, agtype_value *entity);
 bool is_decimal_needed(char *numstr);
 static void agtype_in_scalar(void *pstate, char *token,
                              agtype_token_type tokentype,
@@ -95,9 +110,19 @@ static void add_indent(StringInfo out, bool indent, int level);
 static void cannot_cast_agtype_value(enum agtype_value_type type,
                                      const char *sqltype);
 static bool agtype_extract_scalar(agtype_container *agtc, agtype_value *res);
-static agtype *execute_array_access_operator(agtype *array, agtype *element);
-static agtype *execute_map_access_operator(agtype *map, agtype *key);
+static agtype_value *execute_array_access_operator(agtype_container *array,
+                                                   agtype *element);
+static agtype_value *execute_map_access_operator(agtype_container *map,
+                                                 agtype *key);
 agtype_value *string_to_agtype_value(char *s);
+static agtype *build_vertex(graphid id, agtype_value *label,
+                            agtype *properties);
+static agtype *build_edge(graphid id, graphid start_id, graphid end_id,
+                          agtype_value *label, agtype *properties);
+static void get_properties_container(agtype *properties, const char *funcname,
+                                     agtype_container **container, int *len);
+static void get_label_name_value(FunctionCallInfo fcinfo, Oid graph,
+                                 graphid id, agtype_value *label);
 
 PG_FUNCTION_INFO_V1(agtype_in);
 
@@ -119,11 +144,70 @@ PG_FUNCTION_INFO_V1(agtype_out);
 Datum agtype_out(PG_FUNCTION_ARGS)
 {
     agtype *agt = AG_GET_ARG_AGTYPE_P(0);
-    char *out;
+    StringInfoData out;
 
-    out = agtype_to_cstring(NULL, &agt->root, VARSIZE(agt));
+    initStringInfo(&out);
+    agtype_to_cstring(&out, &agt->root, VARSIZE(agt));
 
-    PG_RETURN_CSTRING(out);
+    ag_stat_add(AG_STAT_AGTYPE_SERIALIZE_BYTES, out.len);
+
+    PG_RETURN_CSTRING(out.data);
+}
+
+/*
+ * Version of the binary format of agtype. Version 1 is the agtype container
+ * as it is stored, so values move without being printed and parsed. Its
+ * byte order is that of the server.
+ */
+#define AGTYPE_BINARY_VERSION 1
+
+PG_FUNCTION_INFO_V1(agtype_recv);
+
+/*
+ * agtype type binary input function
+ */
+Datum agtype_recv(PG_FUNCTION_ARGS)
+{
+    StringInfo buf = (StringInfo)PG_GETARG_POINTER(0);
+    int version = pq_getmsgint(buf, 1);
+    int len;
+    agtype *agt;
+
+    if (version != AGTYPE_BINARY_VERSION)
+    {
+        ereport(ERROR, (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+                        errmsg("unsupported agtype version number %d",
+                               version)));
+    }
+
+    len = buf->len - buf->cursor;
+    agt = palloc(VARHDRSZ + len);
+    SET_VARSIZE(agt, VARHDRSZ + len);
+    pq_copymsgbytes(buf, VARDATA(agt), len);
+
+    // the container comes from the client, so it cannot be trusted
+    check_agtype_container(&agt->root, len);
+
+    AG_RETURN_AGTYPE_P(agt);
+}
+
+PG_FUNCTION_INFO_V1(agtype_send);
+
+/*
+ * agtype type binary output function
+ */
+Datum agtype_send(PG_FUNCTION_ARGS)
+{
+    agtype *agt = AG_GET_ARG_AGTYPE_P(0);
+    StringInfoData buf;
+
+    pq_begintypsend(&buf);
+    pq_sendint8(&buf, AGTYPE_BINARY_VERSION);
+    pq_sendbytes(&buf, VARDATA(agt), VARSIZE(agt) - VARHDRSZ);
+
+    ag_stat_add(AG_STAT_AGTYPE_SERIALIZE_BYTES, buf.len);
+
+    PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
 }
 
 /*
@@ -222,16 +306,14 @@ static void agtype_in_object_field_start(void *pstate, char *fname,
 
 static void agtype_put_escaped_value(StringInfo out, agtype_value *scalar_val)
 {
-    char *numstr;
-
     switch (scalar_val->type)
     {
     case AGTV_NULL:
         appendBinaryStringInfo(out, "null", 4);
         break;
     case AGTV_STRING:
-        escape_agtype(out, pnstrdup(scalar_val->val.string.val,
-                                    scalar_val->val.string.len));
+        escape_agtype(out, scalar_val->val.string.val,
+                      scalar_val->val.string.len);
         break;
     case AGTV_NUMERIC:
         appendStringInfoString(
@@ -240,17 +322,10 @@ static void agtype_put_escaped_value(StringInfo out, agtype_value *scalar_val)
         appendBinaryStringInfo(out, "::numeric", 9);
         break;
     case AGTV_INTEGER:
-        appendStringInfoString(
-            out, DatumGetCString(DirectFunctionCall1(
-                     int8out, Int64GetDatum(scalar_val->val.int_value))));
+        put_int8(out, scalar_val->val.int_value);
         break;
     case AGTV_FLOAT:
-        numstr = DatumGetCString(DirectFunctionCall1(
-            float8out, Float8GetDatum(scalar_val->val.float_value)));
-        appendStringInfoString(out, numstr);
-
-        if (is_decimal_needed(numstr))
-            appendBinaryStringInfo(out, ".0", 2);
+        put_float8(out, scalar_val->val.float_value);
         break;
     case AGTV_BOOL:
         if (scalar_val->val.boolean)
@@ -259,72 +334,154 @@ static void agtype_put_escaped_value(StringInfo out, agtype_value *scalar_val)
             appendBinaryStringInfo(out, "false", 5);
         break;
     case AGTV_VERTEX:
-    {
-        agtype *prop;
-        scalar_val->type = AGTV_OBJECT;
-        prop = agtype_value_to_agtype(scalar_val);
-        agtype_to_cstring_worker(out, &prop->root, prop->vl_len_, false);
+        put_entity(out, scalar_val);
         appendBinaryStringInfo(out, "::vertex", 8);
         break;
-    }
     case AGTV_EDGE:
-    {
-        agtype *prop;
-        scalar_val->type = AGTV_OBJECT;
-        prop = agtype_value_to_agtype(scalar_val);
-        agtype_to_cstring_worker(out, &prop->root, prop->vl_len_, false);
+        put_entity(out, scalar_val);
         appendBinaryStringInfo(out, "::edge", 6);
         break;
-    }
     default:
         elog(ERROR, "unknown agtype scalar type");
     }
 }
 
+/*
+ * Prints a vertex or an edge as an object. Its properties are printed from
+ * their container directly.
+ */
+static void put_entity(StringInfo out, agtype_value *entity)
+{
+    int i;
+
+    appendStringInfoCharMacro(out, '{');
+
+    for (i = 0; i < entity->val.object.num_pairs; i++)
+    {
+        agtype_pair *pair = &entity->val.object.pairs[i];
+
+        if (i > 0)
+            appendBinaryStringInfo(out, ", ", 2);
+
+        agtype_put_escaped_value(out, &pair->key);
+        appendBinaryStringInfo(out, ": ", 2);
+
+        if (pair->value.type == AGTV_BINARY)
+        {
+            agtype_to_cstring_worker(out, pair->value.val.binary.data,
+                                     pair->value.val.binary.len, false);
+        }
+        else
+        {
+            agtype_put_escaped_value(out, &pair->value);
+        }
+    }
+
+    appendStringInfoCharMacro(out, '}');
+}
+
+/*
+ * The character to put after the backslash for the characters that must be
+ * escaped in agtype strings. 'u' means the \u00XX form. Other characters are
+ * copied as they are.
+ */
+static const char agtype_escapes[256] = {
+    'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'b', 't', 'n', 'u', 'f', 'r', 'u',
+    'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u',
+    'u', 'u', ['"'] = '"', ['\\'] = '\\'};
+
 /*
  * Produce an agtype string literal, properly escaping characters in the text.
+ *
+ * The characters that need escaping are the ones that the lexer does not take
+ * as they are, so the runs of the other characters are found by the same
+ * block scan and copied at once.
  */
-static void escape_agtype(StringInfo buf, const char *str)
+static void escape_agtype(StringInfo buf, const char *str, int len)
 {
-    const char *p;
+    const char *end = str + len;
+    const char *p = str;
+
+    // the common case is a string without anything to escape
+    enlargeStringInfo(buf, len + 2);
 
     appendStringInfoCharMacro(buf, '"');
-    for (p = str; *p; p++)
+    for (;;)
     {
-        switch (*p)
+        int run_len;
+        char esc;
+
+        run_len = scan_plain_string_chars(p, end - p);
+        if (run_len > 0)
         {
-        case '\b':
-            appendStringInfoString(buf, "\\b");
-            break;
-        case '\f':
-            appendStringInfoString(buf, "\\f");
-            break;
-        case '\n':
-            appendStringInfoString(buf, "\\n");
-            break;
-        case '\r':
-            appendStringInfoString(buf, "\\r");
-            break;
-        case '\t':
-            appendStringInfoString(buf, "\\t");
-            break;
-        case '"':
-            appendStringInfoString(buf, "\\\"");
-            break;
-        case '\\':
-            appendStringInfoString(buf, "\\\\");
-            break;
-        default:
-            if ((unsigned char)*p < ' ')
-                appendStringInfo(buf, "\\u%04x", (int)*p);
-            else
-                appendStringInfoCharMacro(buf, *p);
+            appendBinaryStringInfo(buf, p, run_len);
+            p += run_len;
+        }
+        if (p == end)
             break;
+
+        esc = agtype_escapes[(unsigned char)*p];
+        Assert(esc);
+
+        if (esc == 'u')
+        {
+            appendStringInfo(buf, "\\u%04x", (int)*p);
         }
+        else
+        {
+            appendStringInfoCharMacro(buf, '\\');
+            appendStringInfoCharMacro(buf, esc);
+        }
+        p++;
     }
     appendStringInfoCharMacro(buf, '"');
 }
 
+/*
+ * Formats num into out directly, the same as int8out() does.
+ */
+static void put_int8(StringInfo out, int64 num)
+{
+    enlargeStringInfo(out, MAXINT8LEN + 1);
+
+    pg_lltoa(num, out->data + out->len);
+    out->len += strlen(out->data + out->len);
+}
+
+/*
+ * Formats num into out directly, the same as float8out() does. ".0" is
+ * appended to integral values to keep them floats.
+ */
+static void put_float8(StringInfo out, float8 num)
+{
+    char *numstr;
+
+    enlargeStringInfo(out, AGTYPE_FLOAT8_WIDTH + 1);
+    numstr = out->data + out->len;
+
+    if (isnan(num))
+    {
+        strcpy(numstr, "NaN");
+    }
+    else if (is_infinite(num))
+    {
+        strcpy(numstr, num > 0 ? "Infinity" : "-Infinity");
+    }
+    else
+    {
+        int ndig = DBL_DIG + extra_float_digits;
+
+        if (ndig < 1)
+            ndig = 1;
+
+        snprintf(numstr, AGTYPE_FLOAT8_WIDTH + 1, "%.*g", ndig, num);
+    }
+    out->len += strlen(numstr);
+
+    if (is_decimal_needed(numstr))
+        appendBinaryStringInfo(out, ".0", 2);
+}
+
 bool is_decimal_needed(char *numstr)
 {
     int i;
@@ -1271,76 +1428,148 @@ agtype_value *string_to_agtype_value(char *s)
     return agtv;
 }
 
-PG_FUNCTION_INFO_V1(_agtype_build_vertex);
+/*
+ * Builds a vertex. properties can be NULL, then the vertex gets an empty
+ * object as its properties.
+ */
+static agtype *build_vertex(graphid id, agtype_value *label,
+                            agtype *properties)
+{
+    agtype_value vertex;
+    agtype_container *props;
+    int props_len;
+
+    get_properties_container(properties, "agtype_build_vertex", &props,
+                             &props_len);
+
+    ag_make_vertex_value(&vertex, id, label->val.string.val,
+                         label->val.string.len, props, props_len);
+
+    return agtype_value_to_agtype(&vertex);
+}
 
 /*
- * SQL function agtype_build_vertex(graphid, cstring, agtype)
+ * Builds an edge. properties can be NULL, then the edge gets an empty object
+ * as its properties.
  */
-Datum _agtype_build_vertex(PG_FUNCTION_ARGS)
+static agtype *build_edge(graphid id, graphid start_id, graphid end_id,
+                          agtype_value *label, agtype *properties)
 {
-    agtype_in_state result;
-    graphid id;
+    agtype_value edge;
+    agtype_container *props;
+    int props_len;
 
-    memset(&result, 0, sizeof(agtype_in_state));
+    get_properties_container(properties, "agtype_build_edge", &props,
+                             &props_len);
 
-    result.res = push_agtype_value(&result.parse_state, WAGT_BEGIN_OBJECT,
-                                   NULL);
+    ag_make_edge_value(&edge, id, start_id, end_id, label->val.string.val,
+                       label->val.string.len, props, props_len);
 
-    /* process graphid */
-    result.res = push_agtype_value(&result.parse_state, WAGT_KEY,
-                                   string_to_agtype_value("id"));
+    return agtype_value_to_agtype(&edge);
+}
+
+/*
+ * The properties container is copied as it is into the vertex or edge.
+ * funcname is the name of the SQL function for the error message.
+ */
+static void get_properties_container(agtype *properties, const char *funcname,
+                                     agtype_container **container, int *len)
+{
+    static uint32 empty_object = AGT_FOBJECT;
+
+    //if the properties object is null, use an empty object
+    if (!properties)
+    {
+        *container = (agtype_container *)&empty_object;
+        *len = sizeof(empty_object);
+        return;
+    }
+
+    if (!AGT_ROOT_IS_OBJECT(properties))
+        ereport(
+            ERROR,
+            (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+             errmsg("%s() properties argument must be an object", funcname)));
+
+    *container = &properties->root;
+    *len = VARSIZE(properties) - VARHDRSZ;
+}
+
+/*
+ * Sets label to the name of the label of id. The names of the labels of the
+ * graph are kept in fn_extra for the rest of the query, so that this does
+ * neither a cache lookup nor a copy of the name per call.
+ */
+static void get_label_name_value(FunctionCallInfo fcinfo, Oid graph,
+                                 graphid id, agtype_value *label)
+{
+    label_name_table *table = fcinfo->flinfo->fn_extra;
+
+    if (!table || table->graph != graph)
+    {
+        table = make_label_name_table(graph, fcinfo->flinfo->fn_mcxt);
+        fcinfo->flinfo->fn_extra = table;
+    }
+
+    label->type = AGTV_STRING;
+    label->val.string.val = lookup_label_name(
+        table, get_graphid_label_id(id), &label->val.string.len);
+}
+
+PG_FUNCTION_INFO_V1(_agtype_build_vertex);
+
+/*
+ * SQL function agtype_build_vertex(graphid, cstring, agtype)
+ */
+Datum _agtype_build_vertex(PG_FUNCTION_ARGS)
+{
+    agtype_value label;
 
     if (fcinfo->argnull[0])
         ereport(ERROR,
                 (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
                  errmsg("agtype_build_vertex() graphid cannot be NULL")));
 
-    id = AG_GETARG_GRAPHID(0);
-    add_agtype(id, false, &result, GRAPHIDOID, false);
-
-    /* process label */
-    result.res = push_agtype_value(&result.parse_state, WAGT_KEY,
-                                   string_to_agtype_value("label"));
-
     if (fcinfo->argnull[1])
         ereport(ERROR, (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
                         errmsg("agtype_build_vertex() label cannot be NULL")));
 
-    result.res =
-        push_agtype_value(&result.parse_state, WAGT_VALUE,
-                          string_to_agtype_value(PG_GETARG_CSTRING(1)));
+    label.type = AGTV_STRING;
+    label.val.string.val = PG_GETARG_CSTRING(1);
+    label.val.string.len = check_string_length(strlen(label.val.string.val));
 
-    /* process properties */
-    result.res = push_agtype_value(&result.parse_state, WAGT_KEY,
-                                   string_to_agtype_value("properties"));
+    PG_RETURN_POINTER(build_vertex(
+        AG_GETARG_GRAPHID(0), &label,
+        fcinfo->argnull[2] ? NULL : AG_GET_ARG_AGTYPE_P(2)));
+}
 
-    //if the properties object is null, push an empty object
-    if (fcinfo->argnull[2])
-    {
-        result.res = push_agtype_value(&result.parse_state, WAGT_BEGIN_OBJECT,
-                                       NULL);
-        result.res = push_agtype_value(&result.parse_state, WAGT_END_OBJECT,
-                                       NULL);
-    }
-    else
-    {
-        agtype *properties = AG_GET_ARG_AGTYPE_P(2);
+PG_FUNCTION_INFO_V1(_agtype_build_graph_vertex);
 
-        if (!AGT_ROOT_IS_OBJECT(properties))
-            ereport(
-                ERROR,
-                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
-                 errmsg(
-                     "agtype_build_vertex() properties argument must be an object")));
+/*
+ * SQL function _agtype_build_vertex(oid, graphid, agtype)
+ *
+ * The label is the one of the graphid in the given graph.
+ */
+Datum _agtype_build_graph_vertex(PG_FUNCTION_ARGS)
+{
+    graphid id;
+    agtype_value label;
 
-        add_agtype((Datum)properties, false, &result, AGTYPEOID, false);
-    }
+    if (fcinfo->argnull[0])
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("agtype_build_vertex() graph_oid cannot be NULL")));
 
-    result.res = push_agtype_value(&result.parse_state, WAGT_END_OBJECT, NULL);
+    if (fcinfo->argnull[1])
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("agtype_build_vertex() graphid cannot be NULL")));
 
-    result.res->type = AGTV_VERTEX;
+    id = AG_GETARG_GRAPHID(1);
+    get_label_name_value(fcinfo, PG_GETARG_OID(0), id, &label);
 
-    PG_RETURN_POINTER(agtype_value_to_agtype(result.res));
+    PG_RETURN_POINTER(build_vertex(
+        id, &label, fcinfo->argnull[2] ? NULL : AG_GET_ARG_AGTYPE_P(2)));
 }
 
 PG_FUNCTION_INFO_V1(_agtype_build_edge);
@@ -1350,93 +1579,74 @@ PG_FUNCTION_INFO_V1(_agtype_build_edge);
  */
 Datum _agtype_build_edge(PG_FUNCTION_ARGS)
 {
-    agtype_in_state result;
-    graphid id, start_id, end_id;
-
-    memset(&result, 0, sizeof(agtype_in_state));
-
-    result.res = push_agtype_value(&result.parse_state, WAGT_BEGIN_OBJECT,
-                                   NULL);
-
-    /* process graphid */
-    result.res = push_agtype_value(&result.parse_state, WAGT_KEY,
-                                   string_to_agtype_value("id"));
+    agtype_value label;
 
     if (fcinfo->argnull[0])
         ereport(ERROR,
                 (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
-                 errmsg("agtype_build_vertex() graphid cannot be NULL")));
-
-    id = AG_GETARG_GRAPHID(0);
-    add_agtype(id, false, &result, GRAPHIDOID, false);
-
-    /* process startid */
-    result.res = push_agtype_value(&result.parse_state, WAGT_KEY,
-                                   string_to_agtype_value("start_id"));
+                 errmsg("agtype_build_edge() graphid cannot be NULL")));
 
     if (fcinfo->argnull[1])
         ereport(ERROR,
                 (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
-                 errmsg("agtype_build_vertex() startid cannot be NULL")));
-
-    start_id = AG_GETARG_GRAPHID(1);
-    add_agtype(start_id, false, &result, GRAPHIDOID, false);
-
-    /* process endid */
-    result.res = push_agtype_value(&result.parse_state, WAGT_KEY,
-                                   string_to_agtype_value("end_id"));
+                 errmsg("agtype_build_edge() startid cannot be NULL")));
 
     if (fcinfo->argnull[2])
         ereport(ERROR,
                 (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
-                 errmsg("agtype_build_vertex() endoid cannot be NULL")));
-
-    end_id = AG_GETARG_GRAPHID(2);
-    add_agtype(end_id, false, &result, GRAPHIDOID, false);
-
-    /* process label */
-    result.res = push_agtype_value(&result.parse_state, WAGT_KEY,
-                                   string_to_agtype_value("label"));
+                 errmsg("agtype_build_edge() endoid cannot be NULL")));
 
     if (fcinfo->argnull[3])
         ereport(ERROR, (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
-                        errmsg("agtype_build_vertex() label cannot be NULL")));
+                        errmsg("agtype_build_edge() label cannot be NULL")));
 
-    result.res =
-        push_agtype_value(&result.parse_state, WAGT_VALUE,
-                          string_to_agtype_value(PG_GETARG_CSTRING(3)));
+    label.type = AGTV_STRING;
+    label.val.string.val = PG_GETARG_CSTRING(3);
+    label.val.string.len = check_string_length(strlen(label.val.string.val));
 
-    /* process properties */
-    result.res = push_agtype_value(&result.parse_state, WAGT_KEY,
-                                   string_to_agtype_value("properties"));
+    PG_RETURN_POINTER(build_edge(
+        AG_GETARG_GRAPHID(0), AG_GETARG_GRAPHID(1), AG_GETARG_GRAPHID(2),
+        &label, fcinfo->argnull[4] ? NULL : AG_GET_ARG_AGTYPE_P(4)));
+}
 
-    //if the properties object is null, push an empty object
-    if (fcinfo->argnull[4])
-    {
-        result.res = push_agtype_value(&result.parse_state, WAGT_BEGIN_OBJECT,
-                                       NULL);
-        result.res = push_agtype_value(&result.parse_state, WAGT_END_OBJECT,
-                                       NULL);
-    }
-    else
-    {
-        agtype *properties = AG_GET_ARG_AGTYPE_P(4);
+PG_FUNCTION_INFO_V1(_agtype_build_graph_edge);
 
-        if (!AGT_ROOT_IS_OBJECT(properties))
-            ereport(
-                ERROR,
+/*
+ * SQL function _agtype_build_edge(oid, graphid, graphid, graphid, agtype)
+ *
+ * The label is the one of the graphid of the edge in the given graph.
+ */
+Datum _agtype_build_graph_edge(PG_FUNCTION_ARGS)
+{
+    graphid id;
+    agtype_value label;
+
+    if (fcinfo->argnull[0])
+        ereport(ERROR,
                 (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
-                 errmsg(
-                     "agtype_build_vertex() properties argument must be an object")));
+                 errmsg("agtype_build_edge() graph_oid cannot be NULL")));
 
-        add_agtype((Datum)properties, false, &result, AGTYPEOID, false);
-    }
+    if (fcinfo->argnull[1])
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("agtype_build_edge() graphid cannot be NULL")));
 
-    result.res = push_agtype_value(&result.parse_state, WAGT_END_OBJECT, NULL);
+    if (fcinfo->argnull[2])
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("agtype_build_edge() startid cannot be NULL")));
 
-    result.res->type = AGTV_EDGE;
+    if (fcinfo->argnull[3])
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("agtype_build_edge() endoid cannot be NULL")));
 
-    PG_RETURN_POINTER(agtype_value_to_agtype(result.res));
+    id = AG_GETARG_GRAPHID(1);
+    get_label_name_value(fcinfo, PG_GETARG_OID(0), id, &label);
+
+    PG_RETURN_POINTER(build_edge(
+        id, AG_GETARG_GRAPHID(2), AG_GETARG_GRAPHID(3), &label,
+        fcinfo->argnull[4] ? NULL : AG_GET_ARG_AGTYPE_P(4)));
 }
 
 PG_FUNCTION_INFO_V1(agtype_build_map);
@@ -1656,6 +1866,26 @@ Datum agtype_to_bool(PG_FUNCTION_ARGS)
     PG_RETURN_BOOL(agtv.val.boolean);
 }
 
+PG_FUNCTION_INFO_V1(agtype_to_int8);
+
+/*
+ * Cast agtype to bigint. SKIP and LIMIT of Cypher are coerced to bigint with
+ * this, and the planner folds constant ones to bound the sort below them.
+ */
+Datum agtype_to_int8(PG_FUNCTION_ARGS)
+{
+    agtype *agtype_in = AG_GET_ARG_AGTYPE_P(0);
+    agtype_value agtv;
+
+    if (!agtype_extract_scalar(&agtype_in->root, &agtv) ||
+        agtv.type != AGTV_INTEGER)
+        cannot_cast_agtype_value(agtv.type, "bigint");
+
+    PG_FREE_IF_COPY(agtype_in, 0);
+
+    PG_RETURN_INT64(agtv.val.int_value);
+}
+
 PG_FUNCTION_INFO_V1(bool_to_agtype);
 
 /*
@@ -1669,11 +1899,12 @@ Datum bool_to_agtype(PG_FUNCTION_ARGS)
 /*
  * Helper function for agtype_access_operator map access.
  * Note: This function expects that a map and a scalar key are being passed.
+ * The returned value points into the map, nothing in the map is copied.
  */
-static agtype *execute_map_access_operator(agtype *map, agtype *key)
+static agtype_value *execute_map_access_operator(agtype_container *map,
+                                                 agtype *key)
 {
     agtype_value *key_value;
-    agtype_value *map_value;
     agtype_value new_key_value;
 
     key_value = get_ith_agtype_value_from_container(&key->root, 0);
@@ -1706,21 +1937,17 @@ static agtype *execute_map_access_operator(agtype *map, agtype *key)
         break;
     }
 
-    map_value = find_agtype_value_from_container(&map->root, AGT_FOBJECT,
-                                                 &new_key_value);
-    if (map_value == NULL)
-        return NULL;
-
-    return agtype_value_to_agtype(map_value);
+    return find_agtype_value_from_container(map, AGT_FOBJECT, &new_key_value);
 }
 
 /*
  * Helper function for agtype_access_operator array access.
  * Note: This function expects that an array and a scalar key are being passed.
+ * The returned value points into the array, nothing in the array is copied.
  */
-static agtype *execute_array_access_operator(agtype *array, agtype *element)
+static agtype_value *execute_array_access_operator(agtype_container *array,
+                                                   agtype *element)
 {
-    agtype_value *array_value;
     agtype_value *element_value;
     int64 index;
     uint32 size;
@@ -1735,25 +1962,23 @@ static agtype *execute_array_access_operator(agtype *array, agtype *element)
                 (errmsg("array index must resolve to an integer value")));
     /* adjust for negative index values */
     index = element_value->val.int_value;
-    size = AGT_ROOT_COUNT(array);
+    size = AGTYPE_CONTAINER_SIZE(array);
     if (index < 0)
         index = size + index;
     /* check array bounds */
     if ((index >= size) || (index < 0))
         return NULL;
 
-    array_value = get_ith_agtype_value_from_container(&array->root, index);
-
-    if (array_value == NULL)
-        return NULL;
-
-    return agtype_value_to_agtype(array_value);
+    return get_ith_agtype_value_from_container(array, index);
 }
 
 PG_FUNCTION_INFO_V1(agtype_access_operator);
 /*
  * Execution function for object.property, object["property"],
  * and array[element]
+ *
+ * The containers are walked in place. Only the value that is finally found is
+ * turned into a new agtype.
  */
 Datum agtype_access_operator(PG_FUNCTION_ARGS)
 {
@@ -1762,9 +1987,13 @@ Datum agtype_access_operator(PG_FUNCTION_ARGS)
     bool *nulls;
     Oid *types;
     agtype *object;
+    agtype_container *container;
+    agtype_value *value = NULL;
     agtype *key;
     int i;
 
+    ag_stat_inc(AG_STAT_ACCESS_OPERATOR_CALLS);
+
     nargs = extract_variadic_args(fcinfo, 0, true, &args, &types, &nulls);
     /* we need at least 2 parameters, the object, and a field or element */
     if (nargs < 2)
@@ -1773,18 +2002,18 @@ Datum agtype_access_operator(PG_FUNCTION_ARGS)
     object = DATUM_GET_AGTYPE_P(args[0]);
     if (AGT_ROOT_IS_SCALAR(object))
     {
-        agtype_value *v;
-        v = get_ith_agtype_value_from_container(&object->root, 0);
-
-        if (v->type == AGTV_VERTEX)
-            object = agtype_value_to_agtype(&v->val.object.pairs[2].value);
-        else if (v->type == AGTV_EDGE)
-            object = agtype_value_to_agtype(&v->val.object.pairs[4].value);
-        else
+        /* the properties of a vertex or an edge are accessed */
+        value = get_entity_properties_from_container(&object->root);
+        if (value == NULL)
             ereport(ERROR, (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
                             errmsg("container must be an array or object")));
 
-        //object = agtype_value_to_agtype(&v->val.object.pairs[2].value);
+        Assert(value->type == AGTV_BINARY);
+        container = value->val.binary.data;
+    }
+    else
+    {
+        container = &object->root;
     }
 
     for (i = 1; i < nargs; i++)
@@ -1800,19 +2029,32 @@ Datum agtype_access_operator(PG_FUNCTION_ARGS)
                             errmsg("key must resolve to a scalar value")));
         }
 
-        if (AGT_ROOT_IS_OBJECT(object))
-            object = execute_map_access_operator(object, key);
-        else if (AGT_ROOT_IS_ARRAY(object))
-            object = execute_array_access_operator(object, key);
+        if (AGTYPE_CONTAINER_IS_OBJECT(container))
+            value = execute_map_access_operator(container, key);
+        else if (AGTYPE_CONTAINER_IS_ARRAY(container))
+            value = execute_array_access_operator(container, key);
         else
             ereport(ERROR, (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
                             errmsg("container must be an array or object")));
 
-        if (object == NULL)
+        if (value == NULL)
             PG_RETURN_NULL();
+
+        if (value->type == AGTV_BINARY)
+        {
+            container = value->val.binary.data;
+        }
+        else if (i + 1 < nargs)
+        {
+            /*
+             * A scalar is accessed further. This is done with its raw scalar
+             * array form.
+             */
+            container = &agtype_value_to_agtype(value)->root;
+        }
     }
 
-    return AGTYPE_P_GET_DATUM(object);
+    return AGTYPE_P_GET_DATUM(agtype_value_to_agtype(value));
 }
 
 PG_FUNCTION_INFO_V1(agtype_access_slice);
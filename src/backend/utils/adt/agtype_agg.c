@@ -0,0 +1,1010 @@
+/*
+ * Copyright 2020 Bitnine Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Aggregate functions over agtype for Cypher (count, sum, avg, min, max,
+ * collect, percentileCont and percentileDisc).
+ *
+ * The transition states keep numbers as int64 and float8 instead of agtype
+ * values, so that the input is not copied or converted on every row. Every
+ * state can be combined, serialized and deserialized so that the aggregates
+ * can be computed partially and in parallel.
+ */
+
+#include "postgres.h"
+
+#include <math.h>
+
+#include "common/int.h"
+#include "fmgr.h"
+#include "libpq/pqformat.h"
+#include "utils/builtins.h"
+#include "utils/datum.h"
+#include "utils/numeric.h"
+
+#include "utils/agtype.h"
+#include "utils/agtype_ext.h"
+
+// state of sum() and avg()
+typedef struct agtype_sum_state
+{
+    int64 count; // the number of numbers summed
+    int64 int_sum;
+    float8 float_sum;
+    bool has_float;
+    Numeric numeric_sum; // NULL until a numeric or an int64 overflow is seen
+} agtype_sum_state;
+
+// state of collect()
+typedef struct agtype_collect_state
+{
+    int nelems;
+    int maxelems;
+    agtype **elems;
+} agtype_collect_state;
+
+typedef struct percentile_value
+{
+    bool is_integer;
+    union
+    {
+        int64 int_value;
+        float8 float_value;
+    } val;
+} percentile_value;
+
+// state of percentileCont() and percentileDisc()
+typedef struct agtype_percentile_state
+{
+    float8 percentile;
+    int64 nvalues;
+    int64 maxvalues;
+    percentile_value *values;
+} agtype_percentile_state;
+
+static MemoryContext get_agg_context(FunctionCallInfo fcinfo);
+static bool get_scalar_arg(FunctionCallInfo fcinfo, int argno,
+                           agtype_value *result);
+static bool is_agtype_null(Datum d);
+static agtype_sum_state *make_sum_state(MemoryContext aggcontext);
+static void add_numeric_to_sum(agtype_sum_state *state, Numeric num,
+                               MemoryContext aggcontext);
+static Numeric get_numeric_total(agtype_sum_state *state);
+static agtype_collect_state *make_collect_state(MemoryContext aggcontext);
+static void append_collect_elem(agtype_collect_state *state, agtype *elem,
+                                MemoryContext aggcontext);
+static agtype_percentile_state *make_percentile_state(
+    MemoryContext aggcontext);
+static void append_percentile_value(agtype_percentile_state *state,
+                                    percentile_value *value,
+                                    MemoryContext aggcontext);
+static float8 get_percentile_float(percentile_value *value);
+static int compare_percentile_floats(float8 a, float8 b);
+static int compare_percentile_integer_float(int64 i, float8 f);
+static int percentile_value_cmp(const void *a, const void *b);
+
+static MemoryContext get_agg_context(FunctionCallInfo fcinfo)
+{
+    MemoryContext aggcontext;
+
+    if (!AggCheckCallContext(fcinfo, &aggcontext))
+        elog(ERROR, "aggregate function called in non-aggregate context");
+
+    return aggcontext;
+}
+
+/*
+ * Fills result with the raw scalar of the agtype argument. Integers and
+ * floats are read in place. Returns false if the argument is not a scalar.
+ */
+static bool get_scalar_arg(FunctionCallInfo fcinfo, int argno,
+                           agtype_value *result)
+{
+    Datum d = PG_GETARG_DATUM(argno);
+    agtype *agt;
+
+    if (ag_get_fixed_scalar(PG_DETOAST_DATUM_PACKED(d), result))
+        return true;
+
+    agt = DATUM_GET_AGTYPE_P(d);
+    if (!AGT_ROOT_IS_SCALAR(agt))
+        return false;
+
+    *result = *get_ith_agtype_value_from_container(&agt->root, 0);
+
+    return true;
+}
+
+// Cypher aggregates skip null values just like SQL NULL values.
+static bool is_agtype_null(Datum d)
+{
+    struct varlena *agt = PG_DETOAST_DATUM_PACKED(d);
+    uint32 words[2]; // the root header and the first agtentry
+
+    if (VARSIZE_ANY_EXHDR(agt) < sizeof(words))
+        return false;
+
+    memcpy(words, VARDATA_ANY(agt), sizeof(words));
+
+    return (words[0] & AGT_FSCALAR) && AGTE_IS_NULL(words[1]);
+}
+
+/*
+ * count()
+ */
+
+PG_FUNCTION_INFO_V1(agtype_count_transfn);
+
+Datum agtype_count_transfn(PG_FUNCTION_ARGS)
+{
+    int64 count = PG_GETARG_INT64(0);
+
+    if (!is_agtype_null(PG_GETARG_DATUM(1)))
+        count++;
+
+    PG_RETURN_INT64(count);
+}
+
+PG_FUNCTION_INFO_V1(agtype_count_final);
+
+Datum agtype_count_final(PG_FUNCTION_ARGS)
+{
+    PG_RETURN_DATUM(integer_to_agtype(PG_GETARG_INT64(0)));
+}
+
+/*
+ * sum() and avg()
+ */
+
+static agtype_sum_state *make_sum_state(MemoryContext aggcontext)
+{
+    return MemoryContextAllocZero(aggcontext, sizeof(agtype_sum_state));
+}
+
+static void add_numeric_to_sum(agtype_sum_state *state, Numeric num,
+                               MemoryContext aggcontext)
+{
+    MemoryContext old_mcxt = MemoryContextSwitchTo(aggcontext);
+
+    if (state->numeric_sum)
+    {
+        state->numeric_sum = DatumGetNumeric(DirectFunctionCall2(
+            numeric_add, NumericGetDatum(state->numeric_sum),
+            NumericGetDatum(num)));
+    }
+    else
+    {
+        state->numeric_sum = DatumGetNumeric(
+            datumCopy(NumericGetDatum(num), false, -1));
+    }
+
+    MemoryContextSwitchTo(old_mcxt);
+}
+
+PG_FUNCTION_INFO_V1(agtype_sum_transfn);
+
+Datum agtype_sum_transfn(PG_FUNCTION_ARGS)
+{
+    MemoryContext aggcontext = get_agg_context(fcinfo);
+    agtype_sum_state *state;
+    agtype_value value;
+
+    state = PG_ARGISNULL(0) ? NULL : (agtype_sum_state *)PG_GETARG_POINTER(0);
+
+    if (PG_ARGISNULL(1))
+        PG_RETURN_POINTER(state);
+
+    if (!get_scalar_arg(fcinfo, 1, &value))
+    {
+        ereport(ERROR, (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                        errmsg("sum() and avg() only support numbers")));
+    }
+
+    if (value.type == AGTV_NULL)
+        PG_RETURN_POINTER(state);
+
+    if (!state)
+        state = make_sum_state(aggcontext);
+
+    switch (value.type)
+    {
+    case AGTV_INTEGER:
+    {
+        int64 int_sum;
+
+        // an integer that would overflow the sum is added as a numeric
+        if (pg_add_s64_overflow(state->int_sum, value.val.int_value,
+                                &int_sum))
+        {
+            add_numeric_to_sum(state,
+                               DatumGetNumeric(DirectFunctionCall1(
+                                   int8_numeric,
+                                   Int64GetDatum(value.val.int_value))),
+                               aggcontext);
+        }
+        else
+        {
+            state->int_sum = int_sum;
+        }
+        break;
+    }
+    case AGTV_FLOAT:
+        state->float_sum += value.val.float_value;
+        state->has_float = true;
+        break;
+    case AGTV_NUMERIC:
+        add_numeric_to_sum(state, value.val.numeric, aggcontext);
+        break;
+    default:
+        ereport(ERROR, (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                        errmsg("sum() and avg() only support numbers")));
+    }
+
+    state->count++;
+
+    PG_RETURN_POINTER(state);
+}
+
+PG_FUNCTION_INFO_V1(agtype_sum_combinefn);
+
+Datum agtype_sum_combinefn(PG_FUNCTION_ARGS)
+{
+    MemoryContext aggcontext = get_agg_context(fcinfo);
+    agtype_sum_state *state1;
+    agtype_sum_state *state2;
+    int64 int_sum;
+
+    state1 = PG_ARGISNULL(0) ? NULL : (agtype_sum_state *)PG_GETARG_POINTER(0);
+    state2 = PG_ARGISNULL(1) ? NULL : (agtype_sum_state *)PG_GETARG_POINTER(1);
+
+    if (!state2)
+        PG_RETURN_POINTER(state1);
+
+    if (!state1)
+        state1 = make_sum_state(aggcontext);
+
+    if (pg_add_s64_overflow(state1->int_sum, state2->int_sum, &int_sum))
+    {
+        add_numeric_to_sum(state1,
+                           DatumGetNumeric(DirectFunctionCall1(
+                               int8_numeric, Int64GetDatum(state2->int_sum))),
+                           aggcontext);
+    }
+    else
+    {
+        state1->int_sum = int_sum;
+    }
+    state1->float_sum += state2->float_sum;
+    state1->has_float |= state2->has_float;
+    if (state2->numeric_sum)
+        add_numeric_to_sum(state1, state2->numeric_sum, aggcontext);
+    state1->count += state2->count;
+
+    PG_RETURN_POINTER(state1);
+}
+
+PG_FUNCTION_INFO_V1(agtype_sum_serialize);
+
+Datum agtype_sum_serialize(PG_FUNCTION_ARGS)
+{
+    agtype_sum_state *state = (agtype_sum_state *)PG_GETARG_POINTER(0);
+    StringInfoData buf;
+
+    pq_begintypsend(&buf);
+    pq_sendint64(&buf, state->count);
+    pq_sendint64(&buf, state->int_sum);
+    pq_sendfloat8(&buf, state->float_sum);
+    pq_sendbyte(&buf, state->has_float);
+    if (state->numeric_sum)
+    {
+        bytea *num = DatumGetByteaPP(DirectFunctionCall1(
+            numeric_send, NumericGetDatum(state->numeric_sum)));
+
+        pq_sendbyte(&buf, true);
+        pq_sendint32(&buf, VARSIZE_ANY_EXHDR(num));
+        pq_sendbytes(&buf, VARDATA_ANY(num), VARSIZE_ANY_EXHDR(num));
+    }
+    else
+    {
+        pq_sendbyte(&buf, false);
+    }
+
+    PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
+}
+
+PG_FUNCTION_INFO_V1(agtype_sum_deserialize);
+
+Datum agtype_sum_deserialize(PG_FUNCTION_ARGS)
+{
+    bytea *data = PG_GETARG_BYTEA_PP(0);
+    agtype_sum_state *state;
+    StringInfoData buf;
+
+    get_agg_context(fcinfo);
+
+    initStringInfo(&buf);
+    appendBinaryStringInfo(&buf, VARDATA_ANY(data), VARSIZE_ANY_EXHDR(data));
+
+    state = palloc0(sizeof(agtype_sum_state));
+    state->count = pq_getmsgint64(&buf);
+    state->int_sum = pq_getmsgint64(&buf);
+    state->float_sum = pq_getmsgfloat8(&buf);
+    state->has_float = pq_getmsgbyte(&buf);
+    if (pq_getmsgbyte(&buf))
+    {
+        int len = pq_getmsgint(&buf, 4);
+        StringInfoData num_buf;
+
+        initStringInfo(&num_buf);
+        appendBinaryStringInfo(&num_buf, pq_getmsgbytes(&buf, len), len);
+
+        state->numeric_sum = DatumGetNumeric(DirectFunctionCall3(
+            numeric_recv, PointerGetDatum(&num_buf), InvalidOid,
+            Int32GetDatum(-1)));
+    }
+    pq_getmsgend(&buf);
+
+    PG_RETURN_POINTER(state);
+}
+
+// the exact total of a sum that has seen a numeric
+static Numeric get_numeric_total(agtype_sum_state *state)
+{
+    Datum total = NumericGetDatum(state->numeric_sum);
+
+    total = DirectFunctionCall2(numeric_add, total,
+                                DirectFunctionCall1(
+                                    int8_numeric,
+                                    Int64GetDatum(state->int_sum)));
+    if (state->has_float)
+    {
+        total = DirectFunctionCall2(numeric_add, total,
+                                    DirectFunctionCall1(
+                                        float8_numeric,
+                                        Float8GetDatum(state->float_sum)));
+    }
+
+    return DatumGetNumeric(total);
+}
+
+PG_FUNCTION_INFO_V1(agtype_sum_final);
+
+/*
+ * The sum is an integer if all the numbers are integers, a float if any is
+ * a float, and a numeric if any is a numeric. The sum of no numbers is 0.
+ */
+Datum agtype_sum_final(PG_FUNCTION_ARGS)
+{
+    agtype_sum_state *state;
+    agtype_value result;
+
+    state = PG_ARGISNULL(0) ? NULL : (agtype_sum_state *)PG_GETARG_POINTER(0);
+
+    if (!state)
+        PG_RETURN_DATUM(integer_to_agtype(0));
+
+    if (state->numeric_sum)
+    {
+        result.type = AGTV_NUMERIC;
+        result.val.numeric = get_numeric_total(state);
+
+        AG_RETURN_AGTYPE_P(agtype_value_to_agtype(&result));
+    }
+
+    if (state->has_float)
+        PG_RETURN_DATUM(float_to_agtype(state->int_sum + state->float_sum));
+
+    PG_RETURN_DATUM(integer_to_agtype(state->int_sum));
+}
+
+PG_FUNCTION_INFO_V1(agtype_avg_final);
+
+/*
+ * The average is a numeric if any number is a numeric, and a float
+ * otherwise. The average of no numbers is null.
+ */
+Datum agtype_avg_final(PG_FUNCTION_ARGS)
+{
+    agtype_sum_state *state;
+    agtype_value result;
+
+    state = PG_ARGISNULL(0) ? NULL : (agtype_sum_state *)PG_GETARG_POINTER(0);
+
+    if (!state || state->count == 0)
+        PG_RETURN_NULL();
+
+    if (state->numeric_sum)
+    {
+        Datum count = DirectFunctionCall1(int8_numeric,
+                                          Int64GetDatum(state->count));
+
+        result.type = AGTV_NUMERIC;
+        result.val.numeric = DatumGetNumeric(DirectFunctionCall2(
+            numeric_div, NumericGetDatum(get_numeric_total(state)), count));
+
+        AG_RETURN_AGTYPE_P(agtype_value_to_agtype(&result));
+    }
+
+    PG_RETURN_DATUM(float_to_agtype((state->int_sum + state->float_sum) /
+                                    state->count));
+}
+
+/*
+ * min() and max()
+ *
+ * The state is the smallest (or largest) value itself; null values never
+ * replace it.
+ */
+
+PG_FUNCTION_INFO_V1(agtype_smaller);
+
+Datum agtype_smaller(PG_FUNCTION_ARGS)
+{
+    agtype *agt1 = AG_GET_ARG_AGTYPE_P(0);
+    agtype *agt2 = AG_GET_ARG_AGTYPE_P(1);
+
+    if (is_agtype_null(PG_GETARG_DATUM(1)))
+        AG_RETURN_AGTYPE_P(agt1);
+    if (is_agtype_null(PG_GETARG_DATUM(0)))
+        AG_RETURN_AGTYPE_P(agt2);
+
+    if (compare_agtype_containers_orderability(&agt1->root, &agt2->root) <= 0)
+        AG_RETURN_AGTYPE_P(agt1);
+
+    AG_RETURN_AGTYPE_P(agt2);
+}
+
+PG_FUNCTION_INFO_V1(agtype_larger);
+
+Datum agtype_larger(PG_FUNCTION_ARGS)
+{
+    agtype *agt1 = AG_GET_ARG_AGTYPE_P(0);
+    agtype *agt2 = AG_GET_ARG_AGTYPE_P(1);
+
+    if (is_agtype_null(PG_GETARG_DATUM(1)))
+        AG_RETURN_AGTYPE_P(agt1);
+    if (is_agtype_null(PG_GETARG_DATUM(0)))
+        AG_RETURN_AGTYPE_P(agt2);
+
+    if (compare_agtype_containers_orderability(&agt1->root, &agt2->root) >= 0)
+        AG_RETURN_AGTYPE_P(agt1);
+
+    AG_RETURN_AGTYPE_P(agt2);
+}
+
+/*
+ * collect()
+ */
+
+static agtype_collect_state *make_collect_state(MemoryContext aggcontext)
+{
+    agtype_collect_state *state;
+
+    state = MemoryContextAlloc(aggcontext, sizeof(agtype_collect_state));
+    state->nelems = 0;
+    state->maxelems = 8;
+    state->elems = MemoryContextAlloc(aggcontext,
+                                      sizeof(agtype *) * state->maxelems);
+
+    return state;
+}
+
+// elem is copied into aggcontext
+static void append_collect_elem(agtype_collect_state *state, agtype *elem,
+                                MemoryContext aggcontext)
+{
+    agtype *copy;
+
+    if (state->nelems == state->maxelems)
+    {
+        state->maxelems *= 2;
+        state->elems = repalloc(state->elems,
+                                sizeof(agtype *) * state->maxelems);
+    }
+
+    copy = MemoryContextAlloc(aggcontext, VARSIZE(elem));
+    memcpy(copy, elem, VARSIZE(elem));
+
+    state->elems[state->nelems++] = copy;
+}
+
+PG_FUNCTION_INFO_V1(agtype_collect_transfn);
+
+Datum agtype_collect_transfn(PG_FUNCTION_ARGS)
+{
+    MemoryContext aggcontext = get_agg_context(fcinfo);
+    agtype_collect_state *state;
+
+    state = PG_ARGISNULL(0) ? NULL :
+                              (agtype_collect_state *)PG_GETARG_POINTER(0);
+
+    if (PG_ARGISNULL(1) || is_agtype_null(PG_GETARG_DATUM(1)))
+        PG_RETURN_POINTER(state);
+
+    if (!state)
+        state = make_collect_state(aggcontext);
+
+    append_collect_elem(state, AG_GET_ARG_AGTYPE_P(1), aggcontext);
+
+    PG_RETURN_POINTER(state);
+}
+
+PG_FUNCTION_INFO_V1(agtype_collect_combinefn);
+
+Datum agtype_collect_combinefn(PG_FUNCTION_ARGS)
+{
+    MemoryContext aggcontext = get_agg_context(fcinfo);
+    agtype_collect_state *state1;
+    agtype_collect_state *state2;
+    int i;
+
+    state1 = PG_ARGISNULL(0) ? NULL :
+                               (agtype_collect_state *)PG_GETARG_POINTER(0);
+    state2 = PG_ARGISNULL(1) ? NULL :
+                               (agtype_collect_state *)PG_GETARG_POINTER(1);
+
+    if (!state2)
+        PG_RETURN_POINTER(state1);
+
+    if (!state1)
+        state1 = make_collect_state(aggcontext);
+
+    // the elements of state2 may not be in aggcontext, so they are copied
+    for (i = 0; i < state2->nelems; i++)
+        append_collect_elem(state1, state2->elems[i], aggcontext);
+
+    PG_RETURN_POINTER(state1);
+}
+
+PG_FUNCTION_INFO_V1(agtype_collect_serialize);
+
+Datum agtype_collect_serialize(PG_FUNCTION_ARGS)
+{
+    agtype_collect_state *state;
+    StringInfoData buf;
+    int i;
+
+    state = (agtype_collect_state *)PG_GETARG_POINTER(0);
+
+    pq_begintypsend(&buf);
+    pq_sendint32(&buf, state->nelems);
+    for (i = 0; i < state->nelems; i++)
+    {
+        agtype *elem = state->elems[i];
+
+        pq_sendint32(&buf, VARSIZE(elem));
+        pq_sendbytes(&buf, (char *)elem, VARSIZE(elem));
+    }
+
+    PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
+}
+
+PG_FUNCTION_INFO_V1(agtype_collect_deserialize);
+
+Datum agtype_collect_deserialize(PG_FUNCTION_ARGS)
+{
+    bytea *data = PG_GETARG_BYTEA_PP(0);
+    agtype_collect_state *state;
+    StringInfoData buf;
+    int i;
+
+    get_agg_context(fcinfo);
+
+    initStringInfo(&buf);
+    appendBinaryStringInfo(&buf, VARDATA_ANY(data), VARSIZE_ANY_EXHDR(data));
+
+    state = palloc(sizeof(agtype_collect_state));
+    state->nelems = pq_getmsgint(&buf, 4);
+    state->maxelems = Max(state->nelems, 1);
+    state->elems = palloc(sizeof(agtype *) * state->maxelems);
+    for (i = 0; i < state->nelems; i++)
+    {
+        int len = pq_getmsgint(&buf, 4);
+
+        state->elems[i] = palloc(len);
+        pq_copymsgbytes(&buf, (char *)state->elems[i], len);
+    }
+    pq_getmsgend(&buf);
+
+    PG_RETURN_POINTER(state);
+}
+
+PG_FUNCTION_INFO_V1(agtype_collect_final);
+
+// The list of the collected values. It is empty if there is no value.
+Datum agtype_collect_final(PG_FUNCTION_ARGS)
+{
+    agtype_collect_state *state;
+    agtype_parse_state *parse_state = NULL;
+    agtype_value *result;
+    int i;
+
+    state = PG_ARGISNULL(0) ? NULL :
+                              (agtype_collect_state *)PG_GETARG_POINTER(0);
+
+    result = push_agtype_value(&parse_state, WAGT_BEGIN_ARRAY, NULL);
+
+    for (i = 0; state && i < state->nelems; i++)
+    {
+        agtype *elem = state->elems[i];
+        agtype_value elem_value;
+
+        if (AGT_ROOT_IS_SCALAR(elem))
+        {
+            elem_value = *get_ith_agtype_value_from_container(&elem->root,
+                                                              0);
+        }
+        else
+        {
+            elem_value.type = AGTV_BINARY;
+            elem_value.val.binary.data = &elem->root;
+            elem_value.val.binary.len = VARSIZE(elem) - VARHDRSZ;
+        }
+
+        result = push_agtype_value(&parse_state, WAGT_ELEM, &elem_value);
+    }
+
+    result = push_agtype_value(&parse_state, WAGT_END_ARRAY, NULL);
+
+    AG_RETURN_AGTYPE_P(agtype_value_to_agtype(result));
+}
+
+/*
+ * percentileCont() and percentileDisc()
+ */
+
+static agtype_percentile_state *make_percentile_state(
+    MemoryContext aggcontext)
+{
+    agtype_percentile_state *state;
+
+    state = MemoryContextAlloc(aggcontext, sizeof(agtype_percentile_state));
+    state->percentile = -1; // not known yet
+    state->nvalues = 0;
+    state->maxvalues = 64;
+    state->values = MemoryContextAlloc(aggcontext, sizeof(percentile_value) *
+                                                       state->maxvalues);
+
+    return state;
+}
+
+static void append_percentile_value(agtype_percentile_state *state,
+                                    percentile_value *value,
+                                    MemoryContext aggcontext)
+{
+    if (state->nvalues == state->maxvalues)
+    {
+        state->maxvalues *= 2;
+        if ((Size)state->maxvalues * sizeof(percentile_value) > MaxAllocSize)
+        {
+            state->values = repalloc_huge(state->values,
+                                          sizeof(percentile_value) *
+                                              state->maxvalues);
+        }
+        else
+        {
+            state->values = repalloc(state->values, sizeof(percentile_value) *
+                                                        state->maxvalues);
+        }
+    }
+
+    state->values[state->nvalues++] = *value;
+}
+
+static float8 get_percentile_float(percentile_value *value)
+{
+    if (value->is_integer)
+        return (float8)value->val.int_value;
+
+    return value->val.float_value;
+}
+
+// NaN is equal to itself and greater than any other number, like B-tree
+static int compare_percentile_floats(float8 a, float8 b)
+{
+    if (isnan(a))
+        return isnan(b) ? 0 : 1;
+    if (isnan(b))
+        return -1;
+
+    if (a == b)
+        return 0;
+    return a < b ? -1 : 1;
+}
+
+/*
+ * Compare an integer with a float exactly. Converting the integer to float8
+ * loses precision above 2^53, which makes the order intransitive and breaks
+ * qsort().
+ */
+static int compare_percentile_integer_float(int64 i, float8 f)
+{
+    int64 f_int;
+    float8 f_frac;
+
+    if (isnan(f))
+        return -1;
+
+    // the float is out of the range of int64 (this includes infinities)
+    if (f >= -((float8)PG_INT64_MIN))
+        return -1;
+    if (f < (float8)PG_INT64_MIN)
+        return 1;
+
+    // the integral part of f is exactly representable in both types
+    f_int = (int64)f;
+    if (i != f_int)
+        return i < f_int ? -1 : 1;
+
+    f_frac = f - (float8)f_int;
+    if (f_frac == 0)
+        return 0;
+    return f_frac > 0 ? -1 : 1;
+}
+
+static int percentile_value_cmp(const void *a, const void *b)
+{
+    percentile_value *va = (percentile_value *)a;
+    percentile_value *vb = (percentile_value *)b;
+
+    if (va->is_integer && vb->is_integer)
+    {
+        if (va->val.int_value == vb->val.int_value)
+            return 0;
+        return va->val.int_value < vb->val.int_value ? -1 : 1;
+    }
+
+    if (va->is_integer)
+        return compare_percentile_integer_float(va->val.int_value,
+                                                vb->val.float_value);
+    if (vb->is_integer)
+        return -compare_percentile_integer_float(vb->val.int_value,
+                                                 va->val.float_value);
+
+    return compare_percentile_floats(va->val.float_value, vb->val.float_value);
+}
+
+PG_FUNCTION_INFO_V1(agtype_percentile_transfn);
+
+Datum agtype_percentile_transfn(PG_FUNCTION_ARGS)
+{
+    MemoryContext aggcontext = get_agg_context(fcinfo);
+    agtype_percentile_state *state;
+    agtype_value value;
+    agtype_value percentile;
+    percentile_value pvalue;
+
+    state = PG_ARGISNULL(0) ? NULL :
+                              (agtype_percentile_state *)PG_GETARG_POINTER(0);
+
+    if (PG_ARGISNULL(1) || is_agtype_null(PG_GETARG_DATUM(1)))
+        PG_RETURN_POINTER(state);
+
+    if (!state)
+    {
+        if (PG_ARGISNULL(2) || !get_scalar_arg(fcinfo, 2, &percentile) ||
+            (percentile.type != AGTV_INTEGER && percentile.type != AGTV_FLOAT))
+        {
+            ereport(ERROR, (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                            errmsg("percentile must be a number")));
+        }
+
+        state = make_percentile_state(aggcontext);
+        state->percentile = percentile.type == AGTV_INTEGER ?
+                                percentile.val.int_value :
+                                percentile.val.float_value;
+
+        if (!(state->percentile >= 0 && state->percentile <= 1))
+        {
+            ereport(ERROR,
+                    (errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+                     errmsg("percentile value %g is not between 0 and 1",
+                            state->percentile)));
+        }
+    }
+
+    if (!get_scalar_arg(fcinfo, 1, &value))
+    {
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("percentileCont() and percentileDisc() only support numbers")));
+    }
+
+    switch (value.type)
+    {
+    case AGTV_INTEGER:
+        pvalue.is_integer = true;
+        pvalue.val.int_value = value.val.int_value;
+        break;
+    case AGTV_FLOAT:
+        pvalue.is_integer = false;
+        pvalue.val.float_value = value.val.float_value;
+        break;
+    case AGTV_NUMERIC:
+        pvalue.is_integer = false;
+        pvalue.val.float_value = DatumGetFloat8(DirectFunctionCall1(
+            numeric_float8_no_overflow, NumericGetDatum(value.val.numeric)));
+        break;
+    default:
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("percentileCont() and percentileDisc() only support numbers")));
+    }
+
+    append_percentile_value(state, &pvalue, aggcontext);
+
+    PG_RETURN_POINTER(state);
+}
+
+PG_FUNCTION_INFO_V1(agtype_percentile_combinefn);
+
+Datum agtype_percentile_combinefn(PG_FUNCTION_ARGS)
+{
+    MemoryContext aggcontext = get_agg_context(fcinfo);
+    agtype_percentile_state *state1;
+    agtype_percentile_state *state2;
+    int64 i;
+
+    state1 = PG_ARGISNULL(0) ? NULL :
+                               (agtype_percentile_state *)PG_GETARG_POINTER(0);
+    state2 = PG_ARGISNULL(1) ? NULL :
+                               (agtype_percentile_state *)PG_GETARG_POINTER(1);
+
+    if (!state2)
+        PG_RETURN_POINTER(state1);
+
+    if (!state1)
+    {
+        state1 = make_percentile_state(aggcontext);
+        state1->percentile = state2->percentile;
+    }
+
+    for (i = 0; i < state2->nvalues; i++)
+        append_percentile_value(state1, &state2->values[i], aggcontext);
+
+    PG_RETURN_POINTER(state1);
+}
+
+PG_FUNCTION_INFO_V1(agtype_percentile_serialize);
+
+Datum agtype_percentile_serialize(PG_FUNCTION_ARGS)
+{
+    agtype_percentile_state *state;
+    StringInfoData buf;
+    int64 i;
+
+    state = (agtype_percentile_state *)PG_GETARG_POINTER(0);
+
+    pq_begintypsend(&buf);
+    pq_sendfloat8(&buf, state->percentile);
+    pq_sendint64(&buf, state->nvalues);
+    for (i = 0; i < state->nvalues; i++)
+    {
+        percentile_value *value = &state->values[i];
+
+        pq_sendbyte(&buf, value->is_integer);
+        if (value->is_integer)
+            pq_sendint64(&buf, value->val.int_value);
+        else
+            pq_sendfloat8(&buf, value->val.float_value);
+    }
+
+    PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
+}
+
+PG_FUNCTION_INFO_V1(agtype_percentile_deserialize);
+
+Datum agtype_percentile_deserialize(PG_FUNCTION_ARGS)
+{
+    bytea *data = PG_GETARG_BYTEA_PP(0);
+    agtype_percentile_state *state;
+    StringInfoData buf;
+    int64 i;
+
+    get_agg_context(fcinfo);
+
+    initStringInfo(&buf);
+    appendBinaryStringInfo(&buf, VARDATA_ANY(data), VARSIZE_ANY_EXHDR(data));
+
+    state = palloc(sizeof(agtype_percentile_state));
+    state->percentile = pq_getmsgfloat8(&buf);
+    state->nvalues = pq_getmsgint64(&buf);
+    state->maxvalues = Max(state->nvalues, 1);
+    state->values = palloc_extended(sizeof(percentile_value) *
+                                        state->maxvalues,
+                                    MCXT_ALLOC_HUGE);
+    for (i = 0; i < state->nvalues; i++)
+    {
+        percentile_value *value = &state->values[i];
+
+        value->is_integer = pq_getmsgbyte(&buf);
+        if (value->is_integer)
+            value->val.int_value = pq_getmsgint64(&buf);
+        else
+            value->val.float_value = pq_getmsgfloat8(&buf);
+    }
+    pq_getmsgend(&buf);
+
+    PG_RETURN_POINTER(state);
+}
+
+PG_FUNCTION_INFO_V1(agtype_percentile_cont_final);
+
+/*
+ * The percentile interpolated between the two nearest values, as a float.
+ *
+ * Sorting the values in place does not change what the state represents.
+ */
+Datum agtype_percentile_cont_final(PG_FUNCTION_ARGS)
+{
+    agtype_percentile_state *state;
+    float8 pos;
+    int64 lo;
+    int64 hi;
+    float8 lo_value;
+    float8 hi_value;
+
+    state = PG_ARGISNULL(0) ? NULL :
+                              (agtype_percentile_state *)PG_GETARG_POINTER(0);
+
+    if (!state || state->nvalues == 0)
+        PG_RETURN_NULL();
+
+    qsort(state->values, state->nvalues, sizeof(percentile_value),
+          percentile_value_cmp);
+
+    pos = state->percentile * (state->nvalues - 1);
+    lo = (int64)floor(pos);
+    hi = (int64)ceil(pos);
+
+    lo_value = get_percentile_float(&state->values[lo]);
+    hi_value = get_percentile_float(&state->values[hi]);
+
+    PG_RETURN_DATUM(float_to_agtype(lo_value + (pos - lo) *
+                                                   (hi_value - lo_value)));
+}
+
+PG_FUNCTION_INFO_V1(agtype_percentile_disc_final);
+
+/*
+ * The first value whose position in the sorted values reaches the
+ * percentile. It is one of the values, so integers stay integers.
+ */
+Datum agtype_percentile_disc_final(PG_FUNCTION_ARGS)
+{
+    agtype_percentile_state *state;
+    percentile_value *value;
+    int64 idx;
+
+    state = PG_ARGISNULL(0) ? NULL :
+                              (agtype_percentile_state *)PG_GETARG_POINTER(0);
+
+    if (!state || state->nvalues == 0)
+        PG_RETURN_NULL();
+
+    qsort(state->values, state->nvalues, sizeof(percentile_value),
+          percentile_value_cmp);
+
+    idx = (int64)ceil(state->percentile * state->nvalues) - 1;
+    if (idx < 0)
+        idx = 0;
+
+    value = &state->values[idx];
+    if (value->is_integer)
+        PG_RETURN_DATUM(integer_to_agtype(value->val.int_value));
+
+    PG_RETURN_DATUM(float_to_agtype(value->val.float_value));
+}
@@ -14,6 +14,10 @@
  * limitations under the License.
  */
 
+#include "postgres.h"
+
+#include "mb/pg_wchar.h"
+
 #include "utils/agtype_ext.h"
 #include "utils/agtype.h"
 #include "utils/graphid.h"
@@ -28,8 +32,59 @@
 #define AGT_HEADER_VERTEX 0x00000002
 #define AGT_HEADER_EDGE 0x00000003
 
-static void ag_deserialize_composite(char *base, enum agtype_value_type type,
-                                     agtype_value *result);
+/*
+ * Vertices and edges are stored in a fixed layout after the header.
+ *
+ *   graphids     int64 * n (id for vertices; id, start_id, end_id for edges)
+ *   props_len    uint32, the size of the properties container
+ *   label_len    uint32
+ *   label        label_len bytes, not null-terminated
+ *   padding      to the next int boundary
+ *   properties   the object container of the properties
+ *
+ * So, the graphids and the properties are found without searching keys.
+ */
+#define AGT_ENTITY_IDS_OFFSET AGT_HEADER_SIZE
+#define AGT_ENTITY_PROPS_LEN_OFFSET(nids) \
+    (AGT_ENTITY_IDS_OFFSET + sizeof(int64) * (nids))
+#define AGT_ENTITY_LABEL_LEN_OFFSET(nids) \
+    (AGT_ENTITY_PROPS_LEN_OFFSET(nids) + sizeof(uint32))
+#define AGT_ENTITY_LABEL_OFFSET(nids) \
+    (AGT_ENTITY_LABEL_LEN_OFFSET(nids) + sizeof(uint32))
+
+#define AGT_VERTEX_NIDS 1
+#define AGT_EDGE_NIDS 3
+
+/*
+ * An integer or a float as a raw scalar agtype. This is the layout that
+ * agtype_value_to_agtype() produces for them, written out as a struct so
+ * that it can be read and made without going through agtype_value.
+ */
+typedef struct agtype_fixed_scalar
+{
+    int32 vl_len_; /* varlena header (do not touch directly!) */
+    uint32 header; /* root container header */
+    agtentry entry; /* agtentry of the only element */
+    AGT_HEADER_TYPE agt_header;
+    union
+    {
+        int64 int_value;
+        float8 float_value;
+    } val;
+} agtype_fixed_scalar;
+
+#define AGT_FIXED_SCALAR_HEADER (AGT_FSCALAR | AGT_FARRAY | 1)
+#define AGT_FIXED_SCALAR_ENTRY \
+    (AGTENTRY_IS_AGTYPE | AGTENTRY_HAS_OFF | (AGT_HEADER_SIZE + sizeof(int64)))
+
+static void ag_serialize_entity(StringInfo buffer, agtentry *agtentry,
+                                AGT_HEADER_TYPE type, agtype_value *entity);
+static void ag_deserialize_entity(char *base, enum agtype_value_type type,
+                                  agtype_value *result);
+static int get_entity_nids(enum agtype_value_type type);
+static void set_entity_pair(agtype_pair *pair, char *key, uint32 order);
+static void report_malformed_extended_type(const char *detail)
+    pg_attribute_noreturn();
 
 static short ag_serialize_header(StringInfo buffer, uint32 type)
 {
@@ -79,26 +134,12 @@ bool ag_serialize_extended_type(StringInfo buffer, agtentry *agtentry,
         break;
 
     case AGTV_VERTEX:
-    {
-        uint32 object_ae = 0;
-        padlen = ag_serialize_header(buffer, AGT_HEADER_VERTEX);
-        convert_extended_object(buffer, &object_ae, scalar_val);
-
-        *agtentry = AGTENTRY_IS_AGTYPE |
-                    ((AGTENTRY_OFFLENMASK & (int)object_ae) + AGT_HEADER_SIZE);
+        ag_serialize_entity(buffer, agtentry, AGT_HEADER_VERTEX, scalar_val);
         break;
-    }
 
     case AGTV_EDGE:
-    {
-        uint32 object_ae = 0;
-        padlen = ag_serialize_header(buffer, AGT_HEADER_EDGE);
-        convert_extended_object(buffer, &object_ae, scalar_val);
-
-        *agtentry = AGTENTRY_IS_AGTYPE |
-                    ((AGTENTRY_OFFLENMASK & (int)object_ae) + AGT_HEADER_SIZE);
+        ag_serialize_entity(buffer, agtentry, AGT_HEADER_EDGE, scalar_val);
         break;
-    }
 
     default:
         return false;
@@ -130,10 +171,10 @@ void ag_deserialize_extended_type(char *base_addr, uint32 offset,
         break;
 
     case AGT_HEADER_VERTEX:
-        ag_deserialize_composite(base, AGTV_VERTEX, result);
+        ag_deserialize_entity(base, AGTV_VERTEX, result);
         break;
     case AGT_HEADER_EDGE:
-        ag_deserialize_composite(base, AGTV_EDGE, result);
+        ag_deserialize_entity(base, AGTV_EDGE, result);
         break;
     default:
         elog(ERROR, "Invalid AGT header value.");
@@ -141,28 +182,342 @@ void ag_deserialize_extended_type(char *base_addr, uint32 offset,
 }
 
 /*
- * Deserializes a composite type.
+ * Function fills result with the integer or the float that agt, a datum
+ * that may have a short varlena header, holds as its raw scalar. Nothing is
+ * copied or allocated. Returns false if agt holds anything else.
+ */
+bool ag_get_fixed_scalar(struct varlena *agt, agtype_value *result)
+{
+    char *data = VARDATA_ANY(agt);
+    agtype_fixed_scalar fixed;
+
+    if (VARSIZE_ANY_EXHDR(agt) != sizeof(fixed) - VARHDRSZ)
+        return false;
+
+    // the data is not aligned if the datum has a short header
+    memcpy(&fixed.header, data, sizeof(fixed) - VARHDRSZ);
+
+    if (fixed.header != AGT_FIXED_SCALAR_HEADER ||
+        fixed.entry != AGT_FIXED_SCALAR_ENTRY)
+    {
+        return false;
+    }
+
+    switch (fixed.agt_header)
+    {
+    case AGT_HEADER_INTEGER:
+        result->type = AGTV_INTEGER;
+        result->val.int_value = fixed.val.int_value;
+        return true;
+
+    case AGT_HEADER_FLOAT:
+        result->type = AGTV_FLOAT;
+        result->val.float_value = fixed.val.float_value;
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+/*
+ * Function returns the integer or the float in scalar_val as a raw scalar
+ * agtype.
+ */
+agtype *ag_make_fixed_scalar(agtype_value *scalar_val)
+{
+    agtype_fixed_scalar *result = palloc(sizeof(agtype_fixed_scalar));
+
+    SET_VARSIZE(result, sizeof(agtype_fixed_scalar));
+    result->header = AGT_FIXED_SCALAR_HEADER;
+    result->entry = AGT_FIXED_SCALAR_ENTRY;
+
+    if (scalar_val->type == AGTV_INTEGER)
+    {
+        result->agt_header = AGT_HEADER_INTEGER;
+        result->val.int_value = scalar_val->val.int_value;
+    }
+    else
+    {
+        Assert(scalar_val->type == AGTV_FLOAT);
+
+        result->agt_header = AGT_HEADER_FLOAT;
+        result->val.float_value = scalar_val->val.float_value;
+    }
+
+    return (agtype *)result;
+}
+
+/*
+ * Function checks that the extended type of len bytes (including padding)
+ * at base_addr + offset is well-formed. Errors out if it is not.
+ */
+void ag_check_extended_type(char *base_addr, uint32 offset, uint32 len)
+{
+    uint32 padlen = INTALIGN(offset) - offset;
+    char *base = base_addr + INTALIGN(offset);
+    AGT_HEADER_TYPE agt_header;
+    uint32 size;
+    int nids;
+    uint32 props_len;
+    uint32 label_len;
+    uint64 props_offset;
+
+    if (len < padlen + AGT_HEADER_SIZE)
+        report_malformed_extended_type("header is truncated");
+
+    size = len - padlen;
+    agt_header = *((AGT_HEADER_TYPE *)base);
+
+    switch (agt_header)
+    {
+    case AGT_HEADER_INTEGER:
+    case AGT_HEADER_FLOAT:
+        if (size != AGT_HEADER_SIZE + sizeof(int64))
+            report_malformed_extended_type("invalid length of a number");
+        return;
+
+    case AGT_HEADER_VERTEX:
+        nids = AGT_VERTEX_NIDS;
+        break;
+
+    case AGT_HEADER_EDGE:
+        nids = AGT_EDGE_NIDS;
+        break;
+
+    default:
+        report_malformed_extended_type("invalid header");
+    }
+
+    if (size < AGT_ENTITY_LABEL_OFFSET(nids))
+        report_malformed_extended_type("entity is truncated");
+
+    props_len = *((uint32 *)(base + AGT_ENTITY_PROPS_LEN_OFFSET(nids)));
+    label_len = *((uint32 *)(base + AGT_ENTITY_LABEL_LEN_OFFSET(nids)));
+
+    props_offset = INTALIGN((uint64)AGT_ENTITY_LABEL_OFFSET(nids) + label_len);
+    if (props_offset + props_len != size)
+        report_malformed_extended_type("invalid length of an entity");
+
+    pg_verify_mbstr(GetDatabaseEncoding(), base + AGT_ENTITY_LABEL_OFFSET(nids),
+                    label_len, false);
+
+    check_agtype_container((agtype_container *)(base + props_offset),
+                           props_len);
+    if (!AGTYPE_CONTAINER_IS_OBJECT((agtype_container *)(base + props_offset)))
+        report_malformed_extended_type("properties are not an object");
+}
+
+/*
+ * Function returns the properties of the vertex or edge serialized at
+ * base_addr + offset as an AGTV_BINARY value without deserializing the rest.
+ * Returns NULL if the type is not a vertex or an edge.
+ */
+agtype_value *ag_get_entity_properties(char *base_addr, uint32 offset)
+{
+    char *base = base_addr + INTALIGN(offset);
+    AGT_HEADER_TYPE agt_header = *((AGT_HEADER_TYPE *)base);
+    agtype_value *result;
+    int nids;
+    uint32 label_len;
+
+    if (agt_header == AGT_HEADER_VERTEX)
+        nids = AGT_VERTEX_NIDS;
+    else if (agt_header == AGT_HEADER_EDGE)
+        nids = AGT_EDGE_NIDS;
+    else
+        return NULL;
+
+    label_len = *((uint32 *)(base + AGT_ENTITY_LABEL_LEN_OFFSET(nids)));
+
+    result = palloc(sizeof(agtype_value));
+    result->type = AGTV_BINARY;
+    result->val.binary.len = *((uint32 *)(base +
+                                          AGT_ENTITY_PROPS_LEN_OFFSET(nids)));
+    result->val.binary.data = (agtype_container *)(
+        base + INTALIGN(AGT_ENTITY_LABEL_OFFSET(nids) + label_len));
+
+    return result;
+}
+
+/*
+ * Fills result with a vertex. The pairs of the vertex are in the order that
+ * an object with the same keys would have, and the properties are referenced
+ * in place.
  */
-static void ag_deserialize_composite(char *base, enum agtype_value_type type,
-                                     agtype_value *result)
+void ag_make_vertex_value(agtype_value *result, graphid id, char *label,
+                          int label_len, agtype_container *properties,
+                          int properties_len)
 {
-    agtype_iterator *it;
-    agtype_iterator_token tok;
-    agtype_parse_state *parse_state = NULL;
-    agtype_value *r;
-    agtype_value *parsed_agtype_value = NULL;
-    //offset container by the extended type header
-    char *container_base = base + AGT_HEADER_SIZE;
-
-    r = palloc(sizeof(agtype_value));
-
-    it = agtype_iterator_init((agtype_container *)container_base);
-    while ((tok = agtype_iterator_next(&it, r, true)) != WAGT_DONE)
+    agtype_pair *pairs = palloc(sizeof(agtype_pair) * 3);
+
+    set_entity_pair(&pairs[0], "id", 0);
+    pairs[0].value.type = AGTV_INTEGER;
+    pairs[0].value.val.int_value = id;
+
+    set_entity_pair(&pairs[1], "label", 1);
+    pairs[1].value.type = AGTV_STRING;
+    pairs[1].value.val.string.val = label;
+    pairs[1].value.val.string.len = label_len;
+
+    set_entity_pair(&pairs[2], "properties", 2);
+    pairs[2].value.type = AGTV_BINARY;
+    pairs[2].value.val.binary.data = properties;
+    pairs[2].value.val.binary.len = properties_len;
+
+    result->type = AGTV_VERTEX;
+    result->val.object.num_pairs = 3;
+    result->val.object.pairs = pairs;
+}
+
+/*
+ * Fills result with an edge. See ag_make_vertex_value().
+ */
+void ag_make_edge_value(agtype_value *result, graphid id, graphid start_id,
+                        graphid end_id, char *label, int label_len,
+                        agtype_container *properties, int properties_len)
+{
+    agtype_pair *pairs = palloc(sizeof(agtype_pair) * 5);
+
+    set_entity_pair(&pairs[0], "id", 0);
+    pairs[0].value.type = AGTV_INTEGER;
+    pairs[0].value.val.int_value = id;
+
+    set_entity_pair(&pairs[1], "label", 1);
+    pairs[1].value.type = AGTV_STRING;
+    pairs[1].value.val.string.val = label;
+    pairs[1].value.val.string.len = label_len;
+
+    set_entity_pair(&pairs[2], "end_id", 2);
+    pairs[2].value.type = AGTV_INTEGER;
+    pairs[2].value.val.int_value = end_id;
+
+    set_entity_pair(&pairs[3], "start_id", 3);
+    pairs[3].value.type = AGTV_INTEGER;
+    pairs[3].value.val.int_value = start_id;
+
+    set_entity_pair(&pairs[4], "properties", 4);
+    pairs[4].value.type = AGTV_BINARY;
+    pairs[4].value.val.binary.data = properties;
+    pairs[4].value.val.binary.len = properties_len;
+
+    result->type = AGTV_EDGE;
+    result->val.object.num_pairs = 5;
+    result->val.object.pairs = pairs;
+}
+
+static void set_entity_pair(agtype_pair *pair, char *key, uint32 order)
+{
+    pair->key.type = AGTV_STRING;
+    pair->key.val.string.val = key;
+    pair->key.val.string.len = strlen(key);
+    pair->order = order;
+}
+
+static int get_entity_nids(enum agtype_value_type type)
+{
+    return type == AGTV_VERTEX ? AGT_VERTEX_NIDS : AGT_EDGE_NIDS;
+}
+
+/*
+ * Serializes a vertex or an edge made by ag_make_vertex_value() or
+ * ag_make_edge_value().
+ */
+static void ag_serialize_entity(StringInfo buffer, agtentry *agtentry,
+                                AGT_HEADER_TYPE type, agtype_value *entity)
+{
+    agtype_pair *pairs = entity->val.object.pairs;
+    agtype_value *label;
+    agtype_value *properties;
+    short padlen;
+    int base_offset;
+    int offset;
+    int totallen;
+
+    padlen = ag_serialize_header(buffer, type);
+    base_offset = buffer->len - AGT_HEADER_SIZE;
+
+    offset = reserve_from_buffer(buffer, sizeof(int64));
+    *((int64 *)(buffer->data + offset)) = pairs[0].value.val.int_value;
+
+    if (entity->type == AGTV_VERTEX)
     {
-        parsed_agtype_value = push_agtype_value(
-            &parse_state, tok, tok < WAGT_BEGIN_ARRAY ? r : NULL);
+        label = &pairs[1].value;
+        properties = &pairs[2].value;
+    }
+    else
+    {
+        label = &pairs[1].value;
+        properties = &pairs[4].value;
+
+        // start_id and end_id
+        offset = reserve_from_buffer(buffer, sizeof(int64) * 2);
+        *((int64 *)(buffer->data + offset)) = pairs[3].value.val.int_value;
+        *((int64 *)(buffer->data + offset + sizeof(int64))) =
+            pairs[2].value.val.int_value;
     }
 
-    result->type = type;
-    result->val = parsed_agtype_value->val;
+    Assert(label->type == AGTV_STRING);
+    Assert(properties->type == AGTV_BINARY);
+
+    offset = reserve_from_buffer(buffer, sizeof(uint32) * 2);
+    *((uint32 *)(buffer->data + offset)) = properties->val.binary.len;
+    *((uint32 *)(buffer->data + offset + sizeof(uint32))) =
+        label->val.string.len;
+
+    offset = reserve_from_buffer(buffer, label->val.string.len);
+    memcpy(buffer->data + offset, label->val.string.val,
+           label->val.string.len);
+
+    pad_buffer_to_int(buffer);
+
+    offset = reserve_from_buffer(buffer, properties->val.binary.len);
+    memcpy(buffer->data + offset, properties->val.binary.data,
+           properties->val.binary.len);
+
+    totallen = padlen + (buffer->len - base_offset);
+    if (totallen > AGTENTRY_OFFLENMASK)
+    {
+        ereport(ERROR,
+                (errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+                 errmsg("total size of agtype %s exceeds the maximum of %u bytes",
+                        type == AGT_HEADER_VERTEX ? "vertex" : "edge",
+                        AGTENTRY_OFFLENMASK)));
+    }
+
+    *agtentry = AGTENTRY_IS_AGTYPE | totallen;
+}
+
+/*
+ * Deserializes a vertex or an edge. The label and the properties are
+ * referenced in place.
+ */
+static void ag_deserialize_entity(char *base, enum agtype_value_type type,
+                                  agtype_value *result)
+{
+    int nids = get_entity_nids(type);
+    int64 *ids = (int64 *)(base + AGT_ENTITY_IDS_OFFSET);
+    uint32 props_len = *((uint32 *)(base + AGT_ENTITY_PROPS_LEN_OFFSET(nids)));
+    uint32 label_len = *((uint32 *)(base + AGT_ENTITY_LABEL_LEN_OFFSET(nids)));
+    char *label = base + AGT_ENTITY_LABEL_OFFSET(nids);
+    agtype_container *properties = (agtype_container *)(
+        base + INTALIGN(AGT_ENTITY_LABEL_OFFSET(nids) + label_len));
+
+    if (type == AGTV_VERTEX)
+    {
+        ag_make_vertex_value(result, ids[0], label, label_len, properties,
+                             props_len);
+    }
+    else
+    {
+        ag_make_edge_value(result, ids[0], ids[1], ids[2], label, label_len,
+                           properties, props_len);
+    }
+}
+
+static void report_malformed_extended_type(const char *detail)
+{
+    ereport(ERROR, (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+                    errmsg("malformed agtype binary data"),
+                    errdetail("%s", detail)));
 }
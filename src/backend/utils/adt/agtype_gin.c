@@ -0,0 +1,621 @@
+/*
+ * Copyright 2020 Bitnine Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * GIN support functions for agtype.
+ *
+ * Portions Copyright (c) 1996-2018, PostgreSQL Global Development Group
+ */
+
+#include "postgres.h"
+
+#include "access/gin.h"
+#include "access/hash.h"
+#include "access/stratnum.h"
+#include "catalog/pg_collation.h"
+#include "fmgr.h"
+#include "utils/builtins.h"
+#include "utils/numeric.h"
+#include "utils/varlena.h"
+
+#include "utils/agtype.h"
+#include "utils/graphid.h"
+
+typedef struct path_hash_stack
+{
+    uint32 hash;
+    struct path_hash_stack *parent;
+} path_hash_stack;
+
+static Datum make_text_key(char flag, const char *str, int len);
+static Datum make_scalar_key(const agtype_value *scalar_val, bool is_key);
+static agtype_value *get_exists_key(agtype *key);
+
+/*
+ * agtype_ops
+ *
+ * Keys and values are indexed as text. See the comment of AGT_GIN_FLAG_KEY in
+ * agtype.h for the format.
+ */
+
+PG_FUNCTION_INFO_V1(gin_compare_agtype);
+
+Datum gin_compare_agtype(PG_FUNCTION_ARGS)
+{
+    text *arg1 = PG_GETARG_TEXT_PP(0);
+    text *arg2 = PG_GETARG_TEXT_PP(1);
+    int32 result;
+
+    // compare text as bttextcmp() does, but always using C collation
+    result = varstr_cmp(VARDATA_ANY(arg1), VARSIZE_ANY_EXHDR(arg1),
+                        VARDATA_ANY(arg2), VARSIZE_ANY_EXHDR(arg2),
+                        C_COLLATION_OID);
+
+    PG_FREE_IF_COPY(arg1, 0);
+    PG_FREE_IF_COPY(arg2, 1);
+
+    PG_RETURN_INT32(result);
+}
+
+PG_FUNCTION_INFO_V1(gin_extract_agtype);
+
+Datum gin_extract_agtype(PG_FUNCTION_ARGS)
+{
+    agtype *agt = AG_GET_ARG_AGTYPE_P(0);
+    int32 *nentries = (int32 *)PG_GETARG_POINTER(1);
+    int total = 2 * AGT_ROOT_COUNT(agt);
+    agtype_iterator *it;
+    agtype_value v;
+    agtype_iterator_token r;
+    int i = 0;
+    Datum *entries;
+
+    // if the root is an empty container, there is nothing to index
+    if (total == 0)
+    {
+        *nentries = 0;
+        PG_RETURN_POINTER(NULL);
+    }
+
+    entries = palloc(sizeof(Datum) * total);
+
+    it = agtype_iterator_init(&agt->root);
+    while ((r = agtype_iterator_next(&it, &v, false)) != WAGT_DONE)
+    {
+        // since we recurse into the containers, we might need more space
+        if (i >= total)
+        {
+            total *= 2;
+            entries = repalloc(entries, sizeof(Datum) * total);
+        }
+
+        switch (r)
+        {
+        case WAGT_KEY:
+            entries[i++] = make_scalar_key(&v, true);
+            break;
+        case WAGT_ELEM:
+            // string elements are indexed as keys, see agtype.h
+            entries[i++] = make_scalar_key(&v, (v.type == AGTV_STRING));
+            break;
+        case WAGT_VALUE:
+            entries[i++] = make_scalar_key(&v, false);
+            break;
+        default:
+            // containers are not indexed by themselves
+            break;
+        }
+    }
+
+    *nentries = i;
+
+    PG_RETURN_POINTER(entries);
+}
+
+PG_FUNCTION_INFO_V1(gin_extract_agtype_query);
+
+Datum gin_extract_agtype_query(PG_FUNCTION_ARGS)
+{
+    int32 *nentries = (int32 *)PG_GETARG_POINTER(1);
+    StrategyNumber strategy = PG_GETARG_UINT16(2);
+    int32 *search_mode = (int32 *)PG_GETARG_POINTER(6);
+    Datum *entries;
+
+    if (strategy == AGTYPE_CONTAINS_STRATEGY_NUMBER)
+    {
+        // the query is an agtype, so just extract the entries from it
+        entries = (Datum *)DatumGetPointer(
+            DirectFunctionCall2(gin_extract_agtype, PG_GETARG_DATUM(0),
+                                PointerGetDatum(nentries)));
+
+        // containment of an empty container requires a full index scan
+        if (*nentries == 0)
+            *search_mode = GIN_SEARCH_MODE_ALL;
+    }
+    else if (strategy == AGTYPE_EXISTS_STRATEGY_NUMBER)
+    {
+        agtype_value *key;
+
+        /*
+         * The query is a string, which is treated as a key. Other scalars
+         * never exist, which means no entries in the default search mode.
+         */
+        key = get_exists_key(AG_GET_ARG_AGTYPE_P(0));
+        if (key)
+        {
+            entries = palloc(sizeof(Datum));
+            entries[0] = make_text_key(AGT_GIN_FLAG_KEY, key->val.string.val,
+                                       key->val.string.len);
+            *nentries = 1;
+        }
+        else
+        {
+            entries = NULL;
+            *nentries = 0;
+        }
+    }
+    else if (strategy == AGTYPE_EXISTS_ANY_STRATEGY_NUMBER ||
+             strategy == AGTYPE_EXISTS_ALL_STRATEGY_NUMBER)
+    {
+        agtype *keys = AG_GET_ARG_AGTYPE_P(0);
+        uint32 count;
+        uint32 i;
+        int j;
+
+        // the query is a list, each string in it is treated as a key
+        if (!AGT_ROOT_IS_ARRAY(keys) || AGT_ROOT_IS_SCALAR(keys))
+        {
+            ereport(ERROR, (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                            errmsg("keys must resolve to a list")));
+        }
+
+        count = AGT_ROOT_COUNT(keys);
+        entries = palloc(sizeof(Datum) * Max(count, 1));
+        for (i = 0, j = 0; i < count; i++)
+        {
+            agtype_value *key;
+
+            // elements of the list that are not strings are ignored
+            key = get_ith_agtype_value_from_container(&keys->root, i);
+            if (key->type != AGTV_STRING)
+                continue;
+
+            entries[j++] = make_text_key(AGT_GIN_FLAG_KEY, key->val.string.val,
+                                         key->val.string.len);
+        }
+
+        *nentries = j;
+
+        // existence of all of no keys matches everything
+        if (j == 0 && strategy == AGTYPE_EXISTS_ALL_STRATEGY_NUMBER)
+            *search_mode = GIN_SEARCH_MODE_ALL;
+    }
+    else
+    {
+        elog(ERROR, "unrecognized strategy number: %d", strategy);
+        entries = NULL; // keep compiler quiet
+    }
+
+    PG_RETURN_POINTER(entries);
+}
+
+PG_FUNCTION_INFO_V1(gin_consistent_agtype);
+
+Datum gin_consistent_agtype(PG_FUNCTION_ARGS)
+{
+    bool *check = (bool *)PG_GETARG_POINTER(0);
+    StrategyNumber strategy = PG_GETARG_UINT16(1);
+    int32 nkeys = PG_GETARG_INT32(3);
+    bool *recheck = (bool *)PG_GETARG_POINTER(5);
+    bool res = true;
+    int32 i;
+
+    /*
+     * The index does not know the structure of the values, and long values
+     * are hashed. So, the heap tuple must always be rechecked.
+     */
+    *recheck = true;
+
+    if (strategy == AGTYPE_CONTAINS_STRATEGY_NUMBER ||
+        strategy == AGTYPE_EXISTS_ALL_STRATEGY_NUMBER)
+    {
+        // all the keys must be present
+        for (i = 0; i < nkeys; i++)
+        {
+            if (!check[i])
+            {
+                res = false;
+                break;
+            }
+        }
+    }
+    else if (strategy == AGTYPE_EXISTS_STRATEGY_NUMBER ||
+             strategy == AGTYPE_EXISTS_ANY_STRATEGY_NUMBER)
+    {
+        // the index returns only the items that have at least one key
+        res = true;
+    }
+    else
+    {
+        elog(ERROR, "unrecognized strategy number: %d", strategy);
+    }
+
+    PG_RETURN_BOOL(res);
+}
+
+PG_FUNCTION_INFO_V1(gin_triconsistent_agtype);
+
+Datum gin_triconsistent_agtype(PG_FUNCTION_ARGS)
+{
+    GinTernaryValue *check = (GinTernaryValue *)PG_GETARG_POINTER(0);
+    StrategyNumber strategy = PG_GETARG_UINT16(1);
+    int32 nkeys = PG_GETARG_INT32(3);
+    GinTernaryValue res = GIN_MAYBE;
+    int32 i;
+
+    /*
+     * Note that we never return GIN_TRUE, only GIN_MAYBE or GIN_FALSE; this
+     * corresponds to always forcing recheck in the regular consistent
+     * function.
+     */
+    if (strategy == AGTYPE_CONTAINS_STRATEGY_NUMBER ||
+        strategy == AGTYPE_EXISTS_ALL_STRATEGY_NUMBER)
+    {
+        for (i = 0; i < nkeys; i++)
+        {
+            if (check[i] == GIN_FALSE)
+            {
+                res = GIN_FALSE;
+                break;
+            }
+        }
+    }
+    else if (strategy == AGTYPE_EXISTS_STRATEGY_NUMBER ||
+             strategy == AGTYPE_EXISTS_ANY_STRATEGY_NUMBER)
+    {
+        res = GIN_FALSE;
+        for (i = 0; i < nkeys; i++)
+        {
+            if (check[i] == GIN_TRUE || check[i] == GIN_MAYBE)
+            {
+                res = GIN_MAYBE;
+                break;
+            }
+        }
+    }
+    else
+    {
+        elog(ERROR, "unrecognized strategy number: %d", strategy);
+    }
+
+    PG_RETURN_GIN_TERNARY_VALUE(res);
+}
+
+/*
+ * agtype_path_ops
+ *
+ * Each value is indexed as a hash of itself and the keys on the path to it.
+ * Keys themselves are not indexed, so only containment is supported. In
+ * exchange, the index is smaller and a containment query needs to look up
+ * fewer entries.
+ */
+
+PG_FUNCTION_INFO_V1(gin_extract_agtype_path);
+
+Datum gin_extract_agtype_path(PG_FUNCTION_ARGS)
+{
+    agtype *agt = AG_GET_ARG_AGTYPE_P(0);
+    int32 *nentries = (int32 *)PG_GETARG_POINTER(1);
+    int total = 2 * AGT_ROOT_COUNT(agt);
+    agtype_iterator *it;
+    agtype_value v;
+    agtype_iterator_token r;
+    path_hash_stack tail;
+    path_hash_stack *stack;
+    int i = 0;
+    Datum *entries;
+
+    // if the root is an empty container, there is nothing to index
+    if (total == 0)
+    {
+        *nentries = 0;
+        PG_RETURN_POINTER(NULL);
+    }
+
+    entries = palloc(sizeof(Datum) * total);
+
+    // keep a stack of partial hashes corresponding to parent key levels
+    tail.parent = NULL;
+    tail.hash = 0;
+    stack = &tail;
+
+    it = agtype_iterator_init(&agt->root);
+    while ((r = agtype_iterator_next(&it, &v, false)) != WAGT_DONE)
+    {
+        path_hash_stack *parent;
+
+        // since we recurse into the containers, we might need more space
+        if (i >= total)
+        {
+            total *= 2;
+            entries = repalloc(entries, sizeof(Datum) * total);
+        }
+
+        switch (r)
+        {
+        case WAGT_BEGIN_ARRAY:
+        case WAGT_BEGIN_OBJECT:
+            /*
+             * Push a stack level for this container. The hashes of outer
+             * levels are passed forward so that the hashes for nested values
+             * include outer keys as well as their own keys.
+             */
+            parent = stack;
+            stack = palloc(sizeof(*stack));
+            stack->hash = parent->hash;
+            stack->parent = parent;
+            break;
+        case WAGT_KEY:
+            // mix this key into the current outer hash
+            agtype_hash_scalar_value(&v, &stack->hash);
+            break;
+        case WAGT_ELEM:
+        case WAGT_VALUE:
+            // mix the element or value's hash into the prepared hash
+            agtype_hash_scalar_value(&v, &stack->hash);
+            // and emit an index entry
+            entries[i++] = UInt32GetDatum(stack->hash);
+            // reset hash for next key, value, or sub-container
+            stack->hash = stack->parent->hash;
+            break;
+        case WAGT_END_ARRAY:
+        case WAGT_END_OBJECT:
+            // pop the stack
+            parent = stack->parent;
+            pfree(stack);
+            stack = parent;
+            // reset hash for next key, value, or sub-container
+            if (stack->parent)
+                stack->hash = stack->parent->hash;
+            else
+                stack->hash = 0;
+            break;
+        default:
+            elog(ERROR, "invalid agtype_iterator_next() rc: %d", (int)r);
+        }
+    }
+
+    *nentries = i;
+
+    PG_RETURN_POINTER(entries);
+}
+
+PG_FUNCTION_INFO_V1(gin_extract_agtype_query_path);
+
+Datum gin_extract_agtype_query_path(PG_FUNCTION_ARGS)
+{
+    int32 *nentries = (int32 *)PG_GETARG_POINTER(1);
+    StrategyNumber strategy = PG_GETARG_UINT16(2);
+    int32 *search_mode = (int32 *)PG_GETARG_POINTER(6);
+    Datum *entries;
+
+    if (strategy != AGTYPE_CONTAINS_STRATEGY_NUMBER)
+        elog(ERROR, "unrecognized strategy number: %d", strategy);
+
+    // the query is an agtype, so just extract the entries from it
+    entries = (Datum *)DatumGetPointer(
+        DirectFunctionCall2(gin_extract_agtype_path, PG_GETARG_DATUM(0),
+                            PointerGetDatum(nentries)));
+
+    // containment of an empty container requires a full index scan
+    if (*nentries == 0)
+        *search_mode = GIN_SEARCH_MODE_ALL;
+
+    PG_RETURN_POINTER(entries);
+}
+
+PG_FUNCTION_INFO_V1(gin_consistent_agtype_path);
+
+Datum gin_consistent_agtype_path(PG_FUNCTION_ARGS)
+{
+    bool *check = (bool *)PG_GETARG_POINTER(0);
+    StrategyNumber strategy = PG_GETARG_UINT16(1);
+    int32 nkeys = PG_GETARG_INT32(3);
+    bool *recheck = (bool *)PG_GETARG_POINTER(5);
+    bool res = true;
+    int32 i;
+
+    if (strategy != AGTYPE_CONTAINS_STRATEGY_NUMBER)
+        elog(ERROR, "unrecognized strategy number: %d", strategy);
+
+    /*
+     * agtype_contains() must always be rechecked because of hash collisions
+     * and because the hashes do not tell the positions in arrays.
+     */
+    *recheck = true;
+
+    for (i = 0; i < nkeys; i++)
+    {
+        if (!check[i])
+        {
+            res = false;
+            break;
+        }
+    }
+
+    PG_RETURN_BOOL(res);
+}
+
+PG_FUNCTION_INFO_V1(gin_triconsistent_agtype_path);
+
+Datum gin_triconsistent_agtype_path(PG_FUNCTION_ARGS)
+{
+    GinTernaryValue *check = (GinTernaryValue *)PG_GETARG_POINTER(0);
+    StrategyNumber strategy = PG_GETARG_UINT16(1);
+    int32 nkeys = PG_GETARG_INT32(3);
+    GinTernaryValue res = GIN_MAYBE;
+    int32 i;
+
+    if (strategy != AGTYPE_CONTAINS_STRATEGY_NUMBER)
+        elog(ERROR, "unrecognized strategy number: %d", strategy);
+
+    // never return GIN_TRUE, see gin_triconsistent_agtype()
+    for (i = 0; i < nkeys; i++)
+    {
+        if (check[i] == GIN_FALSE)
+        {
+            res = GIN_FALSE;
+            break;
+        }
+    }
+
+    PG_RETURN_GIN_TERNARY_VALUE(res);
+}
+
+/*
+ * Construct an agtype_ops GIN key from a flag byte and a textual
+ * representation (which need not be null-terminated). This function is
+ * responsible for hashing overlength text representations; it will add the
+ * AGT_GIN_FLAG_HASHED bit to the flag value if it does that.
+ */
+static Datum make_text_key(char flag, const char *str, int len)
+{
+    text *item;
+    char hashbuf[10];
+
+    if (len > AGT_GIN_MAX_LENGTH)
+    {
+        uint32 hashval;
+
+        hashval = DatumGetUInt32(hash_any((const unsigned char *)str, len));
+        snprintf(hashbuf, sizeof(hashbuf), "%08x", hashval);
+        str = hashbuf;
+        len = 8;
+        flag |= AGT_GIN_FLAG_HASHED;
+    }
+
+    /*
+     * Build a 4-byte-header varlena text Datum here. It will get converted to
+     * short header format when stored in the index.
+     */
+    item = palloc(VARHDRSZ + len + 1);
+    SET_VARSIZE(item, VARHDRSZ + len + 1);
+
+    *VARDATA(item) = flag;
+    memcpy(VARDATA(item) + 1, str, len);
+
+    return PointerGetDatum(item);
+}
+
+/*
+ * Create a textual representation of an agtype_value that will serve as a GIN
+ * key in an agtype_ops index. is_key is true if the agtype_value is a key, or
+ * if it is a string array element (since we pretend those are keys, see
+ * agtype.h).
+ */
+static Datum make_scalar_key(const agtype_value *scalar_val, bool is_key)
+{
+    Datum item;
+    char *cstr;
+    uint32 hash;
+    char hashbuf[10];
+
+    switch (scalar_val->type)
+    {
+    case AGTV_NULL:
+        Assert(!is_key);
+        item = make_text_key(AGT_GIN_FLAG_NULL, "", 0);
+        break;
+    case AGTV_BOOL:
+        Assert(!is_key);
+        item = make_text_key(AGT_GIN_FLAG_BOOL,
+                             scalar_val->val.boolean ? "t" : "f", 1);
+        break;
+    case AGTV_INTEGER:
+        Assert(!is_key);
+        cstr = DatumGetCString(DirectFunctionCall1(
+            int8out, Int64GetDatum(scalar_val->val.int_value)));
+        item = make_text_key(AGT_GIN_FLAG_NUM, cstr, strlen(cstr));
+        pfree(cstr);
+        break;
+    case AGTV_FLOAT:
+        /*
+         * The output of float8out() depends on extra_float_digits. So, the
+         * hash of the value is used instead. Equal values have equal hashes.
+         */
+        Assert(!is_key);
+        hash = 0;
+        agtype_hash_scalar_value(scalar_val, &hash);
+        snprintf(hashbuf, sizeof(hashbuf), "%08x", hash);
+        item = make_text_key(AGT_GIN_FLAG_NUM | AGT_GIN_FLAG_HASHED, hashbuf,
+                             8);
+        break;
+    case AGTV_NUMERIC:
+        Assert(!is_key);
+        /*
+         * A normalized textual representation, free of trailing zeroes, is
+         * required so that numerically equal values will produce equal
+         * strings.
+         */
+        cstr = numeric_normalize(scalar_val->val.numeric);
+        item = make_text_key(AGT_GIN_FLAG_NUM, cstr, strlen(cstr));
+        pfree(cstr);
+        break;
+    case AGTV_STRING:
+        item = make_text_key(is_key ? AGT_GIN_FLAG_KEY : AGT_GIN_FLAG_STR,
+                             scalar_val->val.string.val,
+                             scalar_val->val.string.len);
+        break;
+    case AGTV_VERTEX:
+    case AGTV_EDGE:
+        // vertices and edges are identified by their ids
+        Assert(!is_key);
+        cstr = DatumGetCString(DirectFunctionCall1(
+            int8out,
+            GRAPHID_GET_DATUM(
+                scalar_val->val.object.pairs[0].value.val.int_value)));
+        item = make_text_key(AGT_GIN_FLAG_NUM, cstr, strlen(cstr));
+        pfree(cstr);
+        break;
+    default:
+        elog(ERROR, "unrecognized agtype type: %d", scalar_val->type);
+        item = 0; // keep compiler quiet
+        break;
+    }
+
+    return item;
+}
+
+/*
+ * Return the string that the existence operator looks for, or NULL if key is
+ * not a string.
+ */
+static agtype_value *get_exists_key(agtype *key)
+{
+    agtype_value *key_value;
+
+    if (!AGT_ROOT_IS_SCALAR(key))
+    {
+        ereport(ERROR, (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                        errmsg("key must resolve to a scalar value")));
+    }
+
+    key_value = get_ith_agtype_value_from_container(&key->root, 0);
+    if (key_value->type != AGTV_STRING)
+        return NULL;
+
+    return key_value;
+}
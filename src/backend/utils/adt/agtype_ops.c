@@ -22,11 +22,14 @@
 
 #include <math.h>
 
+#include "access/hash.h"
 #include "fmgr.h"
 #include "utils/builtins.h"
 #include "utils/numeric.h"
+#include "utils/sortsupport.h"
 
 #include "utils/agtype.h"
+#include "utils/agtype_ext.h"
 
 static void ereport_op_str(const char *op, agtype *lhs, agtype *rhs);
 static agtype *agtype_concat(agtype *agt1, agtype *agt2);
@@ -36,6 +39,11 @@ static agtype_value *iterator_concat(agtype_iterator **it1,
 static void concat_to_agtype_string(agtype_value *result, char *lhs, int llen,
                                     char *rhs, int rlen);
 static char *get_string_from_agtype_value(agtype_value *agtv, int *length);
+static bool agtype_exists_keys(agtype *agt, agtype *keys, bool any);
+static int agtype_btree_fast_cmp(Datum x, Datum y, SortSupport ssup);
+static void normalize_hash_scalar_value(agtype_value *agtv);
+static bool get_fixed_operands(FunctionCallInfo fcinfo, agtype_value *lhs,
+                               agtype_value *rhs);
 
 static void concat_to_agtype_string(agtype_value *result, char *lhs, int llen,
                                     char *rhs, int rlen)
@@ -135,37 +143,64 @@ bool is_numeric_result(agtype_value *lhs, agtype_value *rhs)
     return false;
 }
 
+/*
+ * Reads the operands of a binary operator in place if both are integers or
+ * floats, so the common arithmetic on numbers neither copies nor
+ * deserializes them. Returns false if either is of any other type.
+ */
+static bool get_fixed_operands(FunctionCallInfo fcinfo, agtype_value *lhs,
+                               agtype_value *rhs)
+{
+    return ag_get_fixed_scalar(PG_DETOAST_DATUM_PACKED(PG_GETARG_DATUM(0)),
+                               lhs) &&
+           ag_get_fixed_scalar(PG_DETOAST_DATUM_PACKED(PG_GETARG_DATUM(1)),
+                               rhs);
+}
+
 PG_FUNCTION_INFO_V1(agtype_add);
 
 /* agtype addition and concat function for + operator */
 Datum agtype_add(PG_FUNCTION_ARGS)
 {
-    agtype *lhs = AG_GET_ARG_AGTYPE_P(0);
-    agtype *rhs = AG_GET_ARG_AGTYPE_P(1);
+    agtype *lhs;
+    agtype *rhs;
+    agtype_value fixed_lhs;
+    agtype_value fixed_rhs;
     agtype_value *agtv_lhs;
     agtype_value *agtv_rhs;
     agtype_value agtv_result;
 
-    /* If both are not scalars */
-    if (!(AGT_ROOT_IS_SCALAR(lhs) && AGT_ROOT_IS_SCALAR(rhs)))
+    if (get_fixed_operands(fcinfo, &fixed_lhs, &fixed_rhs))
+    {
+        agtv_lhs = &fixed_lhs;
+        agtv_rhs = &fixed_rhs;
+    }
+    else
     {
-        Datum agt;
+        lhs = AG_GET_ARG_AGTYPE_P(0);
+        rhs = AG_GET_ARG_AGTYPE_P(1);
+
+        /* If both are not scalars */
+        if (!(AGT_ROOT_IS_SCALAR(lhs) && AGT_ROOT_IS_SCALAR(rhs)))
+        {
+            Datum agt;
 
-        /* It can't be a scalar and an object */
-        if ((AGT_ROOT_IS_SCALAR(lhs) && AGT_ROOT_IS_OBJECT(rhs)) ||
-            (AGT_ROOT_IS_OBJECT(lhs) && AGT_ROOT_IS_SCALAR(rhs)) ||
-            /* It can't be two objects */
-            (AGT_ROOT_IS_OBJECT(lhs) && AGT_ROOT_IS_OBJECT(rhs)))
-            ereport_op_str("+", lhs, rhs);
+            /* It can't be a scalar and an object */
+            if ((AGT_ROOT_IS_SCALAR(lhs) && AGT_ROOT_IS_OBJECT(rhs)) ||
+                (AGT_ROOT_IS_OBJECT(lhs) && AGT_ROOT_IS_SCALAR(rhs)) ||
+                /* It can't be two objects */
+                (AGT_ROOT_IS_OBJECT(lhs) && AGT_ROOT_IS_OBJECT(rhs)))
+                ereport_op_str("+", lhs, rhs);
 
-        agt = AGTYPE_P_GET_DATUM(agtype_concat(lhs, rhs));
+            agt = AGTYPE_P_GET_DATUM(agtype_concat(lhs, rhs));
 
-        PG_RETURN_DATUM(agt);
-    }
+            PG_RETURN_DATUM(agt);
+        }
 
-    /* Both are scalar */
-    agtv_lhs = get_ith_agtype_value_from_container(&lhs->root, 0);
-    agtv_rhs = get_ith_agtype_value_from_container(&rhs->root, 0);
+        /* Both are scalar */
+        agtv_lhs = get_ith_agtype_value_from_container(&lhs->root, 0);
+        agtv_rhs = get_ith_agtype_value_from_container(&rhs->root, 0);
+    }
 
     /*
      * One or both values is a string OR one is a string and the other is
@@ -239,22 +274,36 @@ PG_FUNCTION_INFO_V1(agtype_sub);
  */
 Datum agtype_sub(PG_FUNCTION_ARGS)
 {
-    agtype *lhs = AG_GET_ARG_AGTYPE_P(0);
-    agtype *rhs = AG_GET_ARG_AGTYPE_P(1);
+    agtype *lhs;
+    agtype *rhs;
+    agtype_value fixed_lhs;
+    agtype_value fixed_rhs;
     agtype_value *agtv_lhs;
     agtype_value *agtv_rhs;
     agtype_value agtv_result;
 
-    if (!(AGT_ROOT_IS_SCALAR(lhs)) || !(AGT_ROOT_IS_SCALAR(rhs)))
+    if (get_fixed_operands(fcinfo, &fixed_lhs, &fixed_rhs))
     {
-        ereport(ERROR, (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
-                        errmsg("must be scalar value, not array or object")));
-
-        PG_RETURN_NULL();
+        agtv_lhs = &fixed_lhs;
+        agtv_rhs = &fixed_rhs;
     }
+    else
+    {
+        lhs = AG_GET_ARG_AGTYPE_P(0);
+        rhs = AG_GET_ARG_AGTYPE_P(1);
+
+        if (!(AGT_ROOT_IS_SCALAR(lhs)) || !(AGT_ROOT_IS_SCALAR(rhs)))
+        {
+            ereport(ERROR,
+                    (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                     errmsg("must be scalar value, not array or object")));
+
+            PG_RETURN_NULL();
+        }
 
-    agtv_lhs = get_ith_agtype_value_from_container(&lhs->root, 0);
-    agtv_rhs = get_ith_agtype_value_from_container(&rhs->root, 0);
+        agtv_lhs = get_ith_agtype_value_from_container(&lhs->root, 0);
+        agtv_rhs = get_ith_agtype_value_from_container(&rhs->root, 0);
+    }
 
     if (agtv_lhs->type == AGTV_INTEGER && agtv_rhs->type == AGTV_INTEGER)
     {
@@ -306,19 +355,31 @@ PG_FUNCTION_INFO_V1(agtype_neg);
  */
 Datum agtype_neg(PG_FUNCTION_ARGS)
 {
-    agtype *v = AG_GET_ARG_AGTYPE_P(0);
+    agtype *v;
+    agtype_value fixed_value;
     agtype_value *agtv_value;
     agtype_value agtv_result;
 
-    if (!(AGT_ROOT_IS_SCALAR(v)))
+    if (ag_get_fixed_scalar(PG_DETOAST_DATUM_PACKED(PG_GETARG_DATUM(0)),
+                            &fixed_value))
     {
-        ereport(ERROR, (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
-                        errmsg("must be scalar value, not array or object")));
-
-        PG_RETURN_NULL();
+        agtv_value = &fixed_value;
     }
+    else
+    {
+        v = AG_GET_ARG_AGTYPE_P(0);
+
+        if (!(AGT_ROOT_IS_SCALAR(v)))
+        {
+            ereport(ERROR,
+                    (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                     errmsg("must be scalar value, not array or object")));
+
+            PG_RETURN_NULL();
+        }
 
-    agtv_value = get_ith_agtype_value_from_container(&v->root, 0);
+        agtv_value = get_ith_agtype_value_from_container(&v->root, 0);
+    }
 
     if (agtv_value->type == AGTV_INTEGER)
     {
@@ -354,22 +415,36 @@ PG_FUNCTION_INFO_V1(agtype_mul);
  */
 Datum agtype_mul(PG_FUNCTION_ARGS)
 {
-    agtype *lhs = AG_GET_ARG_AGTYPE_P(0);
-    agtype *rhs = AG_GET_ARG_AGTYPE_P(1);
+    agtype *lhs;
+    agtype *rhs;
+    agtype_value fixed_lhs;
+    agtype_value fixed_rhs;
     agtype_value *agtv_lhs;
     agtype_value *agtv_rhs;
     agtype_value agtv_result;
 
-    if (!(AGT_ROOT_IS_SCALAR(lhs)) || !(AGT_ROOT_IS_SCALAR(rhs)))
+    if (get_fixed_operands(fcinfo, &fixed_lhs, &fixed_rhs))
     {
-        ereport(ERROR, (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
-                        errmsg("must be scalar value, not array or object")));
-
-        PG_RETURN_NULL();
+        agtv_lhs = &fixed_lhs;
+        agtv_rhs = &fixed_rhs;
     }
+    else
+    {
+        lhs = AG_GET_ARG_AGTYPE_P(0);
+        rhs = AG_GET_ARG_AGTYPE_P(1);
+
+        if (!(AGT_ROOT_IS_SCALAR(lhs)) || !(AGT_ROOT_IS_SCALAR(rhs)))
+        {
+            ereport(ERROR,
+                    (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                     errmsg("must be scalar value, not array or object")));
+
+            PG_RETURN_NULL();
+        }
 
-    agtv_lhs = get_ith_agtype_value_from_container(&lhs->root, 0);
-    agtv_rhs = get_ith_agtype_value_from_container(&rhs->root, 0);
+        agtv_lhs = get_ith_agtype_value_from_container(&lhs->root, 0);
+        agtv_rhs = get_ith_agtype_value_from_container(&rhs->root, 0);
+    }
 
     if (agtv_lhs->type == AGTV_INTEGER && agtv_rhs->type == AGTV_INTEGER)
     {
@@ -421,22 +496,36 @@ PG_FUNCTION_INFO_V1(agtype_div);
  */
 Datum agtype_div(PG_FUNCTION_ARGS)
 {
-    agtype *lhs = AG_GET_ARG_AGTYPE_P(0);
-    agtype *rhs = AG_GET_ARG_AGTYPE_P(1);
+    agtype *lhs;
+    agtype *rhs;
+    agtype_value fixed_lhs;
+    agtype_value fixed_rhs;
     agtype_value *agtv_lhs;
     agtype_value *agtv_rhs;
     agtype_value agtv_result;
 
-    if (!(AGT_ROOT_IS_SCALAR(lhs)) || !(AGT_ROOT_IS_SCALAR(rhs)))
+    if (get_fixed_operands(fcinfo, &fixed_lhs, &fixed_rhs))
     {
-        ereport(ERROR, (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
-                        errmsg("must be scalar value, not array or object")));
-
-        PG_RETURN_NULL();
+        agtv_lhs = &fixed_lhs;
+        agtv_rhs = &fixed_rhs;
     }
+    else
+    {
+        lhs = AG_GET_ARG_AGTYPE_P(0);
+        rhs = AG_GET_ARG_AGTYPE_P(1);
+
+        if (!(AGT_ROOT_IS_SCALAR(lhs)) || !(AGT_ROOT_IS_SCALAR(rhs)))
+        {
+            ereport(ERROR,
+                    (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                     errmsg("must be scalar value, not array or object")));
+
+            PG_RETURN_NULL();
+        }
 
-    agtv_lhs = get_ith_agtype_value_from_container(&lhs->root, 0);
-    agtv_rhs = get_ith_agtype_value_from_container(&rhs->root, 0);
+        agtv_lhs = get_ith_agtype_value_from_container(&lhs->root, 0);
+        agtv_rhs = get_ith_agtype_value_from_container(&rhs->root, 0);
+    }
 
     if (agtv_lhs->type == AGTV_INTEGER && agtv_rhs->type == AGTV_INTEGER)
     {
@@ -506,7 +595,7 @@ Datum agtype_div(PG_FUNCTION_ARGS)
         ereport(ERROR, (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
                         errmsg("Invalid input parameter types for agtype_div")));
 
-     AG_RETURN_AGTYPE_P(agtype_value_to_agtype(&agtv_result));
+    AG_RETURN_AGTYPE_P(agtype_value_to_agtype(&agtv_result));
 }
 
 PG_FUNCTION_INFO_V1(agtype_mod);
@@ -516,22 +605,36 @@ PG_FUNCTION_INFO_V1(agtype_mod);
  */
 Datum agtype_mod(PG_FUNCTION_ARGS)
 {
-    agtype *lhs = AG_GET_ARG_AGTYPE_P(0);
-    agtype *rhs = AG_GET_ARG_AGTYPE_P(1);
+    agtype *lhs;
+    agtype *rhs;
+    agtype_value fixed_lhs;
+    agtype_value fixed_rhs;
     agtype_value *agtv_lhs;
     agtype_value *agtv_rhs;
     agtype_value agtv_result;
 
-    if (!(AGT_ROOT_IS_SCALAR(lhs)) || !(AGT_ROOT_IS_SCALAR(rhs)))
+    if (get_fixed_operands(fcinfo, &fixed_lhs, &fixed_rhs))
     {
-        ereport(ERROR, (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
-                        errmsg("must be scalar value, not array or object")));
-
-        PG_RETURN_NULL();
+        agtv_lhs = &fixed_lhs;
+        agtv_rhs = &fixed_rhs;
     }
+    else
+    {
+        lhs = AG_GET_ARG_AGTYPE_P(0);
+        rhs = AG_GET_ARG_AGTYPE_P(1);
+
+        if (!(AGT_ROOT_IS_SCALAR(lhs)) || !(AGT_ROOT_IS_SCALAR(rhs)))
+        {
+            ereport(ERROR,
+                    (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                     errmsg("must be scalar value, not array or object")));
 
-    agtv_lhs = get_ith_agtype_value_from_container(&lhs->root, 0);
-    agtv_rhs = get_ith_agtype_value_from_container(&rhs->root, 0);
+            PG_RETURN_NULL();
+        }
+
+        agtv_lhs = get_ith_agtype_value_from_container(&lhs->root, 0);
+        agtv_rhs = get_ith_agtype_value_from_container(&rhs->root, 0);
+    }
 
     if (agtv_lhs->type == AGTV_INTEGER && agtv_rhs->type == AGTV_INTEGER)
     {
@@ -583,22 +686,36 @@ PG_FUNCTION_INFO_V1(agtype_pow);
  */
 Datum agtype_pow(PG_FUNCTION_ARGS)
 {
-    agtype *lhs = AG_GET_ARG_AGTYPE_P(0);
-    agtype *rhs = AG_GET_ARG_AGTYPE_P(1);
+    agtype *lhs;
+    agtype *rhs;
+    agtype_value fixed_lhs;
+    agtype_value fixed_rhs;
     agtype_value *agtv_lhs;
     agtype_value *agtv_rhs;
     agtype_value agtv_result;
 
-    if (!(AGT_ROOT_IS_SCALAR(lhs)) || !(AGT_ROOT_IS_SCALAR(rhs)))
+    if (get_fixed_operands(fcinfo, &fixed_lhs, &fixed_rhs))
     {
-        ereport(ERROR, (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
-                        errmsg("must be scalar value, not array or object")));
-
-        PG_RETURN_NULL();
+        agtv_lhs = &fixed_lhs;
+        agtv_rhs = &fixed_rhs;
     }
+    else
+    {
+        lhs = AG_GET_ARG_AGTYPE_P(0);
+        rhs = AG_GET_ARG_AGTYPE_P(1);
+
+        if (!(AGT_ROOT_IS_SCALAR(lhs)) || !(AGT_ROOT_IS_SCALAR(rhs)))
+        {
+            ereport(ERROR,
+                    (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                     errmsg("must be scalar value, not array or object")));
+
+            PG_RETURN_NULL();
+        }
 
-    agtv_lhs = get_ith_agtype_value_from_container(&lhs->root, 0);
-    agtv_rhs = get_ith_agtype_value_from_container(&rhs->root, 0);
+        agtv_lhs = get_ith_agtype_value_from_container(&lhs->root, 0);
+        agtv_rhs = get_ith_agtype_value_from_container(&rhs->root, 0);
+    }
 
     if (agtv_lhs->type == AGTV_INTEGER && agtv_rhs->type == AGTV_INTEGER)
     {
@@ -745,6 +862,287 @@ Datum agtype_ge(PG_FUNCTION_ARGS)
     PG_RETURN_BOOL(result);
 }
 
+PG_FUNCTION_INFO_V1(agtype_btree_cmp);
+
+Datum agtype_btree_cmp(PG_FUNCTION_ARGS)
+{
+    agtype *agtype_lhs = AG_GET_ARG_AGTYPE_P(0);
+    agtype *agtype_rhs = AG_GET_ARG_AGTYPE_P(1);
+    int result;
+
+    result = compare_agtype_containers_orderability(&agtype_lhs->root,
+                                                    &agtype_rhs->root);
+
+    PG_FREE_IF_COPY(agtype_lhs, 0);
+    PG_FREE_IF_COPY(agtype_rhs, 1);
+
+    PG_RETURN_INT32(result);
+}
+
+PG_FUNCTION_INFO_V1(agtype_btree_sort);
+
+Datum agtype_btree_sort(PG_FUNCTION_ARGS)
+{
+    SortSupport ssup = (SortSupport)PG_GETARG_POINTER(0);
+
+    ssup->comparator = agtype_btree_fast_cmp;
+    PG_RETURN_VOID();
+}
+
+/*
+ * Comparator used by sorts. It skips the fmgr call overhead of
+ * agtype_btree_cmp() and only detoasts values that are actually toasted.
+ */
+static int agtype_btree_fast_cmp(Datum x, Datum y, SortSupport ssup)
+{
+    agtype *agtype_lhs = DATUM_GET_AGTYPE_P(x);
+    agtype *agtype_rhs = DATUM_GET_AGTYPE_P(y);
+    int result;
+
+    result = compare_agtype_containers_orderability(&agtype_lhs->root,
+                                                    &agtype_rhs->root);
+
+    if ((Pointer)agtype_lhs != DatumGetPointer(x))
+        pfree(agtype_lhs);
+    if ((Pointer)agtype_rhs != DatumGetPointer(y))
+        pfree(agtype_rhs);
+
+    return result;
+}
+
+/*
+ * Integers, floats and numerics that compare equal must hash to the same
+ * value. Hash all of them as float8.
+ */
+static void normalize_hash_scalar_value(agtype_value *agtv)
+{
+    switch (agtv->type)
+    {
+    case AGTV_INTEGER:
+        agtv->val.float_value = (float8)agtv->val.int_value;
+        agtv->type = AGTV_FLOAT;
+        break;
+    case AGTV_NUMERIC:
+        agtv->val.float_value = DatumGetFloat8(DirectFunctionCall1(
+            numeric_float8_no_overflow,
+            NumericGetDatum(agtv->val.numeric)));
+        agtv->type = AGTV_FLOAT;
+        break;
+    default:
+        break;
+    }
+}
+
+PG_FUNCTION_INFO_V1(agtype_hash);
+
+/*
+ * Hash function for the hash operator class. It is consistent with the
+ * equality of compare_agtype_containers_orderability().
+ */
+Datum agtype_hash(PG_FUNCTION_ARGS)
+{
+    agtype *agt = AG_GET_ARG_AGTYPE_P(0);
+    agtype_iterator *it;
+    agtype_value v;
+    agtype_iterator_token tok;
+    uint32 hash = 0;
+
+    it = agtype_iterator_init(&agt->root);
+
+    while ((tok = agtype_iterator_next(&it, &v, false)) != WAGT_DONE)
+    {
+        switch (tok)
+        {
+        case WAGT_BEGIN_ARRAY:
+            /* distinguish raw scalars from one element arrays */
+            hash ^= v.val.array.raw_scalar ? AGT_FSCALAR : AGT_FARRAY;
+            break;
+        case WAGT_BEGIN_OBJECT:
+            hash ^= AGT_FOBJECT;
+            break;
+        case WAGT_KEY:
+        case WAGT_VALUE:
+        case WAGT_ELEM:
+            normalize_hash_scalar_value(&v);
+            agtype_hash_scalar_value(&v, &hash);
+            break;
+        case WAGT_END_ARRAY:
+        case WAGT_END_OBJECT:
+            break;
+        default:
+            elog(ERROR, "invalid agtype_iterator_token %d", tok);
+        }
+    }
+
+    PG_FREE_IF_COPY(agt, 0);
+
+    PG_RETURN_INT32(hash);
+}
+
+PG_FUNCTION_INFO_V1(agtype_hash_extended);
+
+Datum agtype_hash_extended(PG_FUNCTION_ARGS)
+{
+    agtype *agt = AG_GET_ARG_AGTYPE_P(0);
+    uint64 seed = PG_GETARG_INT64(1);
+    agtype_iterator *it;
+    agtype_value v;
+    agtype_iterator_token tok;
+    uint64 hash = 0;
+
+    it = agtype_iterator_init(&agt->root);
+
+    while ((tok = agtype_iterator_next(&it, &v, false)) != WAGT_DONE)
+    {
+        switch (tok)
+        {
+        case WAGT_BEGIN_ARRAY:
+            hash ^= v.val.array.raw_scalar ? AGT_FSCALAR : AGT_FARRAY;
+            break;
+        case WAGT_BEGIN_OBJECT:
+            hash ^= AGT_FOBJECT;
+            break;
+        case WAGT_KEY:
+        case WAGT_VALUE:
+        case WAGT_ELEM:
+            normalize_hash_scalar_value(&v);
+            agtype_hash_scalar_value_extended(&v, &hash, seed);
+            break;
+        case WAGT_END_ARRAY:
+        case WAGT_END_OBJECT:
+            break;
+        default:
+            elog(ERROR, "invalid agtype_iterator_token %d", tok);
+        }
+    }
+
+    PG_FREE_IF_COPY(agt, 0);
+
+    PG_RETURN_UINT64(hash);
+}
+
+PG_FUNCTION_INFO_V1(agtype_contains);
+
+Datum agtype_contains(PG_FUNCTION_ARGS)
+{
+    agtype *agtype_lhs = AG_GET_ARG_AGTYPE_P(0);
+    agtype *agtype_rhs = AG_GET_ARG_AGTYPE_P(1);
+    agtype_iterator *lhs_it;
+    agtype_iterator *rhs_it;
+
+    if (AGT_ROOT_IS_OBJECT(agtype_lhs) != AGT_ROOT_IS_OBJECT(agtype_rhs))
+        PG_RETURN_BOOL(false);
+
+    lhs_it = agtype_iterator_init(&agtype_lhs->root);
+    rhs_it = agtype_iterator_init(&agtype_rhs->root);
+
+    PG_RETURN_BOOL(agtype_deep_contains(&lhs_it, &rhs_it));
+}
+
+PG_FUNCTION_INFO_V1(agtype_contained_by);
+
+Datum agtype_contained_by(PG_FUNCTION_ARGS)
+{
+    agtype *agtype_lhs = AG_GET_ARG_AGTYPE_P(0);
+    agtype *agtype_rhs = AG_GET_ARG_AGTYPE_P(1);
+    agtype_iterator *lhs_it;
+    agtype_iterator *rhs_it;
+
+    if (AGT_ROOT_IS_OBJECT(agtype_lhs) != AGT_ROOT_IS_OBJECT(agtype_rhs))
+        PG_RETURN_BOOL(false);
+
+    lhs_it = agtype_iterator_init(&agtype_lhs->root);
+    rhs_it = agtype_iterator_init(&agtype_rhs->root);
+
+    PG_RETURN_BOOL(agtype_deep_contains(&rhs_it, &lhs_it));
+}
+
+PG_FUNCTION_INFO_V1(agtype_exists);
+
+/*
+ * Only keys of the top-level object and string elements of the top-level array
+ * are matched. The key must be a string.
+ */
+Datum agtype_exists(PG_FUNCTION_ARGS)
+{
+    agtype *agt = AG_GET_ARG_AGTYPE_P(0);
+    agtype *key = AG_GET_ARG_AGTYPE_P(1);
+    agtype_value *key_value;
+    agtype_value *v;
+
+    if (!AGT_ROOT_IS_SCALAR(key))
+    {
+        ereport(ERROR, (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                        errmsg("key must resolve to a scalar value")));
+    }
+
+    key_value = get_ith_agtype_value_from_container(&key->root, 0);
+    if (key_value->type != AGTV_STRING)
+        PG_RETURN_BOOL(false);
+
+    v = find_agtype_value_from_container(&agt->root, AGT_FOBJECT | AGT_FARRAY,
+                                         key_value);
+
+    PG_RETURN_BOOL(v != NULL);
+}
+
+PG_FUNCTION_INFO_V1(agtype_exists_any);
+
+/*
+ * The keys are given as a list. Elements of the list that are not strings are
+ * ignored.
+ */
+Datum agtype_exists_any(PG_FUNCTION_ARGS)
+{
+    PG_RETURN_BOOL(agtype_exists_keys(AG_GET_ARG_AGTYPE_P(0),
+                                      AG_GET_ARG_AGTYPE_P(1), true));
+}
+
+PG_FUNCTION_INFO_V1(agtype_exists_all);
+
+Datum agtype_exists_all(PG_FUNCTION_ARGS)
+{
+    PG_RETURN_BOOL(agtype_exists_keys(AG_GET_ARG_AGTYPE_P(0),
+                                      AG_GET_ARG_AGTYPE_P(1), false));
+}
+
+/*
+ * Helper function for agtype_exists_any() and agtype_exists_all(). It returns
+ * whether any (or all) of the strings in the list keys exist in agt.
+ */
+static bool agtype_exists_keys(agtype *agt, agtype *keys, bool any)
+{
+    uint32 count;
+    uint32 i;
+
+    if (!AGT_ROOT_IS_ARRAY(keys) || AGT_ROOT_IS_SCALAR(keys))
+    {
+        ereport(ERROR, (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                        errmsg("keys must resolve to a list")));
+    }
+
+    count = AGT_ROOT_COUNT(keys);
+    for (i = 0; i < count; i++)
+    {
+        agtype_value *key_value;
+        agtype_value *v;
+
+        key_value = get_ith_agtype_value_from_container(&keys->root, i);
+        if (key_value->type != AGTV_STRING)
+            continue;
+
+        v = find_agtype_value_from_container(&agt->root,
+                                             AGT_FOBJECT | AGT_FARRAY,
+                                             key_value);
+        if (any && v != NULL)
+            return true;
+        if (!any && v == NULL)
+            return false;
+    }
+
+    return !any;
+}
+
 static agtype *agtype_concat(agtype *agt1, agtype *agt2)
 {
     agtype_parse_state *state = NULL;
@@ -30,6 +30,7 @@
 #include "utils/datetime.h"
 
 #include "utils/agtype_parser.h"
+#include "utils/agtype_scan.h"
 
 /*
  * The context of the parser is maintained by the recursive descent
@@ -502,18 +503,20 @@ static inline void agtype_lex(agtype_lex_context *lex)
 {
     char *s;
     int len;
+    char *end;
 
     /* Skip leading whitespace. */
     s = lex->token_terminator;
     len = s - lex->input;
-    while (len < lex->input_length &&
-           (*s == ' ' || *s == '\t' || *s == '\n' || *s == '\r'))
+    end = s + scan_whitespace(s, lex->input_length - len);
+    len += end - s;
+    /* Count the lines of the whitespace for report_agtype_context(). */
+    while ((s = memchr(s, '\n', end - s)) != NULL)
     {
-        if (*s == '\n')
-            ++lex->line_number;
+        ++lex->line_number;
         ++s;
-        ++len;
     }
+    s = end;
     lex->token_start = s;
 
     /* Determine token type. */
@@ -951,20 +954,36 @@ static inline void agtype_lex_string(agtype_lex_context *lex)
                          report_agtype_context(lex)));
             }
         }
-        else if (lex->strval != NULL)
+        else
         {
-            if (hi_surrogate != -1)
+            int run_len;
+
+            /*
+             * Take the whole run of characters that need no special handling
+             * at once, up to the next quote, backslash or control character.
+             */
+            run_len = 1 + scan_plain_string_chars(s + 1,
+                                                  lex->input_length - len - 1);
+
+            if (lex->strval != NULL)
             {
-                ereport(
-                    ERROR,
-                    (errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),
-                     errmsg("invalid input syntax for type %s", "agtype"),
-                     errdetail(
-                         "Unicode low surrogate must follow a high surrogate."),
-                     report_agtype_context(lex)));
+                if (hi_surrogate != -1)
+                {
+                    ereport(
+                        ERROR,
+                        (errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),
+                         errmsg("invalid input syntax for type %s", "agtype"),
+                         errdetail(
+                             "Unicode low surrogate must follow a high surrogate."),
+                         report_agtype_context(lex)));
+                }
+
+                appendBinaryStringInfo(lex->strval, s, run_len);
             }
 
-            appendStringInfoChar(lex->strval, *s);
+            // the loop moves to the character after the run
+            s += run_len - 1;
+            len += run_len - 1;
         }
     }
 
@@ -1016,6 +1035,7 @@ static inline void agtype_lex_number(agtype_lex_context *lex, char *s,
 {
     bool error = false;
     int len = s - lex->input;
+    int digits;
 
     /* assume we have an integer until proven otherwise */
     lex->token_type = AGTYPE_TOKEN_INTEGER;
@@ -1031,11 +1051,9 @@ static inline void agtype_lex_number(agtype_lex_context *lex, char *s,
     }
     else if (len < lex->input_length && *s >= '1' && *s <= '9')
     {
-        do
-        {
-            s++;
-            len++;
-        } while (len < lex->input_length && *s >= '0' && *s <= '9');
+        digits = scan_digits(s, lex->input_length - len);
+        s += digits;
+        len += digits;
     }
     else
     {
@@ -1056,11 +1074,9 @@ static inline void agtype_lex_number(agtype_lex_context *lex, char *s,
         }
         else
         {
-            do
-            {
-                s++;
-                len++;
-            } while (len < lex->input_length && *s >= '0' && *s <= '9');
+            digits = scan_digits(s, lex->input_length - len);
+            s += digits;
+            len += digits;
         }
     }
 
@@ -1083,11 +1099,9 @@ static inline void agtype_lex_number(agtype_lex_context *lex, char *s,
         }
         else
         {
-            do
-            {
-                s++;
-                len++;
-            } while (len < lex->input_length && *s >= '0' && *s <= '9');
+            digits = scan_digits(s, lex->input_length - len);
+            s += digits;
+            len += digits;
         }
     }
 
@@ -0,0 +1,383 @@
+/*
+ * Copyright 2020 Bitnine Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Block scanners of the agtype lexer
+ *
+ * The characters are tested a block at a time. SSE2 is used where the
+ * compiler targets it (it is a part of x86-64), and AVX2 on top of it if the
+ * CPU has it, which is checked at runtime because the extension is not built
+ * for a specific CPU. Otherwise, the characters of strings are tested 8 at a
+ * time in a 64-bit integer and the others one at a time.
+ */
+
+#include "postgres.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define USE_AVX2_WITH_RUNTIME_CHECK
+#endif
+
+#include "utils/agtype_scan.h"
+
+#define IS_PLAIN_STRING_CHAR(c) ((c) != '"' && (c) != '\\' && (c) >= 0x20)
+#define IS_WHITESPACE_CHAR(c) \
+    ((c) == ' ' || (c) == '\t' || (c) == '\n' || (c) == '\r')
+#define IS_DIGIT_CHAR(c) ((c) >= '0' && (c) <= '9')
+
+static int scan_plain_string_chars_choose(const char *s, int len);
+static int scan_whitespace_choose(const char *s, int len);
+static int scan_digits_choose(const char *s, int len);
+static void choose_scanners(void);
+#ifndef __SSE2__
+static int scan_plain_string_chars_sb8(const char *s, int len);
+static int scan_whitespace_sb1(const char *s, int len);
+static int scan_digits_sb1(const char *s, int len);
+#endif
+static inline int scan_plain_string_chars_tail(const char *s, int len);
+static inline int scan_whitespace_tail(const char *s, int len);
+static inline int scan_digits_tail(const char *s, int len);
+#ifdef __SSE2__
+static int scan_plain_string_chars_sse2(const char *s, int len);
+static int scan_whitespace_sse2(const char *s, int len);
+static int scan_digits_sse2(const char *s, int len);
+#endif
+#ifdef USE_AVX2_WITH_RUNTIME_CHECK
+static int scan_plain_string_chars_avx2(const char *s, int len);
+static int scan_whitespace_avx2(const char *s, int len);
+static int scan_digits_avx2(const char *s, int len);
+#endif
+
+int (*scan_plain_string_chars)(const char *s,
+                               int len) = scan_plain_string_chars_choose;
+int (*scan_whitespace)(const char *s, int len) = scan_whitespace_choose;
+int (*scan_digits)(const char *s, int len) = scan_digits_choose;
+
+static int scan_plain_string_chars_choose(const char *s, int len)
+{
+    choose_scanners();
+
+    return scan_plain_string_chars(s, len);
+}
+
+static int scan_whitespace_choose(const char *s, int len)
+{
+    choose_scanners();
+
+    return scan_whitespace(s, len);
+}
+
+static int scan_digits_choose(const char *s, int len)
+{
+    choose_scanners();
+
+    return scan_digits(s, len);
+}
+
+static void choose_scanners(void)
+{
+#ifdef USE_AVX2_WITH_RUNTIME_CHECK
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        scan_plain_string_chars = scan_plain_string_chars_avx2;
+        scan_whitespace = scan_whitespace_avx2;
+        scan_digits = scan_digits_avx2;
+        return;
+    }
+#endif
+
+#ifdef __SSE2__
+    scan_plain_string_chars = scan_plain_string_chars_sse2;
+    scan_whitespace = scan_whitespace_sse2;
+    scan_digits = scan_digits_sse2;
+#else
+    scan_plain_string_chars = scan_plain_string_chars_sb8;
+    scan_whitespace = scan_whitespace_sb1;
+    scan_digits = scan_digits_sb1;
+#endif
+}
+
+#ifndef __SSE2__
+
+static int scan_plain_string_chars_sb8(const char *s, int len)
+{
+    int i = 0;
+
+#define BYTES(b) (UINT64CONST(0x0101010101010101) * (b))
+    for (; i + (int)sizeof(uint64) <= len; i += sizeof(uint64))
+    {
+        uint64 chunk;
+        uint64 quote;
+        uint64 backslash;
+        uint64 special;
+
+        memcpy(&chunk, s + i, sizeof(chunk));
+
+        // a byte of these is 0 where chunk has a quote or a backslash
+        quote = chunk ^ BYTES('"');
+        backslash = chunk ^ BYTES('\\');
+
+        // the high bit of a byte is set if the byte is 0 or less than 0x20
+        special = ((quote - BYTES(0x01)) & ~quote) |
+                  ((backslash - BYTES(0x01)) & ~backslash) |
+                  ((chunk - BYTES(0x20)) & ~chunk);
+
+        if ((special & BYTES(0x80)) != 0)
+            break;
+    }
+#undef BYTES
+
+    // the rest, including the block that has a special character
+    return i + scan_plain_string_chars_tail(s + i, len - i);
+}
+
+// whitespace and digit runs are short, a word at a time would not pay off
+static int scan_whitespace_sb1(const char *s, int len)
+{
+    return scan_whitespace_tail(s, len);
+}
+
+static int scan_digits_sb1(const char *s, int len)
+{
+    return scan_digits_tail(s, len);
+}
+
+#endif
+
+static inline int scan_plain_string_chars_tail(const char *s, int len)
+{
+    int i;
+
+    for (i = 0; i < len; i++)
+    {
+        unsigned char c = (unsigned char)s[i];
+
+        if (!IS_PLAIN_STRING_CHAR(c))
+            break;
+    }
+
+    return i;
+}
+
+static inline int scan_whitespace_tail(const char *s, int len)
+{
+    int i;
+
+    for (i = 0; i < len; i++)
+    {
+        if (!IS_WHITESPACE_CHAR(s[i]))
+            break;
+    }
+
+    return i;
+}
+
+static inline int scan_digits_tail(const char *s, int len)
+{
+    int i;
+
+    for (i = 0; i < len; i++)
+    {
+        if (!IS_DIGIT_CHAR(s[i]))
+            break;
+    }
+
+    return i;
+}
+
+/*
+ * The SSE2 and AVX2 scanners make a mask of the characters of a block that
+ * end the run, and the first bit set in it is the length of the run.
+ */
+
+#ifdef __SSE2__
+
+static int scan_plain_string_chars_sse2(const char *s, int len)
+{
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i max_control = _mm_set1_epi8(0x1f);
+    int i;
+
+    for (i = 0; i + (int)sizeof(__m128i) <= len; i += sizeof(__m128i))
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(s + i));
+        __m128i special;
+        uint32 mask;
+
+        special = _mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                               _mm_cmpeq_epi8(chunk, backslash));
+        // unsigned chunk <= 0x1f
+        special = _mm_or_si128(
+            special,
+            _mm_cmpeq_epi8(_mm_min_epu8(chunk, max_control), chunk));
+
+        mask = _mm_movemask_epi8(special);
+        if (mask != 0)
+            return i + __builtin_ctz(mask);
+    }
+
+    return i + scan_plain_string_chars_tail(s + i, len - i);
+}
+
+static int scan_whitespace_sse2(const char *s, int len)
+{
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i carriage_return = _mm_set1_epi8('\r');
+    int i;
+
+    for (i = 0; i + (int)sizeof(__m128i) <= len; i += sizeof(__m128i))
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(s + i));
+        __m128i whitespace;
+        uint32 mask;
+
+        whitespace = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, space),
+                         _mm_cmpeq_epi8(chunk, tab)),
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, newline),
+                         _mm_cmpeq_epi8(chunk, carriage_return)));
+
+        mask = ~_mm_movemask_epi8(whitespace) & 0xffff;
+        if (mask != 0)
+            return i + __builtin_ctz(mask);
+    }
+
+    return i + scan_whitespace_tail(s + i, len - i);
+}
+
+static int scan_digits_sse2(const char *s, int len)
+{
+    const __m128i zero = _mm_set1_epi8('0');
+    const __m128i nine = _mm_set1_epi8(9);
+    int i;
+
+    for (i = 0; i + (int)sizeof(__m128i) <= len; i += sizeof(__m128i))
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(s + i));
+        __m128i value;
+        __m128i digit;
+        uint32 mask;
+
+        // unsigned chunk - '0' <= 9
+        value = _mm_sub_epi8(chunk, zero);
+        digit = _mm_cmpeq_epi8(_mm_min_epu8(value, nine), value);
+
+        mask = ~_mm_movemask_epi8(digit) & 0xffff;
+        if (mask != 0)
+            return i + __builtin_ctz(mask);
+    }
+
+    return i + scan_digits_tail(s + i, len - i);
+}
+
+#endif
+
+#ifdef USE_AVX2_WITH_RUNTIME_CHECK
+
+__attribute__((target("avx2")))
+static int scan_plain_string_chars_avx2(const char *s, int len)
+{
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i max_control = _mm256_set1_epi8(0x1f);
+    int i;
+
+    for (i = 0; i + (int)sizeof(__m256i) <= len; i += sizeof(__m256i))
+    {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *)(s + i));
+        __m256i special;
+        uint32 mask;
+
+        special = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote),
+                                  _mm256_cmpeq_epi8(chunk, backslash));
+        // unsigned chunk <= 0x1f
+        special = _mm256_or_si256(
+            special,
+            _mm256_cmpeq_epi8(_mm256_min_epu8(chunk, max_control), chunk));
+
+        mask = _mm256_movemask_epi8(special);
+        if (mask != 0)
+            return i + __builtin_ctz(mask);
+    }
+
+    // the rest is shorter than a block of AVX2 but maybe not of SSE2
+    return i + scan_plain_string_chars_sse2(s + i, len - i);
+}
+
+__attribute__((target("avx2")))
+static int scan_whitespace_avx2(const char *s, int len)
+{
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i carriage_return = _mm256_set1_epi8('\r');
+    int i;
+
+    for (i = 0; i + (int)sizeof(__m256i) <= len; i += sizeof(__m256i))
+    {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *)(s + i));
+        __m256i whitespace;
+        uint32 mask;
+
+        whitespace = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, space),
+                            _mm256_cmpeq_epi8(chunk, tab)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, newline),
+                            _mm256_cmpeq_epi8(chunk, carriage_return)));
+
+        mask = ~(uint32)_mm256_movemask_epi8(whitespace);
+        if (mask != 0)
+            return i + __builtin_ctz(mask);
+    }
+
+    return i + scan_whitespace_sse2(s + i, len - i);
+}
+
+__attribute__((target("avx2")))
+static int scan_digits_avx2(const char *s, int len)
+{
+    const __m256i zero = _mm256_set1_epi8('0');
+    const __m256i nine = _mm256_set1_epi8(9);
+    int i;
+
+    for (i = 0; i + (int)sizeof(__m256i) <= len; i += sizeof(__m256i))
+    {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *)(s + i));
+        __m256i value;
+        __m256i digit;
+        uint32 mask;
+
+        // unsigned chunk - '0' <= 9
+        value = _mm256_sub_epi8(chunk, zero);
+        digit = _mm256_cmpeq_epi8(_mm256_min_epu8(value, nine), value);
+
+        mask = ~(uint32)_mm256_movemask_epi8(digit);
+        if (mask != 0)
+            return i + __builtin_ctz(mask);
+    }
+
+    return i + scan_digits_sse2(s + i, len - i);
+}
+
+#endif
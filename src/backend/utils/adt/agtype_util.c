@@ -26,11 +26,13 @@
 
 #include "access/hash.h"
 #include "catalog/pg_collation.h"
+#include "mb/pg_wchar.h"
 #include "miscadmin.h"
 #include "utils/builtins.h"
 #include "utils/memutils.h"
 #include "utils/varlena.h"
 
+#include "utils/ag_stat.h"
 #include "utils/agtype.h"
 #include "utils/agtype_ext.h"
 #include "utils/graphid.h"
@@ -82,6 +84,11 @@ static agtype_value *push_agtype_value_scalar(agtype_parse_state **pstate,
                                               agtype_value *scalar_val);
 static int compare_two_floats_orderability(float8 lhs, float8 rhs);
 static int get_type_sort_priority(enum agtype_value_type type);
+static void check_container(agtype_container *container, uint32 len,
+                            bool is_root);
+static void check_numeric(struct varlena *num, uint32 len);
+static void report_malformed_container(const char *detail)
+    pg_attribute_noreturn();
 
 /*
  * Turn an in-memory agtype_value into an agtype for on-disk storage.
@@ -100,7 +107,12 @@ agtype *agtype_value_to_agtype(agtype_value *val)
 {
     agtype *out;
 
-    if (IS_A_AGTYPE_SCALAR(val))
+    /* Integers and floats have a fixed layout */
+    if (val->type == AGTV_INTEGER || val->type == AGTV_FLOAT)
+    {
+        out = ag_make_fixed_scalar(val);
+    }
+    else if (IS_A_AGTYPE_SCALAR(val))
     {
         /* Scalar value */
         agtype_parse_state *pstate = NULL;
@@ -129,6 +141,8 @@ agtype *agtype_value_to_agtype(agtype_value *val)
         memcpy(VARDATA(out), val->val.binary.data, val->val.binary.len);
     }
 
+    ag_stat_add(AG_STAT_AGTYPE_BUILD_BYTES, VARSIZE(out));
+
     return out;
 }
 
@@ -194,16 +208,18 @@ static int get_type_sort_priority(enum agtype_value_type type)
         return 0;
     if (type == AGTV_VERTEX)
         return 1;
-    if (type == AGTV_ARRAY)
+    if (type == AGTV_EDGE)
         return 2;
-    if (type == AGTV_STRING)
+    if (type == AGTV_ARRAY)
         return 3;
-    if (type == AGTV_BOOL)
+    if (type == AGTV_STRING)
         return 4;
-    if (type == AGTV_NUMERIC || type == AGTV_INTEGER || type == AGTV_FLOAT)
+    if (type == AGTV_BOOL)
         return 5;
-    if (type == AGTV_NULL)
+    if (type == AGTV_NUMERIC || type == AGTV_INTEGER || type == AGTV_FLOAT)
         return 6;
+    if (type == AGTV_NULL)
+        return 7;
     return -1;
 }
 
@@ -518,6 +534,24 @@ agtype_value *get_ith_agtype_value_from_container(agtype_container *container,
     return result;
 }
 
+/*
+ * Get the properties of the vertex or edge that is the raw scalar of the
+ * given root container.
+ *
+ * The vertex or edge is not deserialized. Its properties are returned as an
+ * AGTV_BINARY value that points into the container. Returns NULL if the scalar is not a vertex or an edge.
+ */
+agtype_value *get_entity_properties_from_container(agtype_container *container)
+{
+    Assert(AGTYPE_CONTAINER_IS_SCALAR(container));
+
+    if (!AGTE_IS_AGTYPE(container->children[0]))
+        return NULL;
+
+    // the raw scalar is the only element so its offset is 0
+    return ag_get_entity_properties((char *)&container->children[1], 0);
+}
+
 /*
  * A helper function to fill in an agtype_value to represent an element of an
  * array, or a key or value of an object.
@@ -1341,6 +1375,17 @@ void agtype_hash_scalar_value(const agtype_value *scalar_val, uint32 *hash)
         tmp = DatumGetUInt32(DirectFunctionCall1(
             hashfloat8, Float8GetDatum(scalar_val->val.float_value)));
         break;
+    case AGTV_VERTEX:
+    case AGTV_EDGE:
+    {
+        graphid id;
+
+        /* vertices and edges are identified by their ids */
+        id = scalar_val->val.object.pairs[0].value.val.int_value;
+        tmp = DatumGetUInt32(DirectFunctionCall1(hashint8,
+                                                 GRAPHID_GET_DATUM(id)));
+        break;
+    }
     default:
         ereport(ERROR, (errmsg("invalid agtype scalar type %d to compute hash",
                                scalar_val->type)));
@@ -1404,19 +1449,14 @@ void agtype_hash_scalar_value_extended(const agtype_value *scalar_val,
             UInt64GetDatum(seed)));
         break;
     case AGTV_VERTEX:
-    {
-        graphid id;
-        id = scalar_val->val.object.pairs[0].value.val.int_value;
-        tmp = DatumGetUInt64(DirectFunctionCall2(
-            hashfloat8extended, Float8GetDatum(id), UInt64GetDatum(seed)));
-        break;
-    }
     case AGTV_EDGE:
     {
         graphid id;
+
+        /* must match agtype_hash_scalar_value() for seed 0 */
         id = scalar_val->val.object.pairs[0].value.val.int_value;
         tmp = DatumGetUInt64(DirectFunctionCall2(
-            hashfloat8extended, Float8GetDatum(id), UInt64GetDatum(seed)));
+            hashint8extended, GRAPHID_GET_DATUM(id), UInt64GetDatum(seed)));
         break;
     }
     default:
@@ -1497,6 +1537,7 @@ static bool equals_agtype_scalar_value(agtype_value *a, agtype_value *b)
         case AGTV_FLOAT:
             return a->val.float_value == b->val.float_value;
         case AGTV_VERTEX:
+        case AGTV_EDGE:
         {
             graphid a_graphid, b_graphid;
             a_graphid = a->val.object.pairs[0].value.val.int_value;
@@ -1554,8 +1595,11 @@ int compare_agtype_scalar_values(agtype_value *a, agtype_value *b)
             return compare_two_floats_orderability(a->val.float_value,
                                                    b->val.float_value);
         case AGTV_VERTEX:
+        case AGTV_EDGE:
         {
             graphid a_graphid, b_graphid;
+
+            // vertices and edges are ordered by their ids
             a_graphid = a->val.object.pairs[0].value.val.int_value;
             b_graphid = b->val.object.pairs[0].value.val.int_value;
 
@@ -1832,12 +1876,6 @@ static void convert_agtype_array(StringInfo buffer, agtentry *pheader,
     *pheader = AGTENTRY_IS_CONTAINER | totallen;
 }
 
-void convert_extended_object(StringInfo buffer, agtentry *pheader,
-                             agtype_value *val)
-{
-    convert_agtype_object(buffer, pheader, val, 0);
-}
-
 static void convert_agtype_object(StringInfo buffer, agtentry *pheader,
                                   agtype_value *val, int level)
 {
@@ -2113,3 +2151,184 @@ static void uniqueify_agtype_object(agtype_value *object)
         object->val.object.num_pairs = res + 1 - object->val.object.pairs;
     }
 }
+
+/*
+ * Check that the container of len bytes, which came from outside the server
+ * (e.g. binary input), is well-formed. Every offset and length must stay
+ * within the container, strings must be valid in the database encoding, and
+ * object keys must be unique and in the order lookups expect. This makes it
+ * safe to read the container with the functions in this file.
+ */
+void check_agtype_container(agtype_container *container, uint32 len)
+{
+    check_container(container, len, true);
+}
+
+static void check_container(agtype_container *container, uint32 len,
+                            bool is_root)
+{
+    uint32 header;
+    uint32 count;
+    uint32 nchildren;
+    uint64 header_len;
+    char *base_addr;
+    uint32 data_len;
+    uint32 offset;
+    uint32 prev_offset;
+    uint32 i;
+
+    check_stack_depth();
+
+    if (len < sizeof(uint32))
+        report_malformed_container("container header is truncated");
+
+    header = container->header;
+    count = header & AGT_CMASK;
+
+    if (header & ~(AGT_CMASK | AGT_FSCALAR | AGT_FOBJECT | AGT_FARRAY))
+        report_malformed_container("invalid container flags");
+
+    if ((header & AGT_FOBJECT) && !(header & AGT_FARRAY))
+    {
+        if (header & AGT_FSCALAR)
+            report_malformed_container("invalid container flags");
+        nchildren = count * 2;
+    }
+    else if ((header & AGT_FARRAY) && !(header & AGT_FOBJECT))
+    {
+        if ((header & AGT_FSCALAR) && (!is_root || count != 1))
+            report_malformed_container("invalid scalar container");
+        nchildren = count;
+    }
+    else
+    {
+        report_malformed_container("invalid container flags");
+    }
+
+    header_len = sizeof(uint32) + (uint64)sizeof(agtentry) * nchildren;
+    if (header_len > len)
+        report_malformed_container("container entries are truncated");
+
+    base_addr = (char *)&container->children[nchildren];
+    data_len = len - header_len;
+
+    offset = 0;
+    prev_offset = 0;
+    for (i = 0; i < nchildren; i++)
+    {
+        agtentry entry = container->children[i];
+        uint32 end;
+        uint32 node_len;
+        uint32 padlen = INTALIGN(offset) - offset;
+
+        if (AGTE_HAS_OFF(entry))
+            end = AGTE_OFFLENFLD(entry);
+        else
+            end = offset + AGTE_OFFLENFLD(entry);
+
+        if (end < offset || end > data_len)
+            report_malformed_container("entry is out of bounds");
+
+        node_len = end - offset;
+
+        /* keys of an object must be strings in the order of lookups */
+        if ((header & AGT_FOBJECT) && i < count)
+        {
+            if (!AGTE_IS_STRING(entry))
+                report_malformed_container("object key is not a string");
+
+            if (i > 0)
+            {
+                uint32 prev_len = offset - prev_offset;
+
+                if (prev_len > node_len ||
+                    (prev_len == node_len &&
+                     memcmp(base_addr + prev_offset, base_addr + offset,
+                            node_len) >= 0))
+                {
+                    report_malformed_container(
+                        "object keys are not unique or not sorted");
+                }
+            }
+        }
+
+        if (AGTE_IS_STRING(entry))
+        {
+            pg_verify_mbstr(GetDatabaseEncoding(), base_addr + offset,
+                            node_len, false);
+        }
+        else if (AGTE_IS_NUMERIC(entry))
+        {
+            if (node_len < padlen)
+                report_malformed_container("numeric is truncated");
+            check_numeric((struct varlena *)(base_addr + offset + padlen),
+                          node_len - padlen);
+        }
+        else if (AGTE_IS_CONTAINER(entry))
+        {
+            if (node_len < padlen)
+                report_malformed_container("container is truncated");
+            check_container(
+                (agtype_container *)(base_addr + offset + padlen),
+                node_len - padlen, false);
+        }
+        else if (AGTE_IS_AGTYPE(entry))
+        {
+            ag_check_extended_type(base_addr, offset, node_len);
+        }
+        else if (AGTE_IS_NULL(entry) || AGTE_IS_BOOL_TRUE(entry) ||
+                 AGTE_IS_BOOL_FALSE(entry))
+        {
+            if (node_len != 0)
+                report_malformed_container("scalar has data");
+        }
+        else
+        {
+            report_malformed_container("invalid entry type");
+        }
+
+        prev_offset = offset;
+        offset = end;
+    }
+
+    if (offset != data_len)
+        report_malformed_container("container has trailing data");
+}
+
+/*
+ * The layout of numeric is private to numeric.c, so only the parts that
+ * decide how much numeric.c reads are checked here; the header word tells
+ * whether a second header word precedes the digits.
+ */
+static void check_numeric(struct varlena *num, uint32 len)
+{
+    uint16 flags;
+    uint32 header_len;
+
+    if (len < VARHDRSZ_SHORT)
+        report_malformed_container("numeric is truncated");
+
+    if (VARATT_IS_1B_E(num) || VARATT_IS_4B_C(num) ||
+        (VARATT_IS_4B(num) && len < VARHDRSZ))
+    {
+        report_malformed_container("invalid numeric header");
+    }
+
+    if (VARSIZE_ANY(num) != len)
+        report_malformed_container("numeric length does not match");
+
+    if (VARSIZE_ANY_EXHDR(num) < sizeof(uint16))
+        report_malformed_container("numeric is truncated");
+
+    memcpy(&flags, VARDATA_ANY(num), sizeof(uint16));
+    header_len = (flags & 0x8000) ? sizeof(uint16) : sizeof(uint16) * 2;
+    if (VARSIZE_ANY_EXHDR(num) < header_len)
+        report_malformed_container("numeric is truncated");
+}
+
+static void report_malformed_container(const char *detail)
+{
+    ereport(ERROR, (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+                    errmsg("malformed agtype binary data"),
+                    errdetail("%s", detail)));
+}
@@ -32,6 +32,26 @@ Datum cypher(PG_FUNCTION_ARGS)
     PG_RETURN_NULL();
 }
 
+PG_FUNCTION_INFO_V1(_cypher_expand_clause);
+
+Datum _cypher_expand_clause(PG_FUNCTION_ARGS)
+{
+    ereport(ERROR,
+            (errmsg_internal("unhandled _cypher_expand_clause(oid, graphid, oid, int4, int4) function call")));
+
+    PG_RETURN_NULL();
+}
+
+PG_FUNCTION_INFO_V1(_cypher_vle_clause);
+
+Datum _cypher_vle_clause(PG_FUNCTION_ARGS)
+{
+    ereport(ERROR,
+            (errmsg_internal("unhandled _cypher_vle_clause(oid, graphid, oid, int4, int4, int4, int4, bool) function call")));
+
+    PG_RETURN_NULL();
+}
+
 PG_FUNCTION_INFO_V1(_cypher_create_clause);
 
 Datum _cypher_create_clause(PG_FUNCTION_ARGS)
@@ -16,13 +16,39 @@
 
 #include "postgres.h"
 
+#include "catalog/pg_sequence.h"
+#include "commands/sequence.h"
 #include "fmgr.h"
+#include "libpq/pqformat.h"
 #include "utils/builtins.h"
+#include "utils/hsearch.h"
+#include "utils/inval.h"
 #include "utils/sortsupport.h"
+#include "utils/syscache.h"
 
 #include "utils/graphid.h"
 
+/*
+ * The entry IDs of a label are reserved in blocks per backend. The sequence
+ * of the label holds the last reserved entry ID and increments by the block
+ * size, so a single nextval() reserves the block (last - increment, last].
+ * The backend hands out the IDs in the block without touching the sequence.
+ */
+typedef struct entry_id_block
+{
+    Oid seq_relid; // hash key
+    int64 next;
+    int64 last;
+} entry_id_block;
+
+// entry ID blocks of this backend, keyed by the OID of the sequence
+static HTAB *entry_id_blocks = NULL;
+
 static int graphid_btree_fast_cmp(Datum x, Datum y, SortSupport ssup);
+static void initialize_entry_id_blocks(void);
+static void invalidate_entry_id_blocks(Datum arg, int cache_id,
+                                       uint32 hash_value);
+static int64 get_sequence_increment(Oid seq_relid);
 
 PG_FUNCTION_INFO_V1(graphid_in);
 
@@ -60,6 +86,30 @@ Datum graphid_out(PG_FUNCTION_ARGS)
     PG_RETURN_CSTRING(out);
 }
 
+PG_FUNCTION_INFO_V1(graphid_recv);
+
+// graphid type binary input function
+Datum graphid_recv(PG_FUNCTION_ARGS)
+{
+    StringInfo buf = (StringInfo)PG_GETARG_POINTER(0);
+
+    AG_RETURN_GRAPHID(pq_getmsgint64(buf));
+}
+
+PG_FUNCTION_INFO_V1(graphid_send);
+
+// graphid type binary output function
+Datum graphid_send(PG_FUNCTION_ARGS)
+{
+    graphid gid = AG_GETARG_GRAPHID(0);
+    StringInfoData buf;
+
+    pq_begintypsend(&buf);
+    pq_sendint64(&buf, gid);
+
+    PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
+}
+
 PG_FUNCTION_INFO_V1(graphid_eq);
 
 Datum graphid_eq(PG_FUNCTION_ARGS)
@@ -212,3 +262,102 @@ Datum _graphid(PG_FUNCTION_ARGS)
 
     AG_RETURN_GRAPHID(gid);
 }
+
+PG_FUNCTION_INFO_V1(_next_entry_id);
+
+Datum _next_entry_id(PG_FUNCTION_ARGS)
+{
+    Oid seq_relid = PG_GETARG_OID(0);
+
+    PG_RETURN_INT64(next_entry_id(seq_relid));
+}
+
+/*
+ * Returns the next entry ID from the block of this backend for the label
+ * whose sequence is seq_relid. Reserves a new block if the block is used up.
+ */
+int64 next_entry_id(Oid seq_relid)
+{
+    entry_id_block *block;
+
+    if (!entry_id_blocks)
+        initialize_entry_id_blocks();
+
+    block = hash_search(entry_id_blocks, &seq_relid, HASH_FIND, NULL);
+    if (!block || block->next > block->last)
+    {
+        int64 last;
+        int64 increment;
+
+        /*
+         * nextval_internal() keeps the sequence locked until the end of the
+         * transaction, so the increment cannot change in between.
+         */
+        last = nextval_internal(seq_relid, true);
+        increment = get_sequence_increment(seq_relid);
+
+        block = hash_search(entry_id_blocks, &seq_relid, HASH_ENTER, NULL);
+        block->next = Max(last - Max(increment, 1) + 1, ENTRY_ID_MIN);
+        block->last = last;
+    }
+
+    return block->next++;
+}
+
+static void initialize_entry_id_blocks(void)
+{
+    HASHCTL hash_ctl;
+
+    MemSet(&hash_ctl, 0, sizeof(hash_ctl));
+    hash_ctl.keysize = sizeof(Oid);
+    hash_ctl.entrysize = sizeof(entry_id_block);
+
+    /*
+     * Please see the comment of hash_create() for the nelem value 16 here.
+     * HASH_BLOBS flag is set because the size of the key is sizeof(uint32).
+     */
+    entry_id_blocks = hash_create("entry ID blocks", 16, &hash_ctl,
+                                  HASH_ELEM | HASH_BLOBS);
+
+    // ALTER SEQUENCE and DROP SEQUENCE make the blocks stale
+    CacheRegisterSyscacheCallback(SEQRELID, invalidate_entry_id_blocks,
+                                  (Datum)0);
+}
+
+static void invalidate_entry_id_blocks(Datum arg, int cache_id,
+                                       uint32 hash_value)
+{
+    HASH_SEQ_STATUS hash_seq;
+
+    hash_seq_init(&hash_seq, entry_id_blocks);
+    for (;;)
+    {
+        entry_id_block *block;
+        void *removed;
+
+        block = hash_seq_search(&hash_seq);
+        if (!block)
+            break;
+
+        removed = hash_search(entry_id_blocks, &block->seq_relid,
+                              HASH_REMOVE, NULL);
+        if (!removed)
+            ereport(ERROR, (errmsg_internal("entry ID blocks corrupted")));
+    }
+}
+
+static int64 get_sequence_increment(Oid seq_relid)
+{
+    HeapTuple tuple;
+    int64 increment;
+
+    tuple = SearchSysCache1(SEQRELID, ObjectIdGetDatum(seq_relid));
+    if (!HeapTupleIsValid(tuple))
+        elog(ERROR, "cache lookup failed for sequence %u", seq_relid);
+
+    increment = ((Form_pg_sequence)GETSTRUCT(tuple))->seqincrement;
+
+    ReleaseSysCache(tuple);
+
+    return increment;
+}
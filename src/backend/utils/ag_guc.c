@@ -0,0 +1,61 @@
+/*
+ * Copyright 2020 Bitnine Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "postgres.h"
+
+#include "utils/guc.h"
+
+#include "utils/ag_guc.h"
+
+int cypher_query_cache_size = 256;
+int entry_id_block_size = 1024;
+int cypher_vle_max_hops = 100;
+int cypher_vle_max_rows = 0;
+bool track_cypher_stats = true;
+
+void define_config_params(void)
+{
+    DefineCustomIntVariable("agensgraph.cypher_query_cache_size",
+                            "Sets the maximum number of analyzed cypher() queries cached per session.",
+                            "Queries that end with CREATE clause are not cached. A value of 0 disables the cache.",
+                            &cypher_query_cache_size, 256, 0, INT_MAX,
+                            PGC_USERSET, 0, NULL, NULL, NULL);
+
+    DefineCustomIntVariable("agensgraph.entry_id_block_size",
+                            "Sets the number of entry IDs a session reserves at once for new labels.",
+                            "It is the increment of the sequence of a label and applies to labels created afterwards.",
+                            &entry_id_block_size, 1024, 1, INT_MAX,
+                            PGC_USERSET, 0, NULL, NULL, NULL);
+
+    DefineCustomIntVariable("agensgraph.cypher_vle_max_hops",
+                            "Sets the maximum length of variable-length relationships without an upper bound.",
+                            NULL, &cypher_vle_max_hops, 100, 1, INT_MAX,
+                            PGC_USERSET, 0, NULL, NULL, NULL);
+
+    DefineCustomIntVariable("agensgraph.cypher_vle_max_rows",
+                            "Sets the maximum number of rows a variable-length relationship returns for a start vertex.",
+                            "Exceeding the limit is an error. A value of 0 disables the limit.",
+                            &cypher_vle_max_rows, 0, 0, INT_MAX,
+                            PGC_USERSET, 0, NULL, NULL, NULL);
+
+    DefineCustomBoolVariable("agensgraph.track_cypher_stats",
+                             "Collects statistics on the activity of cypher() queries.",
+                             "The statistics are shown in ag_catalog.ag_stat_cypher.",
+                             &track_cypher_stats, true, PGC_SUSET, 0, NULL,
+                             NULL, NULL);
+
+    EmitWarningsOnPlaceholders("agensgraph");
+}
@@ -0,0 +1,552 @@
+/*
+ * Copyright 2020 Bitnine Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Statistics on the activity of cypher() queries
+ *
+ * Each backend adds to its own pending counters, which costs no more than an
+ * increment. The pending counters are added to the counters in shared memory
+ * at the end of each transaction. The counters are shared only if the library
+ * is loaded with shared_preload_libraries. Otherwise, each backend shows its
+ * own counters, which do not include the activity of its parallel workers.
+ */
+
+#include "postgres.h"
+
+#include "access/tupdesc.h"
+#include "access/xact.h"
+#include "fmgr.h"
+#include "funcapi.h"
+#include "miscadmin.h"
+#include "nodes/execnodes.h"
+#include "port/atomics.h"
+#include "storage/ipc.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
+#include "utils/builtins.h"
+#include "utils/hsearch.h"
+#include "utils/memutils.h"
+#include "utils/tuplestore.h"
+
+#include "utils/ag_stat.h"
+
+/*
+ * maximum number of labels whose created rows are counted in shared memory,
+ * the entries of dropped labels are removed by ag_stat_forget_label()
+ */
+#define AG_STAT_MAX_LABELS 1024
+
+#define Natts_ag_stat_cypher 3
+
+typedef struct ag_stat_label_key
+{
+    Oid database;
+    Oid relation;
+} ag_stat_label_key;
+
+typedef struct ag_stat_label_entry
+{
+    ag_stat_label_key key; // hash key
+    uint64 rows_created;
+} ag_stat_label_entry;
+
+// a label dropped by the current transaction
+typedef struct ag_stat_dropped_label
+{
+    Oid relation;
+    SubTransactionId subid; // the subtransaction that dropped the label
+} ag_stat_dropped_label;
+
+typedef struct ag_stat_shared_state
+{
+    LWLock *lock; // protects ag_stat_shared_labels
+    pg_atomic_uint64 counters[NUM_AG_STAT_COUNTERS];
+} ag_stat_shared_state;
+
+static const char *const ag_stat_counter_names[] = {
+    "parse_calls",
+    "parse_time",
+    "analyze_calls",
+    "analyze_time",
+    "graph_name_cache_hits",
+    "graph_name_cache_misses",
+    "graph_namespace_cache_hits",
+    "graph_namespace_cache_misses",
+    "label_oid_cache_hits",
+    "label_oid_cache_misses",
+    "label_name_graph_cache_hits",
+    "label_name_graph_cache_misses",
+    "label_graph_id_cache_hits",
+    "label_graph_id_cache_misses",
+    "label_relation_cache_hits",
+    "label_relation_cache_misses",
+    "label_stats_cache_hits",
+    "label_stats_cache_misses",
+    "ag_func_oid_cache_hits",
+    "ag_func_oid_cache_misses",
+    "ag_func_name_cache_hits",
+    "ag_func_name_cache_misses",
+    "cypher_query_cache_hits",
+    "cypher_query_cache_misses",
+    "agtype_build_bytes",
+    "agtype_serialize_bytes",
+    "access_operator_calls",
+    "rows_created_overflow"
+};
+
+uint64 ag_stat_pending_counters[NUM_AG_STAT_COUNTERS];
+
+// rows created per label that have not been added to the shared ones yet
+static HTAB *ag_stat_pending_labels = NULL;
+
+/*
+ * labels whose rows_created counters are removed if the current transaction
+ * commits, in TopTransactionContext
+ */
+static List *ag_stat_dropped_labels = NIL;
+
+static ag_stat_shared_state *ag_stat_shared = NULL;
+static HTAB *ag_stat_shared_labels = NULL;
+
+static shmem_startup_hook_type prev_shmem_startup_hook = NULL;
+
+static Size ag_stat_shmem_size(void);
+static void ag_stat_shmem_startup(void);
+static void ag_stat_xact_callback(XactEvent event, void *arg);
+static void ag_stat_subxact_callback(SubXactEvent event,
+                                     SubTransactionId mySubid,
+                                     SubTransactionId parentSubid, void *arg);
+static void flush_pending_stats(void);
+static void forget_dropped_labels(void);
+static void put_label_rows(Tuplestorestate *tupstore, TupleDesc tupdesc,
+                           HTAB *labels);
+static void remove_all_labels(HTAB *labels);
+
+void ag_stat_init(void)
+{
+    StaticAssertStmt(lengthof(ag_stat_counter_names) == NUM_AG_STAT_COUNTERS,
+                     "ag_stat_counter_names must match ag_stat_counter");
+
+    RegisterXactCallback(ag_stat_xact_callback, NULL);
+    RegisterSubXactCallback(ag_stat_subxact_callback, NULL);
+
+    if (!process_shared_preload_libraries_in_progress)
+        return;
+
+    RequestAddinShmemSpace(ag_stat_shmem_size());
+    RequestNamedLWLockTranche("agensgraph", 1);
+
+    prev_shmem_startup_hook = shmem_startup_hook;
+    shmem_startup_hook = ag_stat_shmem_startup;
+}
+
+void ag_stat_fini(void)
+{
+    UnregisterXactCallback(ag_stat_xact_callback, NULL);
+    UnregisterSubXactCallback(ag_stat_subxact_callback, NULL);
+
+    if (shmem_startup_hook == ag_stat_shmem_startup)
+        shmem_startup_hook = prev_shmem_startup_hook;
+}
+
+static Size ag_stat_shmem_size(void)
+{
+    Size size;
+
+    size = MAXALIGN(sizeof(ag_stat_shared_state));
+    size = add_size(size, hash_estimate_size(AG_STAT_MAX_LABELS,
+                                             sizeof(ag_stat_label_entry)));
+
+    return size;
+}
+
+static void ag_stat_shmem_startup(void)
+{
+    HASHCTL hash_ctl;
+    bool found;
+    int i;
+
+    if (prev_shmem_startup_hook)
+        prev_shmem_startup_hook();
+
+    LWLockAcquire(AddinShmemInitLock, LW_EXCLUSIVE);
+
+    ag_stat_shared = ShmemInitStruct("agensgraph cypher stats",
+                                     sizeof(ag_stat_shared_state), &found);
+    if (!found)
+    {
+        ag_stat_shared->lock = &(GetNamedLWLockTranche("agensgraph"))->lock;
+        for (i = 0; i < NUM_AG_STAT_COUNTERS; i++)
+            pg_atomic_init_u64(&ag_stat_shared->counters[i], 0);
+    }
+
+    MemSet(&hash_ctl, 0, sizeof(hash_ctl));
+    hash_ctl.keysize = sizeof(ag_stat_label_key);
+    hash_ctl.entrysize = sizeof(ag_stat_label_entry);
+
+    ag_stat_shared_labels = ShmemInitHash("agensgraph cypher stats labels",
+                                          AG_STAT_MAX_LABELS,
+                                          AG_STAT_MAX_LABELS, &hash_ctl,
+                                          HASH_ELEM | HASH_BLOBS);
+
+    LWLockRelease(AddinShmemInitLock);
+}
+
+static void ag_stat_xact_callback(XactEvent event, void *arg)
+{
+    switch (event)
+    {
+    case XACT_EVENT_COMMIT:
+        flush_pending_stats();
+        forget_dropped_labels();
+        break;
+    case XACT_EVENT_PARALLEL_COMMIT:
+    case XACT_EVENT_ABORT:
+    case XACT_EVENT_PARALLEL_ABORT:
+        flush_pending_stats();
+        // the list is freed along with TopTransactionContext
+        ag_stat_dropped_labels = NIL;
+        break;
+    case XACT_EVENT_PREPARE:
+        /*
+         * Whether the labels are dropped is decided later, by another
+         * backend. Their counters are kept until ag_stat_cypher_reset().
+         */
+        ag_stat_dropped_labels = NIL;
+        break;
+    default:
+        break;
+    }
+}
+
+// The labels dropped by an aborted subtransaction are not dropped at all.
+static void ag_stat_subxact_callback(SubXactEvent event,
+                                     SubTransactionId mySubid,
+                                     SubTransactionId parentSubid, void *arg)
+{
+    ListCell *lc;
+    ListCell *prev = NULL;
+    ListCell *next;
+
+    if (event != SUBXACT_EVENT_COMMIT_SUB && event != SUBXACT_EVENT_ABORT_SUB)
+        return;
+
+    for (lc = list_head(ag_stat_dropped_labels); lc != NULL; lc = next)
+    {
+        ag_stat_dropped_label *dropped = lfirst(lc);
+
+        next = lnext(lc);
+
+        if (dropped->subid != mySubid)
+        {
+            prev = lc;
+            continue;
+        }
+
+        if (event == SUBXACT_EVENT_COMMIT_SUB)
+        {
+            dropped->subid = parentSubid;
+            prev = lc;
+        }
+        else
+        {
+            ag_stat_dropped_labels = list_delete_cell(ag_stat_dropped_labels,
+                                                      lc, prev);
+            pfree(dropped);
+        }
+    }
+}
+
+void ag_stat_count_rows_created(Oid relation, uint64 rows)
+{
+    ag_stat_label_key key;
+    ag_stat_label_entry *entry;
+    bool found;
+
+    if (!track_cypher_stats || rows == 0)
+        return;
+
+    if (!ag_stat_pending_labels)
+    {
+        HASHCTL hash_ctl;
+
+        MemSet(&hash_ctl, 0, sizeof(hash_ctl));
+        hash_ctl.keysize = sizeof(ag_stat_label_key);
+        hash_ctl.entrysize = sizeof(ag_stat_label_entry);
+
+        // Please see the comment of hash_create() for the nelem value 16 here.
+        ag_stat_pending_labels = hash_create("cypher stats labels", 16,
+                                             &hash_ctl,
+                                             HASH_ELEM | HASH_BLOBS);
+    }
+
+    key.database = MyDatabaseId;
+    key.relation = relation;
+
+    entry = hash_search(ag_stat_pending_labels, &key, HASH_ENTER, &found);
+    if (!found)
+        entry->rows_created = 0;
+    entry->rows_created += rows;
+}
+
+/*
+ * Remove the rows_created counter of the given label, which is being dropped,
+ * when the current transaction commits. The counter is kept if the
+ * transaction (or the subtransaction that drops the label) aborts.
+ */
+void ag_stat_forget_label(Oid relation)
+{
+    MemoryContext old_context;
+    ag_stat_dropped_label *dropped;
+
+    old_context = MemoryContextSwitchTo(TopTransactionContext);
+
+    dropped = palloc(sizeof(*dropped));
+    dropped->relation = relation;
+    dropped->subid = GetCurrentSubTransactionId();
+    ag_stat_dropped_labels = lappend(ag_stat_dropped_labels, dropped);
+
+    MemoryContextSwitchTo(old_context);
+}
+
+/*
+ * Remove the counters of the labels dropped by the transaction that is being
+ * committed. This must not fail since the transaction cannot abort anymore.
+ */
+static void forget_dropped_labels(void)
+{
+    ListCell *lc;
+
+    if (!ag_stat_dropped_labels)
+        return;
+
+    if (ag_stat_shared)
+        LWLockAcquire(ag_stat_shared->lock, LW_EXCLUSIVE);
+
+    foreach (lc, ag_stat_dropped_labels)
+    {
+        ag_stat_dropped_label *dropped = lfirst(lc);
+        ag_stat_label_key key;
+
+        key.database = MyDatabaseId;
+        key.relation = dropped->relation;
+
+        if (ag_stat_pending_labels)
+            hash_search(ag_stat_pending_labels, &key, HASH_REMOVE, NULL);
+
+        if (ag_stat_shared)
+            hash_search(ag_stat_shared_labels, &key, HASH_REMOVE, NULL);
+    }
+
+    if (ag_stat_shared)
+        LWLockRelease(ag_stat_shared->lock);
+
+    // the list is freed along with TopTransactionContext
+    ag_stat_dropped_labels = NIL;
+}
+
+/*
+ * Add the pending counters of the backend to the shared ones. This must not
+ * fail since it is called while a transaction is being aborted.
+ */
+static void flush_pending_stats(void)
+{
+    HASH_SEQ_STATUS seq;
+    ag_stat_label_entry *pending;
+    int i;
+
+    if (!ag_stat_shared)
+        return;
+
+    for (i = 0; i < NUM_AG_STAT_COUNTERS; i++)
+    {
+        if (ag_stat_pending_counters[i] == 0)
+            continue;
+
+        pg_atomic_fetch_add_u64(&ag_stat_shared->counters[i],
+                                (int64)ag_stat_pending_counters[i]);
+        ag_stat_pending_counters[i] = 0;
+    }
+
+    if (!ag_stat_pending_labels ||
+        hash_get_num_entries(ag_stat_pending_labels) == 0)
+        return;
+
+    LWLockAcquire(ag_stat_shared->lock, LW_EXCLUSIVE);
+
+    hash_seq_init(&seq, ag_stat_pending_labels);
+    while ((pending = hash_seq_search(&seq)) != NULL)
+    {
+        ag_stat_label_entry *entry;
+        bool found;
+
+        /*
+         * The rows of the labels that do not fit in shared memory are only
+         * counted in total, by rows_created_overflow.
+         */
+        entry = hash_search(ag_stat_shared_labels, &pending->key,
+                            HASH_ENTER_NULL, &found);
+        if (entry)
+        {
+            if (!found)
+                entry->rows_created = 0;
+            entry->rows_created += pending->rows_created;
+        }
+        else
+        {
+            pg_atomic_fetch_add_u64(
+                &ag_stat_shared->counters[AG_STAT_ROWS_CREATED_OVERFLOW],
+                (int64)pending->rows_created);
+        }
+
+        hash_search(ag_stat_pending_labels, &pending->key, HASH_REMOVE, NULL);
+    }
+
+    LWLockRelease(ag_stat_shared->lock);
+}
+
+PG_FUNCTION_INFO_V1(ag_stat_cypher);
+
+/*
+ * ag_stat_cypher(OUT name text, OUT label regclass, OUT value bigint)
+ *
+ * label is NULL except for the rows_created counters, which are per label of
+ * the current database.
+ */
+Datum ag_stat_cypher(PG_FUNCTION_ARGS)
+{
+    ReturnSetInfo *rsinfo = (ReturnSetInfo *)fcinfo->resultinfo;
+    TupleDesc tupdesc;
+    Tuplestorestate *tupstore;
+    MemoryContext old_context;
+    Datum values[Natts_ag_stat_cypher];
+    bool nulls[Natts_ag_stat_cypher];
+    int i;
+
+    if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo) ||
+        !(rsinfo->allowedModes & SFRM_Materialize))
+    {
+        ereport(ERROR,
+                (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                 errmsg("set-valued function called in context that cannot accept a set")));
+    }
+
+    if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+        elog(ERROR, "return type must be a row type");
+
+    old_context =
+        MemoryContextSwitchTo(rsinfo->econtext->ecxt_per_query_memory);
+
+    tupdesc = CreateTupleDescCopy(tupdesc);
+    tupstore = tuplestore_begin_heap(true, false, work_mem);
+
+    rsinfo->returnMode = SFRM_Materialize;
+    rsinfo->setResult = tupstore;
+    rsinfo->setDesc = tupdesc;
+
+    MemoryContextSwitchTo(old_context);
+
+    // so that the backend sees its own activity right away
+    flush_pending_stats();
+
+    MemSet(nulls, false, sizeof(nulls));
+    nulls[1] = true;
+    for (i = 0; i < NUM_AG_STAT_COUNTERS; i++)
+    {
+        uint64 value;
+
+        if (ag_stat_shared)
+            value = pg_atomic_read_u64(&ag_stat_shared->counters[i]);
+        else
+            value = ag_stat_pending_counters[i];
+
+        values[0] = CStringGetTextDatum(ag_stat_counter_names[i]);
+        values[2] = Int64GetDatum((int64)value);
+        tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+    }
+
+    if (ag_stat_shared)
+    {
+        LWLockAcquire(ag_stat_shared->lock, LW_SHARED);
+        put_label_rows(tupstore, tupdesc, ag_stat_shared_labels);
+        LWLockRelease(ag_stat_shared->lock);
+    }
+    else if (ag_stat_pending_labels)
+    {
+        put_label_rows(tupstore, tupdesc, ag_stat_pending_labels);
+    }
+
+    tuplestore_donestoring(tupstore);
+
+    return (Datum)0;
+}
+
+static void put_label_rows(Tuplestorestate *tupstore, TupleDesc tupdesc,
+                           HTAB *labels)
+{
+    HASH_SEQ_STATUS seq;
+    ag_stat_label_entry *entry;
+    Datum values[Natts_ag_stat_cypher];
+    bool nulls[Natts_ag_stat_cypher];
+
+    MemSet(nulls, false, sizeof(nulls));
+
+    hash_seq_init(&seq, labels);
+    while ((entry = hash_seq_search(&seq)) != NULL)
+    {
+        if (entry->key.database != MyDatabaseId)
+            continue;
+
+        values[0] = CStringGetTextDatum("rows_created");
+        values[1] = ObjectIdGetDatum(entry->key.relation);
+        values[2] = Int64GetDatum((int64)entry->rows_created);
+        tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+    }
+}
+
+PG_FUNCTION_INFO_V1(ag_stat_cypher_reset);
+
+// ag_stat_cypher_reset() resets all the counters of ag_stat_cypher
+Datum ag_stat_cypher_reset(PG_FUNCTION_ARGS)
+{
+    int i;
+
+    MemSet(ag_stat_pending_counters, 0, sizeof(ag_stat_pending_counters));
+    if (ag_stat_pending_labels)
+        remove_all_labels(ag_stat_pending_labels);
+
+    if (ag_stat_shared)
+    {
+        for (i = 0; i < NUM_AG_STAT_COUNTERS; i++)
+            pg_atomic_write_u64(&ag_stat_shared->counters[i], 0);
+
+        LWLockAcquire(ag_stat_shared->lock, LW_EXCLUSIVE);
+        remove_all_labels(ag_stat_shared_labels);
+        LWLockRelease(ag_stat_shared->lock);
+    }
+
+    PG_RETURN_VOID();
+}
+
+static void remove_all_labels(HTAB *labels)
+{
+    HASH_SEQ_STATUS seq;
+    ag_stat_label_entry *entry;
+
+    hash_seq_init(&seq, labels);
+    while ((entry = hash_seq_search(&seq)) != NULL)
+        hash_search(labels, &entry->key, HASH_REMOVE, NULL);
+}
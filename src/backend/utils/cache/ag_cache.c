@@ -18,6 +18,7 @@
 
 #include "access/attnum.h"
 #include "access/genam.h"
+#include "access/hash.h"
 #include "access/heapam.h"
 #include "access/htup.h"
 #include "access/htup_details.h"
@@ -25,11 +26,19 @@
 #include "access/stratnum.h"
 #include "access/sysattr.h"
 #include "access/tupdesc.h"
+#include "catalog/namespace.h"
+#include "catalog/pg_proc.h"
 #include "fmgr.h"
+#include "nodes/nodeFuncs.h"
+#include "nodes/parsenodes.h"
+#include "nodes/pg_list.h"
+#include "nodes/primnodes.h"
+#include "storage/lmgr.h"
 #include "storage/lockdefs.h"
 #include "utils/builtins.h"
 #include "utils/catcache.h"
 #include "utils/fmgroids.h"
+#include "utils/hashutils.h"
 #include "utils/hsearch.h"
 #include "utils/inval.h"
 #include "utils/memutils.h"
@@ -39,7 +48,10 @@
 
 #include "catalog/ag_graph.h"
 #include "catalog/ag_label.h"
+#include "catalog/ag_namespace.h"
 #include "utils/ag_cache.h"
+#include "utils/ag_guc.h"
+#include "utils/ag_stat.h"
 #include "utils/graphid.h"
 
 typedef struct graph_name_cache_entry
@@ -84,6 +96,49 @@ typedef struct label_relation_cache_entry
     label_cache_data data;
 } label_relation_cache_entry;
 
+typedef struct label_stats_cache_entry
+{
+    Oid relation; // hash key
+    bool analyzed; // false if there are no statistics for the relation
+    label_stats_data data; // heavy hitters are in CacheMemoryContext
+} label_stats_cache_entry;
+
+typedef struct ag_func_name_cache_key
+{
+    NameData name;
+    int nargs;
+    Oid arg_types[FUNC_MAX_ARGS];
+} ag_func_name_cache_key;
+
+typedef struct ag_func_name_cache_entry
+{
+    ag_func_name_cache_key key; // hash key
+    Oid oid;
+} ag_func_name_cache_entry;
+
+typedef struct cypher_query_cache_key
+{
+    Oid graph;
+    uint32 query_hash;
+    // operators and functions in the query are looked up through search_path
+    uint32 search_path_hash;
+    Oid param_type;
+    int param_id;
+} cypher_query_cache_key;
+
+typedef struct cypher_query_cache_entry
+{
+    cypher_query_cache_key key; // hash key
+    MemoryContext context; // holds everything below
+    char *query_str;
+    OverrideSearchPath *search_path;
+    List *coltypes;
+    List *coltypmods;
+    List *relations; // relations that query depends on
+    List *lockmodes; // lock modes that the parser took on relations
+    Query *query;
+} cypher_query_cache_entry;
+
 // ag_graph.name
 static HTAB *graph_name_cache_hash = NULL;
 static ScanKeyData graph_name_scan_keys[1];
@@ -108,6 +163,27 @@ static ScanKeyData label_graph_id_scan_keys[2];
 static HTAB *label_relation_cache_hash = NULL;
 static ScanKeyData label_relation_scan_keys[1];
 
+// ag_label_stats.relation
+static HTAB *label_stats_cache_hash = NULL;
+
+// ag_catalog namespace and the types in it
+static Oid ag_namespace_oid = InvalidOid;
+static Oid ag_type_oids[AG_TYPE_OID_COUNT];
+static const char *const ag_type_names[AG_TYPE_OID_COUNT] = {
+    "agtype", "_agtype", "graphid", "_graphid"
+};
+
+// pg_proc.oid
+static HTAB *ag_func_oid_cache_hash = NULL;
+
+// pg_proc.proname, pg_proc.proargtypes (ag_catalog only)
+static HTAB *ag_func_name_cache_hash = NULL;
+
+// analyzed cypher() queries
+static HTAB *cypher_query_cache_hash = NULL;
+// bumped whenever entries are removed from cypher_query_cache_hash
+static uint64 cypher_query_cache_generation = 0;
+
 // initialize all caches
 static void initialize_caches(void);
 
@@ -137,6 +213,7 @@ static void create_label_oid_cache(void);
 static void create_label_name_graph_cache(void);
 static void create_label_graph_id_cache(void);
 static void create_label_relation_cache(void);
+static void create_label_stats_cache(void);
 static void invalidate_label_caches(Datum arg, Oid relid);
 static void invalidate_label_oid_cache(Oid relid);
 static void flush_label_oid_cache(void);
@@ -146,6 +223,9 @@ static void invalidate_label_graph_id_cache(Oid relid);
 static void flush_label_graph_id_cache(void);
 static void invalidate_label_relation_cache(Oid relid);
 static void flush_label_relation_cache(void);
+static void invalidate_label_stats_cache(Oid relid);
+static void flush_label_stats_cache(void);
+static void remove_label_stats_cache_entry(label_stats_cache_entry *entry);
 static label_cache_data *search_label_oid_cache_miss(Oid oid);
 static label_cache_data *search_label_name_graph_cache_miss(Name name,
                                                             Oid graph);
@@ -156,9 +236,36 @@ static label_cache_data *search_label_graph_id_cache_miss(Oid graph, int32 id);
 static void *label_graph_id_cache_hash_search(Oid graph, int32 id,
                                               HASHACTION action, bool *found);
 static label_cache_data *search_label_relation_cache_miss(Oid relation);
+static label_stats_cache_entry *search_label_stats_cache_miss(Oid relation);
+static void copy_heavy_hitters_to_cache(label_degree_stats *stats);
 static void fill_label_cache_data(label_cache_data *cache_data,
                                   HeapTuple tuple, TupleDesc tuple_desc);
 
+// ag_catalog objects
+static void initialize_ag_oid_caches(void);
+static void create_ag_func_caches(void);
+static void invalidate_ag_oid_caches(Datum arg, int cache_id,
+                                     uint32 hash_value);
+static void reset_ag_type_oids(void);
+static void flush_ag_func_oid_cache(void);
+static void flush_ag_func_name_cache(void);
+static ag_func_cache_data *search_ag_func_oid_cache_miss(Oid oid);
+static Oid search_ag_func_name_cache_miss(ag_func_name_cache_key *key);
+
+// cypher query
+static void initialize_cypher_query_cache(void);
+static void create_cypher_query_cache(void);
+static void invalidate_cypher_query_cache_callback(Datum arg, int cache_id,
+                                                   uint32 hash_value);
+static void invalidate_cypher_query_cache(Oid relid);
+static void flush_cypher_query_cache(void);
+static void remove_cypher_query_cache_entry(cypher_query_cache_entry *entry);
+static uint32 get_search_path_hash(void);
+static void fill_cypher_query_cache_key(cypher_query_cache_key *key, Oid graph,
+                                        const char *query_str, Param *params);
+static bool collect_query_relations(Node *node,
+                                    cypher_query_cache_entry *entry);
+
 static void initialize_caches(void)
 {
     static bool initialized = false;
@@ -171,6 +278,8 @@ static void initialize_caches(void)
 
     initialize_graph_caches();
     initialize_label_caches();
+    initialize_ag_oid_caches();
+    initialize_cypher_query_cache();
 
     initialized = true;
 }
@@ -273,6 +382,9 @@ static void invalidate_graph_caches(Datum arg, int cache_id, uint32 hash_value)
      */
     flush_graph_name_cache();
     flush_graph_namespace_cache();
+
+    // analyzed queries refer to the graphs by their OIDs
+    flush_cypher_query_cache();
 }
 
 static void flush_graph_name_cache(void)
@@ -332,8 +444,12 @@ graph_cache_data *search_graph_name_cache(const char *name)
     namestrcpy(&name_key, name);
     entry = hash_search(graph_name_cache_hash, &name_key, HASH_FIND, NULL);
     if (entry)
+    {
+        ag_stat_inc(AG_STAT_GRAPH_NAME_CACHE_HITS);
         return &entry->data;
+    }
 
+    ag_stat_inc(AG_STAT_GRAPH_NAME_CACHE_MISSES);
     return search_graph_name_cache_miss(&name_key);
 }
 
@@ -390,8 +506,12 @@ graph_cache_data *search_graph_namespace_cache(Oid namespace)
     entry = hash_search(graph_namespace_cache_hash, &namespace, HASH_FIND,
                         NULL);
     if (entry)
+    {
+        ag_stat_inc(AG_STAT_GRAPH_NAMESPACE_CACHE_HITS);
         return &entry->data;
+    }
 
+    ag_stat_inc(AG_STAT_GRAPH_NAMESPACE_CACHE_MISSES);
     return search_graph_namespace_cache_miss(namespace);
 }
 
@@ -503,6 +623,7 @@ static void create_label_caches(void)
     create_label_name_graph_cache();
     create_label_graph_id_cache();
     create_label_relation_cache();
+    create_label_stats_cache();
 }
 
 static void create_label_oid_cache(void)
@@ -575,6 +696,22 @@ static void create_label_relation_cache(void)
                                             &hash_ctl, HASH_ELEM | HASH_BLOBS);
 }
 
+static void create_label_stats_cache(void)
+{
+    HASHCTL hash_ctl;
+
+    MemSet(&hash_ctl, 0, sizeof(hash_ctl));
+    hash_ctl.keysize = sizeof(Oid);
+    hash_ctl.entrysize = sizeof(label_stats_cache_entry);
+
+    /*
+     * Please see the comment of hash_create() for the nelem value 16 here.
+     * HASH_BLOBS flag is set because the size of the key is sizeof(uint32).
+     */
+    label_stats_cache_hash = hash_create("ag_label_stats (relation) cache", 16,
+                                         &hash_ctl, HASH_ELEM | HASH_BLOBS);
+}
+
 static void invalidate_label_caches(Datum arg, Oid relid)
 {
     Assert(label_name_graph_cache_hash);
@@ -585,6 +722,8 @@ static void invalidate_label_caches(Datum arg, Oid relid)
         invalidate_label_name_graph_cache(relid);
         invalidate_label_graph_id_cache(relid);
         invalidate_label_relation_cache(relid);
+        invalidate_label_stats_cache(relid);
+        invalidate_cypher_query_cache(relid);
     }
     else
     {
@@ -592,6 +731,8 @@ static void invalidate_label_caches(Datum arg, Oid relid)
         flush_label_name_graph_cache();
         flush_label_graph_id_cache();
         flush_label_relation_cache();
+        flush_label_stats_cache();
+        flush_cypher_query_cache();
     }
 }
 
@@ -799,6 +940,60 @@ static void flush_label_relation_cache(void)
     }
 }
 
+/*
+ * The statistics of an edge label are stored and deleted along with a
+ * relcache invalidation of the relation of the label, see
+ * store_label_stats().
+ */
+static void invalidate_label_stats_cache(Oid relid)
+{
+    label_stats_cache_entry *entry;
+
+    entry = hash_search(label_stats_cache_hash, &relid, HASH_FIND, NULL);
+    if (!entry)
+        return;
+
+    remove_label_stats_cache_entry(entry);
+}
+
+static void flush_label_stats_cache(void)
+{
+    HASH_SEQ_STATUS hash_seq;
+
+    hash_seq_init(&hash_seq, label_stats_cache_hash);
+    for (;;)
+    {
+        label_stats_cache_entry *entry;
+
+        entry = hash_seq_search(&hash_seq);
+        if (!entry)
+            break;
+
+        remove_label_stats_cache_entry(entry);
+    }
+}
+
+static void remove_label_stats_cache_entry(label_stats_cache_entry *entry)
+{
+    void *removed;
+
+    if (entry->analyzed)
+    {
+        pfree(entry->data.out.heavy_ids);
+        pfree(entry->data.out.heavy_degrees);
+        pfree(entry->data.in.heavy_ids);
+        pfree(entry->data.in.heavy_degrees);
+    }
+
+    removed = hash_search(label_stats_cache_hash, &entry->relation,
+                          HASH_REMOVE, NULL);
+    if (!removed)
+    {
+        ereport(ERROR,
+                (errmsg_internal("ag_label_stats (relation) cache corrupted")));
+    }
+}
+
 label_cache_data *search_label_oid_cache(Oid oid)
 {
     label_cache_data *entry;
@@ -807,8 +1002,12 @@ label_cache_data *search_label_oid_cache(Oid oid)
 
     entry = hash_search(label_oid_cache_hash, &oid, HASH_FIND, NULL);
     if (entry)
+    {
+        ag_stat_inc(AG_STAT_LABEL_OID_CACHE_HITS);
         return entry;
+    }
 
+    ag_stat_inc(AG_STAT_LABEL_OID_CACHE_MISSES);
     return search_label_oid_cache_miss(oid);
 }
 
@@ -872,8 +1071,12 @@ label_cache_data *search_label_name_graph_cache(const char *name, Oid graph)
     entry = label_name_graph_cache_hash_search(&name_key, graph, HASH_FIND,
                                                NULL);
     if (entry)
+    {
+        ag_stat_inc(AG_STAT_LABEL_NAME_GRAPH_CACHE_HITS);
         return &entry->data;
+    }
 
+    ag_stat_inc(AG_STAT_LABEL_NAME_GRAPH_CACHE_MISSES);
     return search_label_name_graph_cache_miss(&name_key, graph);
 }
 
@@ -951,8 +1154,12 @@ label_cache_data *search_label_graph_id_cache(Oid graph, int32 id)
 
     entry = label_graph_id_cache_hash_search(graph, id, HASH_FIND, NULL);
     if (entry)
+    {
+        ag_stat_inc(AG_STAT_LABEL_GRAPH_ID_CACHE_HITS);
         return &entry->data;
+    }
 
+    ag_stat_inc(AG_STAT_LABEL_GRAPH_ID_CACHE_MISSES);
     return search_label_graph_id_cache_miss(graph, id);
 }
 
@@ -1025,8 +1232,12 @@ label_cache_data *search_label_relation_cache(Oid relation)
 
     entry = hash_search(label_relation_cache_hash, &relation, HASH_FIND, NULL);
     if (entry)
+    {
+        ag_stat_inc(AG_STAT_LABEL_RELATION_CACHE_HITS);
         return &entry->data;
+    }
 
+    ag_stat_inc(AG_STAT_LABEL_RELATION_CACHE_MISSES);
     return search_label_relation_cache_miss(relation);
 }
 
@@ -1077,6 +1288,82 @@ static label_cache_data *search_label_relation_cache_miss(Oid relation)
     return entry;
 }
 
+label_stats_data *search_label_stats_cache(Oid relation)
+{
+    label_stats_cache_entry *entry;
+
+    initialize_caches();
+
+    entry = hash_search(label_stats_cache_hash, &relation, HASH_FIND, NULL);
+    if (entry)
+    {
+        ag_stat_inc(AG_STAT_LABEL_STATS_CACHE_HITS);
+    }
+    else
+    {
+        ag_stat_inc(AG_STAT_LABEL_STATS_CACHE_MISSES);
+        entry = search_label_stats_cache_miss(relation);
+    }
+
+    if (!entry->analyzed)
+        return NULL;
+
+    return &entry->data;
+}
+
+/*
+ * Labels that have not been analyzed are cached as well, so that planning a
+ * hop of such a label does not scan ag_label_stats every time.
+ */
+static label_stats_cache_entry *search_label_stats_cache_miss(Oid relation)
+{
+    label_stats_data stats;
+    bool analyzed;
+    bool found;
+    label_stats_cache_entry *entry;
+
+    /*
+     * Reading the catalog might invalidate the label caches. This is OK
+     * because this function is called when the desired entry is not in the
+     * cache.
+     */
+    analyzed = read_label_stats(relation, &stats);
+
+    // get a new entry
+    entry = hash_search(label_stats_cache_hash, &relation, HASH_ENTER,
+                        &found);
+    Assert(!found); // no concurrent update on label_stats_cache_hash
+
+    entry->analyzed = analyzed;
+    if (analyzed)
+    {
+        copy_heavy_hitters_to_cache(&stats.out);
+        copy_heavy_hitters_to_cache(&stats.in);
+        entry->data = stats;
+    }
+
+    return entry;
+}
+
+static void copy_heavy_hitters_to_cache(label_degree_stats *stats)
+{
+    Datum *heavy_ids;
+    float8 *heavy_degrees;
+
+    heavy_ids = MemoryContextAlloc(CacheMemoryContext,
+                                   sizeof(Datum) * stats->num_heavy);
+    memcpy(heavy_ids, stats->heavy_ids, sizeof(Datum) * stats->num_heavy);
+    heavy_degrees = MemoryContextAlloc(CacheMemoryContext,
+                                       sizeof(float8) * stats->num_heavy);
+    memcpy(heavy_degrees, stats->heavy_degrees,
+           sizeof(float8) * stats->num_heavy);
+
+    pfree(stats->heavy_ids);
+    pfree(stats->heavy_degrees);
+    stats->heavy_ids = heavy_ids;
+    stats->heavy_degrees = heavy_degrees;
+}
+
 static void fill_label_cache_data(label_cache_data *cache_data,
                                   HeapTuple tuple, TupleDesc tuple_desc)
 {
@@ -1108,3 +1395,582 @@ static void fill_label_cache_data(label_cache_data *cache_data,
     Assert(!is_null);
     cache_data->relation = DatumGetObjectId(value);
 }
+
+static void initialize_ag_oid_caches(void)
+{
+    reset_ag_type_oids();
+
+    create_ag_func_caches();
+
+    /*
+     * The cached OIDs become stale when the extension is dropped (and maybe
+     * created again). Dropping the extension drops ag_catalog namespace, the
+     * types and the functions in it. So, register the invalidation logic for
+     * invalidation events of the caches of those objects.
+     */
+    CacheRegisterSyscacheCallback(NAMESPACEOID, invalidate_ag_oid_caches,
+                                  (Datum)0);
+    CacheRegisterSyscacheCallback(TYPEOID, invalidate_ag_oid_caches,
+                                  (Datum)0);
+    CacheRegisterSyscacheCallback(PROCOID, invalidate_ag_oid_caches,
+                                  (Datum)0);
+}
+
+static void create_ag_func_caches(void)
+{
+    HASHCTL hash_ctl;
+
+    /*
+     * Use ag_func_cache_data itself since it has oid field as its first field
+     * that is the key for this hash.
+     */
+    MemSet(&hash_ctl, 0, sizeof(hash_ctl));
+    hash_ctl.keysize = sizeof(Oid);
+    hash_ctl.entrysize = sizeof(ag_func_cache_data);
+
+    /*
+     * Please see the comment of hash_create() for the nelem value 16 here.
+     * HASH_BLOBS flag is set because the size of the key is sizeof(uint32).
+     */
+    ag_func_oid_cache_hash = hash_create("pg_proc (oid) cache", 16, &hash_ctl,
+                                         HASH_ELEM | HASH_BLOBS);
+
+    MemSet(&hash_ctl, 0, sizeof(hash_ctl));
+    hash_ctl.keysize = sizeof(ag_func_name_cache_key);
+    hash_ctl.entrysize = sizeof(ag_func_name_cache_entry);
+
+    /*
+     * Please see the comment of hash_create() for the nelem value 16 here.
+     * HASH_BLOBS flag is set because the key for this hash is fixed-size.
+     */
+    ag_func_name_cache_hash = hash_create("pg_proc (name, argtypes) cache", 16,
+                                          &hash_ctl, HASH_ELEM | HASH_BLOBS);
+}
+
+static void invalidate_ag_oid_caches(Datum arg, int cache_id,
+                                     uint32 hash_value)
+{
+    /*
+     * hash_value is for an entry in the syscache, not in the caches here.
+     * So, all the entries are flushed. They are cheap to fill again and
+     * invalidation events of the caches are rare in performance-critical
+     * paths.
+     */
+    switch (cache_id)
+    {
+    case NAMESPACEOID:
+        ag_namespace_oid = InvalidOid;
+        reset_ag_type_oids();
+        flush_ag_func_oid_cache();
+        flush_ag_func_name_cache();
+        break;
+    case TYPEOID:
+        reset_ag_type_oids();
+        break;
+    case PROCOID:
+        flush_ag_func_oid_cache();
+        flush_ag_func_name_cache();
+        break;
+    default:
+        Assert(false);
+        break;
+    }
+}
+
+static void reset_ag_type_oids(void)
+{
+    int i;
+
+    for (i = 0; i < AG_TYPE_OID_COUNT; i++)
+        ag_type_oids[i] = InvalidOid;
+}
+
+static void flush_ag_func_oid_cache(void)
+{
+    HASH_SEQ_STATUS hash_seq;
+
+    hash_seq_init(&hash_seq, ag_func_oid_cache_hash);
+    for (;;)
+    {
+        ag_func_cache_data *entry;
+        void *removed;
+
+        entry = hash_seq_search(&hash_seq);
+        if (!entry)
+            break;
+
+        removed = hash_search(ag_func_oid_cache_hash, &entry->oid,
+                              HASH_REMOVE, NULL);
+        if (!removed)
+            ereport(ERROR, (errmsg_internal("pg_proc (oid) cache corrupted")));
+    }
+}
+
+static void flush_ag_func_name_cache(void)
+{
+    HASH_SEQ_STATUS hash_seq;
+
+    hash_seq_init(&hash_seq, ag_func_name_cache_hash);
+    for (;;)
+    {
+        ag_func_name_cache_entry *entry;
+        void *removed;
+
+        entry = hash_seq_search(&hash_seq);
+        if (!entry)
+            break;
+
+        removed = hash_search(ag_func_name_cache_hash, &entry->key,
+                              HASH_REMOVE, NULL);
+        if (!removed)
+        {
+            ereport(ERROR,
+                    (errmsg_internal("pg_proc (name, argtypes) cache corrupted")));
+        }
+    }
+}
+
+Oid search_ag_namespace_oid_cache(void)
+{
+    initialize_caches();
+
+    if (!OidIsValid(ag_namespace_oid))
+        ag_namespace_oid = get_namespace_oid("ag_catalog", true);
+
+    return ag_namespace_oid;
+}
+
+Oid search_ag_type_oid_cache(ag_type_oid_id type)
+{
+    AssertArg(type >= 0 && type < AG_TYPE_OID_COUNT);
+
+    initialize_caches();
+
+    if (!OidIsValid(ag_type_oids[type]))
+    {
+        Oid namespace = ag_catalog_namespace_id();
+        Oid oid;
+
+        /*
+         * GetSysCacheOid2() might flush the OID caches. Fill the entry after
+         * the lookup.
+         */
+        oid = GetSysCacheOid2(TYPENAMENSP,
+                              CStringGetDatum(ag_type_names[type]),
+                              ObjectIdGetDatum(namespace));
+        ag_type_oids[type] = oid;
+    }
+
+    return ag_type_oids[type];
+}
+
+ag_func_cache_data *search_ag_func_oid_cache(Oid oid)
+{
+    ag_func_cache_data *entry;
+
+    initialize_caches();
+
+    entry = hash_search(ag_func_oid_cache_hash, &oid, HASH_FIND, NULL);
+    if (entry)
+    {
+        ag_stat_inc(AG_STAT_AG_FUNC_OID_CACHE_HITS);
+        return entry;
+    }
+
+    ag_stat_inc(AG_STAT_AG_FUNC_OID_CACHE_MISSES);
+    return search_ag_func_oid_cache_miss(oid);
+}
+
+static ag_func_cache_data *search_ag_func_oid_cache_miss(Oid oid)
+{
+    HeapTuple proctup;
+    Form_pg_proc proc;
+    ag_func_cache_data data;
+    ag_func_cache_data *entry;
+    bool found;
+
+    /*
+     * SearchSysCache1() might call AcceptInvalidationMessage() and that might
+     * flush the OID caches. This is OK because this function is called when
+     * the desired entry is not in the cache.
+     */
+    proctup = SearchSysCache1(PROCOID, ObjectIdGetDatum(oid));
+    if (!HeapTupleIsValid(proctup))
+        return NULL;
+
+    proc = (Form_pg_proc)GETSTRUCT(proctup);
+    data.oid = oid;
+    namecpy(&data.name, &proc->proname);
+    data.namespace = proc->pronamespace;
+
+    ReleaseSysCache(proctup);
+
+    // get a new entry
+    entry = hash_search(ag_func_oid_cache_hash, &oid, HASH_ENTER, &found);
+    Assert(!found); // no concurrent update on ag_func_oid_cache_hash
+
+    *entry = data;
+
+    return entry;
+}
+
+Oid search_ag_func_name_cache(const char *name, int nargs,
+                              const Oid *arg_types)
+{
+    ag_func_name_cache_key key;
+    ag_func_name_cache_entry *entry;
+
+    AssertArg(name);
+    AssertArg(nargs >= 0 && nargs <= FUNC_MAX_ARGS);
+
+    initialize_caches();
+
+    // zero the unused bytes since HASH_BLOBS hashes the whole key
+    MemSet(&key, 0, sizeof(key));
+    namestrcpy(&key.name, name);
+    key.nargs = nargs;
+    if (nargs > 0)
+        memcpy(key.arg_types, arg_types, sizeof(Oid) * nargs);
+
+    entry = hash_search(ag_func_name_cache_hash, &key, HASH_FIND, NULL);
+    if (entry)
+    {
+        ag_stat_inc(AG_STAT_AG_FUNC_NAME_CACHE_HITS);
+        return entry->oid;
+    }
+
+    ag_stat_inc(AG_STAT_AG_FUNC_NAME_CACHE_MISSES);
+    return search_ag_func_name_cache_miss(&key);
+}
+
+static Oid search_ag_func_name_cache_miss(ag_func_name_cache_key *key)
+{
+    Oid namespace;
+    oidvector *arg_types;
+    Oid oid;
+    ag_func_name_cache_entry *entry;
+    bool found;
+
+    namespace = ag_catalog_namespace_id();
+    arg_types = buildoidvector(key->arg_types, key->nargs);
+
+    /*
+     * GetSysCacheOid3() might call AcceptInvalidationMessage() and that might
+     * flush the OID caches. This is OK because this function is called when
+     * the desired entry is not in the cache.
+     */
+    oid = GetSysCacheOid3(PROCNAMEARGSNSP, NameGetDatum(&key->name),
+                          PointerGetDatum(arg_types),
+                          ObjectIdGetDatum(namespace));
+    pfree(arg_types);
+
+    if (!OidIsValid(oid))
+        return InvalidOid;
+
+    // get a new entry
+    entry = hash_search(ag_func_name_cache_hash, key, HASH_ENTER, &found);
+    Assert(!found); // no concurrent update on ag_func_name_cache_hash
+
+    entry->oid = oid;
+
+    return oid;
+}
+
+static void initialize_cypher_query_cache(void)
+{
+    create_cypher_query_cache();
+
+    /*
+     * Analyzed queries have OIDs of functions, operators, and casts in them.
+     * So, register the invalidation logic of the cypher query cache for
+     * invalidation events of PROCOID, OPEROID, and CASTSOURCETARGET caches.
+     * Graphs and labels are handled by the callbacks of the graph caches and
+     * the label caches.
+     */
+    CacheRegisterSyscacheCallback(PROCOID,
+                                  invalidate_cypher_query_cache_callback,
+                                  (Datum)0);
+    CacheRegisterSyscacheCallback(OPEROID,
+                                  invalidate_cypher_query_cache_callback,
+                                  (Datum)0);
+    CacheRegisterSyscacheCallback(CASTSOURCETARGET,
+                                  invalidate_cypher_query_cache_callback,
+                                  (Datum)0);
+}
+
+static void create_cypher_query_cache(void)
+{
+    HASHCTL hash_ctl;
+
+    MemSet(&hash_ctl, 0, sizeof(hash_ctl));
+    hash_ctl.keysize = sizeof(cypher_query_cache_key);
+    hash_ctl.entrysize = sizeof(cypher_query_cache_entry);
+
+    /*
+     * Please see the comment of hash_create() for the nelem value 16 here.
+     * HASH_BLOBS flag is set because the key for this hash is fixed-size.
+     */
+    cypher_query_cache_hash = hash_create("cypher query cache", 16, &hash_ctl,
+                                          HASH_ELEM | HASH_BLOBS);
+}
+
+static void invalidate_cypher_query_cache_callback(Datum arg, int cache_id,
+                                                   uint32 hash_value)
+{
+    flush_cypher_query_cache();
+}
+
+static void invalidate_cypher_query_cache(Oid relid)
+{
+    HASH_SEQ_STATUS hash_seq;
+
+    hash_seq_init(&hash_seq, cypher_query_cache_hash);
+    for (;;)
+    {
+        cypher_query_cache_entry *entry;
+
+        entry = hash_seq_search(&hash_seq);
+        if (!entry)
+            break;
+
+        // removing the entry that hash_seq_search() just returned is safe
+        if (list_member_oid(entry->relations, relid))
+            remove_cypher_query_cache_entry(entry);
+    }
+}
+
+static void flush_cypher_query_cache(void)
+{
+    HASH_SEQ_STATUS hash_seq;
+
+    hash_seq_init(&hash_seq, cypher_query_cache_hash);
+    for (;;)
+    {
+        cypher_query_cache_entry *entry;
+
+        entry = hash_seq_search(&hash_seq);
+        if (!entry)
+            break;
+
+        remove_cypher_query_cache_entry(entry);
+    }
+}
+
+static void remove_cypher_query_cache_entry(cypher_query_cache_entry *entry)
+{
+    MemoryContext context = entry->context;
+    void *removed;
+
+    removed = hash_search(cypher_query_cache_hash, &entry->key, HASH_REMOVE,
+                          NULL);
+    if (!removed)
+        ereport(ERROR, (errmsg_internal("cypher query cache corrupted")));
+
+    MemoryContextDelete(context);
+
+    cypher_query_cache_generation++;
+}
+
+// the hash of the schemas that are searched now, including implicit ones
+static uint32 get_search_path_hash(void)
+{
+    List *search_path;
+    ListCell *lc;
+    uint32 hash = 0;
+
+    search_path = fetch_search_path(true);
+    foreach (lc, search_path)
+        hash = hash_combine(hash, DatumGetUInt32(hash_uint32(lfirst_oid(lc))));
+    list_free(search_path);
+
+    return hash;
+}
+
+static void fill_cypher_query_cache_key(cypher_query_cache_key *key, Oid graph,
+                                        const char *query_str, Param *params)
+{
+    // zero the padding bytes since HASH_BLOBS hashes the whole key
+    MemSet(key, 0, sizeof(*key));
+
+    key->graph = graph;
+    key->query_hash = DatumGetUInt32(hash_any((const unsigned char *)query_str,
+                                              strlen(query_str)));
+    key->search_path_hash = get_search_path_hash();
+    if (params)
+    {
+        key->param_type = params->paramtype;
+        key->param_id = params->paramid;
+    }
+    else
+    {
+        key->param_type = InvalidOid;
+        key->param_id = 0;
+    }
+}
+
+/*
+ * Return a copy of the Query tree that was analyzed for the given cypher()
+ * call before, or NULL if there is none. coltypes and coltypmods are the types
+ * and the type modifiers of the column definition list of the call.
+ */
+Query *search_cypher_query_cache(Oid graph, const char *query_str,
+                                 Param *params, List *coltypes,
+                                 List *coltypmods)
+{
+    cypher_query_cache_key key;
+    cypher_query_cache_entry *entry;
+    List *relations;
+    List *lockmodes;
+    uint64 generation;
+    ListCell *lc1;
+    ListCell *lc2;
+
+    if (cypher_query_cache_size <= 0)
+        return NULL;
+
+    initialize_caches();
+
+    fill_cypher_query_cache_key(&key, graph, query_str, params);
+    entry = hash_search(cypher_query_cache_hash, &key, HASH_FIND, NULL);
+    if (!entry)
+    {
+        ag_stat_inc(AG_STAT_CYPHER_QUERY_CACHE_MISSES);
+        return NULL;
+    }
+
+    // the hashes of the query string and the search path are not unique
+    if (strcmp(entry->query_str, query_str) != 0 ||
+        !OverrideSearchPathMatchesCurrent(entry->search_path) ||
+        !equal(entry->coltypes, coltypes) ||
+        !equal(entry->coltypmods, coltypmods))
+    {
+        ag_stat_inc(AG_STAT_CYPHER_QUERY_CACHE_MISSES);
+        return NULL;
+    }
+
+    /*
+     * The planner expects that the parser has locked the relations in the
+     * Query tree. Take the same locks the parser took. Taking a lock might
+     * call AcceptInvalidationMessages() and that might remove the entry. So,
+     * the lists are copied and the entry is used only if nothing has been
+     * removed in the meantime.
+     */
+    relations = list_copy(entry->relations);
+    lockmodes = list_copy(entry->lockmodes);
+    generation = cypher_query_cache_generation;
+
+    forboth (lc1, relations, lc2, lockmodes)
+        LockRelationOid(lfirst_oid(lc1), lfirst_int(lc2));
+
+    list_free(relations);
+    list_free(lockmodes);
+
+    if (generation != cypher_query_cache_generation)
+    {
+        ag_stat_inc(AG_STAT_CYPHER_QUERY_CACHE_MISSES);
+        return NULL;
+    }
+
+    ag_stat_inc(AG_STAT_CYPHER_QUERY_CACHE_HITS);
+    return copyObject(entry->query);
+}
+
+void store_cypher_query_cache(Oid graph, const char *query_str, Param *params,
+                              List *coltypes, List *coltypmods, Query *query)
+{
+    cypher_query_cache_key key;
+    cypher_query_cache_entry *entry;
+    MemoryContext context;
+    MemoryContext old_context;
+    bool found;
+
+    if (cypher_query_cache_size <= 0)
+        return;
+
+    initialize_caches();
+
+    fill_cypher_query_cache_key(&key, graph, query_str, params);
+    entry = hash_search(cypher_query_cache_hash, &key, HASH_FIND, NULL);
+    if (entry)
+    {
+        // replace the entry of another query that has the same key
+        remove_cypher_query_cache_entry(entry);
+    }
+    else if (hash_get_num_entries(cypher_query_cache_hash) >=
+             cypher_query_cache_size)
+    {
+        /*
+         * The cache is meant for a working set of frequently issued queries.
+         * Start over instead of keeping track of the usage of each entry.
+         */
+        flush_cypher_query_cache();
+    }
+
+    context = AllocSetContextCreate(CacheMemoryContext,
+                                    "cypher query cache entry",
+                                    ALLOCSET_SMALL_SIZES);
+
+    entry = hash_search(cypher_query_cache_hash, &key, HASH_ENTER, &found);
+    Assert(!found);
+
+    entry->context = context;
+    entry->relations = NIL;
+    entry->lockmodes = NIL;
+
+    old_context = MemoryContextSwitchTo(context);
+
+    entry->query_str = pstrdup(query_str);
+    entry->search_path = GetOverrideSearchPath(context);
+    entry->coltypes = list_copy(coltypes);
+    entry->coltypmods = list_copy(coltypmods);
+    entry->query = copyObject(query);
+    collect_query_relations((Node *)entry->query, entry);
+
+    MemoryContextSwitchTo(old_context);
+}
+
+// collect the relations in the Query tree with the locks the parser took
+static bool collect_query_relations(Node *node,
+                                    cypher_query_cache_entry *entry)
+{
+    if (!node)
+        return false;
+
+    if (IsA(node, RangeTblEntry))
+    {
+        RangeTblEntry *rte = (RangeTblEntry *)node;
+        LOCKMODE lockmode;
+        ListCell *lc1;
+        ListCell *lc2;
+
+        if (rte->rtekind != RTE_RELATION)
+            return false;
+
+        if (rte->requiredPerms & (ACL_INSERT | ACL_UPDATE | ACL_DELETE))
+            lockmode = RowExclusiveLock;
+        else
+            lockmode = AccessShareLock;
+
+        forboth (lc1, entry->relations, lc2, entry->lockmodes)
+        {
+            if (lfirst_oid(lc1) == rte->relid)
+            {
+                lfirst_int(lc2) = Max(lfirst_int(lc2), lockmode);
+                return false;
+            }
+        }
+
+        entry->relations = lappend_oid(entry->relations, rte->relid);
+        entry->lockmodes = lappend_int(entry->lockmodes, lockmode);
+
+        return false;
+    }
+
+    if (IsA(node, Query))
+    {
+        return query_tree_walker((Query *)node, collect_query_relations, entry,
+                                 QTW_EXAMINE_RTES);
+    }
+
+    return expression_tree_walker(node, collect_query_relations, entry);
+}
@@ -70,6 +70,23 @@ int32 get_label_id(const char *label_name, Oid label_graph);
 Oid get_label_relation(const char *label_name, Oid label_graph);
 char *get_label_relation_name(const char *label_name, Oid label_graph);
 
+/*
+ * label_name_table maps the label IDs of a graph to the names of the labels.
+ * names is indexed by the label ID, and the names of the default labels are
+ * empty strings. It lives as long as mcxt does.
+ */
+typedef struct label_name_table
+{
+    Oid graph;
+    MemoryContext mcxt;
+    int32 size; // the number of slots in names and name_lens
+    char **names;
+    int *name_lens;
+} label_name_table;
+
+label_name_table *make_label_name_table(Oid graph, MemoryContext mcxt);
+char *lookup_label_name(label_name_table *table, int32 label_id, int *len);
+
 bool label_id_exists(Oid label_graph, int32 label_id);
 RangeVar *get_label_range_var(char *graph_name, Oid graph_oid, char *label_name);
 
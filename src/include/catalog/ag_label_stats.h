@@ -0,0 +1,71 @@
+/*
+ * Copyright 2020 Bitnine Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AG_AG_LABEL_STATS_H
+#define AG_AG_LABEL_STATS_H
+
+#include "postgres.h"
+
+#include "catalog/ag_catalog.h"
+
+#define Anum_ag_label_stats_relation 1
+#define Anum_ag_label_stats_edges 2
+#define Anum_ag_label_stats_start_vertices 3
+#define Anum_ag_label_stats_avg_out_degree 4
+#define Anum_ag_label_stats_max_out_degree 5
+#define Anum_ag_label_stats_heavy_start_ids 6
+#define Anum_ag_label_stats_heavy_start_degrees 7
+#define Anum_ag_label_stats_end_vertices 8
+#define Anum_ag_label_stats_avg_in_degree 9
+#define Anum_ag_label_stats_max_in_degree 10
+#define Anum_ag_label_stats_heavy_end_ids 11
+#define Anum_ag_label_stats_heavy_end_degrees 12
+
+#define Natts_ag_label_stats 12
+
+#define ag_label_stats_relation_id() ag_relation_id("ag_label_stats", "table")
+#define ag_label_stats_relation_index_id() \
+    ag_relation_id("ag_label_stats_relation_index", "index")
+
+// the degrees of the vertices at one end of the edges of a label
+typedef struct label_degree_stats
+{
+    float8 vertices; // number of distinct vertices
+    float8 avg_degree;
+    float8 max_degree;
+    // vertices with the most edges, in descending order of their degrees
+    int num_heavy;
+    Datum *heavy_ids;
+    float8 *heavy_degrees;
+} label_degree_stats;
+
+typedef struct label_stats_data
+{
+    float8 edges;
+    label_degree_stats out; // start vertices
+    label_degree_stats in; // end vertices
+} label_stats_data;
+
+void store_label_stats(Oid relation, label_stats_data *stats);
+void delete_label_stats(Oid relation);
+
+// reads the catalog, search_label_stats_cache() should be used instead
+bool read_label_stats(Oid relation, label_stats_data *stats);
+
+// the statistics are copied from the cache into CurrentMemoryContext
+bool get_label_stats(Oid relation, label_stats_data *stats);
+
+#endif
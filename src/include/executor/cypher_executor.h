@@ -21,7 +21,37 @@
 #include "nodes/nodes.h"
 #include "nodes/plannodes.h"
 
+/*
+ * Columns of the tuples that Cypher Expand returns, an adjacent edge of the
+ * bound vertex followed by the vertex at the other end of the edge
+ */
+#define Natts_cypher_expand 6
+
+#define cypher_expand_edge_id 0
+#define cypher_expand_start_id 1
+#define cypher_expand_end_id 2
+#define cypher_expand_edge_properties 3
+#define cypher_expand_id 4
+#define cypher_expand_properties 5
+
+/*
+ * Columns of the tuples that Cypher VLE returns, the vertex at the end of a
+ * path from the bound vertex followed by the array of the edges of the path.
+ * The array is NULL for shortest paths.
+ */
+#define Natts_cypher_vle 3
+
+#define cypher_vle_id 0
+#define cypher_vle_properties 1
+#define cypher_vle_edge_ids 2
+
 Node *create_cypher_create_plan_state(CustomScan *cscan);
 extern const CustomExecMethods cypher_create_exec_methods;
 
+Node *create_cypher_expand_plan_state(CustomScan *cscan);
+extern const CustomExecMethods cypher_expand_exec_methods;
+
+Node *create_cypher_vle_plan_state(CustomScan *cscan);
+extern const CustomExecMethods cypher_vle_exec_methods;
+
 #endif
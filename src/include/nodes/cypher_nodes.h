@@ -93,6 +93,7 @@ typedef struct cypher_path
 {
     ExtensibleNode extensible;
     List *path; // [ node ( , relationship , node , ... ) ]
+    bool shortest; // shortestPath( path )
     int location;
 } cypher_path;
 
@@ -113,7 +114,7 @@ typedef enum
     CYPHER_REL_DIR_RIGHT
 } cypher_rel_dir;
 
-// -[ name :label props ]-
+// -[ name :label *min_hops..max_hops props ]-
 typedef struct cypher_relationship
 {
     ExtensibleNode extensible;
@@ -121,6 +122,9 @@ typedef struct cypher_relationship
     char *label;
     Node *props; // map or parameter
     cypher_rel_dir dir;
+    bool varlen; // true if the length is given
+    int min_hops;
+    int max_hops; // -1 if there is no upper bound
     int location;
 } cypher_relationship;
 
@@ -181,6 +185,8 @@ typedef struct cypher_target_node
     List *targetList;
     List *expr_states;
     cypher_rel_dir dir;
+    // reported to ag_stat_cypher when the node ends
+    uint64 rows_created;
 } cypher_target_node;
 
 
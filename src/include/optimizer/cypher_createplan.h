@@ -21,6 +21,14 @@
 #include "nodes/plannodes.h"
 #include "nodes/relation.h"
 
+void register_cypher_scan_methods(void);
+
+Plan *plan_cypher_expand_path(PlannerInfo *root, RelOptInfo *rel,
+                              CustomPath *best_path, List *tlist,
+                              List *clauses, List *custom_plans);
+Plan *plan_cypher_vle_path(PlannerInfo *root, RelOptInfo *rel,
+                           CustomPath *best_path, List *tlist, List *clauses,
+                           List *custom_plans);
 Plan *plan_cypher_create_path(PlannerInfo *root, RelOptInfo *rel,
                               CustomPath *best_path, List *tlist,
                               List *clauses, List *custom_plans);
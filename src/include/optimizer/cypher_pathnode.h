@@ -20,6 +20,10 @@
 #include "nodes/pg_list.h"
 #include "nodes/relation.h"
 
+CustomPath *create_cypher_expand_path(PlannerInfo *root, RelOptInfo *rel,
+                                      List *custom_private);
+CustomPath *create_cypher_vle_path(PlannerInfo *root, RelOptInfo *rel,
+                                   List *custom_private);
 CustomPath *create_cypher_create_path(PlannerInfo *root, RelOptInfo *rel,
                                       List *custom_private);
 
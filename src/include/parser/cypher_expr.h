@@ -22,7 +22,12 @@
 
 #include "parser/cypher_parse_node.h"
 
+// the names of the id and properties columns that are exposed next to vertices
+#define VERTEX_ID_COLUMN_NAME "_ag_vertex_id"
+#define VERTEX_PROPERTIES_COLUMN_NAME "_ag_vertex_properties"
+
 Node *transform_cypher_expr(cypher_parsestate *cpstate, Node *expr,
                             ParseExprKind expr_kind);
+Node *make_property_access_expr(Node *properties, char *key);
 
 #endif
@@ -19,6 +19,12 @@
 
 #include "postgres.h"
 
+#include "nodes/parsenodes.h"
+#include "nodes/pg_list.h"
+#include "nodes/primnodes.h"
+
+#include "catalog/ag_label_stats.h"
+
 // graph_cache_data contains the same fields that ag_graph catalog table has
 typedef struct graph_cache_data
 {
@@ -38,6 +44,24 @@ typedef struct label_cache_data
     Oid relation;
 } label_cache_data;
 
+// ag_catalog types whose OIDs are cached
+typedef enum ag_type_oid_id
+{
+    AG_TYPE_OID_AGTYPE,
+    AG_TYPE_OID_AGTYPE_ARRAY,
+    AG_TYPE_OID_GRAPHID,
+    AG_TYPE_OID_GRAPHID_ARRAY,
+    AG_TYPE_OID_COUNT
+} ag_type_oid_id;
+
+// ag_func_cache_data contains the fields of pg_proc that ag_func.c needs
+typedef struct ag_func_cache_data
+{
+    Oid oid;
+    NameData name;
+    Oid namespace;
+} ag_func_cache_data;
+
 // callers of these functions must not modify the returned struct
 graph_cache_data *search_graph_name_cache(const char *name);
 graph_cache_data *search_graph_namespace_cache(Oid namespace);
@@ -45,5 +69,21 @@ label_cache_data *search_label_oid_cache(Oid oid);
 label_cache_data *search_label_name_graph_cache(const char *name, Oid graph);
 label_cache_data *search_label_graph_id_cache(Oid graph, int32 id);
 label_cache_data *search_label_relation_cache(Oid relation);
+// NULL if the edge label of the relation has not been analyzed
+label_stats_data *search_label_stats_cache(Oid relation);
+ag_func_cache_data *search_ag_func_oid_cache(Oid oid);
+
+// these functions return InvalidOid if there is no such object
+Oid search_ag_namespace_oid_cache(void);
+Oid search_ag_type_oid_cache(ag_type_oid_id type);
+Oid search_ag_func_name_cache(const char *name, int nargs,
+                              const Oid *arg_types);
+
+// callers of these functions get and give their own copy of the Query tree
+Query *search_cypher_query_cache(Oid graph, const char *query_str,
+                                 Param *params, List *coltypes,
+                                 List *coltypmods);
+void store_cypher_query_cache(Oid graph, const char *query_str, Param *params,
+                              List *coltypes, List *coltypmods, Query *query);
 
 #endif
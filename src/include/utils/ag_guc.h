@@ -0,0 +1,49 @@
+/*
+ * Copyright 2020 Bitnine Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AG_AG_GUC_H
+#define AG_AG_GUC_H
+
+/*
+ * Maximum number of analyzed cypher() queries kept per backend. A value of 0
+ * disables the cache.
+ */
+extern int cypher_query_cache_size;
+
+/*
+ * Number of entry IDs a backend reserves at once from the sequence of a label
+ * that is created with it. See next_entry_id().
+ */
+extern int entry_id_block_size;
+
+/*
+ * The length of variable-length relationships without an upper bound is
+ * limited to cypher_vle_max_hops. A variable-length relationship fails if it
+ * returns more than cypher_vle_max_rows rows for a single start vertex. A
+ * value of 0 disables the row limit.
+ */
+extern int cypher_vle_max_hops;
+extern int cypher_vle_max_rows;
+
+/*
+ * Whether the activity of cypher() queries is counted for
+ * ag_catalog.ag_stat_cypher. See utils/ag_stat.h.
+ */
+extern bool track_cypher_stats;
+
+void define_config_params(void);
+
+#endif
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2020 Bitnine Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AG_AG_STAT_H
+#define AG_AG_STAT_H
+
+#include "postgres.h"
+
+#include "portability/instr_time.h"
+
+#include "utils/ag_guc.h"
+
+/*
+ * Counters of ag_catalog.ag_stat_cypher. The names of the counters are in
+ * ag_stat_counter_names of ag_stat.c and must be kept in the same order.
+ */
+typedef enum ag_stat_counter
+{
+    AG_STAT_PARSE_CALLS,
+    AG_STAT_PARSE_TIME, // microseconds
+    AG_STAT_ANALYZE_CALLS,
+    AG_STAT_ANALYZE_TIME, // microseconds
+    AG_STAT_GRAPH_NAME_CACHE_HITS,
+    AG_STAT_GRAPH_NAME_CACHE_MISSES,
+    AG_STAT_GRAPH_NAMESPACE_CACHE_HITS,
+    AG_STAT_GRAPH_NAMESPACE_CACHE_MISSES,
+    AG_STAT_LABEL_OID_CACHE_HITS,
+    AG_STAT_LABEL_OID_CACHE_MISSES,
+    AG_STAT_LABEL_NAME_GRAPH_CACHE_HITS,
+    AG_STAT_LABEL_NAME_GRAPH_CACHE_MISSES,
+    AG_STAT_LABEL_GRAPH_ID_CACHE_HITS,
+    AG_STAT_LABEL_GRAPH_ID_CACHE_MISSES,
+    AG_STAT_LABEL_RELATION_CACHE_HITS,
+    AG_STAT_LABEL_RELATION_CACHE_MISSES,
+    AG_STAT_LABEL_STATS_CACHE_HITS,
+    AG_STAT_LABEL_STATS_CACHE_MISSES,
+    AG_STAT_AG_FUNC_OID_CACHE_HITS,
+    AG_STAT_AG_FUNC_OID_CACHE_MISSES,
+    AG_STAT_AG_FUNC_NAME_CACHE_HITS,
+    AG_STAT_AG_FUNC_NAME_CACHE_MISSES,
+    AG_STAT_CYPHER_QUERY_CACHE_HITS,
+    AG_STAT_CYPHER_QUERY_CACHE_MISSES,
+    AG_STAT_AGTYPE_BUILD_BYTES,
+    AG_STAT_AGTYPE_SERIALIZE_BYTES,
+    AG_STAT_ACCESS_OPERATOR_CALLS,
+    AG_STAT_ROWS_CREATED_OVERFLOW, // rows not counted in rows_created
+    NUM_AG_STAT_COUNTERS
+} ag_stat_counter;
+
+/*
+ * The counters of the backend that have not been added to the shared ones
+ * yet. Hot paths only add to them, see ag_stat_add().
+ */
+extern uint64 ag_stat_pending_counters[NUM_AG_STAT_COUNTERS];
+
+#define ag_stat_add(counter, n) \
+    do \
+    { \
+        if (track_cypher_stats) \
+            ag_stat_pending_counters[(counter)] += (n); \
+    } while (0)
+
+#define ag_stat_inc(counter) ag_stat_add((counter), 1)
+
+/*
+ * ag_stat_start_timer() and ag_stat_stop_timer() add the time between them to
+ * the given timing counter, and count the call.
+ */
+static inline void ag_stat_start_timer(instr_time *start)
+{
+    if (track_cypher_stats)
+        INSTR_TIME_SET_CURRENT(*start);
+    else
+        INSTR_TIME_SET_ZERO(*start);
+}
+
+static inline void ag_stat_stop_timer(ag_stat_counter calls_counter,
+                                      ag_stat_counter time_counter,
+                                      instr_time *start)
+{
+    instr_time duration;
+
+    // tracking may have been turned on in between
+    if (!track_cypher_stats || INSTR_TIME_IS_ZERO(*start))
+        return;
+
+    INSTR_TIME_SET_CURRENT(duration);
+    INSTR_TIME_SUBTRACT(duration, *start);
+
+    ag_stat_pending_counters[calls_counter]++;
+    ag_stat_pending_counters[time_counter] += INSTR_TIME_GET_MICROSEC(duration);
+}
+
+void ag_stat_count_rows_created(Oid relation, uint64 rows);
+void ag_stat_forget_label(Oid relation);
+
+void ag_stat_init(void);
+void ag_stat_fini(void);
+
+#endif
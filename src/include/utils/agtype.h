@@ -27,9 +27,8 @@
 #include "lib/stringinfo.h"
 #include "utils/array.h"
 #include "utils/numeric.h"
-#include "utils/syscache.h"
 
-#include "catalog/ag_namespace.h"
+#include "utils/ag_cache.h"
 
 /* Tokens used when sequentially processing an agtype value */
 typedef enum
@@ -401,6 +400,7 @@ int compare_agtype_containers_orderability(agtype_container *a,
 agtype_value *find_agtype_value_from_container(agtype_container *container,
                                                uint32 flags,
                                                agtype_value *key);
+agtype_value *get_entity_properties_from_container(agtype_container *container);
 agtype_value *get_ith_agtype_value_from_container(agtype_container *container,
                                                   uint32 i);
 agtype_value *push_agtype_value(agtype_parse_state **pstate,
@@ -416,10 +416,9 @@ bool agtype_deep_contains(agtype_iterator **val,
 void agtype_hash_scalar_value(const agtype_value *scalar_val, uint32 *hash);
 void agtype_hash_scalar_value_extended(const agtype_value *scalar_val,
                                        uint64 *hash, uint64 seed);
-void convert_extended_object(StringInfo buffer, agtentry *pheader,
-                             agtype_value *val);
 Datum get_numeric_datum_from_agtype_value(agtype_value *agtv);
 bool is_numeric_result(agtype_value *lhs, agtype_value *rhs);
+void check_agtype_container(agtype_container *container, uint32 len);
 
 /* agtype.c support functions */
 char *agtype_to_cstring(StringInfo out, agtype_container *in,
@@ -435,11 +434,7 @@ bool is_decimal_needed(char *numstr);
 int compare_agtype_scalar_values(agtype_value *a, agtype_value *b);
 
 // OID of agtype and _agtype
-#define AGTYPEOID \
-    (GetSysCacheOid2(TYPENAMENSP, CStringGetDatum("agtype"), \
-                     ObjectIdGetDatum(ag_catalog_namespace_id())))
-#define AGTYPEARRAYOID \
-    (GetSysCacheOid2(TYPENAMENSP, CStringGetDatum("_agtype"), \
-                     ObjectIdGetDatum(ag_catalog_namespace_id())))
+#define AGTYPEOID search_ag_type_oid_cache(AG_TYPE_OID_AGTYPE)
+#define AGTYPEARRAYOID search_ag_type_oid_cache(AG_TYPE_OID_AGTYPE_ARRAY)
 
 #endif
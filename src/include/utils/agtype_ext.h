@@ -20,6 +20,7 @@
 #include "postgres.h"
 
 #include "utils/agtype.h"
+#include "utils/graphid.h"
 
 /*
  * Function serializes the data into the buffer provided.
@@ -36,4 +37,36 @@ bool ag_serialize_extended_type(StringInfo buffer, agtentry *agtentry,
 void ag_deserialize_extended_type(char *base_addr, uint32 offset,
                                   agtype_value *result);
 
+/*
+ * Functions read and make raw scalar integers and floats directly, without
+ * going through the container functions. ag_get_fixed_scalar() accepts
+ * datums with short varlena headers and returns false for other values.
+ */
+bool ag_get_fixed_scalar(struct varlena *agt, agtype_value *result);
+agtype *ag_make_fixed_scalar(agtype_value *scalar_val);
+
+/*
+ * Function checks that the extended type of len bytes (including padding)
+ * serialized at base_addr + offset is well-formed. Errors out if it is not.
+ */
+void ag_check_extended_type(char *base_addr, uint32 offset, uint32 len);
+
+/*
+ * Function returns the properties of the vertex or edge serialized at
+ * base_addr + offset as an AGTV_BINARY value without deserializing the rest.
+ * Returns NULL if the type is not a vertex or an edge.
+ */
+agtype_value *ag_get_entity_properties(char *base_addr, uint32 offset);
+
+/*
+ * Functions fill result with a vertex or an edge. The label and the
+ * properties container are referenced, not copied.
+ */
+void ag_make_vertex_value(agtype_value *result, graphid id, char *label,
+                          int label_len, agtype_container *properties,
+                          int properties_len);
+void ag_make_edge_value(agtype_value *result, graphid id, graphid start_id,
+                        graphid end_id, char *label, int label_len,
+                        agtype_container *properties, int properties_len);
+
 #endif
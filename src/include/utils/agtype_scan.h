@@ -0,0 +1,38 @@
+/*
+ * Copyright 2020 Bitnine Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AG_AGTYPE_SCAN_H
+#define AG_AGTYPE_SCAN_H
+
+#include "postgres.h"
+
+/*
+ * Each of these returns the number of characters at the beginning of s (of
+ * length len) that are of its kind. They point to the implementation that
+ * suits the CPU best, which is chosen on the first call (see pg_comp_crc32c).
+ */
+
+// characters that need no escaping in an agtype string; that is, all but
+// quotes, backslashes and control characters
+extern int (*scan_plain_string_chars)(const char *s, int len);
+
+// ' ', '\t', '\n' and '\r'
+extern int (*scan_whitespace)(const char *s, int len);
+
+// '0' to '9'
+extern int (*scan_digits)(const char *s, int len);
+
+#endif
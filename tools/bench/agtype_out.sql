@@ -0,0 +1,84 @@
+/*
+ * Copyright 2020 Bitnine Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+--
+-- Microbenchmarks of the agtype output function
+--
+-- Run it with psql against a database that has the extension installed.
+--
+--   psql -X -f tools/bench/agtype_out.sql
+--
+-- Each query turns every value of a table into text and prints the time it
+-- took. The tables are temporary and the input is generated, so the numbers
+-- are comparable between builds on the same machine.
+--
+
+LOAD 'agensgraph';
+SET search_path TO ag_catalog;
+
+\set rows 1000000
+
+CREATE TEMPORARY TABLE bench_int AS
+SELECT (g * 7919)::text::agtype AS v
+FROM generate_series(1, :rows) AS g;
+
+CREATE TEMPORARY TABLE bench_float AS
+SELECT (g / 7.0)::float8::text::agtype AS v
+FROM generate_series(1, :rows) AS g;
+
+CREATE TEMPORARY TABLE bench_string AS
+SELECT to_json(repeat('abcdefgh', 8) || g)::text::agtype AS v
+FROM generate_series(1, :rows) AS g;
+
+CREATE TEMPORARY TABLE bench_escaped_string AS
+SELECT to_json(repeat(E'a"b\\c\n', 8) || g)::text::agtype AS v
+FROM generate_series(1, :rows) AS g;
+
+CREATE TEMPORARY TABLE bench_object AS
+SELECT agtype_build_map('id', g, 'name', 'name_' || g, 'score', g / 3.0,
+                        'tags', agtype_build_list('a', 'b', 'c')) AS v
+FROM generate_series(1, :rows) AS g;
+
+CREATE TEMPORARY TABLE bench_vertex AS
+SELECT _agtype_build_vertex(g::text::graphid, 'person',
+                            agtype_build_map('name', 'name_' || g, 'age', g))
+       AS v
+FROM generate_series(1, :rows) AS g;
+
+CREATE TEMPORARY TABLE bench_edge AS
+SELECT _agtype_build_edge(g::text::graphid, g::text::graphid,
+                          (g + 1)::text::graphid, 'knows',
+                          agtype_build_map('since', 2000 + g % 20)) AS v
+FROM generate_series(1, :rows) AS g;
+
+VACUUM ANALYZE bench_int, bench_float, bench_string, bench_escaped_string,
+               bench_object, bench_vertex, bench_edge;
+
+\timing on
+
+SELECT sum(octet_length(v::text)) AS int_out FROM bench_int;
+SELECT sum(octet_length(v::text)) AS float_out FROM bench_float;
+SELECT sum(octet_length(v::text)) AS string_out FROM bench_string;
+SELECT sum(octet_length(v::text)) AS escaped_string_out
+FROM bench_escaped_string;
+SELECT sum(octet_length(v::text)) AS object_out FROM bench_object;
+SELECT sum(octet_length(v::text)) AS vertex_out FROM bench_vertex;
+SELECT sum(octet_length(v::text)) AS edge_out FROM bench_edge;
+
+\timing off
+
+DROP TABLE bench_int, bench_float, bench_string, bench_escaped_string,
+           bench_object, bench_vertex, bench_edge;